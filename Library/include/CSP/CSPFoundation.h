@@ -126,6 +126,15 @@ public:
 	/// @return csp::common::String&
 	static const csp::common::String& GetTenant();
 
+	/// @brief Sets how many web requests Foundation sends at the same time. Requests beyond this are queued until one completes.
+	/// This must be called before Initialise to take effect, and has no effect on WASM builds, where the browser schedules requests.
+	/// @param MaxConcurrentRequests uint32_t : Number of requests in flight at once. Defaults to 4.
+	static void SetMaxConcurrentWebRequests(uint32_t MaxConcurrentRequests);
+
+	/// @brief Gets how many web requests Foundation sends at the same time.
+	/// @return uint32_t
+	static uint32_t GetMaxConcurrentWebRequests();
+
 private:
 	static bool IsInitialised;
 	static EndpointURIs* Endpoints;
@@ -133,6 +142,7 @@ private:
 	static csp::common::String* DeviceId;
 	static csp::common::String* ClientUserAgentString;
 	static csp::common::String* Tenant;
+	static uint32_t MaxConcurrentWebRequests;
 };
 
 
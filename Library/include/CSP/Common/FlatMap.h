@@ -0,0 +1,267 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CSP/CSPCommon.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+CSP_NO_EXPORT
+
+
+namespace csp::common
+{
+
+/// @brief Ordered map storage for small integer keys, used by csp::common::Map in place of std::map.
+///
+/// Keys are kept sorted in a contiguous array, so finding a key is a binary search over a few cache lines rather than a walk down a
+/// tree of separately allocated nodes, and iterating doesn't chase pointers between keys. Each element is still allocated on its
+/// own, so references to elements stay valid as other elements are added and removed, as they do with std::map. Adding or removing
+/// an element moves the keys after it, which is cheap for the small maps of component and property ids this is meant for.
+///
+/// Provides the subset of the std::map interface that Map uses.
+///
+/// @tparam TKey : Integer type to use as the key
+/// @tparam TValue : Type to use as the value
+template <typename TKey, typename TValue> class FlatIntegerMap
+{
+	static_assert(std::is_integral_v<TKey>, "FlatIntegerMap only supports integer keys");
+
+public:
+	using value_type = std::pair<const TKey, TValue>;
+
+private:
+	struct Slot
+	{
+		TKey Key;
+		value_type* Element;
+	};
+
+	using SlotList = std::vector<Slot>;
+
+	template <typename TSlotIterator, typename TElement> class IteratorBase
+	{
+	public:
+		IteratorBase(TSlotIterator InIt) : It(InIt)
+		{
+		}
+
+		TElement& operator*() const
+		{
+			return *It->Element;
+		}
+
+		TElement* operator->() const
+		{
+			return It->Element;
+		}
+
+		IteratorBase& operator++()
+		{
+			++It;
+
+			return *this;
+		}
+
+		bool operator==(const IteratorBase& Other) const
+		{
+			return It == Other.It;
+		}
+
+		bool operator!=(const IteratorBase& Other) const
+		{
+			return It != Other.It;
+		}
+
+	private:
+		TSlotIterator It;
+	};
+
+public:
+	using iterator		 = IteratorBase<typename SlotList::iterator, value_type>;
+	using const_iterator = IteratorBase<typename SlotList::const_iterator, const value_type>;
+
+	FlatIntegerMap() = default;
+
+	FlatIntegerMap(const FlatIntegerMap& Other)
+	{
+		CopyFrom(Other);
+	}
+
+	FlatIntegerMap(FlatIntegerMap&& Other) noexcept : Slots(std::move(Other.Slots))
+	{
+		Other.Slots.clear();
+	}
+
+	~FlatIntegerMap()
+	{
+		clear();
+	}
+
+	FlatIntegerMap& operator=(const FlatIntegerMap& Other)
+	{
+		if (this != &Other)
+		{
+			clear();
+			CopyFrom(Other);
+		}
+
+		return *this;
+	}
+
+	FlatIntegerMap& operator=(FlatIntegerMap&& Other) noexcept
+	{
+		if (this != &Other)
+		{
+			clear();
+			Slots = std::move(Other.Slots);
+			Other.Slots.clear();
+		}
+
+		return *this;
+	}
+
+	iterator begin()
+	{
+		return iterator(Slots.begin());
+	}
+
+	iterator end()
+	{
+		return iterator(Slots.end());
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(Slots.begin());
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(Slots.end());
+	}
+
+	size_t size() const
+	{
+		return Slots.size();
+	}
+
+	bool empty() const
+	{
+		return Slots.empty();
+	}
+
+	iterator find(const TKey& Key)
+	{
+		auto It = LowerBound(Slots, Key);
+
+		return iterator((It != Slots.end() && It->Key == Key) ? It : Slots.end());
+	}
+
+	const_iterator find(const TKey& Key) const
+	{
+		auto It = LowerBound(Slots, Key);
+
+		return const_iterator((It != Slots.end() && It->Key == Key) ? It : Slots.end());
+	}
+
+	size_t count(const TKey& Key) const
+	{
+		return find(Key) != end() ? 1 : 0;
+	}
+
+	TValue& operator[](const TKey& Key)
+	{
+		return emplace(Key, TValue()).first->second;
+	}
+
+	/// @brief Adds an element if there isn't one with this key already. Returns the element with the key, and whether it was added.
+	template <typename... TArgs> std::pair<iterator, bool> emplace(const TKey& Key, TArgs&&... Args)
+	{
+		auto It = LowerBound(Slots, Key);
+
+		if (It != Slots.end() && It->Key == Key)
+		{
+			return {iterator(It), false};
+		}
+
+		auto* Element = new value_type(std::piecewise_construct, std::forward_as_tuple(Key), std::forward_as_tuple(std::forward<TArgs>(Args)...));
+		It			  = Slots.insert(It, Slot {Key, Element});
+
+		return {iterator(It), true};
+	}
+
+	size_t erase(const TKey& Key)
+	{
+		auto It = LowerBound(Slots, Key);
+
+		if (It == Slots.end() || It->Key != Key)
+		{
+			return 0;
+		}
+
+		delete It->Element;
+		Slots.erase(It);
+
+		return 1;
+	}
+
+	void clear()
+	{
+		for (auto& Current : Slots)
+		{
+			delete Current.Element;
+		}
+
+		Slots.clear();
+	}
+
+private:
+	template <typename TSlotList> static auto LowerBound(TSlotList& Slots, const TKey& Key)
+	{
+		return std::lower_bound(Slots.begin(),
+								Slots.end(),
+								Key,
+								[](const Slot& Current, const TKey& Value)
+								{
+									return Current.Key < Value;
+								});
+	}
+
+	void CopyFrom(const FlatIntegerMap& Other)
+	{
+		Slots.reserve(Other.Slots.size());
+
+		for (const auto& Current : Other.Slots)
+		{
+			Slots.push_back(Slot {Current.Key, new value_type(*Current.Element)});
+		}
+	}
+
+	SlotList Slots;
+};
+
+/// @brief Whether csp::common::Map stores elements with this key type in a FlatIntegerMap rather than a std::map.
+template <typename TKey> constexpr bool UseFlatMapStorage = std::is_integral_v<TKey> && sizeof(TKey) <= sizeof(uint32_t);
+
+} // namespace csp::common
@@ -18,6 +18,7 @@
 
 #include "CSP/CSPCommon.h"
 #include "CSP/Common/Array.h"
+#include "CSP/Common/FlatMap.h"
 #include "CSP/Memory/DllAllocator.h"
 
 #include <map>
@@ -29,12 +30,15 @@ namespace csp::common
 /// @brief Simple DLL-safe map of key object pairs.
 ///
 /// Simple map type used to pass maps of key object pairs across the DLL boundary.
+/// Maps with small integer keys, such as component and property ids, store their elements in a FlatIntegerMap, which is faster to
+/// search and iterate than the std::map used for other keys. Either way, elements are kept in key order, and references to elements
+/// stay valid until the element is removed.
 ///
 /// @tparam TKey : Type to use as the key
 /// @tparam TValue : Type to use as the value
 template <typename TKey, typename TValue> class CSP_API Map
 {
-	using MapType = std::map<TKey, TValue>;
+	using MapType = std::conditional_t<UseFlatMapStorage<TKey>, FlatIntegerMap<TKey, TValue>, std::map<TKey, TValue>>;
 
 public:
 	/// @brief Constructs a map with 0 elements.
@@ -53,11 +57,13 @@ public:
 	}
 
 	/// @brief Move constructor.
+	///        Takes the elements of the other map, leaving it empty.
 	/// @param Other Map<TKey, TValue>&&
 	CSP_NO_EXPORT Map(Map<TKey, TValue>&& Other)
 	{
 		Container = (MapType*) csp::memory::DllAlloc(sizeof(MapType));
-		new (Container) MapType(*Other.Container);
+		new (Container) MapType(std::move(*Other.Container));
+		Other.Container->clear();
 	}
 
 	/// @brief Constructs a map from a `std::initializer_list`.
@@ -96,12 +102,14 @@ public:
 	/// @return const TValue& : Map element
 	const TValue& operator[](const TKey& Key) const
 	{
-		if (Container->count(Key) == 0)
+		const auto It = Container->find(Key);
+
+		if (It == Container->end())
 		{
 			throw std::runtime_error("Key not present in Map. Please ensure an element with the given key exists before attempting to access it.");
 		}
 
-		return Container->operator[](Key);
+		return It->second;
 	}
 
 	/// @brief Copy assignment.
@@ -114,13 +122,13 @@ public:
 			return *this;
 		}
 
-		Container->~MapType();
-		new (Container) MapType(*Other.Container);
+		*Container = *Other.Container;
 
 		return *this;
 	}
 
 	/// @brief Move assignment.
+	///        Takes the elements of the other map, leaving it empty.
 	/// @param Other Map<TKey, TValue>&&
 	/// @return Map<TKey, TValue>&
 	CSP_NO_EXPORT Map<TKey, TValue>& operator=(Map<TKey, TValue>&& Other)
@@ -130,8 +138,8 @@ public:
 			return *this;
 		}
 
-		Container->~MapType();
-		new (Container) MapType(*Other.Container);
+		*Container = std::move(*Other.Container);
+		Other.Container->clear();
 
 		return *this;
 	}
@@ -188,10 +196,7 @@ public:
 	/// @param Key const TKey& : Key to remove from the map
 	void Remove(const TKey& Key)
 	{
-		if (HasKey(Key))
-		{
-			Container->erase(Key);
-		}
+		Container->erase(Key);
 	}
 
 	/// @brief Removes all elements in this map.
@@ -31,6 +31,8 @@ namespace csp::common
 {
 
 /// @brief Custom string class that we can use safely across a DLL boundary.
+/// A String is a single pointer to a buffer that is always allocated and freed inside the library. The characters are stored in the same
+/// allocation as the buffer's length and capacity, and empty strings share a buffer rather than allocating.
 class CSP_API String
 {
 public:
@@ -62,9 +64,11 @@ public:
 	String(String const& Other);
 
 	/// @brief Move constructor
+	/// Leaves Other empty.
 	String(String&& Other);
 
 	/// @brief Copy assignment.
+	/// Reuses this string's buffer if it is already large enough.
 	/// @param Rhs const String&
 	/// @return String&
 	String& operator=(const String& Rhs);
@@ -102,6 +106,7 @@ public:
 	/// @return csp::common::List<csp::common::String>
 	List<String> Split(char Delimiter) const;
 
+	/// @brief Compares lengths before comparing characters, so strings of different lengths are rejected without reading them.
 	bool operator==(const String& Other) const;
 	bool operator==(const char* Other) const;
 	bool operator!=(const String& Other) const;
@@ -190,6 +195,18 @@ private:
 	/// @brief Returns internal buffer.
 	/// @return const char*
 	const char* Get() const;
+	char* GetMutable();
+
+	/// @brief Makes room for a string of the given length, discarding the current contents, and returns the buffer to write it to.
+	char* Resize(size_t NewLength);
+
+	/// @brief Frees any allocated buffer, leaving the string empty.
+	void Release();
+
+	void Append(const char* Other, size_t OtherLength);
+
+	/// @brief Takes Other's contents, leaving Other empty. Expects this string to hold nothing that needs freeing.
+	void MoveFrom(String& Other);
 
 private:
 	class Impl;
@@ -36,6 +36,14 @@ class CSPEngine_SerialisationTests_SpaceEntityUserSignalRSerialisationTest_Test;
 class CSPEngine_SerialisationTests_SpaceEntityUserSignalRSerialisationTest_Test;
 class CSPEngine_SerialisationTests_SpaceEntityObjectSignalRDeserialisationTest_Test;
 class CSPEngine_SerialisationTests_SpaceEntityObjectSignalRDeserialisationTest_Test;
+class CSPEngine_SerialisationTests_SpaceEntityObjectMsgPackSerialisationTest_Test;
+class CSPEngine_SerialisationTests_SpaceEntityPatchMsgPackSerialisationTest_Test;
+class CSPEngine_SerialisationTests_PatchSerialisationAllocationTest_Test;
+class CSPEngine_SpaceEntitySystemTests_EntityLookupScalingTest_Test;
+class CSPEngine_SpaceEntitySystemTests_EntityLockContentionTest_Test;
+class CSPEngine_SpaceEntitySystemTests_GlobalTransformCacheTest_Test;
+class CSPEngine_SpaceEntitySystemTests_IncomingPatchCoalescingTest_Test;
+class CSPEngine_SpaceEntitySystemTests_OutgoingPatchPriorityTest_Test;
 #endif
 CSP_END_IGNORE
 
@@ -109,6 +117,14 @@ class CSP_API SpaceEntity
 	friend class ::CSPEngine_SerialisationTests_SpaceEntityUserSignalRDeserialisationTest_Test;
 	friend class ::CSPEngine_SerialisationTests_SpaceEntityObjectSignalRSerialisationTest_Test;
 	friend class ::CSPEngine_SerialisationTests_SpaceEntityObjectSignalRDeserialisationTest_Test;
+	friend class ::CSPEngine_SerialisationTests_SpaceEntityObjectMsgPackSerialisationTest_Test;
+	friend class ::CSPEngine_SerialisationTests_SpaceEntityPatchMsgPackSerialisationTest_Test;
+	friend class ::CSPEngine_SerialisationTests_PatchSerialisationAllocationTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_EntityLookupScalingTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_EntityLockContentionTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_GlobalTransformCacheTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_IncomingPatchCoalescingTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_OutgoingPatchPriorityTest_Test;
 #endif
 	/** @endcond */
 	CSP_END_IGNORE
@@ -385,6 +401,15 @@ private:
 
 	void ResolveParentChildRelationship();
 
+	// Flags the cached global transform of this entity and all of its descendants as needing to be recomputed.
+	// Must be called whenever the local transform or the parent of an entity changes.
+	void MarkGlobalTransformDirty();
+	// Recomputes the cached global transform if it is dirty. GlobalTransformLock must be held by the caller.
+	void UpdateGlobalTransform() const;
+
+	// Updates Name and keeps the owning SpaceEntitySystem's name lookup in sync.
+	void SetNameInternal(const csp::common::String& Value);
+
 	SpaceEntitySystem* EntitySystem;
 
 	SpaceEntityType Type;
@@ -420,6 +445,13 @@ private:
 	std::mutex* ComponentsLock;
 	std::mutex* PropertiesLock;
 
+	// Cached global transform, and the column-major world matrix built from it that children are positioned relative to.
+	// Locks are only ever taken from child to parent while recomputing these, so walking up the hierarchy can't deadlock.
+	mutable SpaceTransform GlobalTransform;
+	mutable float GlobalMatrix[16];
+	mutable bool GlobalTransformDirty;
+	std::mutex* GlobalTransformLock;
+
 	std::atomic_int* RefCount;
 
 	csp::common::List<uint16_t> TransientDeletionComponentIds;
@@ -28,6 +28,9 @@
 #include <list>
 #include <mutex>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 namespace signalr
@@ -38,6 +41,23 @@ class value;
 } // namespace signalr
 
 
+CSP_START_IGNORE
+#ifdef CSP_TESTS
+class CSPEngine_SpaceEntitySystemTests_EntityLockContentionTest_Test;
+class CSPEngine_SpaceEntitySystemTests_GlobalTransformCacheTest_Test;
+class CSPEngine_SpaceEntitySystemTests_IncomingPatchCoalescingTest_Test;
+#endif
+CSP_END_IGNORE
+
+
+namespace csp
+{
+
+class RecursiveSharedMutex;
+
+} // namespace csp
+
+
 namespace csp::memory
 {
 
@@ -63,6 +83,9 @@ namespace csp::multiplayer
 {
 
 class ClientElectionManager;
+class IncomingPatchQueue;
+struct IncomingEntityPatch;
+class MsgPackEntitySerialiser;
 class MultiplayerConnection;
 class SignalRConnection;
 class SpaceEntity;
@@ -85,8 +108,14 @@ class CSP_API SpaceEntitySystem
 	friend class SpaceEntityEventHandler;
 	friend class ClientElectionManager;
 	friend class EntityScript;
+	friend class EntitySystemScriptInterface;
 	friend class SpaceEntity;
 	friend void csp::memory::Delete<SpaceEntitySystem>(SpaceEntitySystem* Ptr);
+#ifdef CSP_TESTS
+	friend class ::CSPEngine_SpaceEntitySystemTests_EntityLockContentionTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_GlobalTransformCacheTest_Test;
+	friend class ::CSPEngine_SpaceEntitySystemTests_IncomingPatchCoalescingTest_Test;
+#endif
 	/** @endcond */
 	CSP_END_IGNORE
 
@@ -152,7 +181,7 @@ public:
 	/// @return A pointer to the first found match SpaceEntity.
 	SpaceEntity* FindSpaceObject(const csp::common::String& InName);
 
-	/// @brief Locks the entity mutex.
+	/// @brief Locks the entity mutex exclusively. Blocks until no other thread is reading or updating entities.
 	void LockEntityUpdate() const;
 
 	/// @brief Unlocks the entity mutex.
@@ -301,6 +330,39 @@ public:
 	/// @return The id of the leader.
 	uint64_t GetLeaderId() const;
 
+	/// @brief Set how long clients wait without a heartbeat from the script leader before its successor takes over.
+	///
+	/// The leader sends a heartbeat four times within this time. When the leader stops without leaving the space, scripts stop running
+	/// for about this long before the client with the next-highest id takes over, without running a new election.
+	/// Has no effect unless Leader Election is enabled.
+	/// @param TimeoutMS uint32_t : The timeout in milliseconds. Defaults to 2000.
+	void SetLeaderHeartbeatTimeout(uint32_t TimeoutMS);
+
+	/// @brief Enable partitioning of script authority between clients, enabling Leader Election if it isn't already.
+	///
+	/// Rather than the elected leader running every entity script, each hierarchy of entities is given to one client, chosen by
+	/// consistent hashing of its root entity over the clients in the space, so script load is spread across all of them.
+	/// When a client joins or leaves, only the hierarchies that hash to that client change authority. A leader that stops without
+	/// leaving the space loses its share once the others fail over from it.
+	///
+	/// Every client follows the leader's setting, which the leader sends with its heartbeat, so clients never run scripts under
+	/// different settings for longer than it takes the heartbeat to arrive. Enabling it on another client has no effect until that
+	/// client becomes the leader, so every client should make the same choice. A leader running an older version never partitions.
+	void EnableScriptAuthorityPartitioning();
+
+	/// @brief Disable partitioning of script authority, so that the elected leader runs every entity script again.
+	/// As with enabling it, only the leader's setting takes effect.
+	void DisableScriptAuthorityPartitioning();
+
+	/// @brief Check if script authority is partitioned between clients, which follows the leader's setting.
+	/// @return true if enabled, false otherwise.
+	bool IsScriptAuthorityPartitioningEnabled() const;
+
+	/// @brief Debug helper to get the id of the client that runs the given entity's scripts.
+	/// @param Entity SpaceEntity : The entity to get the script authority for.
+	/// @return The id of the client, or 0 if there isn't one.
+	uint64_t GetScriptAuthorityId(const SpaceEntity* Entity) const;
+
 	/// @brief Finds a component by the given id.
 	///
 	/// Searchs through all components of all entites so should be used sparingly.
@@ -325,10 +387,40 @@ public:
 	/// \endrst
 	void SetEntityPatchRateLimitEnabled(bool Enabled);
 
+	/// @brief Retrieve the number of bytes of entity patches that may be sent each time pending entity operations are processed.
+	/// @return The budget in bytes, or 0 if unlimited.
+	uint32_t GetEntityPatchFrameBudget() const;
+
+	/// @brief Set the number of bytes of entity patches that may be sent each time pending entity operations are processed.
+	///
+	/// Once the budget has been used, any remaining entities keep their changes queued until a later frame, with avatars sent first.
+	/// Further changes made to a queued entity are merged into its pending patch. Defaults to 128KB.
+	///
+	/// @param Bytes uint32_t : The budget in bytes. Pass 0 to send every pending patch each frame.
+	void SetEntityPatchFrameBudget(uint32_t Bytes);
+
+	/// @brief Retrieve the largest size of a single message of entity patches sent to Magnopus Connected Services.
+	/// @return The size in bytes, or 0 if unlimited.
+	uint32_t GetMaxEntityPatchMessageSize() const;
+
+	/// @brief Set the largest size of a single message of entity patches sent to Magnopus Connected Services.
+	///
+	/// Patches that don't fit in one message are split across several. A single patch larger than this is still sent on its own.
+	/// Defaults to 30KB, to stay within the default message size limit of the server.
+	///
+	/// @param Bytes uint32_t : The size in bytes. Pass 0 to send all of a frame's patches in one message.
+	void SetMaxEntityPatchMessageSize(uint32_t Bytes);
+
 	/// @brief Retrieves all entites that exist at the root level (do not have a parent entity).
 	/// @return A list of root entities.
 	const csp::common::List<SpaceEntity*>* GetRootHierarchyEntities() const;
 
+	/// @brief Brings the cached global transforms of all entities up to date, visiting the hierarchy breadth-first from the root entities
+	/// so that each parent is resolved once, before any of its children.
+	/// Global transforms are otherwise resolved lazily by SpaceEntity::GetGlobalTransform. Calling this once per frame, before querying
+	/// global transforms, avoids walking up the hierarchy on each query.
+	void UpdateWorldTransforms();
+
 	/// @brief Creates an entity hierarchy for a given parent entity id. Pass null to create a hiererchy for the root.
 	/// @param ParentId Optional<uint64_t> : An optional parent. Pass null to create a hiererchy for the root.
 	/// @param HierarchyItemIds Array<uint64_t> : An array of entity ids.
@@ -373,7 +465,7 @@ protected:
 	SpaceEntityList SelectedEntities;
 	SpaceEntityList RootHierarchyEntities;
 
-	std::recursive_mutex* EntitiesLock;
+	csp::RecursiveSharedMutex* EntitiesLock;
 
 private:
 	SpaceEntitySystem(MultiplayerConnection* InMultiplayerConnection);
@@ -382,9 +474,13 @@ private:
 	MultiplayerConnection* MultiplayerConnectionInst;
 	csp::multiplayer::SignalRConnection* Connection;
 
-	using SpaceEntityQueue	= std::deque<SpaceEntity*>;
-	using PatchMessageQueue = std::deque<signalr::value*>;
-	using SpaceEntitySet	= std::set<SpaceEntity*>;
+	using SpaceEntityQueue = std::deque<SpaceEntity*>;
+	using SpaceEntitySet   = std::set<SpaceEntity*>;
+
+	// Lookup indices over Entities, kept in sync whenever an entity is added, removed or renamed.
+	// Entities sharing a name are stored in the order they were added (or renamed) under that name.
+	using SpaceEntityIdMap	 = std::unordered_map<uint64_t, SpaceEntity*>;
+	using SpaceEntityNameMap = std::unordered_map<std::string, std::vector<SpaceEntity*>>;
 
 
 	EntityCreatedCallback SpaceEntityCreatedCallback;
@@ -406,7 +502,12 @@ private:
 
 	void AddPendingEntity(SpaceEntity* EntityToAdd);
 	void RemovePendingEntity(SpaceEntity* EntityToRemove);
-	void ApplyIncomingPatch(const signalr::value*);
+
+	void AddEntityToIndex(SpaceEntity* Entity);
+	void RemoveEntityFromIndex(SpaceEntity* Entity);
+	void OnEntityNameChanged(SpaceEntity* Entity, const csp::common::String& OldName);
+	const std::vector<SpaceEntity*>* FindEntitiesByName(const csp::common::String& InName) const;
+	void ApplyIncomingPatch(const IncomingEntityPatch& Patch);
 	void HandleException(const std::exception_ptr& Except, const std::string& ExceptionDescription);
 
 	void OnAllEntitiesCreated();
@@ -417,8 +518,9 @@ private:
 	bool EntityIsInRootHierarchy(SpaceEntity* Entity);
 
 	void ClaimScriptOwnershipFromClient(uint64_t ClientId);
-	bool CheckIfWeShouldRunScriptsLocally() const;
-	void RunScriptRemotely(int64_t ContextId, const csp::common::String& ScriptText);
+	uint64_t GetScriptAuthorityKey(const SpaceEntity* Entity) const;
+	bool CheckIfWeShouldRunScriptsLocally(const SpaceEntity* Entity) const;
+	void RunScriptRemotely(const SpaceEntity* Entity, const csp::common::String& ScriptText);
 	void TickEntityScripts();
 
 	void OnAvatarAdd(const SpaceEntity* Avatar, const SpaceEntityList& Avatars);
@@ -437,11 +539,20 @@ private:
 	class ClientElectionManager* ElectionManager;
 
 	std::mutex* TickEntitiesLock;
+	// Guards PendingAdds and PendingRemoves, so that entities can be queued for adding or removal without the entity lock
+	std::mutex* PendingEntitiesLock;
 
 	SpaceEntityQueue* PendingAdds;
 	SpaceEntityQueue* PendingRemoves;
 	SpaceEntitySet* PendingOutgoingUpdateUniqueSet;
-	PatchMessageQueue* PendingIncomingUpdates;
+	// Has its own lock, so that queueing patches as they arrive doesn't wait on the entity lock
+	IncomingPatchQueue* PendingIncomingUpdates;
+
+	// Reused for every outgoing patch, so that serialising patches doesn't allocate once its buffer has grown
+	MsgPackEntitySerialiser* PatchSerialiser;
+
+	SpaceEntityIdMap* EntityIdIndex;
+	SpaceEntityNameMap* EntityNameIndex;
 
 	bool EnableEntityTick;
 	std::list<SpaceEntity*> TickUpdateEntities;
@@ -451,6 +562,9 @@ private:
 
 	bool EntityPatchRateLimitEnabled = true;
 
+	uint32_t EntityPatchFrameBudget;
+	uint32_t MaxEntityPatchMessageSize;
+
 	bool IsInitialised = false;
 
 	SequenceHierarchyChangedCallbackHandler SequenceHierarchyChangedCallback;
@@ -334,6 +334,39 @@ private:
 };
 
 
+/// @ingroup Asset System
+/// @brief Data class used to contain the overall result of downloading the data of several assets at once.
+/// Succeeds only if every asset's data was downloaded.
+class CSP_API AssetDataBatchResult : public csp::systems::ResultBase
+{
+	/** @cond DO_NOT_DOCUMENT */
+	friend class AssetSystem;
+	/** @endcond */
+
+public:
+	/// @brief Gets the number of assets in the batch.
+	uint32_t GetNumAssets() const;
+
+	/// @brief Gets the number of assets whose data couldn't be downloaded.
+	uint32_t GetNumFailed() const;
+
+	/// @brief Gets the number of files downloaded. Assets that share data are only downloaded once, so this may be less than the number
+	/// of assets.
+	uint32_t GetNumDownloads() const;
+
+protected:
+	AssetDataBatchResult() = delete;
+	AssetDataBatchResult(void*);
+
+private:
+	AssetDataBatchResult(csp::systems::EResultCode ResCode, uint16_t HttpResCode);
+
+	uint32_t NumAssets	  = 0;
+	uint32_t NumFailed	  = 0;
+	uint32_t NumDownloads = 0;
+};
+
+
 /// @brief Callback containing asset.
 /// @param Result CreateAssetResult : result class
 typedef std::function<void(const AssetResult& Result)> AssetResultCallback;
@@ -350,4 +383,8 @@ typedef std::function<void(const UriResult& Result)> UriResultCallback;
 /// @param Result GetAssetsResult : result class
 typedef std::function<void(const AssetDataResult& Result)> AssetDataResultCallback;
 
+/// @brief Callback containing the overall result of a batch of asset data downloads.
+/// @param Result AssetDataBatchResult : result class
+typedef std::function<void(const AssetDataBatchResult& Result)> AssetDataBatchResultCallback;
+
 } // namespace csp::systems
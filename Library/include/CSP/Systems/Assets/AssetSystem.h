@@ -26,6 +26,9 @@
 #include "CSP/Systems/Spaces/Space.h"
 #include "CSP/Systems/SystemBase.h"
 
+#include <functional>
+#include <memory>
+
 
 namespace csp::services
 {
@@ -39,6 +42,7 @@ namespace csp::web
 {
 
 class RemoteFileManager;
+class IHttpResponseSink;
 
 } // namespace csp::web
 
@@ -56,6 +60,17 @@ CSP_END_IGNORE
 namespace csp::systems
 {
 
+CSP_START_IGNORE
+/// @brief Receives a piece of downloaded asset data. Data is only valid for the duration of the call.
+typedef std::function<void(uint64_t Offset, const void* Data, size_t Length)> AssetDataChunkCallback;
+
+/// @brief Receives the data of one asset of a batch download, with the index of the asset in the batch.
+typedef std::function<void(size_t Index, const AssetDataResult& Result)> AssetDataBatchItemCallback;
+
+/// @brief Receives the data of one level of a LOD chain as it is prefetched, with the level it is for.
+typedef std::function<void(int LODLevel, const AssetDataResult& Result)> LODAssetDataCallback;
+CSP_END_IGNORE
+
 /// @ingroup Asset System
 /// @brief Public facing system that allows uploading/downloading and creation of assets.
 class CSP_API AssetSystem : public SystemBase
@@ -63,6 +78,7 @@ class CSP_API AssetSystem : public SystemBase
 	CSP_START_IGNORE
 	/** @cond DO_NOT_DOCUMENT */
 	friend class SystemsManager;
+	friend class AssetSystemEventHandler;
 	friend void csp::memory::Delete<AssetSystem>(AssetSystem* Ptr);
 	/** @endcond */
 	CSP_END_IGNORE
@@ -233,12 +249,88 @@ public:
 	CSP_ASYNC_RESULT void
 		DownloadAssetDataEx(const Asset& Asset, csp::common::CancellationToken& CancellationToken, AssetDataResultCallback Callback);
 
+	/// @brief Downloads data for a given Asset from CHS straight to a file, without holding the data in memory.
+	/// The file is created at its full size before the download starts, and the data is written into it as it is received.
+	/// Large assets are downloaded as several ranges in parallel, if the server supports range requests.
+	/// If the download fails or is cancelled, the file is removed.
+	/// @param Asset Asset : asset to download data for
+	/// @param FilePath csp::common::String : path of the file to write the data to. Any existing file is replaced.
+	/// @param CancellationToken csp::common::CancellationToken : token for cancelling download
+	/// @param Callback UInt64ResultCallback : callback when asynchronous task finishes, giving the number of bytes written
+	CSP_ASYNC_RESULT void DownloadAssetDataToFile(const Asset& Asset,
+												  const csp::common::String& FilePath,
+												  csp::common::CancellationToken& CancellationToken,
+												  UInt64ResultCallback Callback);
+
+	CSP_START_IGNORE
+	/// @brief Downloads data for a given Asset from CHS straight into a buffer provided by the caller.
+	/// Large assets are downloaded as several ranges in parallel, if the server supports range requests.
+	/// Fails with an HTTP response code of 413 (Request Entity Too Large) if the data doesn't fit in the buffer.
+	/// @param Asset Asset : asset to download data for
+	/// @param Buffer void* : buffer to write the data to. It must remain valid until Callback is called with a final result.
+	/// @param BufferSize size_t : size of Buffer in bytes
+	/// @param CancellationToken csp::common::CancellationToken : token for cancelling download
+	/// @param Callback UInt64ResultCallback : callback when asynchronous task finishes, giving the number of bytes written
+	void DownloadAssetDataToBuffer(const Asset& Asset,
+								   void* Buffer,
+								   size_t BufferSize,
+								   csp::common::CancellationToken& CancellationToken,
+								   UInt64ResultCallback Callback);
+
+	/// @brief Downloads data for a given Asset from CHS, passing it to ChunkCallback a piece at a time as it is received.
+	/// If the download has to be retried part way through, the data is passed again from offset 0.
+	/// @param Asset Asset : asset to download data for
+	/// @param ChunkCallback AssetDataChunkCallback : called with each piece of data, on a web client thread
+	/// @param CancellationToken csp::common::CancellationToken : token for cancelling download
+	/// @param Callback UInt64ResultCallback : callback when asynchronous task finishes, giving the number of bytes downloaded
+	void DownloadAssetDataInChunks(const Asset& Asset,
+								   AssetDataChunkCallback ChunkCallback,
+								   csp::common::CancellationToken& CancellationToken,
+								   UInt64ResultCallback Callback);
+
+	/// @brief Downloads the data of several assets as one batch, such as the assets needed to load a space.
+	/// Assets with the same Uri are only downloaded once. At most MaxConcurrentDownloads are in flight at once, and the next is started,
+	/// in priority order, as each one completes, so that a large batch doesn't hold up other requests.
+	/// @param Assets csp::common::Array<Asset> : assets to download data for
+	/// @param Priorities csp::common::Array<int32_t> : priority of the asset at each index. Higher priority assets are downloaded first,
+	/// and assets with the same priority in the order given. Assets without a priority, or all of them if the array is empty, have priority 0.
+	/// @param MaxConcurrentDownloads uint32_t : maximum number of downloads in flight at once
+	/// @param CancellationToken csp::common::CancellationToken : token for cancelling the downloads that haven't completed
+	/// @param ItemCallback AssetDataBatchItemCallback : called with the progress and result of each asset, on a web client thread
+	/// @param Callback AssetDataBatchResultCallback : callback once every asset has been given its result
+	void DownloadAssetDataBatch(const csp::common::Array<Asset>& Assets,
+								const csp::common::Array<int32_t>& Priorities,
+								uint32_t MaxConcurrentDownloads,
+								csp::common::CancellationToken& CancellationToken,
+								AssetDataBatchItemCallback ItemCallback,
+								AssetDataBatchResultCallback Callback);
+	CSP_END_IGNORE
+
 	/// @brief Get the size of the data associated with an Asset.
 	/// @param Asset Asset : asset to get data size for
 	/// @param Callback UInt64ResultCallback : callback when asynchronous task finishes
 	CSP_ASYNC_RESULT void GetAssetDataSize(const Asset& Asset, UInt64ResultCallback Callback);
 
+	/// @brief Enables a persistent on-disk cache of downloaded asset data, so that assets downloaded in a previous session are only
+	/// revalidated with the server rather than downloaded again. Cached data is reused for as long as the server reports it unchanged.
+	/// Not supported on WASM, where the browser's own HTTP cache is used instead.
+	/// @param Directory csp::common::String : directory to store cached asset data in. It is created if it doesn't exist.
+	/// @param MaxSizeBytes uint64_t : maximum total size of cached asset data. Least recently used data is removed first. 0 means unlimited.
+	/// @return bool : false if the cache could not be created in Directory.
+	bool EnableAssetDataCache(const csp::common::String& Directory, uint64_t MaxSizeBytes);
+
+	/// @brief Stops caching downloaded asset data. Data already cached is kept on disk for when the cache is next enabled.
+	void DisableAssetDataCache();
+
+	/// @brief Removes all cached asset data from disk.
+	void ClearAssetDataCache();
+
+	/// @brief Get the total size of the cached asset data, in bytes.
+	/// @return uint64_t : size of the cache, or 0 if caching isn't enabled.
+	uint64_t GetAssetDataCacheSize() const;
+
 	/// @brief Gets a LOD chain within the given AssetCollection.
+	/// Chains are cached, and only fetched again once the assets in the collection change.
 	/// @param AssetCollection AssetCollection : AssetCollection which contains the LOD chain.
 	/// @param Callback LODChainResultCallback : callback when asynchronous task finishes
 	CSP_ASYNC_RESULT void GetLODChain(const AssetCollection& AssetCollection, LODChainResultCallback Callback);
@@ -251,15 +343,45 @@ public:
 	CSP_ASYNC_RESULT_WITH_PROGRESS void
 		RegisterAssetToLODChain(const AssetCollection& AssetCollection, const Asset& Asset, int LODLevel, AssetResultCallback Callback);
 
+	CSP_START_IGNORE
+	/// @brief Downloads the data of every level of a LOD chain, starting with the coarsest, so that something can be shown as soon as
+	/// possible. Finer levels are then downloaded one at a time in the background, at no more than MaxBytesPerSecond on average, and each
+	/// can replace the one before it as it arrives.
+	/// @param Chain LODChain : chain to download the levels of, such as one from GetLODChain
+	/// @param MaxBytesPerSecond uint64_t : bandwidth budget for the whole chain. 0 means unlimited.
+	/// @param CancellationToken csp::common::CancellationToken : token for stopping the prefetch before the next level. It must remain
+	/// valid until Callback is called.
+	/// @param LevelCallback LODAssetDataCallback : called with the progress and result of each level, coarsest first, on a web client thread
+	/// @param Callback NullResultCallback : callback once every level has been downloaded, or the prefetch has been cancelled. Fails if any
+	/// level couldn't be downloaded.
+	void PrefetchLODChain(const LODChain& Chain,
+						  uint64_t MaxBytesPerSecond,
+						  csp::common::CancellationToken& CancellationToken,
+						  LODAssetDataCallback LevelCallback,
+						  NullResultCallback Callback);
+	CSP_END_IGNORE
+
 private:
 	AssetSystem(); // This constructor is only provided to appease the wrapper generator and should not be used
 	CSP_NO_EXPORT AssetSystem(csp::web::WebClient* InWebClient);
 	~AssetSystem();
 
+	CSP_START_IGNORE
+	void DownloadAssetDataToSink(const Asset& Asset,
+								 const std::shared_ptr<csp::web::IHttpResponseSink>& Sink,
+								 bool InRanges,
+								 csp::common::CancellationToken& CancellationToken,
+								 UInt64ResultCallback Callback);
+	CSP_END_IGNORE
+
 	csp::services::ApiBase* PrototypeAPI;
 	csp::services::ApiBase* AssetDetailAPI;
 
 	csp::web::RemoteFileManager* FileManager;
+
+	class AssetSystemLODStore* LODStore;
+	class LODChainCache* LODCache;
+	class AssetSystemEventHandler* EventHandler;
 };
 
 } // namespace csp::systems
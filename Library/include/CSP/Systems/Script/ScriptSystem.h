@@ -81,6 +81,8 @@ public:
 	bool BindContext(int64_t ContextId);
 	bool ResetContext(int64_t ContextId);
 	bool ExistsInContext(int64_t ContextId, const csp::common::String& ObjectName);
+	bool ResolveFunction(int64_t ContextId, const csp::common::String& FunctionName);
+	bool CallFunction(int64_t ContextId, const csp::common::String& FunctionName, const csp::common::String& Arg0, const csp::common::String& Arg1);
 	void* GetContext(int64_t ContextId);
 	void* GetModule(int64_t ContextId, const csp::common::String& ModuleName);
 	void RegisterScriptBinding(IScriptBinding* ScriptBinding);
@@ -60,6 +60,7 @@ class CSP_API SettingsSystem : public SystemBase
 	CSP_START_IGNORE
 	/** @cond DO_NOT_DOCUMENT */
 	friend class SystemsManager;
+	friend class SettingsSystemEventHandler;
 	friend void csp::memory::Delete<SettingsSystem>(SettingsSystem* Ptr);
 	/** @endcond */
 	CSP_END_IGNORE
@@ -149,6 +150,20 @@ public:
 	/// @param Callback NullResultCallback : Callback to call when task finishes.
 	CSP_ASYNC_RESULT void GetAvatarInfo(AvatarInfoResultCallback Callback);
 
+	/// @brief Keeps the current user's settings in a file as well as in memory, so that settings read in one session can be read
+	/// without a round trip to Magnopus Connected Services in the next.
+	/// Settings are always cached in memory once read or written, and are read again once they are fifteen minutes old.
+	/// @param FilePath csp::common::String : file to keep the settings in. It is created if it doesn't exist.
+	/// @return bool : false if the file exists but could not be read.
+	bool EnablePersistentSettingsCache(const csp::common::String& FilePath);
+
+	/// @brief Stops keeping settings in a file. The file is left as it is.
+	void DisablePersistentSettingsCache();
+
+	/// @brief Discards cached settings and avatar portrait URIs, so that they are read from Magnopus Connected Services next time.
+	/// Changes to settings that haven't been written yet are kept.
+	void ClearSettingsCache();
+
 private:
 	SettingsSystem(); // This constructor is only provided to appease the wrapper generator and should not be used
 	CSP_NO_EXPORT SettingsSystem(csp::web::WebClient* InWebClient);
@@ -161,6 +176,9 @@ private:
 	void GetSettingValue(const csp::common::String& InContext, const csp::common::String& InKey, StringResultCallback Callback) const;
 
 	csp::services::ApiBase* SettingsAPI;
+	class SettingsServiceStore* Store;
+	class SettingsCache* Cache;
+	class SettingsSystemEventHandler* EventHandler;
 
 	void AddAvatarPortrait(const csp::systems::FileAssetDataSource& ImageDataSource, NullResultCallback Callback);
 	void AddAvatarPortraitWithBuffer(const csp::systems::BufferAssetDataSource& ImageDataSource, NullResultCallback Callback);
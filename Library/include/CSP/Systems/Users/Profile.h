@@ -101,6 +101,8 @@ public:
 	csp::common::Array<BasicProfile>& GetProfiles();
 	const csp::common::Array<BasicProfile>& GetProfiles() const;
 
+	CSP_NO_EXPORT BasicProfilesResult(csp::systems::EResultCode ResCode, uint16_t HttpResCode) : csp::systems::ResultBase(ResCode, HttpResCode) {};
+
 private:
 	BasicProfilesResult(void*) {};
 
@@ -220,6 +220,7 @@ public:
 	CSP_ASYNC_RESULT void GetProfilesByUserId(const csp::common::Array<csp::common::String>& InUserIds, BasicProfilesResultCallback Callback);
 
 	/// @brief Get a list of minimal profiles (avatarId, personalityType, userName, and platform) by user IDs.
+	/// Profiles are cached for five minutes, and requests made at around the same time are sent to Magnopus Connected Services together.
 	/// @param InUserIds csp::common::Array<csp::common::String> : an array of user IDs to search for users by
 	/// @param Callback BasicProfilesResultCallback : callback to call when a response is received
 	CSP_ASYNC_RESULT void GetBasicProfilesByUserId(const csp::common::Array<csp::common::String>& InUserIds, BasicProfilesResultCallback Callback);
@@ -270,6 +271,9 @@ private:
 	csp::services::ApiBase* ExternalServiceProxyApi;
 	csp::services::ApiBase* StripeAPI;
 
+	class UserServiceProfileStore* ProfileStore;
+	class ProfileCache* BasicProfileCache;
+
 	LoginState CurrentLoginState;
 
 	LoginTokenInfoResultCallback RefreshTokenChangedCallback;
@@ -19,11 +19,14 @@
 #include "CSP/Common/StringFormat.h"
 #include "CSP/Systems/SystemsManager.h"
 #include "CSP/version.h"
+#include "Common/Scheduler.h"
 #include "Common/UUIDGenerator.h"
 #include "Common/Wrappers.h"
 #include "Debug/Logging.h"
 #include "Events/EventSystem.h"
+#include "Web/WebClient.h"
 
+#include <algorithm>
 #include <cstdio>
 
 #if defined(DEBUG)
@@ -235,6 +238,7 @@ ClientUserAgent* CSPFoundation::ClientUserAgentInfo		  = nullptr;
 csp::common::String* CSPFoundation::DeviceId			  = nullptr;
 csp::common::String* CSPFoundation::ClientUserAgentString = nullptr;
 csp::common::String* CSPFoundation::Tenant				  = nullptr;
+uint32_t CSPFoundation::MaxConcurrentWebRequests		  = csp::web::CSP_MAX_CONCURRENT_REQUESTS;
 
 bool CSPFoundation::Initialise(const csp::common::String& EndpointRootURI, const csp::common::String& InTenant)
 {
@@ -272,6 +276,9 @@ bool CSPFoundation::Initialise(const csp::common::String& EndpointRootURI, const
 	Endpoints->AggregationServiceURI = CSP_TEXT(AggregationServiceURI.c_str());
 	Endpoints->TrackingServiceURI	 = CSP_TEXT(TrackingServiceURI.c_str());
 
+	// Created up front, rather than by whichever system first schedules something, and destroyed once the systems are
+	csp::GetScheduler();
+
 	csp::systems::SystemsManager::Instantiate();
 
 	*DeviceId	  = LoadDeviceId().c_str();
@@ -305,6 +312,8 @@ bool CSPFoundation::Shutdown()
 	csp::events::EventSystem::Get().UnRegisterAllListeners();
 	csp::systems::SystemsManager::Destroy();
 
+	csp::DestroyScheduler();
+
 	CSP_DELETE(Tenant);
 	CSP_DELETE(Endpoints);
 	CSP_DELETE(ClientUserAgentInfo);
@@ -323,6 +332,8 @@ void CSPFoundation::Tick()
 
 	CSP_PROFILE_SCOPED();
 
+	// The event system reuses processed events, so after the first frame this takes the previous frame's tick event from the pool
+	// rather than allocating
 	csp::events::Event* TickEvent = csp::events::EventSystem::Get().AllocateEvent(csp::events::FOUNDATION_TICK_EVENT_ID);
 	csp::events::EventSystem::Get().EnqueueEvent(TickEvent);
 
@@ -401,6 +412,21 @@ void CSPFoundation::SetClientUserAgentInfo(const csp::ClientUserAgent& ClientUse
 													   GetClientUserAgentInfo().ClientOS.c_str());
 }
 
+void CSPFoundation::SetMaxConcurrentWebRequests(uint32_t MaxConcurrentRequests)
+{
+	if (IsInitialised)
+	{
+		CSP_LOG_WARN_MSG("SetMaxConcurrentWebRequests was called after Initialise, so will only take effect the next time Foundation is initialised");
+	}
+
+	MaxConcurrentWebRequests = std::max(MaxConcurrentRequests, 1u);
+}
+
+uint32_t CSPFoundation::GetMaxConcurrentWebRequests()
+{
+	return MaxConcurrentWebRequests;
+}
+
 
 void Free(void* Pointer)
 {
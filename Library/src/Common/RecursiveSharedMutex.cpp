@@ -0,0 +1,178 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Common/RecursiveSharedMutex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+
+// How many times the current thread holds each RecursiveSharedMutex shared. Entries are removed when the count reaches zero, so this
+// only ever holds the handful of mutexes the thread is currently inside.
+thread_local std::vector<std::pair<const csp::RecursiveSharedMutex*, uint32_t>> SharedLockDepths;
+
+std::pair<const csp::RecursiveSharedMutex*, uint32_t>* FindSharedLockDepth(const csp::RecursiveSharedMutex* Mutex)
+{
+	auto It = std::find_if(SharedLockDepths.begin(),
+						   SharedLockDepths.end(),
+						   [Mutex](const auto& Entry)
+						   {
+							   return Entry.first == Mutex;
+						   });
+
+	return It != SharedLockDepths.end() ? &*It : nullptr;
+}
+
+} // namespace
+
+
+namespace csp
+{
+
+RecursiveSharedMutex::RecursiveSharedMutex() : NumReaders(0), NumWaitingWriters(0), IsWriterActive(false), OwnerDepth(0)
+{
+}
+
+void RecursiveSharedMutex::lock()
+{
+	if (IsOwnedByThisThread())
+	{
+		++OwnerDepth;
+
+		return;
+	}
+
+	// Waiting here would wait on our own shared lock forever, so fail the way std::mutex does when it detects a deadlock, in all builds
+	if (FindSharedLockDepth(this) != nullptr)
+	{
+		throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur),
+								"A shared lock on a RecursiveSharedMutex can't be upgraded to an exclusive lock");
+	}
+
+	std::unique_lock<std::mutex> Lock(StateMutex);
+
+	++NumWaitingWriters;
+
+	WritersCond.wait(Lock,
+					 [this]
+					 {
+						 return !IsWriterActive && NumReaders == 0;
+					 });
+
+	--NumWaitingWriters;
+	IsWriterActive = true;
+
+	Owner	   = std::this_thread::get_id();
+	OwnerDepth = 1;
+}
+
+void RecursiveSharedMutex::unlock()
+{
+	assert(IsOwnedByThisThread());
+
+	if (--OwnerDepth > 0)
+	{
+		return;
+	}
+
+	Owner = std::thread::id();
+
+	{
+		std::scoped_lock Lock(StateMutex);
+		IsWriterActive = false;
+	}
+
+	// Wake everyone; readers will go back to waiting if another writer is queued
+	WritersCond.notify_one();
+	ReadersCond.notify_all();
+}
+
+void RecursiveSharedMutex::lock_shared()
+{
+	// Reading while holding the exclusive lock is just another level of the exclusive lock
+	if (IsOwnedByThisThread())
+	{
+		++OwnerDepth;
+
+		return;
+	}
+
+	if (auto* Depth = FindSharedLockDepth(this))
+	{
+		// Already reading, so we mustn't wait behind a queued writer, which would itself be waiting on us
+		++Depth->second;
+
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> Lock(StateMutex);
+
+		ReadersCond.wait(Lock,
+						 [this]
+						 {
+							 return !IsWriterActive && NumWaitingWriters == 0;
+						 });
+
+		++NumReaders;
+	}
+
+	SharedLockDepths.emplace_back(this, 1);
+}
+
+void RecursiveSharedMutex::unlock_shared()
+{
+	if (IsOwnedByThisThread())
+	{
+		unlock();
+
+		return;
+	}
+
+	auto* Depth = FindSharedLockDepth(this);
+	assert(Depth != nullptr);
+
+	if (--Depth->second > 0)
+	{
+		return;
+	}
+
+	SharedLockDepths.erase(SharedLockDepths.begin() + (Depth - SharedLockDepths.data()));
+
+	bool WakeWriter;
+
+	{
+		std::scoped_lock Lock(StateMutex);
+		WakeWriter = --NumReaders == 0 && NumWaitingWriters > 0;
+	}
+
+	if (WakeWriter)
+	{
+		WritersCond.notify_one();
+	}
+}
+
+bool RecursiveSharedMutex::IsOwnedByThisThread() const
+{
+	return Owner.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+} // namespace csp
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+
+namespace csp
+{
+
+/// @brief Reader/writer mutex that can be locked recursively, for use with std::scoped_lock/std::unique_lock (exclusive) and
+/// std::shared_lock (shared).
+/// A thread holding the exclusive lock may lock it again, exclusively or shared. A thread holding a shared lock may lock it shared again,
+/// even while a writer is waiting, but can't lock it exclusively, as that would wait on itself forever. Trying to do so throws
+/// std::system_error with std::errc::resource_deadlock_would_occur.
+/// Waiting writers take priority over new readers, so that a steady stream of readers can't starve them.
+class RecursiveSharedMutex
+{
+public:
+	RecursiveSharedMutex();
+	RecursiveSharedMutex(const RecursiveSharedMutex&) = delete;
+
+	void lock();
+	void unlock();
+
+	void lock_shared();
+	void unlock_shared();
+
+private:
+	bool IsOwnedByThisThread() const;
+
+	std::mutex StateMutex;
+	std::condition_variable ReadersCond;
+	std::condition_variable WritersCond;
+
+	uint32_t NumReaders;
+	uint32_t NumWaitingWriters;
+	bool IsWriterActive;
+
+	std::atomic<std::thread::id> Owner;
+	uint32_t OwnerDepth;
+};
+
+} // namespace csp
@@ -15,26 +15,326 @@
  */
 #include "Common/Scheduler.h"
 
+#include "Common/WorkStealingExecutor.h"
+#include "Memory/Memory.h"
+
+#include <assert.h>
+
+
 namespace csp
 {
 
-static Scheduler* SchedulerPtr = nullptr;
+static std::atomic<Scheduler*> SchedulerPtr = nullptr;
+static std::mutex SchedulerMutex;
 
 Scheduler* GetScheduler()
 {
-	if (SchedulerPtr == nullptr)
+	Scheduler* Instance = SchedulerPtr.load(std::memory_order_acquire);
+
+	if (Instance != nullptr)
 	{
-		SchedulerPtr = CSP_NEW Scheduler();
-		SchedulerPtr->Initialise();
+		return Instance;
 	}
 
-	return SchedulerPtr;
+	// Foundation creates the scheduler when it is initialised, so this only creates it for code running outside of Foundation
+	std::scoped_lock Lock(SchedulerMutex);
+
+	Instance = SchedulerPtr.load(std::memory_order_relaxed);
+
+	if (Instance == nullptr)
+	{
+		Instance = CSP_NEW Scheduler();
+		Instance->Initialise();
+
+		SchedulerPtr.store(Instance, std::memory_order_release);
+	}
+
+	return Instance;
 }
 
 void DestroyScheduler()
 {
-	CSP_DELETE(SchedulerPtr);
-	SchedulerPtr = nullptr;
+	Scheduler* Instance = SchedulerPtr.load(std::memory_order_acquire);
+
+	if (Instance == nullptr)
+	{
+		return;
+	}
+
+	// Shut down before clearing the pointer, so that functions still running can reach the scheduler while we wait for them,
+	// and have any timers they add rejected rather than creating a new scheduler
+	Instance->Shutdown();
+
+	{
+		std::scoped_lock Lock(SchedulerMutex);
+		SchedulerPtr.store(nullptr, std::memory_order_release);
+	}
+
+	CSP_DELETE(Instance);
+}
+
+
+Scheduler::Scheduler(size_t InNumWorkers)
+	: Thread(nullptr), NumWorkers(InNumWorkers), Executor(nullptr), IdCounter(1), ShouldExit(false)
+{
+}
+
+Scheduler::~Scheduler()
+{
+	Shutdown();
+}
+
+void Scheduler::Initialise()
+{
+	assert(Thread == nullptr);
+
+	ShouldExit = false;
+	Executor   = CSP_NEW WorkStealingExecutor(NumWorkers);
+	Thread	   = CSP_NEW std::thread(
+		[this]()
+		{
+			ThreadLoop();
+		});
+}
+
+void Scheduler::Shutdown()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	{
+		std::scoped_lock Lock(Mutex);
+		ShouldExit = true;
+		Timers.clear();
+		TimerPositions.clear();
+	}
+
+	WakeUp.notify_all();
+	Thread->join();
+	CSP_DELETE(Thread);
+	Thread = nullptr;
+
+	Executor->Shutdown();
+	CSP_DELETE(Executor);
+	Executor = nullptr;
+}
+
+ScheduledTaskId Scheduler::ScheduleAt(const std::chrono::system_clock::time_point& Time, std::function<void()> Func)
+{
+	return ScheduleAfter(Time - std::chrono::system_clock::now(), std::move(Func));
+}
+
+ScheduledTaskId Scheduler::ScheduleAt(const csp::common::DateTime& Time, std::function<void()> Func)
+{
+	return ScheduleAt(Time.GetTimePoint(), std::move(Func));
+}
+
+ScheduledTaskId Scheduler::ScheduleAfter(Clock::duration Delay, std::function<void()> Func)
+{
+	return AddTimer(Clock::now() + Delay, Clock::duration::zero(), std::move(Func));
+}
+
+ScheduledTaskId Scheduler::ScheduleEvery(Clock::duration Interval, std::function<void()> Func)
+{
+	assert(Interval > Clock::duration::zero() && "Interval must be positive!");
+
+	return AddTimer(Clock::now() + Interval, Interval, std::move(Func));
+}
+
+bool Scheduler::CancelTask(ScheduledTaskId Id)
+{
+	std::scoped_lock Lock(Mutex);
+
+	const auto It = TimerPositions.find(Id);
+
+	if (It == TimerPositions.end())
+	{
+		return false;
+	}
+
+	// Removing the earliest timer only means the timer thread will wake up early and go back to sleep, so there's no need to notify it
+	PopTimer(It->second);
+
+	return true;
+}
+
+size_t Scheduler::GetNumPendingTasks() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Timers.size();
+}
+
+ScheduledTaskId Scheduler::AddTimer(Clock::time_point Deadline, Clock::duration Interval, std::function<void()>&& Func)
+{
+	const ScheduledTaskId Id = IdCounter++;
+	bool IsEarliest			 = false;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Once shut down there is no timer thread left to run the function
+		if (ShouldExit)
+		{
+			return InvalidScheduledTaskId;
+		}
+
+		PushTimer({Deadline, Id, Interval, std::make_shared<std::function<void()>>(std::move(Func))});
+		IsEarliest = Timers.front().Id == Id;
+	}
+
+	// The timer thread only needs waking if it is sleeping until a later deadline
+	if (IsEarliest)
+	{
+		WakeUp.notify_one();
+	}
+
+	return Id;
+}
+
+void Scheduler::ThreadLoop()
+{
+	std::vector<std::shared_ptr<std::function<void()>>> DueFuncs;
+	std::unique_lock Lock(Mutex);
+
+	while (!ShouldExit)
+	{
+		if (Timers.empty())
+		{
+			WakeUp.wait(Lock);
+
+			continue;
+		}
+
+		const auto Now = Clock::now();
+
+		if (Timers.front().Deadline > Now)
+		{
+			// wait_until holds on to the deadline while the lock is released, and the front timer can be popped in the meantime
+			const auto NextDeadline = Timers.front().Deadline;
+			WakeUp.wait_until(Lock, NextDeadline);
+
+			continue;
+		}
+
+		while (!Timers.empty() && Timers.front().Deadline <= Now)
+		{
+			Timer Due = PopTimer(0);
+			DueFuncs.push_back(Due.Func);
+
+			if (Due.Interval > Clock::duration::zero())
+			{
+				// Keep to the original schedule, skipping any firings we're too late for
+				const auto Missed = (Now - Due.Deadline) / Due.Interval;
+				Due.Deadline += Due.Interval * (Missed + 1);
+
+				PushTimer(std::move(Due));
+			}
+		}
+
+		Lock.unlock();
+
+		for (auto& Func : DueFuncs)
+		{
+			Executor->Enqueue(
+				[Func = std::move(Func)](void*) -> void*
+				{
+					(*Func)();
+
+					return nullptr;
+				},
+				ETaskPriority::High);
+		}
+
+		DueFuncs.clear();
+
+		Lock.lock();
+	}
+}
+
+void Scheduler::PushTimer(Timer&& NewTimer)
+{
+	TimerPositions[NewTimer.Id] = Timers.size();
+	Timers.push_back(std::move(NewTimer));
+
+	SiftUp(Timers.size() - 1);
+}
+
+Scheduler::Timer Scheduler::PopTimer(size_t Position)
+{
+	const size_t Last = Timers.size() - 1;
+
+	if (Position != Last)
+	{
+		SwapTimers(Position, Last);
+	}
+
+	Timer Removed = std::move(Timers.back());
+	Timers.pop_back();
+	TimerPositions.erase(Removed.Id);
+
+	// The timer moved into the gap may belong either above or below it
+	if (Position < Timers.size())
+	{
+		SiftUp(Position);
+		SiftDown(Position);
+	}
+
+	return Removed;
+}
+
+void Scheduler::SiftUp(size_t Position)
+{
+	while (Position > 0)
+	{
+		const size_t Parent = (Position - 1) / 2;
+
+		if (Timers[Parent].Deadline <= Timers[Position].Deadline)
+		{
+			break;
+		}
+
+		SwapTimers(Parent, Position);
+		Position = Parent;
+	}
+}
+
+void Scheduler::SiftDown(size_t Position)
+{
+	for (;;)
+	{
+		const size_t Left	= Position * 2 + 1;
+		const size_t Right	= Left + 1;
+		size_t Earliest		= Position;
+
+		if (Left < Timers.size() && Timers[Left].Deadline < Timers[Earliest].Deadline)
+		{
+			Earliest = Left;
+		}
+
+		if (Right < Timers.size() && Timers[Right].Deadline < Timers[Earliest].Deadline)
+		{
+			Earliest = Right;
+		}
+
+		if (Earliest == Position)
+		{
+			break;
+		}
+
+		SwapTimers(Position, Earliest);
+		Position = Earliest;
+	}
+}
+
+void Scheduler::SwapTimers(size_t A, size_t B)
+{
+	std::swap(Timers[A], Timers[B]);
+
+	TimerPositions[Timers[A].Id] = A;
+	TimerPositions[Timers[B].Id] = B;
 }
 
 } // namespace csp
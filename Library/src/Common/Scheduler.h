@@ -16,196 +16,93 @@
 #pragma once
 
 #include "Common/DateTime.h"
-#include "Memory/Memory.h"
-#include "Memory/StlAllocator.h"
 
-#include <assert.h>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
-#include <future>
-#include <list>
 #include <memory>
-#include <queue>
-#include <sstream>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 namespace csp
 {
 
-using ScheduledTaskId = uint32_t;
-
-struct FunctionTimer
-{
-	std::function<void()> Func;
-	std::chrono::system_clock::time_point Time;
-	ScheduledTaskId Id;
-
-	FunctionTimer()
-	{
-	}
-
-	FunctionTimer(std::function<void()>&& InFunc, const std::chrono::system_clock::time_point& InTime, ScheduledTaskId InId)
-		: Func(InFunc), Time(InTime), Id(InId)
-	{
-	}
-
-	bool operator<(const FunctionTimer& Rhs) const
-	{
-		return Time > Rhs.Time;
-	}
-
-	bool operator==(const FunctionTimer& Rhs) const
-	{
-		return Id == Rhs.Id;
-	}
+class WorkStealingExecutor;
 
-	void Get()
-	{
-		Func();
-	}
-
-	void operator()()
-	{
-		Func();
-	}
+using ScheduledTaskId = uint32_t;
 
-	uint32_t GetId() const
-	{
-		return Id;
-	}
-};
+/// @brief Returned in place of a task id when a timer can't be scheduled. Never the id of a real task.
+constexpr ScheduledTaskId InvalidScheduledTaskId = 0;
 
+/// @brief Runs functions at a given time, or repeatedly at a fixed interval.
+/// Pending timers are kept in a binary min-heap ordered by deadline, indexed by task id so that a timer can be cancelled in O(log n)
+/// wherever it is in the heap. A single timer thread sleeps on a condition variable until the earliest deadline, or until an earlier
+/// timer is added, and hands each due function to a fixed pool of worker threads, so slow functions don't delay other timers.
+/// All deadlines are tracked on the steady clock; times given on the system clock are converted when the timer is added.
 class Scheduler
 {
 public:
-	Scheduler() : Thread(nullptr), IdCounter(1), ShouldExit(false)
-	{
-	}
-
-	~Scheduler()
-	{
-		Shutdown();
-	}
-
-	void Initialise()
-	{
-		assert(Thread == nullptr);
-		ShouldExit = false;
-		Thread	   = CSP_NEW std::thread(
-			[this]()
-			{
-				ThreadLoop();
-			});
-	}
-
-	void Shutdown()
-	{
-		if (Thread != nullptr)
-		{
-			ShouldExit = true;
-			Thread->join();
-			CSP_DELETE(Thread);
-			Thread = nullptr;
-		}
-	}
-
-	ScheduledTaskId ScheduleAt(const std::chrono::system_clock::time_point& Time, std::function<void()> Func)
-	{
-		std::function<void()> threadFunc = [Func]()
-		{
-			std::thread Thread(Func);
-			Thread.detach();
-		};
+	using Clock = std::chrono::steady_clock;
 
-		return ScheduleAtIntern(Time, std::move(threadFunc));
-	}
+	/// @param InNumWorkers Number of worker threads that scheduled functions run on.
+	explicit Scheduler(size_t InNumWorkers = 2);
+	~Scheduler();
 
-	void ScheduleEvery(std::chrono::system_clock::duration Interval, std::function<void()> Func)
-	{
-		std::function<void()> threadFunc = [Func]()
-		{
-			std::thread Thread(Func);
-			Thread.detach();
-		};
+	void Initialise();
 
-		this->ScheduleEveryIntern(Interval, threadFunc);
-	}
+	/// @brief Stops the timer thread, discarding any pending timers, then waits for functions that are already running to finish.
+	/// Timers added after Shutdown are rejected, and InvalidScheduledTaskId is returned for them.
+	void Shutdown();
 
-	ScheduledTaskId ScheduleAt(const csp::common::DateTime& Time, std::function<void()> Func)
-	{
-		return ScheduleAt(Time.GetTimePoint(), std::move(Func));
-	}
+	ScheduledTaskId ScheduleAt(const std::chrono::system_clock::time_point& Time, std::function<void()> Func);
+	ScheduledTaskId ScheduleAt(const csp::common::DateTime& Time, std::function<void()> Func);
+	ScheduledTaskId ScheduleAfter(Clock::duration Delay, std::function<void()> Func);
 
-	void CancelTask(ScheduledTaskId Id)
-	{
-		std::scoped_lock<std::mutex> ListLocker(ListLock);
+	/// @brief Runs Func every Interval, starting one Interval from now, until the returned task is cancelled.
+	/// Firings are a fixed Interval apart rather than Interval after the previous call finished. If the scheduler falls behind, missed
+	/// firings are skipped rather than run back to back.
+	ScheduledTaskId ScheduleEvery(Clock::duration Interval, std::function<void()> Func);
 
-		auto it = std::remove_if(Tasks.begin(),
-								 Tasks.end(),
-								 [Id](const FunctionTimer& Func)
-								 {
-									 return Func.Id == Id;
-								 });
+	/// @brief Removes a pending timer. A function that has already been handed to a worker still runs.
+	/// Returns false if there was no pending timer with this id.
+	bool CancelTask(ScheduledTaskId Id);
 
-		Tasks.erase(it, Tasks.end());
-	}
+	size_t GetNumPendingTasks() const;
 
 private:
-	ScheduledTaskId ScheduleAtIntern(const std::chrono::system_clock::time_point& Time, std::function<void()>&& Func)
-	{
-		ScheduledTaskId Id = IdCounter++;
-
-		{
-			std::scoped_lock<std::mutex> ListLocker(ListLock);
-			Tasks.push_back(FunctionTimer(std::move(Func), Time, Id));
-			Tasks.sort();
-		}
-
-		return Id;
-	}
-
-	void ScheduleEveryIntern(std::chrono::system_clock::duration Interval, std::function<void()> Func)
-	{
-		std::function<void()> waitFunc = [this, Interval, Func]()
-		{
-			Func();
-			this->ScheduleEveryIntern(Interval, Func);
-		};
+	struct Timer
+	{
+		Clock::time_point Deadline;
+		ScheduledTaskId Id;
+		// Zero for one-off timers
+		Clock::duration Interval;
+		// Shared, so that repeating timers don't copy their function every time they fire
+		std::shared_ptr<std::function<void()>> Func;
+	};
+
+	ScheduledTaskId AddTimer(Clock::time_point Deadline, Clock::duration Interval, std::function<void()>&& Func);
+	void ThreadLoop();
+
+	// Heap operations. These all expect Mutex to be held.
+	void PushTimer(Timer&& NewTimer);
+	Timer PopTimer(size_t Position);
+	void SiftUp(size_t Position);
+	void SiftDown(size_t Position);
+	void SwapTimers(size_t A, size_t B);
+
+	std::vector<Timer> Timers;
+	std::unordered_map<ScheduledTaskId, size_t> TimerPositions;
+	mutable std::mutex Mutex;
+	std::condition_variable WakeUp;
 
-		ScheduleAtIntern(std::chrono::system_clock::now() + Interval, std::move(waitFunc));
-	}
-
-	void ThreadLoop()
-	{
-		while (!ShouldExit)
-		{
-			{
-				std::scoped_lock<std::mutex> ListLocker(ListLock);
-
-				auto now = std::chrono::system_clock::now();
-
-				if (Tasks.size() > 0 && Tasks.front().Time <= now)
-				{
-					FunctionTimer Func;
-
-					{
-						Func = Tasks.front();
-						Tasks.pop_front();
-					}
-
-					Func.Get();
-				}
-			}
-
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		}
-	}
-
-private:
-	std::mutex ListLock;
-	std::list<FunctionTimer, csp::memory::StlAllocator<FunctionTimer>> Tasks;
 	std::thread* Thread;
+	size_t NumWorkers;
+	WorkStealingExecutor* Executor;
 	std::atomic_uint32_t IdCounter;
 	bool ShouldExit;
 
@@ -213,7 +110,10 @@ private:
 	Scheduler(const Scheduler& Rhs)			   = delete;
 };
 
+/// @brief Returns the shared scheduler, creating it if it doesn't exist yet. Safe to call from any thread.
 Scheduler* GetScheduler();
+
+/// @brief Stops and destroys the shared scheduler. Called by CSPFoundation::Shutdown once the systems using it have been destroyed.
 void DestroyScheduler();
 
 } // namespace csp
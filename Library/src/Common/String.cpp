@@ -20,241 +20,229 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 
 
 namespace csp::common
 {
 
-/**
-		Custom string class that we can use safely across a DLL boundary
- */
-
-/// @brief Internal implementation for DLL safe string class
+/// @brief Internal implementation for DLL safe string class.
+/// The characters follow the Impl in the same allocation.
 class String::Impl
 {
 public:
-	~Impl()
-	{
-		CSP_DELETE_ARRAY(Text);
-	}
-
-	explicit Impl(char const* const InText) : Text(nullptr), Length(0)
+	static Impl* Create(size_t Capacity)
 	{
-		const char* _InText = InText;
-
-		if (InText == nullptr)
-		{
-			_InText = "";
-		}
-
-		const size_t Len = strlen(_InText);
-
-		char* NewText = CSP_NEW char[Len + 1];
+		Impl* NewImpl	  = static_cast<Impl*>(CSP_ALLOC(sizeof(Impl) + Capacity + 1));
+		NewImpl->Length	  = 0;
+		NewImpl->Capacity = Capacity;
 
-		if (Len > 0)
-		{
-			memcpy((void*) NewText, _InText, Len * sizeof(char));
-		}
-
-		NewText[Len] = 0;
-
-		Text   = NewText;
-		Length = Len;
+		return NewImpl;
 	}
 
-	Impl(char const* const InText, size_t Len) : Text(nullptr), Length(0)
+	static void Destroy(Impl* InImpl)
 	{
-		const char* _InText = InText;
-
-		if (InText == nullptr || Len == 0)
-		{
-			_InText = "";
-			Len		= 0;
-		}
-
-		char* NewText = CSP_NEW char[Len + 1];
-
-		if (Len > 0)
+		if (InImpl != GetEmpty())
 		{
-			memcpy((void*) NewText, _InText, Len * sizeof(char));
+			CSP_FREE(InImpl);
 		}
-
-		NewText[Len] = 0;
-
-		Text   = NewText;
-		Length = Len;
 	}
 
-	explicit Impl(size_t Len) : Text(nullptr), Length(0)
+	// Shared by every empty string, so that they don't allocate. Its capacity is 0, so it is never written to.
+	static Impl* GetEmpty()
 	{
-		char* NewText = CSP_NEW char[Len + 1];
-
-#if DEBUG
-		if (Len > 0)
+		static struct
 		{
-			memset((void*) NewText, 0, sizeof(NewText));
-		}
-#endif
+			Impl Header;
+			char Terminator;
+		} Empty = {{0, 0}, '\0'};
 
-		NewText[Len] = 0;
-		Text		 = NewText;
-		Length		 = Len;
+		return &Empty.Header;
 	}
 
-	Impl* Clone() const
+	char* GetText()
 	{
-		return CSP_NEW Impl(Text, Length);
+		return reinterpret_cast<char*>(this + 1);
 	}
 
-	inline void Append(const char* Other, size_t OtherLength)
-	{
-		if (Other == nullptr || OtherLength == 0)
-		{
-			return;
-		}
+	size_t Length;
+	// Number of characters the buffer can hold, not including the terminator
+	size_t Capacity;
+};
 
-		auto NewLength = Length + OtherLength;
-		auto NewText   = CSP_NEW char[NewLength + 1];
-		memcpy(NewText, Text, Length);
-		memcpy(NewText + Length, Other, OtherLength);
-		NewText[NewLength] = '\0';
 
-		CSP_DELETE_ARRAY(Text);
-		Text   = NewText;
-		Length = NewLength;
-	}
+String::String() : ImplPtr(Impl::GetEmpty())
+{
+}
 
-	void Append(const Impl& Other)
+String::String(char const* const Text, size_t Length) : ImplPtr(Impl::GetEmpty())
+{
+	if (Text != nullptr && Length > 0)
 	{
-		Append(Other.Text, Other.Length);
+		memcpy(Resize(Length), Text, Length);
 	}
+}
 
-	void Append(const char* Other)
-	{
-		if (Other == nullptr)
-		{
-			return;
-		}
-
-		auto OtherLength = strlen(Other);
-		Append(Other, OtherLength);
-	}
-
-	List<String> Split(char Separator)
-	{
-		List<String> Parts;
-
-		// NOTE: Don't use strtok here because it ignores empty entries!
-		auto Index = strchr(Text, Separator);
-
-		if (Index == nullptr)
-		{
-			Parts.Append(Text);
-
-			return Parts;
-		}
-
-		auto Start = Text;
+String::String(size_t Length) : ImplPtr(Impl::GetEmpty())
+{
+	Resize(Length);
 
-		for (;;)
-		{
-			Parts.Append(String(Start, Index - Start));
-			Start = Index + 1;
-			Index = strchr(Start, Separator);
-
-			// Also look for null-terminator
-			if (Index == nullptr)
-			{
-				Index = strchr(Start, '\0');
-				Parts.Append(String(Start, Index - Start));
-				break;
-			}
-		}
+#if DEBUG
+	memset(GetMutable(), 0, Length);
+#endif
+}
 
-		return Parts;
-	}
+String::String(const char* Text) : String(Text, Text != nullptr ? strlen(Text) : 0)
+{
+}
 
-	char* Text;
-	size_t Length;
-};
+String::String(String const& Other) : String(Other.Get(), Other.Length())
+{
+}
 
+String::String(String&& Other) : ImplPtr(Impl::GetEmpty())
+{
+	MoveFrom(Other);
+}
 
-String::String() : ImplPtr(CSP_NEW Impl(""))
+String::~String()
 {
+	Release();
 }
 
-String::String(char const* const Text, size_t Length) : ImplPtr(CSP_NEW Impl(Text, Length))
+const char* String::Get() const
 {
+	return ImplPtr->GetText();
 }
 
-String::String(size_t Length) : ImplPtr(CSP_NEW Impl(Length))
+char* String::GetMutable()
 {
+	return ImplPtr->GetText();
 }
 
-String::String(const char* Text) : ImplPtr(CSP_NEW Impl(Text))
+char* String::Resize(size_t NewLength)
 {
+	if (NewLength == 0)
+	{
+		Release();
+
+		return GetMutable();
+	}
+
+	// Reuse the existing buffer if it is large enough
+	if (ImplPtr->Capacity < NewLength)
+	{
+		Release();
+		ImplPtr = Impl::Create(NewLength);
+	}
+
+	char* Text		= ImplPtr->GetText();
+	ImplPtr->Length = NewLength;
+	Text[NewLength] = '\0';
+
+	return Text;
 }
 
-String::String(String const& Other) : ImplPtr(Other.ImplPtr->Clone())
+void String::Release()
 {
+	Impl::Destroy(ImplPtr);
+	ImplPtr = Impl::GetEmpty();
 }
 
-String::String(String&& Other)
+void String::MoveFrom(String& Other)
 {
 	ImplPtr		  = Other.ImplPtr;
-	Other.ImplPtr = nullptr;
+	Other.ImplPtr = Impl::GetEmpty();
 }
 
 List<String> String::Split(char Separator) const
 {
-	return ImplPtr->Split(Separator);
+	List<String> Parts;
+
+	const char* Text = Get();
+
+	// NOTE: Don't use strtok here because it ignores empty entries!
+	auto Index = strchr(Text, Separator);
+
+	if (Index == nullptr)
+	{
+		Parts.Append(*this);
+
+		return Parts;
+	}
+
+	auto Start = Text;
+
+	for (;;)
+	{
+		Parts.Append(String(Start, Index - Start));
+		Start = Index + 1;
+		Index = strchr(Start, Separator);
+
+		// Also look for null-terminator
+		if (Index == nullptr)
+		{
+			Index = strchr(Start, '\0');
+			Parts.Append(String(Start, Index - Start));
+			break;
+		}
+	}
+
+	return Parts;
 }
 
 String& String::swap(String& Other)
 {
-	std::swap(ImplPtr, Other.ImplPtr);
+	String Temp(std::move(Other));
+	Other.MoveFrom(*this);
+	MoveFrom(Temp);
+
 	return *this;
 }
 
 String& String::operator=(const String& Rhs)
 {
-	if (ImplPtr != nullptr)
+	if (this != &Rhs)
 	{
-		CSP_DELETE(ImplPtr);
+		const size_t Length = Rhs.Length();
+		memcpy(Resize(Length), Rhs.Get(), Length);
 	}
 
-	ImplPtr = Rhs.ImplPtr->Clone();
 	return *this;
 }
 
 String& String::operator=(String&& Rhs)
 {
-	if (ImplPtr != nullptr)
+	if (this != &Rhs)
 	{
-		CSP_DELETE(ImplPtr);
+		Release();
+		MoveFrom(Rhs);
 	}
 
-	ImplPtr		= Rhs.ImplPtr;
-	Rhs.ImplPtr = nullptr;
 	return *this;
 }
 
 String& String::operator=(char const* const Text)
 {
-	if (ImplPtr != nullptr)
+	const size_t Length = Text != nullptr ? strlen(Text) : 0;
+
+	if (Length == 0)
+	{
+		Release();
+	}
+	else if (Text >= Get() && Text <= Get() + this->Length())
+	{
+		// Assigning part of this string to itself, so take a copy before the buffer is reused
+		*this = String(Text, Length);
+	}
+	else
 	{
-		CSP_DELETE(ImplPtr);
+		memcpy(Resize(Length), Text, Length);
 	}
 
-	ImplPtr = CSP_NEW Impl(Text);
 	return *this;
 }
 
-const char* String::Get() const
-{
-	return ImplPtr->Text;
-}
-
 size_t String::Length() const
 {
 	return ImplPtr->Length;
@@ -262,44 +250,28 @@ size_t String::Length() const
 
 size_t String::AllocatedMemorySize() const
 {
-	return ImplPtr->Length + 1;
+	return Length() + 1;
 }
 
 bool String::IsEmpty() const
 {
-	return ImplPtr->Length == 0;
+	return Length() == 0;
 }
 
 bool String::operator==(const String& Other) const
 {
-	if (ImplPtr->Length == 0 && Other.Length() == 0)
-	{
-		return true;
-	}
-
-	if (ImplPtr->Length == 0 || Other.Length() == 0)
-	{
-		return false;
-	}
-
-	return strcmp(Get(), Other.Get()) == 0;
+	return Length() == Other.Length() && memcmp(Get(), Other.Get(), Length()) == 0;
 }
 
 bool String::operator==(const char* Other) const
 {
-	auto OtherLength = strlen(Other);
-
-	if (ImplPtr->Length == 0 && OtherLength == 0)
-	{
-		return true;
-	}
-
-	if (ImplPtr->Length == 0 || OtherLength == 0)
+	if (Other == nullptr)
 	{
-		return false;
+		return IsEmpty();
 	}
 
-	return strcmp(Get(), Other) == 0;
+	// Compares all Length() characters, as the string may contain NULs that Other can't
+	return strlen(Other) == Length() && memcmp(Get(), Other, Length()) == 0;
 }
 
 bool String::operator!=(const String& Other) const
@@ -317,22 +289,55 @@ bool String::operator<(const String& Other) const
 	return strcmp(Get(), Other.Get()) < 0;
 }
 
-String::~String()
+void String::Append(const String& Other)
 {
-	if (ImplPtr != nullptr)
-	{
-		CSP_DELETE(ImplPtr);
-	}
+	Append(Other.Get(), Other.Length());
 }
 
-void String::Append(const String& Other)
+void String::Append(const char* Other)
 {
-	ImplPtr->Append(*Other.ImplPtr);
+	if (Other == nullptr)
+	{
+		return;
+	}
+
+	Append(Other, strlen(Other));
 }
 
-void String::Append(const char* Other)
+void String::Append(const char* Other, size_t OtherLength)
 {
-	ImplPtr->Append(Other);
+	if (OtherLength == 0)
+	{
+		return;
+	}
+
+	// Other may point into this string, so it's only read before the old buffer is released
+
+	const size_t OldLength = Length();
+	const size_t NewLength = OldLength + OtherLength;
+
+	if (ImplPtr->Capacity >= NewLength)
+	{
+		// Fits in the existing buffer
+		char* Text = GetMutable();
+		memcpy(Text + OldLength, Other, OtherLength);
+		Text[NewLength] = '\0';
+		ImplPtr->Length = NewLength;
+
+		return;
+	}
+
+	// Grow geometrically, so that building a string up by repeated appends doesn't reallocate every time
+	Impl* NewImpl = Impl::Create(std::max(NewLength, ImplPtr->Capacity * 2));
+	char* NewText = NewImpl->GetText();
+
+	memcpy(NewText, Get(), OldLength);
+	memcpy(NewText + OldLength, Other, OtherLength);
+	NewText[NewLength] = '\0';
+	NewImpl->Length	   = NewLength;
+
+	Release();
+	ImplPtr = NewImpl;
 }
 
 String& String::operator+=(const String& Other)
@@ -353,8 +358,8 @@ String String::Trim() const
 {
 	static char Whitespace[] = {' ', '\r', '\n', '\t'};
 
-	auto Length = ImplPtr->Length;
-	auto Text	= ImplPtr->Text;
+	auto Length = this->Length();
+	auto Text	= Get();
 
 	// Trim leading whitespace
 	while (Length > 0)
@@ -385,8 +390,8 @@ String String::Trim() const
 String String::ToLower() const
 {
 	String Copy = *this;
-	auto Length = Copy.ImplPtr->Length;
-	auto Text	= Copy.ImplPtr->Text;
+	auto Length = Copy.Length();
+	auto Text	= Copy.GetMutable();
 
 	for (int i = 0; i < Length; ++i)
 	{
@@ -420,7 +425,8 @@ String String::Join(const List<String>& Parts, Optional<char> Separator)
 		Length += Parts.Size() - 1;
 	}
 
-	auto Buffer = CSP_NEW char[Length + 1]();
+	String JoinedString(Length);
+	auto Buffer = JoinedString.GetMutable();
 	size_t Pos	= 0;
 
 	for (size_t i = 0; i < Parts.Size(); ++i)
@@ -441,11 +447,13 @@ String String::Join(const List<String>& Parts, Optional<char> Separator)
 		}
 	}
 
-	Buffer[Length] = '\0';
-
-	String JoinedString(Buffer);
+	// Empty parts are skipped, but their separators were counted, so the joined string may be shorter than expected
+	if (Pos < Length)
+	{
+		return String(Buffer, Pos);
+	}
 
-	CSP_DELETE_ARRAY(Buffer);
+	Buffer[Length] = '\0';
 
 	return JoinedString;
 }
@@ -474,7 +482,8 @@ String String::Join(const std::initializer_list<String>& Parts, Optional<char> S
 		Length += Parts.size() - 1;
 	}
 
-	auto Buffer = CSP_NEW char[Length + 1]();
+	String JoinedString(Length);
+	auto Buffer = JoinedString.GetMutable();
 	size_t Pos	= 0;
 
 	for (size_t i = 0; i < Parts.size(); ++i)
@@ -495,11 +504,13 @@ String String::Join(const std::initializer_list<String>& Parts, Optional<char> S
 		}
 	}
 
-	Buffer[Length] = '\0';
-
-	String JoinedString(Buffer);
+	// Empty parts are skipped, but their separators were counted, so the joined string may be shorter than expected
+	if (Pos < Length)
+	{
+		return String(Buffer, Pos);
+	}
 
-	CSP_DELETE_ARRAY(Buffer);
+	Buffer[Length] = '\0';
 
 	return JoinedString;
 }
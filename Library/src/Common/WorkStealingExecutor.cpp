@@ -0,0 +1,351 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Common/WorkStealingExecutor.h"
+
+
+namespace
+{
+
+// Number of slots in the timer wheel. With the default 10ms resolution one revolution covers ~5 seconds, which is longer than any
+// retry delay we currently use.
+constexpr size_t kTimerWheelSlots = 512;
+
+// Identifies the executor and worker the current thread belongs to, so that work enqueued from a task stays on the same worker
+thread_local const csp::WorkStealingExecutor* CurrentExecutor = nullptr;
+thread_local size_t CurrentWorkerIndex						  = 0;
+
+} // namespace
+
+
+namespace csp
+{
+
+WorkStealingExecutor::WorkStealingExecutor(size_t NumWorkers, std::chrono::milliseconds InTimerResolution)
+	: NextQueue(0)
+	, PendingTasks(0)
+	, SleepingWorkers(0)
+	, ShutdownFlag(false)
+	, Timers(kTimerWheelSlots)
+	, TimerResolution(std::max(InTimerResolution, std::chrono::milliseconds(1)))
+	, TimerShutdownFlag(false)
+{
+	NumWorkers = std::max<size_t>(NumWorkers, 1);
+
+	Queues.reserve(NumWorkers);
+
+	for (size_t i = 0; i < NumWorkers; ++i)
+	{
+		Queues.push_back(std::make_unique<WorkerQueues>());
+	}
+
+	Workers.reserve(NumWorkers);
+
+	for (size_t i = 0; i < NumWorkers; ++i)
+	{
+		Workers.emplace_back(
+			[this, i]()
+			{
+				WorkerLoop(i);
+			});
+	}
+
+	TimerThread = std::thread(
+		[this]()
+		{
+			TimerLoop();
+		});
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+	Shutdown();
+}
+
+void WorkStealingExecutor::Enqueue(Task Work)
+{
+	Enqueue(std::move(Work), ETaskPriority::Normal);
+}
+
+void WorkStealingExecutor::Enqueue(Task Work, ETaskPriority Priority)
+{
+	const size_t QueueIndex = (CurrentExecutor == this) ? CurrentWorkerIndex : (NextQueue++ % Queues.size());
+
+	Push(QueueIndex, std::move(Work), Priority);
+}
+
+void WorkStealingExecutor::EnqueueAfter(std::chrono::milliseconds Delay, Task Work, ETaskPriority Priority)
+{
+	if (Delay <= std::chrono::milliseconds(0))
+	{
+		Enqueue(std::move(Work), Priority);
+
+		return;
+	}
+
+	{
+		std::scoped_lock Lock(TimerMutex);
+
+		if (!TimerShutdownFlag)
+		{
+			// Round up, plus one tick as we may be part way through the current one
+			const uint64_t DelayTicks = (Delay.count() + TimerResolution.count() - 1) / TimerResolution.count() + 1;
+			Timers.Add(DelayTicks, {std::move(Work), Priority});
+			TimerCond.notify_one();
+
+			return;
+		}
+	}
+
+	// The timer thread has already stopped, so there's nothing left to wait on
+	Enqueue(std::move(Work), Priority);
+}
+
+void WorkStealingExecutor::Shutdown()
+{
+	if (TimerThread.joinable())
+	{
+		{
+			std::scoped_lock Lock(TimerMutex);
+			TimerShutdownFlag = true;
+		}
+
+		TimerCond.notify_all();
+		TimerThread.join();
+
+		// Anything still waiting on a timer is run now rather than dropped, as callers may be relying on it to complete
+		std::vector<DelayedTask> Remaining;
+
+		{
+			std::scoped_lock Lock(TimerMutex);
+			Timers.Drain(Remaining);
+		}
+
+		for (auto& Delayed : Remaining)
+		{
+			Enqueue(std::move(Delayed.Work), Delayed.Priority);
+		}
+	}
+
+	{
+		std::scoped_lock Lock(SleepMutex);
+		ShutdownFlag = true;
+	}
+
+	SleepCond.notify_all();
+
+	for (auto& Worker : Workers)
+	{
+		if (Worker.joinable())
+		{
+			Worker.join();
+		}
+	}
+}
+
+size_t WorkStealingExecutor::GetNumWorkers() const
+{
+	return Workers.size();
+}
+
+void WorkStealingExecutor::Push(size_t QueueIndex, Task&& Work, ETaskPriority Priority)
+{
+	auto& Queue = *Queues[QueueIndex];
+
+	{
+		std::scoped_lock Lock(Queue.Mutex);
+		Queue.Tasks[static_cast<size_t>(Priority)].push_back(std::move(Work));
+		++Queue.NumTasks;
+	}
+
+	++PendingTasks;
+
+	// Workers register as sleeping before checking PendingTasks, so either they will see this task or we will see them.
+	// Taking the lock before notifying ensures a worker can't be between its check and its wait when we notify.
+	if (SleepingWorkers > 0)
+	{
+		{
+			std::scoped_lock Lock(SleepMutex);
+		}
+
+		SleepCond.notify_one();
+	}
+}
+
+bool WorkStealingExecutor::TryPop(size_t WorkerIndex, Task& OutWork, bool& OutContended)
+{
+	const size_t NumQueues = Queues.size();
+
+	for (size_t Priority = 0; Priority < static_cast<size_t>(ETaskPriority::Num); ++Priority)
+	{
+		// Our own queue first, oldest task first
+		auto& Own = *Queues[WorkerIndex];
+
+		if (Own.NumTasks > 0)
+		{
+			std::scoped_lock Lock(Own.Mutex);
+
+			if (!Own.Tasks[Priority].empty())
+			{
+				OutWork = std::move(Own.Tasks[Priority].front());
+				Own.Tasks[Priority].pop_front();
+				--Own.NumTasks;
+				--PendingTasks;
+
+				return true;
+			}
+		}
+
+		// Then steal from the other end of everyone else's, so we contend with the owner as little as possible.
+		// Queues that are busy are skipped; they're being serviced by someone already.
+		for (size_t Offset = 1; Offset < NumQueues; ++Offset)
+		{
+			auto& Victim = *Queues[(WorkerIndex + Offset) % NumQueues];
+
+			if (Victim.NumTasks == 0)
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> Lock(Victim.Mutex, std::try_to_lock);
+
+			if (!Lock.owns_lock())
+			{
+				OutContended = true;
+
+				continue;
+			}
+
+			if (!Victim.Tasks[Priority].empty())
+			{
+				OutWork = std::move(Victim.Tasks[Priority].back());
+				Victim.Tasks[Priority].pop_back();
+				--Victim.NumTasks;
+				--PendingTasks;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingExecutor::WorkerLoop(size_t WorkerIndex)
+{
+	CurrentExecutor	   = this;
+	CurrentWorkerIndex = WorkerIndex;
+
+	for (;;)
+	{
+		Task Work;
+		bool Contended = false;
+
+		if (TryPop(WorkerIndex, Work, Contended))
+		{
+			Work(nullptr);
+
+			continue;
+		}
+
+		if (Contended)
+		{
+			// There may be work in a queue that was busy. Give whoever holds it a chance to finish rather than spinning.
+			std::this_thread::yield();
+
+			continue;
+		}
+
+		std::unique_lock<std::mutex> Lock(SleepMutex);
+
+		++SleepingWorkers;
+
+		SleepCond.wait(Lock,
+					   [this]
+					   {
+						   return PendingTasks > 0 || ShutdownFlag;
+					   });
+
+		--SleepingWorkers;
+
+		if (ShutdownFlag && PendingTasks == 0)
+		{
+			break;
+		}
+	}
+
+	CurrentExecutor = nullptr;
+}
+
+void WorkStealingExecutor::TimerLoop()
+{
+	std::vector<DelayedTask> Expired;
+
+	std::unique_lock<std::mutex> Lock(TimerMutex);
+
+	Clock::time_point NextTick = Clock::now() + TimerResolution;
+
+	while (!TimerShutdownFlag)
+	{
+		if (Timers.IsEmpty())
+		{
+			// Nothing to do, so don't wake up every tick
+			TimerCond.wait(Lock,
+						   [this]
+						   {
+							   return TimerShutdownFlag || !Timers.IsEmpty();
+						   });
+
+			NextTick = Clock::now() + TimerResolution;
+
+			continue;
+		}
+
+		if (TimerCond.wait_until(Lock,
+								 NextTick,
+								 [this]
+								 {
+									 return TimerShutdownFlag;
+								 }))
+		{
+			break;
+		}
+
+		// Catch up on any ticks we missed if we were woken late
+		const Clock::time_point Now = Clock::now();
+
+		while (NextTick <= Now)
+		{
+			Timers.Advance(Expired);
+			NextTick += TimerResolution;
+		}
+
+		if (!Expired.empty())
+		{
+			Lock.unlock();
+
+			for (auto& Delayed : Expired)
+			{
+				Enqueue(std::move(Delayed.Work), Delayed.Priority);
+			}
+
+			Expired.clear();
+
+			Lock.lock();
+		}
+	}
+}
+
+} // namespace csp
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "Common/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace csp
+{
+
+enum class ETaskPriority : uint8_t
+{
+	High,
+	Normal,
+	Low,
+	Num
+};
+
+
+/// @brief Hashed timing wheel. Timers are bucketed by the slot they expire in, so adding a timer and advancing the wheel by one tick
+/// are both constant time regardless of how many timers are pending. Timers further away than one revolution wait out the extra
+/// revolutions in their slot. Not thread-safe; the owner is responsible for locking.
+template <typename T> class TimerWheel
+{
+public:
+	explicit TimerWheel(size_t InNumSlots) : Slots(InNumSlots), CurrentSlot(0), Count(0)
+	{
+	}
+
+	/// @brief Adds a timer that expires after DelayTicks calls to Advance. A delay of 0 is treated as 1 so that a timer added while
+	/// processing expired timers never fires in the same pass.
+	void Add(uint64_t DelayTicks, T&& Item)
+	{
+		DelayTicks = std::max<uint64_t>(DelayTicks, 1);
+
+		const size_t Slot = (CurrentSlot + DelayTicks) % Slots.size();
+		Slots[Slot].push_back({std::move(Item), (DelayTicks - 1) / Slots.size()});
+		++Count;
+	}
+
+	/// @brief Moves the wheel on by one tick and appends any timers that have expired to OutExpired.
+	void Advance(std::vector<T>& OutExpired)
+	{
+		CurrentSlot = (CurrentSlot + 1) % Slots.size();
+
+		auto& Slot = Slots[CurrentSlot];
+
+		for (auto It = Slot.begin(); It != Slot.end();)
+		{
+			if (It->Rounds == 0)
+			{
+				OutExpired.push_back(std::move(It->Item));
+				It = Slot.erase(It);
+				--Count;
+			}
+			else
+			{
+				--It->Rounds;
+				++It;
+			}
+		}
+	}
+
+	/// @brief Removes all pending timers, regardless of when they were due, and appends them to OutItems.
+	void Drain(std::vector<T>& OutItems)
+	{
+		for (auto& Slot : Slots)
+		{
+			for (auto& Entry : Slot)
+			{
+				OutItems.push_back(std::move(Entry.Item));
+			}
+
+			Slot.clear();
+		}
+
+		Count = 0;
+	}
+
+	bool IsEmpty() const
+	{
+		return Count == 0;
+	}
+
+	size_t Size() const
+	{
+		return Count;
+	}
+
+private:
+	struct Entry
+	{
+		T Item;
+		uint64_t Rounds;
+	};
+
+	std::vector<std::deque<Entry>> Slots;
+	size_t CurrentSlot;
+	size_t Count;
+};
+
+
+/// @brief Fixed-size pool of worker threads, each with its own set of per-priority task queues.
+/// Tasks enqueued from a worker go onto that worker's queues; tasks enqueued from any other thread are spread across workers round-robin.
+/// Idle workers steal from the other workers' queues, always preferring higher priority work over their own lower priority work.
+/// Delayed tasks are held in a timer wheel serviced by a single timer thread, so they never occupy a worker while they wait.
+class WorkStealingExecutor : public ITaskQueue
+{
+public:
+	using Task = std::function<void*(void*)>;
+
+	/// @param NumWorkers Number of worker threads. At least one worker is always created.
+	/// @param InTimerResolution Granularity of delayed tasks. Delayed tasks run no earlier than requested and at most two ticks later.
+	explicit WorkStealingExecutor(size_t NumWorkers, std::chrono::milliseconds InTimerResolution = std::chrono::milliseconds(10));
+
+	WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+	~WorkStealingExecutor() override;
+
+	void Enqueue(Task Work) override;
+	void Enqueue(Task Work, ETaskPriority Priority);
+	void EnqueueAfter(std::chrono::milliseconds Delay, Task Work, ETaskPriority Priority = ETaskPriority::Normal);
+
+	/// @brief Runs any delayed tasks immediately, waits for all queued tasks to finish and then joins the worker threads.
+	void Shutdown() override;
+
+	size_t GetNumWorkers() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct WorkerQueues
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks[static_cast<size_t>(ETaskPriority::Num)];
+		// Total across all priorities, so that thieves can skip empty queues without taking the lock
+		std::atomic<size_t> NumTasks = 0;
+	};
+
+	struct DelayedTask
+	{
+		Task Work;
+		ETaskPriority Priority;
+	};
+
+	void Push(size_t QueueIndex, Task&& Work, ETaskPriority Priority);
+	bool TryPop(size_t WorkerIndex, Task& OutWork, bool& OutContended);
+
+	void WorkerLoop(size_t WorkerIndex);
+	void TimerLoop();
+
+	std::vector<std::unique_ptr<WorkerQueues>> Queues;
+	std::vector<std::thread> Workers;
+
+	std::atomic<size_t> NextQueue;
+	std::atomic<size_t> PendingTasks;
+	std::atomic<size_t> SleepingWorkers;
+
+	bool ShutdownFlag;
+	std::condition_variable SleepCond;
+	std::mutex SleepMutex;
+
+	TimerWheel<DelayedTask> Timers;
+	std::chrono::milliseconds TimerResolution;
+	bool TimerShutdownFlag;
+	std::condition_variable TimerCond;
+	std::mutex TimerMutex;
+	std::thread TimerThread;
+};
+
+} // namespace csp
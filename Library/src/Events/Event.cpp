@@ -19,7 +19,10 @@
 #include "Common/Wrappers.h"
 #include "Memory/Memory.h"
 
-#include <map>
+#include <assert.h>
+#include <cstring>
+#include <string_view>
+#include <vector>
 
 
 namespace csp::events
@@ -41,83 +44,129 @@ public:
 	const float GetFloat(const char* Key) const;
 	bool GetBool(const char* Key) const;
 
+	// Removes all params, keeping any storage allocated for them so that the payload can be reused
+	void Clear();
+
 private:
-	enum EParamType
+	enum EParamType : uint8_t
 	{
 		TypeInt,
 		TypeFloat,
 		TypeString,
-		TypeBool
+		TypeBool,
+		TypeHeapString
 	};
 
+	// Strings up to this size, including the terminator, are stored in the param itself
+	static constexpr size_t InlineStringSize = 48;
+	// Params beyond this many are stored in an allocated list
+	static constexpr size_t NumInlineParams = 4;
+
 	struct EventParam
 	{
-		EventParam(EParamType Type) : ParamType(Type)
+		EventParam() : KeyHash(0), ParamType(TypeInt), IntParam(0)
 		{
 		}
 
-		EventParam(const EventParam& Other)
+		EventParam(EventParam&& Other) noexcept
 		{
-			ParamType = Other.ParamType;
+			MoveFrom(Other);
+		}
 
-			switch (ParamType)
+		EventParam& operator=(EventParam&& Other) noexcept
+		{
+			if (this != &Other)
 			{
-				case TypeInt:
-					IntParam = Other.IntParam;
-					break;
+				Release();
+				MoveFrom(Other);
+			}
 
-				case TypeFloat:
-					FloatParam = Other.FloatParam;
-					break;
+			return *this;
+		}
 
-				case TypeBool:
-					BoolParam = Other.BoolParam;
-					break;
+		EventParam(const EventParam&)			 = delete;
+		EventParam& operator=(const EventParam&) = delete;
 
-				case TypeString:
-					SetString(Other.StringParam);
-					break;
+		~EventParam()
+		{
+			Release();
+		}
 
-				default:
-					break; // Unknown type
+		void SetString(const char* InString)
+		{
+			size_t StringLen = strlen(InString);
+
+			if (StringLen < InlineStringSize)
+			{
+				ParamType = TypeString;
+				STRCPY(StringParam, InlineStringSize, InString);
+			}
+			else
+			{
+				ParamType		= TypeHeapString;
+				HeapStringParam = (char*) CSP_ALLOC(StringLen + 1);
+				STRCPY(HeapStringParam, StringLen + 1, InString);
 			}
 		}
 
-		~EventParam()
+		const char* GetString() const
 		{
-			if (ParamType == TypeString)
+			return ParamType == TypeHeapString ? HeapStringParam : StringParam;
+		}
+
+		void Release()
+		{
+			if (ParamType == TypeHeapString)
 			{
-				CSP_FREE(StringParam);
+				CSP_FREE(HeapStringParam);
 			}
+
+			ParamType = TypeInt;
 		}
 
-		void SetString(const char* InString)
+		void MoveFrom(EventParam& Other)
 		{
-			size_t StringLen = strlen(InString);
-			StringParam		 = (char*) CSP_ALLOC(StringLen + 1);
+			Key		  = std::move(Other.Key);
+			KeyHash	  = Other.KeyHash;
+			ParamType = Other.ParamType;
+			memcpy(StringParam, Other.StringParam, InlineStringSize);
 
-			STRCPY(StringParam, StringLen + 1, InString);
+			// The heap string, if there is one, now belongs to this param
+			Other.ParamType = TypeInt;
 		}
 
+		// Kept for params whose keys share a hash. Its storage is reused along with the param.
+		csp::StlString Key;
+		size_t KeyHash;
 		EParamType ParamType;
 
 		union
 		{
 			int IntParam;
 			float FloatParam;
-			char* StringParam;
 			bool BoolParam;
+			char* HeapStringParam;
+			char StringParam[InlineStringSize];
 		};
 	};
 
-	using ParamMap
-		= std::map<csp::StlString, EventParam, std::less<csp::StlString>, csp::memory::StlAllocator<std::pair<const csp::StlString, EventParam>>>;
+	static size_t HashKey(const char* Key);
+
+	const EventParam* FindParam(const char* Key) const;
+	// Returns nullptr if the payload already has a param with this key
+	EventParam* AddParam(const char* Key);
 
-	ParamMap Parameters;
+	EventParam& GetParam(size_t Index);
+	const EventParam& GetParam(size_t Index) const;
+
+	// Params are looked up by the hash of their key, and then by the key itself
+	EventParam InlineParams[NumInlineParams];
+	std::vector<EventParam> OverflowParams;
+	size_t NumParams;
 };
 
 
-EventPayloadImpl::EventPayloadImpl()
+EventPayloadImpl::EventPayloadImpl() : NumParams(0)
 {
 }
 
@@ -125,41 +174,110 @@ EventPayloadImpl::~EventPayloadImpl()
 {
 }
 
+size_t EventPayloadImpl::HashKey(const char* Key)
+{
+	return std::hash<std::string_view> {}(Key);
+}
+
+EventPayloadImpl::EventParam& EventPayloadImpl::GetParam(size_t Index)
+{
+	return Index < NumInlineParams ? InlineParams[Index] : OverflowParams[Index - NumInlineParams];
+}
+
+const EventPayloadImpl::EventParam& EventPayloadImpl::GetParam(size_t Index) const
+{
+	return Index < NumInlineParams ? InlineParams[Index] : OverflowParams[Index - NumInlineParams];
+}
+
+const EventPayloadImpl::EventParam* EventPayloadImpl::FindParam(const char* Key) const
+{
+	const size_t KeyHash = HashKey(Key);
+
+	for (size_t i = 0; i < NumParams; ++i)
+	{
+		const EventParam& Param = GetParam(i);
+
+		if (Param.KeyHash == KeyHash && Param.Key == Key)
+		{
+			return &Param;
+		}
+	}
+
+	return nullptr;
+}
+
+EventPayloadImpl::EventParam* EventPayloadImpl::AddParam(const char* Key)
+{
+	// As with the map this replaced, adding a key twice keeps the first value
+	if (FindParam(Key) != nullptr)
+	{
+		return nullptr;
+	}
+
+	if (NumParams >= NumInlineParams)
+	{
+		OverflowParams.emplace_back();
+	}
+
+	EventParam& Param = GetParam(NumParams++);
+	Param.Key		  = Key;
+	Param.KeyHash	  = HashKey(Key);
+
+	return &Param;
+}
+
+void EventPayloadImpl::Clear()
+{
+	for (size_t i = 0; i < NumInlineParams && i < NumParams; ++i)
+	{
+		InlineParams[i].Release();
+	}
+
+	OverflowParams.clear();
+	NumParams = 0;
+}
+
 void EventPayloadImpl::AddInt(const char* Key, const int Value)
 {
-	EventParam Param(TypeInt);
-	Param.IntParam = Value;
-	Parameters.insert(ParamMap::value_type(Key, Param));
+	if (EventParam* Param = AddParam(Key))
+	{
+		Param->ParamType = TypeInt;
+		Param->IntParam	 = Value;
+	}
 }
 
 void EventPayloadImpl::AddString(const char* Key, const char* Value)
 {
-	EventParam Param(TypeString);
-	Param.SetString(Value);
-	Parameters.insert(ParamMap::value_type(Key, Param));
+	if (EventParam* Param = AddParam(Key))
+	{
+		Param->SetString(Value);
+	}
 }
 
 void EventPayloadImpl::AddFloat(const char* Key, const float Value)
 {
-	EventParam Param(TypeFloat);
-	Param.FloatParam = Value;
-	Parameters.insert(ParamMap::value_type(Key, Param));
+	if (EventParam* Param = AddParam(Key))
+	{
+		Param->ParamType  = TypeFloat;
+		Param->FloatParam = Value;
+	}
 }
 
 void EventPayloadImpl::AddBool(const char* Key, const bool Value)
 {
-	EventParam Param(TypeBool);
-	Param.BoolParam = Value;
-	Parameters.insert(ParamMap::value_type(Key, Param));
+	if (EventParam* Param = AddParam(Key))
+	{
+		Param->ParamType = TypeBool;
+		Param->BoolParam = Value;
+	}
 }
 
 const int EventPayloadImpl::GetInt(const char* Key) const
 {
-	ParamMap::const_iterator it = Parameters.find(Key);
-	if (it != Parameters.end())
+	if (const EventParam* Param = FindParam(Key))
 	{
-		assert(it->second.ParamType == TypeInt);
-		return it->second.IntParam;
+		assert(Param->ParamType == TypeInt);
+		return Param->IntParam;
 	}
 
 	return 0;
@@ -167,11 +285,10 @@ const int EventPayloadImpl::GetInt(const char* Key) const
 
 const char* EventPayloadImpl::GetString(const char* Key) const
 {
-	ParamMap::const_iterator it = Parameters.find(Key);
-	if (it != Parameters.end())
+	if (const EventParam* Param = FindParam(Key))
 	{
-		assert(it->second.ParamType == TypeString);
-		return it->second.StringParam;
+		assert(Param->ParamType == TypeString || Param->ParamType == TypeHeapString);
+		return Param->GetString();
 	}
 
 	return nullptr;
@@ -179,11 +296,10 @@ const char* EventPayloadImpl::GetString(const char* Key) const
 
 const float EventPayloadImpl::GetFloat(const char* Key) const
 {
-	ParamMap::const_iterator it = Parameters.find(Key);
-	if (it != Parameters.end())
+	if (const EventParam* Param = FindParam(Key))
 	{
-		assert(it->second.ParamType == TypeFloat);
-		return it->second.FloatParam;
+		assert(Param->ParamType == TypeFloat);
+		return Param->FloatParam;
 	}
 
 	return 0.0f;
@@ -191,11 +307,10 @@ const float EventPayloadImpl::GetFloat(const char* Key) const
 
 bool EventPayloadImpl::GetBool(const char* Key) const
 {
-	ParamMap::const_iterator it = Parameters.find(Key);
-	if (it != Parameters.end())
+	if (const EventParam* Param = FindParam(Key))
 	{
-		assert(it->second.ParamType == TypeBool);
-		return it->second.BoolParam;
+		assert(Param->ParamType == TypeBool);
+		return Param->BoolParam;
 	}
 
 	return false;
@@ -211,6 +326,12 @@ Event::~Event()
 	CSP_DELETE(Impl);
 }
 
+void Event::Reset(const EventId& InId)
+{
+	Id = InId;
+	Impl->Clear();
+}
+
 void Event::AddInt(const char* Key, const int Value)
 {
 	Impl->AddInt(Key, Value);
@@ -24,9 +24,13 @@
 namespace csp::events
 {
 
+/// @brief An event and its payload of keyed params.
+/// The first few params, and strings of up to 47 characters, are stored without allocating. Events are created by the event
+/// system, which reuses them once they have been processed, so an event should not be referenced after it has been enqueued.
 class CSP_API Event
 {
 	friend class EventSystem;
+	friend class EventSystemImpl;
 
 public:
 	~Event();
@@ -48,6 +52,9 @@ public:
 private:
 	Event(const EventId& InId);
 
+	// Clears the payload so that the event can be reused
+	void Reset(const EventId& InId);
+
 	EventId Id;
 	class EventPayloadImpl* Impl;
 };
@@ -15,31 +15,200 @@
  */
 #include "Events/EventDispatcher.h"
 
+#include "Memory/Memory.h"
+
+#include <algorithm>
+
+
 namespace csp::events
 {
 
-EventDispatcher::EventDispatcher(const EventId& InId) : Id(InId)
+EventDispatcher::EventDispatcher(const EventId& InId) : Id(InId), NumListeners(0), DispatchDepth(0), NeedsCompaction(false)
 {
 }
 
 void EventDispatcher::RegisterListener(EventListener* InListener)
 {
 	// Check it's not there already
-	CallbackList.remove(InListener);
+	if (std::find(Listeners.begin(), Listeners.end(), InListener) != Listeners.end())
+	{
+		return;
+	}
 
-	CallbackList.push_back(InListener);
+	Listeners.push_back(InListener);
+	++NumListeners;
 }
 
 void EventDispatcher::UnRegisterListener(EventListener* InListener)
 {
-	CallbackList.remove(InListener);
+	auto It = std::find(Listeners.begin(), Listeners.end(), InListener);
+
+	if (It == Listeners.end())
+	{
+		return;
+	}
+
+	--NumListeners;
+
+	if (DispatchDepth > 0)
+	{
+		// Removing the listener now would shift the listeners still to be called
+		*It				= nullptr;
+		NeedsCompaction = true;
+	}
+	else
+	{
+		Listeners.erase(It);
+	}
 }
 
 void EventDispatcher::Dispatch(const Event& InEvent)
 {
-	for (auto Callback : CallbackList)
+	++DispatchDepth;
+
+	// Listeners registered by a listener are added to the end, and should only receive later events
+	const size_t Count = Listeners.size();
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		// Indexed each time, as registering a listener may reallocate the list
+		if (EventListener* Listener = Listeners[i])
+		{
+			Listener->OnEvent(InEvent);
+		}
+	}
+
+	if (--DispatchDepth == 0 && NeedsCompaction)
+	{
+		Compact();
+	}
+}
+
+const EventId& EventDispatcher::GetId() const
+{
+	return Id;
+}
+
+size_t EventDispatcher::GetNumListeners() const
+{
+	return NumListeners;
+}
+
+void EventDispatcher::Compact()
+{
+	Listeners.erase(std::remove(Listeners.begin(), Listeners.end(), nullptr), Listeners.end());
+	NeedsCompaction = false;
+}
+
+
+EventDispatcherTable::EventDispatcherTable() : NumDispatchers(0)
+{
+}
+
+EventDispatcherTable::~EventDispatcherTable()
+{
+	Clear();
+}
+
+size_t EventDispatcherTable::Hash(const EventId& Id)
+{
+	return std::hash<EventId> {}(Id);
+}
+
+EventDispatcher* EventDispatcherTable::Find(const EventId& Id) const
+{
+	if (NumDispatchers == 0)
+	{
+		return nullptr;
+	}
+
+	const size_t Mask = Slots.size() - 1;
+	const size_t Key  = Hash(Id);
+
+	for (size_t Index = Key & Mask;; Index = (Index + 1) & Mask)
 	{
-		Callback->OnEvent(InEvent);
+		const Slot& Current = Slots[Index];
+
+		if (Current.Dispatcher == nullptr)
+		{
+			return nullptr;
+		}
+
+		if (Current.Hash == Key && Current.Dispatcher->GetId() == Id)
+		{
+			return Current.Dispatcher;
+		}
+	}
+}
+
+EventDispatcher& EventDispatcherTable::FindOrAdd(const EventId& Id)
+{
+	if (EventDispatcher* Existing = Find(Id))
+	{
+		return *Existing;
+	}
+
+	if ((NumDispatchers + 1) * 2 > Slots.size())
+	{
+		Grow();
+	}
+
+	const size_t Mask = Slots.size() - 1;
+	const size_t Key  = Hash(Id);
+	size_t Index	  = Key & Mask;
+
+	while (Slots[Index].Dispatcher != nullptr)
+	{
+		Index = (Index + 1) & Mask;
+	}
+
+	Slots[Index] = {Key, CSP_NEW EventDispatcher(Id)};
+	++NumDispatchers;
+
+	return *Slots[Index].Dispatcher;
+}
+
+void EventDispatcherTable::Clear()
+{
+	for (Slot& Current : Slots)
+	{
+		if (Current.Dispatcher != nullptr)
+		{
+			CSP_DELETE(Current.Dispatcher);
+			Current.Dispatcher = nullptr;
+		}
+	}
+
+	NumDispatchers = 0;
+}
+
+size_t EventDispatcherTable::GetSize() const
+{
+	return NumDispatchers;
+}
+
+void EventDispatcherTable::Grow()
+{
+	std::vector<Slot> OldSlots(std::max<size_t>(Slots.size() * 2, 16), Slot {0, nullptr});
+	std::swap(Slots, OldSlots);
+
+	const size_t Mask = Slots.size() - 1;
+
+	for (const Slot& Current : OldSlots)
+	{
+		if (Current.Dispatcher == nullptr)
+		{
+			continue;
+		}
+
+		size_t Index = Current.Hash & Mask;
+
+		while (Slots[Index].Dispatcher != nullptr)
+		{
+			Index = (Index + 1) & Mask;
+		}
+
+		Slots[Index] = Current;
 	}
 }
 
@@ -17,16 +17,18 @@
 
 #include "Events/Event.h"
 #include "Events/EventListener.h"
-#include "Memory/StlAllocator.h"
 
-#include <list>
+#include <cstdint>
+#include <vector>
 
 
 namespace csp::events
 {
 
-using EventCallbackList = std::list<csp::events::EventListener*, csp::memory::StlAllocator<csp::events::EventListener*>>;
-
+/// @brief Sends events with a given id to the listeners registered for it.
+/// Listeners are kept in a contiguous list. Listeners may be registered and unregistered from within OnEvent: an unregistered listener
+/// is cleared from the list straight away, so it won't receive the event being dispatched, and the list is compacted once the dispatch
+/// has finished. A newly registered listener receives events from the next dispatch on.
 class EventDispatcher
 {
 public:
@@ -37,9 +39,58 @@ public:
 
 	void Dispatch(const Event& InEvent);
 
+	const EventId& GetId() const;
+	size_t GetNumListeners() const;
+
 private:
+	void Compact();
+
 	EventId Id;
-	EventCallbackList CallbackList;
+	// Unregistered listeners are set to null while dispatching, and removed afterwards
+	std::vector<EventListener*> Listeners;
+	size_t NumListeners;
+	uint32_t DispatchDepth;
+	bool NeedsCompaction;
+};
+
+
+/// @brief Maps event ids to their dispatchers.
+/// An open-addressing table with linear probing over a contiguous array of slots, keyed on the hashes an EventId already holds, so
+/// looking up a dispatcher doesn't hash any strings or follow a bucket list. Dispatchers are allocated separately and never moved,
+/// so a dispatcher stays valid while the table grows, including when a listener for a new id is registered during a dispatch.
+class EventDispatcherTable
+{
+public:
+	EventDispatcherTable();
+	~EventDispatcherTable();
+
+	EventDispatcherTable(const EventDispatcherTable&)			 = delete;
+	EventDispatcherTable& operator=(const EventDispatcherTable&) = delete;
+
+	/// @brief Returns the dispatcher for an id, or nullptr if no listener has been registered for it
+	EventDispatcher* Find(const EventId& Id) const;
+
+	/// @brief Returns the dispatcher for an id, adding one if there isn't one already
+	EventDispatcher& FindOrAdd(const EventId& Id);
+
+	void Clear();
+
+	size_t GetSize() const;
+
+private:
+	struct Slot
+	{
+		size_t Hash;
+		EventDispatcher* Dispatcher;
+	};
+
+	static size_t Hash(const EventId& Id);
+
+	void Grow();
+
+	// Capacity is always a power of two, and is kept at least twice the number of dispatchers. Empty slots have a null dispatcher.
+	std::vector<Slot> Slots;
+	size_t NumDispatchers;
 };
 
 } // namespace csp::events
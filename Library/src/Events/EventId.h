@@ -18,6 +18,8 @@
 #include "CSP/CSPCommon.h"
 #include "CSP/Common/String.h"
 
+#include <functional>
+
 namespace csp::events
 {
 
@@ -44,7 +46,8 @@ const EventId USERSERVICE_LOGOUT_EVENT_ID = EventId("UserService", "Logout");
 const EventId SPACESYSTEM_ENTER_SPACE_EVENT_ID = EventId("SpaceSystem", "Enter");
 const EventId SPACESYSTEM_EXIT_SPACE_EVENT_ID  = EventId("SpaceSystem", "Exit");
 
-const EventId MULTIPLAYERSYSTEM_DISCONNECT_EVENT_ID = EventId("MultiplayerSystem", "Disconnect");
+const EventId MULTIPLAYERSYSTEM_DISCONNECT_EVENT_ID				   = EventId("MultiplayerSystem", "Disconnect");
+const EventId MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID = EventId("MultiplayerSystem", "AssetDetailBlobChanged");
 
 const EventId FOUNDATION_TICK_EVENT_ID = EventId("Foundation", "Tick");
 
@@ -52,3 +55,25 @@ const EventId ENTITYSYSTEM_ADD_ENTITY_EVENT_ID	  = EventId("EntitySystem", "AddE
 const EventId ENTITYSYSTEM_REMOVE_ENTITY_EVENT_ID = EventId("EntitySystem", "RemoveEntity");
 
 } // namespace csp::events
+
+
+namespace std
+{
+
+template <> struct hash<csp::events::EventId>
+{
+	void HashCombine(std::size_t& InHash, std::size_t Other) const
+	{
+		InHash ^= Other + 0x9e3779b9 + (InHash << 6) + (InHash >> 2);
+	}
+
+	std::size_t operator()(const csp::events::EventId& Id) const
+	{
+		std::size_t Hash = Id.EventNamespace;
+		HashCombine(Hash, Id.EventName);
+
+		return Hash;
+	}
+};
+
+} // namespace std
@@ -15,33 +15,14 @@
  */
 #include "Events/EventSystem.h"
 
-#include "Common/Queue.h"
 #include "Events/EventDispatcher.h"
 #include "Memory/Memory.h"
 
-#include <unordered_map>
+#include <atomic_queue/atomic_queue.h>
 
-
-namespace std
-{
-
-template <> struct hash<csp::events::EventId>
-{
-	void HashCombine(std::size_t& InHash, std::size_t Other) const
-	{
-		InHash ^= Other + 0x9e3779b9 + (InHash << 6) + (InHash >> 2);
-	}
-
-	std::size_t operator()(const csp::events::EventId& Id) const
-	{
-		std::size_t Hash = Id.EventNamespace;
-		HashCombine(Hash, Id.EventName);
-
-		return Hash;
-	}
-};
-
-} // namespace std
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 
 namespace csp::events
@@ -49,14 +30,20 @@ namespace csp::events
 
 // Internal Implementation
 
+// Queued events are held in a fixed size lock-free ring. Any thread may enqueue, but only the thread calling ProcessEvents dequeues.
+// If the ring fills up, further events go to a locked overflow list until the next time events are processed.
+constexpr unsigned EventQueueCapacity = 1024;
+
+// Processed events are kept in a pool to be reused, rather than being deleted, up to this many
+constexpr unsigned EventPoolCapacity = 256;
+
 class EventSystemImpl
 {
 public:
 	EventSystemImpl();
 	~EventSystemImpl();
 
-	EventDispatcher& GetDispatcher(const EventId& Id);
-
+	Event* AllocateEvent(const EventId& Id);
 	void EnqueueEvent(const Event* InEvent);
 
 	void RegisterListener(const EventId& Id, EventListener* InListener);
@@ -65,75 +52,143 @@ public:
 	void ProcessEvents();
 
 private:
-	csp::Queue<const Event*> EventQueue;
+	void DispatchAndRelease(const Event* InEvent);
 
-	// Define eastl map using above defined hasher and our custom allocator
-	using DispatcherMap = std::unordered_map<EventId,
-											 EventDispatcher,
-											 std::hash<EventId>,
-											 std::equal_to<EventId>,
-											 csp::memory::StlAllocator<std::pair<const EventId, EventDispatcher>>>;
+	// AtomicQueue2 rather than AtomicQueue, as AtomicQueue's pop doesn't acquire, so it doesn't guarantee that the consumer sees what the
+	// producer wrote to the event before pushing it
+	atomic_queue::AtomicQueue2<const Event*, EventQueueCapacity> EventQueue;
 
-	DispatcherMap Dispatchers;
+	// Set while OverflowEvents holds events, so that producers keep adding to the overflow list until it has been processed.
+	// This keeps events from any one thread in the order they were enqueued.
+	std::atomic_bool HasOverflowed;
+	std::mutex OverflowMutex;
+	std::vector<const Event*> OverflowEvents;
+	std::vector<const Event*> ProcessingEvents;
+
+	atomic_queue::AtomicQueue2<Event*, EventPoolCapacity> EventPool;
+
+	EventDispatcherTable Dispatchers;
 };
 
-EventSystemImpl::EventSystemImpl()
+EventSystemImpl::EventSystemImpl() : HasOverflowed(false)
 {
 }
 
 EventSystemImpl::~EventSystemImpl()
 {
-}
+	const Event* QueuedEvent = nullptr;
 
-EventDispatcher& EventSystemImpl::GetDispatcher(const EventId& Id)
-{
-	DispatcherMap::iterator it = Dispatchers.find(Id);
-	if (it != Dispatchers.end())
+	while (EventQueue.try_pop(QueuedEvent))
+	{
+		CSP_DELETE(QueuedEvent);
+	}
+
+	for (const Event* OverflowEvent : OverflowEvents)
+	{
+		CSP_DELETE(OverflowEvent);
+	}
+
+	Event* PooledEvent = nullptr;
+
+	while (EventPool.try_pop(PooledEvent))
 	{
-		// Use existing dispatcher
-		return it->second;
+		CSP_DELETE(PooledEvent);
 	}
-	else
+}
+
+Event* EventSystemImpl::AllocateEvent(const EventId& Id)
+{
+	Event* NewEvent = nullptr;
+
+	if (EventPool.try_pop(NewEvent))
 	{
-		// Add new dispatcher
-		auto result = Dispatchers.insert(DispatcherMap::value_type(Id, EventDispatcher(Id)));
-		return result.first->second;
+		NewEvent->Reset(Id);
+
+		return NewEvent;
 	}
+
+	return CSP_NEW Event(Id);
 }
 
 void EventSystemImpl::EnqueueEvent(const Event* InEvent)
 {
-	EventQueue.Enqueue(InEvent);
+	if (!HasOverflowed.load(std::memory_order_acquire) && EventQueue.try_push(InEvent))
+	{
+		return;
+	}
+
+	std::scoped_lock Lock(OverflowMutex);
+	OverflowEvents.push_back(InEvent);
+	HasOverflowed.store(true, std::memory_order_release);
 }
 
 void EventSystemImpl::RegisterListener(const EventId& Id, EventListener* InListener)
 {
-	EventDispatcher& Dispatcher = GetDispatcher(Id);
+	EventDispatcher& Dispatcher = Dispatchers.FindOrAdd(Id);
 	Dispatcher.RegisterListener(InListener);
 }
 
 void EventSystemImpl::UnRegisterListener(const EventId& Id, EventListener* InListener)
 {
-	EventDispatcher& Dispatcher = GetDispatcher(Id);
-	Dispatcher.UnRegisterListener(InListener);
+	if (EventDispatcher* Dispatcher = Dispatchers.Find(Id))
+	{
+		Dispatcher->UnRegisterListener(InListener);
+	}
 }
 
 void EventSystemImpl::UnRegisterAllListeners()
 {
-	Dispatchers.clear();
+	Dispatchers.Clear();
 }
 
 void EventSystemImpl::ProcessEvents()
 {
-	while (EventQueue.IsEmpty() == false)
+	// Keep going until both the ring and the overflow list are empty, so that events enqueued by listeners are processed too
+	for (;;)
+	{
+		const Event* QueuedEvent = nullptr;
+
+		while (EventQueue.try_pop(QueuedEvent))
+		{
+			DispatchAndRelease(QueuedEvent);
+		}
+
+		if (!HasOverflowed.load(std::memory_order_acquire))
+		{
+			break;
+		}
+
+		{
+			// Anything pushed to the ring from here on was enqueued after the overflowed events, so it's fine to leave it for the next pass
+			std::scoped_lock Lock(OverflowMutex);
+			std::swap(OverflowEvents, ProcessingEvents);
+			HasOverflowed.store(false, std::memory_order_release);
+		}
+
+		for (const Event* OverflowEvent : ProcessingEvents)
+		{
+			DispatchAndRelease(OverflowEvent);
+		}
+
+		ProcessingEvents.clear();
+	}
+}
+
+void EventSystemImpl::DispatchAndRelease(const Event* InEvent)
+{
+	// Events nobody is listening for are dropped, without adding a dispatcher for them
+	if (EventDispatcher* Dispatcher = Dispatchers.Find(InEvent->GetId()))
 	{
-		auto QueuedItem = EventQueue.Dequeue();
+		Dispatcher->Dispatch(*InEvent);
+	}
 
-		const Event* QueuedEvent = QueuedItem.value();
-		const EventId& Id		 = QueuedEvent->GetId();
-		GetDispatcher(Id).Dispatch(*QueuedEvent);
+	// The event is no longer referenced by anything, so it's safe to reuse it
+	Event* ProcessedEvent = const_cast<Event*>(InEvent);
+	ProcessedEvent->Reset(ProcessedEvent->GetId());
 
-		CSP_DELETE(QueuedEvent);
+	if (!EventPool.try_push(ProcessedEvent))
+	{
+		CSP_DELETE(ProcessedEvent);
 	}
 }
 
@@ -145,7 +200,8 @@ EventSystem& EventSystem::Get()
 	return TheEventSystem;
 }
 
-EventSystem::EventSystem() : Impl(CSP_NEW EventSystemImpl())
+EventSystem::EventSystem()
+	: Impl(CSP_NEW_ALIGN_P(csp::memory::DefaultAllocator(), std::align_val_t(alignof(EventSystemImpl))) EventSystemImpl())
 {
 }
 
@@ -156,7 +212,7 @@ EventSystem::~EventSystem()
 
 Event* EventSystem::AllocateEvent(const EventId& Id)
 {
-	return CSP_NEW Event(Id);
+	return Impl->AllocateEvent(Id);
 }
 
 void EventSystem::EnqueueEvent(const Event* InEvent)
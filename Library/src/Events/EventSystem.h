@@ -30,12 +30,13 @@ public:
 
 	static EventSystem& Get();
 
-	/// @brief Create a new event instance
-	/// @note The event will be deleted after it has been processed in ProcessEvents
+	/// @brief Create a new event instance, reusing a previously processed event if one is available
+	/// @note The event will be released back to the event system after it has been processed in ProcessEvents
+	/// @note This call is thread safe
 	Event* AllocateEvent(const EventId& Id);
 
 	/// @brief Enqueue an event to be sent later
-	/// @note This call is thread safe
+	/// @note This call is thread safe and lock-free, unless more events are queued than the queue has room for
 	/// @param InEvent
 	void EnqueueEvent(const Event* InEvent);
 
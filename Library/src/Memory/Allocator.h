@@ -42,6 +42,9 @@ public:
 	virtual void Deallocate(void* Ptr, size_t Bytes)							  = 0;
 
 	virtual const size_t GetAllocatedBytes() const = 0;
+
+	/// Total number of allocations made, including reallocations
+	virtual const size_t GetNumAllocations() const = 0;
 };
 
 } // namespace csp::memory
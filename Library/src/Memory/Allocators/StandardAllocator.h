@@ -81,13 +81,15 @@ public:
 	void Deallocate(void* Ptr, size_t Bytes) override;
 
 	const size_t GetAllocatedBytes() const override;
+	const size_t GetNumAllocations() const override;
 
 private:
 	std::atomic<size_t> AllocatedBytes;
+	std::atomic<size_t> NumAllocations;
 	TLockTrait AllocMutex;
 };
 
-template <typename TLockTrait> StandardAllocator<TLockTrait>::StandardAllocator() : AllocatedBytes(0)
+template <typename TLockTrait> StandardAllocator<TLockTrait>::StandardAllocator() : AllocatedBytes(0), NumAllocations(0)
 {
 }
 
@@ -103,6 +105,7 @@ template <typename TLockTrait> void* StandardAllocator<TLockTrait>::Allocate(siz
 template <typename TLockTrait> void* StandardAllocator<TLockTrait>::Allocate(size_t n, std::align_val_t alignment)
 {
 	AllocatedBytes += n;
+	NumAllocations.fetch_add(1, std::memory_order_relaxed);
 
 	AllocMutex.Lock();
 
@@ -142,6 +145,7 @@ template <typename TLockTrait> void* StandardAllocator<TLockTrait>::Reallocate(v
 {
 	// TODO increment with the difference between the old allocation and the new one
 	// AllocatedBytes += n;
+	NumAllocations.fetch_add(1, std::memory_order_relaxed);
 
 	AllocMutex.Lock();
 
@@ -199,4 +203,9 @@ template <typename TLockTrait> const size_t StandardAllocator<TLockTrait>::GetAl
 	return AllocatedBytes;
 }
 
+template <typename TLockTrait> const size_t StandardAllocator<TLockTrait>::GetNumAllocations() const
+{
+	return NumAllocations.load(std::memory_order_relaxed);
+}
+
 } // namespace csp::memory
@@ -65,6 +65,24 @@ ClientElectionManager::ClientElectionManager(SpaceEntitySystem* InSpaceEntitySys
 	, TheElectionState(ElectionState::Idle)
 	, LocalClient(nullptr)
 	, Leader(nullptr)
+	, Failover(
+		  DefaultLeaderHeartbeatTimeOut / 4,
+		  DefaultLeaderHeartbeatTimeOut,
+		  [this](uint64_t Epoch)
+		  {
+			  if (LocalClient != nullptr)
+			  {
+				  // Only the leader sends heartbeats, so its own choice of partitioning is the one in effect
+				  IsAuthorityPartitioned = IsPartitioningRequested;
+				  LocalClient->SendLeaderHeartbeat(Epoch, IsAuthorityPartitioned);
+			  }
+		  },
+		  [this](int64_t LeaderId, uint64_t /*Epoch*/)
+		  {
+			  OnLeaderFailover(LeaderId);
+		  })
+	, IsPartitioningRequested(false)
+	, IsAuthorityPartitioned(false)
 {
 	csp::events::EventSystem::Get().RegisterListener(csp::events::FOUNDATION_TICK_EVENT_ID, EventHandler);
 	csp::events::EventSystem::Get().RegisterListener(csp::events::MULTIPLAYERSYSTEM_DISCONNECT_EVENT_ID, EventHandler);
@@ -115,6 +133,12 @@ void ClientElectionManager::OnDisconnect()
 		CSP_DELETE(Proxy);
 	}
 
+	AuthorityRing.Clear();
+	Failover.Clear();
+
+	// Whoever leads when we next connect decides
+	IsAuthorityPartitioned = false;
+
 	UnBindNetworkEvents();
 }
 
@@ -141,6 +165,11 @@ void ClientElectionManager::OnLocalClientAdd(const SpaceEntity* ClientAvatar, co
 	ClientProxy* Client = AddClientUsingAvatar(ClientAvatar);
 	LocalClient			= Client;
 
+	if (LocalClient != nullptr)
+	{
+		Failover.SetLocalClient(LocalClient->GetId(), LeaderFailover::Clock::now());
+	}
+
 	if (IsFirstClient)
 	{
 		// We are the first (and currently only client), so just start acting as leader
@@ -220,6 +249,17 @@ ClientProxy* ClientElectionManager::AddClientUsingId(int64_t ClientId)
 		Client = CSP_NEW ClientProxy(ClientId, this);
 		Clients.insert(ClientMap::value_type(ClientId, Client));
 
+		// Only the entities that hash to the new client change authority
+		AuthorityRing.AddClient(ClientId);
+		Failover.AddClient(ClientId);
+
+		// The leader's heartbeat can arrive before its avatar, leaving us without a client to make leader until now
+		if (Leader == nullptr && ClientId == Failover.GetLeader())
+		{
+			CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::AddClientUsingId - Leader %lld has arrived", ClientId);
+			SetLeader(Client);
+		}
+
 		if ((LocalClient != nullptr) && (Leader != nullptr))
 		{
 			// If a new client connects when we have a valid leader then notify them who it is
@@ -248,16 +288,24 @@ void ClientElectionManager::RemoveClientUsingId(int64_t ClientId)
 		if ((Client == Leader) && (Client != LocalClient))
 		{
 			// Handle the current leader being removed
-			OnLeaderRemoved();
+			OnLeaderRemoved(ClientId);
 		}
-		else if (Client == LocalClient)
+		else
 		{
-			CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose, "Local Client %d removed", ClientId);
-			LocalClient = nullptr;
+			if (Client == LocalClient)
+			{
+				CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose, "Local Client %d removed", ClientId);
+				LocalClient = nullptr;
+			}
+
+			Failover.RemoveClient(ClientId, LeaderFailover::Clock::now());
 		}
 
 		CSP_DELETE(Client);
 		Clients.erase(ClientId);
+
+		// The removed client's entities are shared between the clients that follow it on the ring
+		AuthorityRing.RemoveClient(ClientId);
 	}
 	else
 	{
@@ -336,6 +384,58 @@ ClientProxy* ClientElectionManager::GetLeader() const
 	return Leader;
 }
 
+uint64_t ClientElectionManager::GetLeaderEpoch() const
+{
+	return Failover.GetEpoch();
+}
+
+void ClientElectionManager::SetLeaderHeartbeatTimeout(std::chrono::milliseconds Timeout)
+{
+	CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::SetLeaderHeartbeatTimeout Timeout=%lldms", Timeout.count());
+	Failover.SetTimeout(Timeout);
+}
+
+void ClientElectionManager::SetScriptAuthorityPartitioned(bool Partitioned)
+{
+	CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::SetScriptAuthorityPartitioned Partitioned=%d", Partitioned);
+	IsPartitioningRequested = Partitioned;
+
+	if (IsLocalClientLeader())
+	{
+		// Tell the other clients straight away, rather than leaving them to disagree with us until the next heartbeat
+		IsAuthorityPartitioned = Partitioned;
+		LocalClient->SendLeaderHeartbeat(Failover.GetEpoch(), Partitioned);
+	}
+	else if (Partitioned != IsAuthorityPartitioned)
+	{
+		CSP_LOG_WARN_FORMAT("ClientElectionManager::SetScriptAuthorityPartitioned - The leader has Partitioned=%d, which is kept until it "
+							"changes it or we become the leader",
+							IsAuthorityPartitioned.load());
+	}
+}
+
+bool ClientElectionManager::IsScriptAuthorityPartitioned() const
+{
+	return IsAuthorityPartitioned;
+}
+
+ClientProxy* ClientElectionManager::GetScriptAuthority(uint64_t RootEntityId) const
+{
+	if (!IsAuthorityPartitioned)
+	{
+		return Leader;
+	}
+
+	const auto ClientIt = Clients.find(AuthorityRing.GetAuthority(RootEntityId));
+
+	return (ClientIt != Clients.end()) ? ClientIt->second : nullptr;
+}
+
+bool ClientElectionManager::IsLocalClientScriptAuthority(uint64_t RootEntityId) const
+{
+	return (LocalClient != nullptr) && (LocalClient == GetScriptAuthority(RootEntityId));
+}
+
 void ClientElectionManager::SetLeader(ClientProxy* Client)
 {
 	if (Client != nullptr)
@@ -349,6 +449,14 @@ void ClientElectionManager::SetLeader(ClientProxy* Client)
 
 	Leader = Client;
 
+	if (Client != nullptr && Client == LocalClient)
+	{
+		IsAuthorityPartitioned = IsPartitioningRequested;
+	}
+
+	// Starts a new epoch if we are the new leader
+	Failover.SetLeader((Client != nullptr) ? Client->GetId() : LeaderFailover::NoClient, LeaderFailover::Clock::now());
+
 	// Notify Scripts ready callback now we have a valid leader
 	if (ScriptSystemReadyCallback)
 	{
@@ -358,18 +466,70 @@ void ClientElectionManager::SetLeader(ClientProxy* Client)
 
 void ClientElectionManager::CheckLeaderIsValid()
 {
-	// Todo :- Ping leader and check they're still there
+	// Sends our heartbeat if we are the leader, or hands over to the leader's successor if its heartbeat is overdue
+	Failover.Update(LeaderFailover::Clock::now());
+
+	// Kept to the tick, where scripts are run, rather than changed from the network thread while their authority is being looked up
+	UpdateAuthorityRing();
 }
 
-void ClientElectionManager::OnLeaderRemoved()
+void ClientElectionManager::OnLeaderHeartbeat(int64_t LeaderId, uint64_t Epoch, bool LeaderIsAuthorityPartitioned)
+{
+	if (Failover.OnHeartbeat(LeaderId, Epoch, LeaderFailover::Clock::now()) && Failover.GetLeader() == LeaderId)
+	{
+		if (LeaderIsAuthorityPartitioned != IsAuthorityPartitioned)
+		{
+			CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose,
+						   "ClientElectionManager::OnLeaderHeartbeat - Leader %lld has Partitioned=%d",
+						   LeaderId,
+						   LeaderIsAuthorityPartitioned);
+		}
+
+		IsAuthorityPartitioned = LeaderIsAuthorityPartitioned;
+	}
+}
+
+void ClientElectionManager::UpdateAuthorityRing()
+{
+	for (const auto& Client : Clients)
+	{
+		const bool IsSuspected = Failover.IsSuspected(Client.first);
+
+		if (IsSuspected && AuthorityRing.HasClient(Client.first))
+		{
+			CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::UpdateAuthorityRing - Client %lld suspected", Client.first);
+			AuthorityRing.RemoveClient(Client.first);
+		}
+		else if (!IsSuspected)
+		{
+			AuthorityRing.AddClient(Client.first);
+		}
+	}
+}
+
+void ClientElectionManager::OnLeaderRemoved(int64_t LeaderId)
 {
 	Leader = nullptr;
 
-	if (LocalClient != nullptr)
+	// The current leader has left, so its successor takes over straight away, rather than negotiating a new leader with every client
+	Failover.RemoveClient(LeaderId, LeaderFailover::Clock::now());
+}
+
+void ClientElectionManager::OnLeaderFailover(int64_t LeaderId)
+{
+	ClientProxy* Client = (LeaderId != LeaderFailover::NoClient) ? FindClientUsingId(LeaderId) : nullptr;
+
+	if (Client == nullptr)
 	{
-		// The current leader has left, so we may need to find a new one
-		AsyncNegotiateLeader();
+		// We've stepped down, or heard from a leader we don't know about yet, so no scripts run here until we know who the leader is
+		CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::OnLeaderFailover - No known leader (ClientId=%lld)", LeaderId);
+		Leader = nullptr;
+
+		return;
 	}
+
+	CSP_LOG_FORMAT(csp::systems::LogLevel::Verbose, "ClientElectionManager::OnLeaderFailover - Leader is now %lld", LeaderId);
+	SetLeader(Client);
 }
 
 void ClientElectionManager::AsyncNegotiateLeader()
@@ -520,6 +680,20 @@ void ClientElectionManager::OnClientElectionEvent(const csp::common::Array<Repli
 
 	CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose, "ClientElectionManager::OnClientElectionEvent called. Event=%d, Id=%d", EventType, ClientId);
 
+	if (EventType == static_cast<int64_t>(ClientElectionMessageType::LeaderHeartbeat))
+	{
+		if (Data.Size() > 3)
+		{
+			const uint64_t Epoch = static_cast<uint64_t>(Data[3].GetInt());
+			// Leaders that don't send it can't partition script authority
+			const bool LeaderIsAuthorityPartitioned = (Data.Size() > 4) && Data[4].GetBool();
+
+			OnLeaderHeartbeat(ClientId, Epoch, LeaderIsAuthorityPartitioned);
+		}
+
+		return;
+	}
+
 	if (LocalClient != nullptr)
 	{
 		LocalClient->HandleEvent(EventType, ClientId);
@@ -531,6 +705,8 @@ void ClientElectionManager::OnRemoteRunScriptEvent(const csp::common::Array<Repl
 	// @Note This needs to be kept in sync with any changes to message format
 	const int64_t ContextId				  = static_cast<int64_t>(Data[0].GetInt());
 	const csp::common::String& ScriptText = Data[1].GetString();
+	// Clients that don't send the epoch can't be fenced
+	const uint64_t SenderEpoch = (Data.Size() > 2) ? static_cast<uint64_t>(Data[2].GetInt()) : 0;
 
 	CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose,
 				   "ClientElectionManager::OnRemoteRunScriptEvent called. ContextId=%lld, Script='%s'",
@@ -539,7 +715,15 @@ void ClientElectionManager::OnRemoteRunScriptEvent(const csp::common::Array<Repl
 
 	if (LocalClient != nullptr)
 	{
-		if (IsLocalClientLeader())
+		// Checked in both modes, so that a leader that has been replaced without knowing it finds out from the sender's epoch and steps
+		// down. Stepping down also takes it out of the authority ring.
+		const bool IsLeaderWrite = Failover.CanApplyScriptWrite(SenderEpoch, LeaderFailover::Clock::now());
+
+		// While authority moves between clients, a script may arrive from a client that hasn't yet seen the change, so partitioned
+		// scripts are run wherever the sender chose to send them, rather than being dropped, unless we have been failed over from
+		const bool CanRun = IsAuthorityPartitioned ? !Failover.IsSuspected(LocalClient->GetId()) : (IsLeaderWrite && IsLocalClientLeader());
+
+		if (CanRun)
 		{
 			csp::systems::ScriptSystem* TheScriptSystem = csp::systems::SystemsManager::Get().GetScriptSystem();
 			TheScriptSystem->RunScript(ContextId, ScriptText);
@@ -19,6 +19,13 @@
 #include "CSP/Multiplayer/MultiPlayerConnection.h"
 #include "CSP/Multiplayer/SpaceEntitySystem.h"
 #include "ClientProxy.h"
+#include "LeaderFailover.h"
+#include "ScriptAuthorityRing.h"
+
+
+#ifdef CSP_TESTS
+class CSPEngine_LeaderFailoverTests_HeartbeatBeforeAvatarTest_Test;
+#endif
 
 
 namespace csp::multiplayer
@@ -45,6 +52,10 @@ class ClientElectionManager
 	friend class ClientElectionEventHandler;
 	/** @endcond */
 
+#ifdef CSP_TESTS
+	friend class ::CSPEngine_LeaderFailoverTests_HeartbeatBeforeAvatarTest_Test;
+#endif
+
 public:
 	ClientElectionManager(SpaceEntitySystem* InSpaceEntitySystem);
 	~ClientElectionManager();
@@ -67,6 +78,22 @@ public:
 
 	ClientProxy* GetLeader() const;
 
+	// The epoch of the current leader, which goes up each time leadership changes hands
+	uint64_t GetLeaderEpoch() const;
+
+	// How long to wait without a heartbeat from the leader before handing over to its successor
+	void SetLeaderHeartbeatTimeout(std::chrono::milliseconds Timeout);
+
+	// When script authority is partitioned, each entity's scripts are run by one client chosen by consistent hashing, rather than all
+	// scripts being run by the leader. Every client follows the leader's choice, which it sends with its heartbeat, so a client's own
+	// choice only takes effect while it is the leader.
+	void SetScriptAuthorityPartitioned(bool Partitioned);
+	bool IsScriptAuthorityPartitioned() const;
+
+	// Returns the client with authority over scripts in the hierarchy with the given root entity
+	ClientProxy* GetScriptAuthority(uint64_t RootEntityId) const;
+	bool IsLocalClientScriptAuthority(uint64_t RootEntityId) const;
+
 private:
 	void BindNetworkEvents();
 	void UnBindNetworkEvents();
@@ -86,7 +113,13 @@ private:
 
 	void SetLeader(ClientProxy* Client);
 	void CheckLeaderIsValid();
-	void OnLeaderRemoved();
+	void OnLeaderHeartbeat(int64_t LeaderId, uint64_t Epoch, bool LeaderIsAuthorityPartitioned);
+
+	// Gives script authority to every client except those that leadership has failed over from, as they may have stopped without
+	// leaving the space
+	void UpdateAuthorityRing();
+	void OnLeaderRemoved(int64_t LeaderId);
+	void OnLeaderFailover(int64_t LeaderId);
 
 	// void UpdateClientStates();
 
@@ -118,6 +151,13 @@ private:
 
 	ClientProxy* Leader;
 
+	LeaderFailover Failover;
+
+	ScriptAuthorityRing AuthorityRing;
+	// The local client's choice, and the one in effect, which is the leader's
+	bool IsPartitioningRequested;
+	std::atomic_bool IsAuthorityPartitioned;
+
 	csp::multiplayer::SpaceEntitySystem::CallbackHandler ScriptSystemReadyCallback;
 };
 
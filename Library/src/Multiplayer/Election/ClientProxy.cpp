@@ -138,6 +138,10 @@ void ClientProxy::HandleEvent(int64_t EventType, int64_t ClientId)
 			break;
 		case ClientElectionMessageType::ElectionNotifyLeader:
 			HandleElectionNotifyLeaderEvent(ClientId);
+			break;
+		case ClientElectionMessageType::LeaderHeartbeat:
+			// Handled by the election manager, as it carries the leader's epoch
+			break;
 	}
 }
 
@@ -155,8 +159,8 @@ void ClientProxy::RunScript(int64_t ContextId, const csp::common::String& Script
 {
 	if (ContextId != Id)
 	{
-		const int64_t LeaderClientId = ElectionManagerPtr->GetLeader()->GetId();
-		SendRemoteRunScriptEvent(LeaderClientId, ContextId, ScriptText);
+		// Run by the client this proxy represents, which is the leader, or the script authority for the entity when authority is partitioned
+		SendRemoteRunScriptEvent(Id, ContextId, ScriptText);
 	}
 	else
 	{
@@ -165,6 +169,31 @@ void ClientProxy::RunScript(int64_t ContextId, const csp::common::String& Script
 	}
 }
 
+void ClientProxy::SendLeaderHeartbeat(uint64_t Epoch, bool IsAuthorityPartitioned)
+{
+	auto& SystemsManager			  = csp::systems::SystemsManager::Get();
+	MultiplayerConnection* Connection = SystemsManager.GetMultiplayerConnection();
+
+	const int64_t MessageId = Eid++;
+
+	const MultiplayerConnection::ErrorCodeCallbackHandler SignalRCallback = [](ErrorCode Error)
+	{
+		if (Error != ErrorCode::None)
+		{
+			CSP_LOG_ERROR_MSG("ClientProxy::SendLeaderHeartbeat: SignalR connection: Error");
+		}
+	};
+
+	// @Note This needs to be kept in sync with ClientElectionManager::OnClientElectionEvent
+	Connection->SendNetworkEvent(ClientElectionMessage,
+								 {ReplicatedValue(static_cast<int64_t>(ClientElectionMessageType::LeaderHeartbeat)),
+								  ReplicatedValue(Id),
+								  ReplicatedValue(MessageId),
+								  ReplicatedValue(static_cast<int64_t>(Epoch)),
+								  ReplicatedValue(IsAuthorityPartitioned)},
+								 SignalRCallback);
+}
+
 void ClientProxy::HandleIdleState()
 {
 	// Nothing to do currently
@@ -235,8 +264,11 @@ void ClientProxy::SendRemoteRunScriptEvent(int64_t TargetClientId, int64_t Conte
 				   ContextId,
 				   ScriptText.c_str());
 
+	// Sent with the epoch of the leader we know about, so that a leader that has since been replaced can tell, and won't run it
+	const int64_t Epoch = static_cast<int64_t>(ElectionManagerPtr->GetLeaderEpoch());
+
 	Connection->SendNetworkEventToClient(RemoteRunScriptMessage,
-										 {ReplicatedValue(ContextId), ReplicatedValue(ScriptText)},
+										 {ReplicatedValue(ContextId), ReplicatedValue(ScriptText), ReplicatedValue(Epoch)},
 										 TargetClientId,
 										 SignalRCallback);
 }
@@ -52,6 +52,9 @@ constexpr const char* RemoteRunScriptMessage = "RemoteRunScriptMessage";
 // Default time to wait for a response from an election message
 constexpr const std::chrono::system_clock::duration DefaultElectionTimeOut = std::chrono::milliseconds(2000);
 
+// Default time to wait without a heartbeat from the leader before its successor takes over
+constexpr const std::chrono::milliseconds DefaultLeaderHeartbeatTimeOut = std::chrono::milliseconds(2000);
+
 
 enum class ClientElectionMessageType
 {
@@ -59,6 +62,7 @@ enum class ClientElectionMessageType
 	ElectionResponse,
 	ElectionLeader,
 	ElectionNotifyLeader,
+	LeaderHeartbeat,
 
 	NumElectionMessages
 };
@@ -98,6 +102,9 @@ public:
 
 	void RunScript(int64_t ContextId, const csp::common::String& ScriptText);
 
+	// Sends a heartbeat to every client, as leader, with whether the leader has script authority partitioned
+	void SendLeaderHeartbeat(uint64_t Epoch, bool IsAuthorityPartitioned);
+
 private:
 	void HandleIdleState();
 	void HandleElectingState();
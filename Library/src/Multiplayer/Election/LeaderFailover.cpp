@@ -0,0 +1,352 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "LeaderFailover.h"
+
+
+namespace csp::multiplayer
+{
+
+LeaderFailover::LeaderFailover(Clock::duration InHeartbeatInterval,
+							   Clock::duration InTimeout,
+							   SendHeartbeatCallback InSendHeartbeat,
+							   LeaderChangedCallback InLeaderChanged)
+	: HeartbeatInterval(InHeartbeatInterval)
+	, Timeout(InTimeout)
+	, SendHeartbeat(std::move(InSendHeartbeat))
+	, LeaderChanged(std::move(InLeaderChanged))
+	, LocalClientId(NoClient)
+	, LeaderId(NoClient)
+	, SuccessorId(NoClient)
+	, Epoch(0)
+	, IsLeaderArmed(false)
+{
+}
+
+void LeaderFailover::SetTimeout(Clock::duration InTimeout)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Timeout			  = InTimeout;
+	HeartbeatInterval = InTimeout / 4;
+}
+
+void LeaderFailover::SetLocalClient(int64_t ClientId, Clock::time_point Now)
+{
+	std::scoped_lock Lock(Mutex);
+
+	LocalClientId = ClientId;
+	LastHeard	  = Now;
+
+	if (ClientId != NoClient)
+	{
+		Clients.insert(ClientId);
+		UpdateSuccessor();
+	}
+}
+
+void LeaderFailover::AddClient(int64_t ClientId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Clients.insert(ClientId);
+	UpdateSuccessor();
+}
+
+void LeaderFailover::RemoveClient(int64_t ClientId, Clock::time_point Now)
+{
+	Notifications Notify;
+	uint64_t NotifyEpoch;
+	int64_t NotifyLeaderId;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		Clients.erase(ClientId);
+		Suspected.erase(ClientId);
+
+		if (ClientId == LocalClientId)
+		{
+			LocalClientId = NoClient;
+		}
+
+		if (ClientId == LeaderId && LocalClientId != NoClient)
+		{
+			FailOver(Now, Notify);
+		}
+		else
+		{
+			UpdateSuccessor();
+		}
+
+		NotifyEpoch	   = Epoch;
+		NotifyLeaderId = LeaderId;
+	}
+
+	Send(Notify, NotifyEpoch, NotifyLeaderId);
+}
+
+void LeaderFailover::Clear()
+{
+	std::scoped_lock Lock(Mutex);
+
+	Clients.clear();
+	Suspected.clear();
+	LocalClientId = NoClient;
+	LeaderId	  = NoClient;
+	SuccessorId	  = NoClient;
+	Epoch		  = 0;
+	IsLeaderArmed = false;
+}
+
+void LeaderFailover::SetLeader(int64_t NewLeaderId, Clock::time_point Now)
+{
+	Notifications Notify;
+	uint64_t NotifyEpoch;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		if (NewLeaderId == LeaderId)
+		{
+			return;
+		}
+
+		LeaderId	  = NewLeaderId;
+		LastHeard	  = Now;
+		IsLeaderArmed = false;
+		Suspected.erase(NewLeaderId);
+		UpdateSuccessor();
+
+		if (NewLeaderId != NoClient && NewLeaderId == LocalClientId)
+		{
+			++Epoch;
+			LastSent			 = Now;
+			Notify.SendHeartbeat = true;
+		}
+
+		NotifyEpoch = Epoch;
+	}
+
+	Send(Notify, NotifyEpoch, NewLeaderId);
+}
+
+bool LeaderFailover::OnHeartbeat(int64_t HeartbeatLeaderId, uint64_t HeartbeatEpoch, Clock::time_point Now)
+{
+	Notifications Notify;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		if (HeartbeatEpoch < Epoch)
+		{
+			return false;
+		}
+
+		// Within an epoch the higher id wins, as it would in an election. This settles two clients promoting themselves with different
+		// views of who was alive, and lets a follower go back to a leader it gave up on too early.
+		if (HeartbeatEpoch == Epoch && LeaderId != NoClient && HeartbeatLeaderId < LeaderId)
+		{
+			return false;
+		}
+
+		// A new leader under a newer epoch has taken over by failing over from the one we were following, even if we hadn't yet timed
+		// it out ourselves. This includes finding out that we were that leader.
+		if (HeartbeatEpoch > Epoch && LeaderId != NoClient && LeaderId != HeartbeatLeaderId && Clients.count(LeaderId) > 0)
+		{
+			Suspected.insert(LeaderId);
+		}
+
+		Epoch		  = HeartbeatEpoch;
+		LastHeard	  = Now;
+		IsLeaderArmed = true;
+		Suspected.erase(HeartbeatLeaderId);
+
+		if (HeartbeatLeaderId != LeaderId)
+		{
+			ChangeLeader(HeartbeatLeaderId, Now, Notify);
+		}
+	}
+
+	Send(Notify, HeartbeatEpoch, HeartbeatLeaderId);
+
+	return true;
+}
+
+void LeaderFailover::Update(Clock::time_point Now)
+{
+	Notifications Notify;
+	uint64_t NotifyEpoch;
+	int64_t NotifyLeaderId;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		if (LocalClientId == NoClient)
+		{
+			return;
+		}
+
+		if (LeaderId == LocalClientId)
+		{
+			if (Now - LastSent >= HeartbeatInterval)
+			{
+				LastSent			 = Now;
+				Notify.SendHeartbeat = true;
+			}
+		}
+		else if (IsLeaderArmed && Now - LastHeard > Timeout && Clients.size() > 1)
+		{
+			// Also covers having stepped down without hearing who replaced us
+			if (LeaderId != NoClient)
+			{
+				Suspected.insert(LeaderId);
+			}
+
+			FailOver(Now, Notify);
+		}
+
+		NotifyEpoch	   = Epoch;
+		NotifyLeaderId = LeaderId;
+	}
+
+	Send(Notify, NotifyEpoch, NotifyLeaderId);
+}
+
+bool LeaderFailover::CanApplyScriptWrite(uint64_t SenderEpoch, Clock::time_point Now)
+{
+	Notifications Notify;
+	uint64_t NotifyEpoch;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		if (SenderEpoch > Epoch)
+		{
+			// The sender has heard from a newer leader than we have, so we're no longer the leader if we ever were. Wait to hear from
+			// the new one, or fail over if we don't.
+			Epoch = SenderEpoch;
+
+			if (LocalClientId != NoClient && LeaderId == LocalClientId)
+			{
+				// The others have failed over from us, so suspect ourselves as they do
+				Suspected.insert(LocalClientId);
+				ChangeLeader(NoClient, Now, Notify);
+			}
+		}
+
+		NotifyEpoch = Epoch;
+
+		if (!Notify.LeaderChanged)
+		{
+			return LocalClientId != NoClient && LeaderId == LocalClientId;
+		}
+	}
+
+	Send(Notify, NotifyEpoch, NoClient);
+
+	return false;
+}
+
+int64_t LeaderFailover::GetLeader() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return LeaderId;
+}
+
+int64_t LeaderFailover::GetSuccessor() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return SuccessorId;
+}
+
+bool LeaderFailover::IsSuspected(int64_t ClientId) const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Suspected.count(ClientId) > 0;
+}
+
+uint64_t LeaderFailover::GetEpoch() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Epoch;
+}
+
+bool LeaderFailover::IsLocalClientLeader() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return LocalClientId != NoClient && LeaderId == LocalClientId;
+}
+
+void LeaderFailover::FailOver(Clock::time_point Now, Notifications& Notify)
+{
+	const int64_t NewLeaderId = SuccessorId;
+
+	if (NewLeaderId == LocalClientId)
+	{
+		// Promote ourselves straight away, and tell everyone under a new epoch so the old leader's writes can be told apart from ours
+		++Epoch;
+		LastSent			 = Now;
+		Notify.SendHeartbeat = true;
+	}
+
+	// Followers treat the successor as leader until they hear its first heartbeat, and move on to the next if they don't
+	ChangeLeader(NewLeaderId, Now, Notify);
+}
+
+void LeaderFailover::ChangeLeader(int64_t NewLeaderId, Clock::time_point Now, Notifications& Notify)
+{
+	LeaderId			 = NewLeaderId;
+	LastHeard			 = Now;
+	IsLeaderArmed		 = true;
+	Notify.LeaderChanged = true;
+
+	UpdateSuccessor();
+}
+
+void LeaderFailover::UpdateSuccessor()
+{
+	SuccessorId = NoClient;
+
+	for (auto It = Clients.rbegin(); It != Clients.rend(); ++It)
+	{
+		if (*It != LeaderId && Suspected.count(*It) == 0)
+		{
+			SuccessorId = *It;
+
+			break;
+		}
+	}
+}
+
+void LeaderFailover::Send(const Notifications& Notify, uint64_t NotifyEpoch, int64_t NotifyLeaderId)
+{
+	if (Notify.SendHeartbeat && SendHeartbeat)
+	{
+		SendHeartbeat(NotifyEpoch);
+	}
+
+	if (Notify.LeaderChanged && LeaderChanged)
+	{
+		LeaderChanged(NotifyLeaderId, NotifyEpoch);
+	}
+}
+
+} // namespace csp::multiplayer
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+
+
+namespace csp::multiplayer
+{
+
+/// <summary>
+/// Tracks the liveness of the script leader through heartbeats, and fails over to a successor without running a new election.
+///     The leader broadcasts a heartbeat carrying its epoch every heartbeat interval. A follower that hears nothing from the leader for
+/// longer than the timeout, or sees it removed, hands leadership to the successor: the client with the next-highest id, which is who a
+/// full election would pick. The successor promotes itself straight away under a new epoch, and the other followers treat it as the
+/// leader while they wait for its first heartbeat. If that doesn't arrive within the timeout either, the successor is skipped in turn.
+///     A leader chosen by an election is only timed out once it has sent a heartbeat. A client running an older version never sends
+/// them, and failing over from it would leave two leaders, since it would keep running scripts without knowing it had been replaced.
+///     Epochs fence off stale leaders. A heartbeat or script from an older epoch is rejected, and a leader that sees a newer epoch steps
+/// down, so a leader that was cut off can't keep applying script writes once another client has taken over.
+///     A leader that has been failed over from is suspected until it is heard from as leader again or leaves. Every client comes to
+/// suspect it, whether it timed the leader out itself, heard from the successor under a newer epoch first, or was that leader.
+/// All times are passed in, so the state can be driven by a simulated clock in tests.
+/// </summary>
+class LeaderFailover
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr int64_t NoClient = 0;
+
+	/// <summary>
+	/// Called to broadcast a heartbeat from the local client, as leader, with the given epoch.
+	/// </summary>
+	typedef std::function<void(uint64_t Epoch)> SendHeartbeatCallback;
+
+	/// <summary>
+	/// Called when the leader changes because of a failover, a heartbeat or a step-down, but not because of a call to SetLeader.
+	/// LeaderId is NoClient while the local client is waiting to hear who replaced it.
+	/// </summary>
+	typedef std::function<void(int64_t LeaderId, uint64_t Epoch)> LeaderChangedCallback;
+
+	LeaderFailover(Clock::duration InHeartbeatInterval,
+				   Clock::duration InTimeout,
+				   SendHeartbeatCallback InSendHeartbeat,
+				   LeaderChangedCallback InLeaderChanged);
+
+	/// <summary>
+	/// Sets how long to wait for a heartbeat before failing over, with heartbeats sent four times within it.
+	/// </summary>
+	void SetTimeout(Clock::duration InTimeout);
+
+	void SetLocalClient(int64_t ClientId, Clock::time_point Now);
+	void AddClient(int64_t ClientId);
+
+	/// <summary>
+	/// Removes a client, failing over straight away if it was the leader.
+	/// </summary>
+	void RemoveClient(int64_t ClientId, Clock::time_point Now);
+
+	void Clear();
+
+	/// <summary>
+	/// Sets the leader chosen by an election. If it is the local client, it starts a new epoch and sends a heartbeat straight away.
+	/// </summary>
+	void SetLeader(int64_t LeaderId, Clock::time_point Now);
+
+	/// <summary>
+	/// Handles a heartbeat from a leader. Returns false if it was rejected as coming from a stale leader.
+	/// </summary>
+	bool OnHeartbeat(int64_t LeaderId, uint64_t HeartbeatEpoch, Clock::time_point Now);
+
+	/// <summary>
+	/// Sends the leader's heartbeat when it is due, and fails over if the leader's heartbeat is overdue.
+	/// </summary>
+	void Update(Clock::time_point Now);
+
+	/// <summary>
+	/// Returns true if the local client is the leader and may apply a script write sent under SenderEpoch. A write sent under a newer
+	/// epoch than the local client knows about means it has been replaced, so it steps down.
+	/// </summary>
+	bool CanApplyScriptWrite(uint64_t SenderEpoch, Clock::time_point Now);
+
+	int64_t GetLeader() const;
+	int64_t GetSuccessor() const;
+
+	/// <summary>
+	/// Returns true if leadership has failed over from the client, which may have stopped without leaving the space.
+	/// </summary>
+	bool IsSuspected(int64_t ClientId) const;
+
+	uint64_t GetEpoch() const;
+	bool IsLocalClientLeader() const;
+
+private:
+	struct Notifications
+	{
+		bool SendHeartbeat = false;
+		bool LeaderChanged = false;
+	};
+
+	// These expect Mutex to be held
+	void FailOver(Clock::time_point Now, Notifications& Notify);
+	void ChangeLeader(int64_t NewLeaderId, Clock::time_point Now, Notifications& Notify);
+	void UpdateSuccessor();
+	void Send(const Notifications& Notify, uint64_t NotifyEpoch, int64_t NotifyLeaderId);
+
+	Clock::duration HeartbeatInterval;
+	Clock::duration Timeout;
+	SendHeartbeatCallback SendHeartbeat;
+	LeaderChangedCallback LeaderChanged;
+
+	mutable std::mutex Mutex;
+	std::set<int64_t> Clients;
+	// Clients that leadership has failed over from, which are skipped as successors until they are heard from again
+	std::set<int64_t> Suspected;
+	int64_t LocalClientId;
+	int64_t LeaderId;
+	int64_t SuccessorId;
+	uint64_t Epoch;
+	// Whether the leader can be timed out: it has sent a heartbeat, or was promoted by a failover and so knows to send them
+	bool IsLeaderArmed;
+	Clock::time_point LastHeard;
+	Clock::time_point LastSent;
+};
+
+} // namespace csp::multiplayer
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Multiplayer/Election/ScriptAuthorityRing.h"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace csp::multiplayer
+{
+
+ScriptAuthorityRing::ScriptAuthorityRing(uint32_t InPointsPerClient) : PointsPerClient(std::max<uint32_t>(InPointsPerClient, 1)), NumClients(0)
+{
+}
+
+void ScriptAuthorityRing::AddClient(int64_t ClientId)
+{
+	if (HasClient(ClientId))
+	{
+		return;
+	}
+
+	const uint64_t ClientHash = Hash(static_cast<uint64_t>(ClientId));
+
+	Points.reserve(Points.size() + PointsPerClient);
+
+	for (uint32_t i = 0; i < PointsPerClient; ++i)
+	{
+		Points.emplace_back(Hash(ClientHash + i), ClientId);
+	}
+
+	std::sort(Points.begin(), Points.end());
+	++NumClients;
+}
+
+void ScriptAuthorityRing::RemoveClient(int64_t ClientId)
+{
+	const auto NewEnd = std::remove_if(Points.begin(),
+									   Points.end(),
+									   [ClientId](const std::pair<uint64_t, int64_t>& Point)
+									   {
+										   return Point.second == ClientId;
+									   });
+
+	if (NewEnd != Points.end())
+	{
+		Points.erase(NewEnd, Points.end());
+		--NumClients;
+	}
+}
+
+void ScriptAuthorityRing::Clear()
+{
+	Points.clear();
+	NumClients = 0;
+}
+
+bool ScriptAuthorityRing::HasClient(int64_t ClientId) const
+{
+	const uint64_t ClientHash = Hash(static_cast<uint64_t>(ClientId));
+
+	return std::binary_search(Points.begin(), Points.end(), std::make_pair(Hash(ClientHash), ClientId));
+}
+
+size_t ScriptAuthorityRing::GetNumClients() const
+{
+	return NumClients;
+}
+
+int64_t ScriptAuthorityRing::GetAuthority(uint64_t EntityId) const
+{
+	if (Points.empty())
+	{
+		return NoClient;
+	}
+
+	const auto Point = std::lower_bound(Points.begin(), Points.end(), std::make_pair(Hash(EntityId), std::numeric_limits<int64_t>::min()));
+
+	// Past the last point wraps around to the first
+	return (Point != Points.end()) ? Point->second : Points.front().second;
+}
+
+uint64_t ScriptAuthorityRing::Hash(uint64_t Value)
+{
+	// SplitMix64 finaliser. Entity and client ids are often sequential, so they need mixing well to spread them around the ring.
+	Value += 0x9E3779B97F4A7C15ULL;
+	Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBULL;
+
+	return Value ^ (Value >> 31);
+}
+
+} // namespace csp::multiplayer
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace csp::multiplayer
+{
+
+/// <summary>
+/// Shares out script authority for entities between clients by consistent hashing.
+///     Each client is placed at a number of points on a hash ring, and an entity belongs to the client at the first point at or after the
+/// entity's own hash. Adding a client only takes entities from the clients just before its points, and removing one only hands its
+/// entities on to the clients after them, so every other entity keeps its authority. Placing each client at many points keeps the share
+/// of entities each client gets close to even.
+/// The hash is fixed rather than std::hash, so that every client computes the same assignment whatever platform it is running on.
+/// </summary>
+class ScriptAuthorityRing
+{
+public:
+	static constexpr int64_t NoClient				 = 0;
+	static constexpr uint32_t DefaultPointsPerClient = 256;
+
+	explicit ScriptAuthorityRing(uint32_t InPointsPerClient = DefaultPointsPerClient);
+
+	void AddClient(int64_t ClientId);
+	void RemoveClient(int64_t ClientId);
+	void Clear();
+
+	bool HasClient(int64_t ClientId) const;
+	size_t GetNumClients() const;
+
+	/// <summary>
+	/// Returns the client with authority over the entity with the given id, or NoClient if there are no clients.
+	/// </summary>
+	int64_t GetAuthority(uint64_t EntityId) const;
+
+	static uint64_t Hash(uint64_t Value);
+
+private:
+	// Sorted by hash, then client id, so that clients agree on the owner of a point that two clients happen to share
+	std::vector<std::pair<uint64_t, int64_t>> Points;
+	uint32_t PointsPerClient;
+	size_t NumClients;
+};
+
+} // namespace csp::multiplayer
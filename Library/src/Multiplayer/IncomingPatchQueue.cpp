@@ -0,0 +1,597 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "IncomingPatchQueue.h"
+
+#include "Common/WorkStealingExecutor.h"
+#include "Debug/Logging.h"
+#include "Multiplayer/MsgPackEntitySerialiser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+
+namespace
+{
+
+// Below this many patches, handing them to the decode workers costs more than it saves
+constexpr size_t MIN_PATCHES_TO_DECODE_IN_PARALLEL = 256;
+constexpr size_t PATCHES_PER_DECODE_TASK		   = 64;
+constexpr size_t MAX_DEFAULT_DECODE_WORKERS		   = 4;
+
+template <typename T, typename KeyType> T* FindById(std::vector<T>& Items, KeyType Id)
+{
+	for (auto& Item : Items)
+	{
+		if (Item.Id == Id)
+		{
+			return &Item;
+		}
+	}
+
+	return nullptr;
+}
+
+template <typename KeyType> void SetValue(std::vector<std::pair<KeyType, csp::multiplayer::ReplicatedValue>>& Values,
+										  KeyType Key,
+										  const csp::multiplayer::ReplicatedValue& Value)
+{
+	for (auto& Existing : Values)
+	{
+		if (Existing.first == Key)
+		{
+			Existing.second = Value;
+
+			return;
+		}
+	}
+
+	Values.emplace_back(Key, Value);
+}
+
+// Shared between Flush() and the decode tasks, as tasks may still be starting after Flush() has returned
+struct DecodeBatch
+{
+	std::atomic<size_t> NextChunk = 0;
+	size_t NumChunks			  = 0;
+
+	std::mutex Mutex;
+	std::condition_variable Done;
+	size_t NumChunksDone = 0;
+};
+
+} // namespace
+
+
+namespace csp::multiplayer
+{
+
+IncomingEntityPatch IncomingEntityPatch::Decode(const signalr::value& EntityMessage)
+{
+	MsgPackEntityDeserialiser Deserialiser(EntityMessage);
+	IncomingEntityPatch Patch;
+
+	Deserialiser.EnterEntity();
+	{
+		Patch.EntityId = Deserialiser.ReadUInt64();
+		Patch.OwnerId  = Deserialiser.ReadUInt64();
+		Patch.Destroy  = Deserialiser.ReadBool();
+
+		if (Deserialiser.NextValueIsArray())
+		{
+			uint32_t Size = 0;
+			Deserialiser.EnterArray(Size);
+			{
+				Patch.ShouldUpdateParent = Deserialiser.ReadBool();
+
+				if (Deserialiser.NextValueIsNull())
+				{
+					Deserialiser.Skip();
+				}
+				else
+				{
+					Patch.HasParentId = true;
+					Patch.ParentId	  = Deserialiser.ReadUInt64();
+				}
+			}
+			Deserialiser.LeaveArray();
+		}
+
+		// Components are ignored when destroying an entity
+		if (!Patch.Destroy && !Deserialiser.NextValueIsNull())
+		{
+			Patch.HasComponents = true;
+
+			Deserialiser.EnterComponents();
+			{
+				std::vector<uint16_t> ViewComponentIds;
+				Deserialiser.GetViewComponentIds(ViewComponentIds);
+
+				Patch.ViewComponents.reserve(ViewComponentIds.size());
+
+				for (const uint16_t Id : ViewComponentIds)
+				{
+					Patch.ViewComponents.emplace_back(Id, Deserialiser.GetViewComponent(Id));
+				}
+
+				auto RealComponentCount = Deserialiser.GetNumRealComponents();
+				Patch.Components.reserve(RealComponentCount);
+
+				while (RealComponentCount--)
+				{
+					Component& NewComponent = Patch.Components.emplace_back();
+
+					Deserialiser.EnterComponent(NewComponent.Id, NewComponent.Type);
+					{
+						const auto NumProperties = Deserialiser.GetNumProperties();
+						NewComponent.Properties.reserve(NumProperties);
+
+						for (uint64_t i = 0; i < NumProperties; ++i)
+						{
+							uint64_t PropertyKey;
+							auto PropertyValue = Deserialiser.ReadProperty(PropertyKey);
+
+							NewComponent.Properties.emplace_back(PropertyKey, PropertyValue);
+						}
+					}
+					Deserialiser.LeaveComponent();
+				}
+			}
+			Deserialiser.LeaveComponents();
+		}
+	}
+	Deserialiser.LeaveEntity();
+
+	return Patch;
+}
+
+bool IncomingEntityPatch::Merge(IncomingEntityPatch& Later)
+{
+	if (Destroy || Later.Destroy)
+	{
+		return false;
+	}
+
+	for (const auto& LaterComponent : Later.Components)
+	{
+		const Component* Existing = FindById(Components, LaterComponent.Id);
+
+		if (Existing != nullptr && Existing->Type != LaterComponent.Type)
+		{
+			return false;
+		}
+	}
+
+	for (auto& LaterComponent : Later.Components)
+	{
+		if (Component* Existing = FindById(Components, LaterComponent.Id))
+		{
+			for (const auto& Property : LaterComponent.Properties)
+			{
+				SetValue(Existing->Properties, Property.first, Property.second);
+			}
+		}
+		else
+		{
+			Components.push_back(std::move(LaterComponent));
+		}
+	}
+
+	for (const auto& ViewComponent : Later.ViewComponents)
+	{
+		SetValue(ViewComponents, ViewComponent.first, ViewComponent.second);
+	}
+
+	// Every patch carries the entity's current owner and parent, but the hierarchy is only resolved when one asks for it
+	OwnerId			   = Later.OwnerId;
+	HasParentId		   = Later.HasParentId;
+	ParentId		   = Later.ParentId;
+	ShouldUpdateParent = ShouldUpdateParent || Later.ShouldUpdateParent;
+	HasComponents	   = HasComponents || Later.HasComponents;
+
+	return true;
+}
+
+
+IncomingEntityPatchReader::IncomingEntityPatchReader(const IncomingEntityPatch& InPatch) : Patch(InPatch)
+{
+}
+
+void IncomingEntityPatchReader::EnterEntity()
+{
+}
+
+void IncomingEntityPatchReader::LeaveEntity()
+{
+}
+
+bool IncomingEntityPatchReader::ReadBool()
+{
+	throw std::runtime_error("ReadBool() function not supported by IncomingEntityPatchReader!");
+}
+
+uint8_t IncomingEntityPatchReader::ReadByte()
+{
+	throw std::runtime_error("ReadByte() function not supported by IncomingEntityPatchReader!");
+}
+
+double IncomingEntityPatchReader::ReadDouble()
+{
+	throw std::runtime_error("ReadDouble() function not supported by IncomingEntityPatchReader!");
+}
+
+int64_t IncomingEntityPatchReader::ReadInt64()
+{
+	throw std::runtime_error("ReadInt64() function not supported by IncomingEntityPatchReader!");
+}
+
+uint64_t IncomingEntityPatchReader::ReadUInt64()
+{
+	throw std::runtime_error("ReadUInt64() function not supported by IncomingEntityPatchReader!");
+}
+
+csp::common::String IncomingEntityPatchReader::ReadString()
+{
+	throw std::runtime_error("ReadString() function not supported by IncomingEntityPatchReader!");
+}
+
+csp::common::Vector2 IncomingEntityPatchReader::ReadVector2()
+{
+	throw std::runtime_error("ReadVector2() function not supported by IncomingEntityPatchReader!");
+}
+
+csp::common::Vector3 IncomingEntityPatchReader::ReadVector3()
+{
+	throw std::runtime_error("ReadVector3() function not supported by IncomingEntityPatchReader!");
+}
+
+csp::common::Vector4 IncomingEntityPatchReader::ReadVector4()
+{
+	throw std::runtime_error("ReadVector4() function not supported by IncomingEntityPatchReader!");
+}
+
+bool IncomingEntityPatchReader::NextValueIsNull()
+{
+	assert(!InComponents && "NextValueIsNull() function not supported in current state!");
+
+	// An empty components section is read as null, in the same way as MsgPackEntityDeserialiser
+	return !Patch.HasComponents || (Patch.Components.empty() && Patch.ViewComponents.empty());
+}
+
+bool IncomingEntityPatchReader::NextValueIsArray()
+{
+	return false;
+}
+
+void IncomingEntityPatchReader::EnterComponents()
+{
+	assert(!InComponents && "Components already entered!");
+
+	InComponents	 = true;
+	CurrentComponent = 0;
+}
+
+void IncomingEntityPatchReader::LeaveComponents()
+{
+	assert(InComponents && !InComponent && "Components not entered or component entered!");
+
+	InComponents = false;
+}
+
+void IncomingEntityPatchReader::EnterArray(CSP_OUT uint32_t& OutLength)
+{
+	throw std::runtime_error("EnterArray() function not supported by IncomingEntityPatchReader!");
+}
+
+void IncomingEntityPatchReader::LeaveArray()
+{
+	throw std::runtime_error("LeaveArray() function not supported by IncomingEntityPatchReader!");
+}
+
+uint64_t IncomingEntityPatchReader::GetNumComponents()
+{
+	return Patch.Components.size() + Patch.ViewComponents.size();
+}
+
+uint64_t IncomingEntityPatchReader::GetNumRealComponents()
+{
+	return Patch.Components.size();
+}
+
+void IncomingEntityPatchReader::EnterComponent(CSP_OUT uint16_t& OutId, CSP_OUT uint64_t& OutType)
+{
+	assert(InComponents && !InComponent && "Components not entered or component already entered!");
+	assert(CurrentComponent < Patch.Components.size() && "No more components to read!");
+
+	const auto& Component = Patch.Components[CurrentComponent];
+
+	OutId			= Component.Id;
+	OutType			= Component.Type;
+	InComponent		= true;
+	CurrentProperty = 0;
+}
+
+void IncomingEntityPatchReader::LeaveComponent()
+{
+	assert(InComponent && "Component not entered!");
+
+	InComponent = false;
+	++CurrentComponent;
+}
+
+uint64_t IncomingEntityPatchReader::GetNumProperties()
+{
+	assert(InComponent && "Component not entered!");
+
+	return Patch.Components[CurrentComponent].Properties.size();
+}
+
+ReplicatedValue IncomingEntityPatchReader::ReadProperty(CSP_OUT uint64_t& OutId)
+{
+	assert(InComponent && "Component not entered!");
+
+	const auto& Properties = Patch.Components[CurrentComponent].Properties;
+
+	if (CurrentProperty == Properties.size())
+	{
+		throw std::runtime_error("No more properties to read!");
+	}
+
+	const auto& Property = Properties[CurrentProperty++];
+	OutId				 = Property.first;
+
+	return Property.second;
+}
+
+ReplicatedValue IncomingEntityPatchReader::GetViewComponent(uint16_t Id)
+{
+	for (const auto& ViewComponent : Patch.ViewComponents)
+	{
+		if (ViewComponent.first == Id)
+		{
+			return ViewComponent.second;
+		}
+	}
+
+	return ReplicatedValue();
+}
+
+bool IncomingEntityPatchReader::HasViewComponent(uint16_t Id)
+{
+	for (const auto& ViewComponent : Patch.ViewComponents)
+	{
+		if (ViewComponent.first == Id)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void IncomingEntityPatchReader::Skip()
+{
+	throw std::runtime_error("Skip() function not supported by IncomingEntityPatchReader!");
+}
+
+
+IncomingPatchQueue::IncomingPatchQueue(size_t InNumDecodeWorkers) : NumDecodeWorkers(InNumDecodeWorkers)
+{
+}
+
+IncomingPatchQueue::~IncomingPatchQueue()
+{
+	if (DecodeExecutor)
+	{
+		DecodeExecutor->Shutdown();
+	}
+}
+
+size_t IncomingPatchQueue::GetDefaultNumDecodeWorkers()
+{
+#ifdef CSP_WASM
+	return 0;
+#else
+	// Leave a hardware thread for the thread applying the patches, which also decodes its share
+	const size_t NumHardwareThreads = std::thread::hardware_concurrency();
+
+	return std::min(NumHardwareThreads > 1 ? NumHardwareThreads - 1 : 0, MAX_DEFAULT_DECODE_WORKERS);
+#endif
+}
+
+void IncomingPatchQueue::Push(const signalr::value& EntityMessage)
+{
+	std::scoped_lock Lock(Mutex);
+	Pending.push_back(EntityMessage);
+}
+
+void IncomingPatchQueue::Clear()
+{
+	std::scoped_lock Lock(Mutex);
+	Pending.clear();
+}
+
+size_t IncomingPatchQueue::GetSize() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Pending.size();
+}
+
+std::vector<IncomingEntityPatch> IncomingPatchQueue::Flush()
+{
+	std::vector<signalr::value> Messages;
+
+	{
+		std::scoped_lock Lock(Mutex);
+		Messages.swap(Pending);
+	}
+
+	std::vector<IncomingEntityPatch> Patches(Messages.size());
+	std::vector<char> Decoded(Messages.size(), false);
+
+	Decode(Messages, Patches, Decoded);
+
+	// Drop the patches which failed to decode
+	size_t NumDecoded = 0;
+
+	for (size_t i = 0; i < Patches.size(); ++i)
+	{
+		if (Decoded[i])
+		{
+			if (NumDecoded != i)
+			{
+				Patches[NumDecoded] = std::move(Patches[i]);
+			}
+
+			++NumDecoded;
+		}
+	}
+
+	Patches.resize(NumDecoded);
+
+	Coalesce(Patches);
+
+	return Patches;
+}
+
+void IncomingPatchQueue::Coalesce(std::vector<IncomingEntityPatch>& Patches)
+{
+	// Index of the patch each entity's later patches are merged into
+	std::unordered_map<uint64_t, size_t> OpenPatches;
+	size_t NumMerged = 0;
+
+	for (size_t i = 0; i < Patches.size(); ++i)
+	{
+		IncomingEntityPatch& Patch = Patches[i];
+
+		if (Patch.Destroy)
+		{
+			// Destroying an entity can affect others, such as deselecting the entities a departing avatar had selected,
+			// so keep everything received after it after it
+			OpenPatches.clear();
+		}
+		else
+		{
+			const auto It = OpenPatches.find(Patch.EntityId);
+
+			if (It != OpenPatches.end() && Patches[It->second].Merge(Patch))
+			{
+				continue;
+			}
+
+			OpenPatches[Patch.EntityId] = NumMerged;
+		}
+
+		if (NumMerged != i)
+		{
+			Patches[NumMerged] = std::move(Patch);
+		}
+
+		++NumMerged;
+	}
+
+	Patches.resize(NumMerged);
+}
+
+void IncomingPatchQueue::Decode(const std::vector<signalr::value>& Messages,
+								std::vector<IncomingEntityPatch>& OutPatches,
+								std::vector<char>& OutDecoded)
+{
+	const size_t NumChunks = (Messages.size() + PATCHES_PER_DECODE_TASK - 1) / PATCHES_PER_DECODE_TASK;
+
+	const auto DecodeChunk = [&Messages, &OutPatches, &OutDecoded](size_t Chunk)
+	{
+		const size_t End = std::min((Chunk + 1) * PATCHES_PER_DECODE_TASK, Messages.size());
+
+		for (size_t i = Chunk * PATCHES_PER_DECODE_TASK; i < End; ++i)
+		{
+			try
+			{
+				OutPatches[i] = IncomingEntityPatch::Decode(Messages[i]);
+				OutDecoded[i] = true;
+			}
+			catch (const std::exception& e)
+			{
+				CSP_LOG_FORMAT(csp::systems::LogLevel::Error, "Failed to decode a received patch message. Exception: %s", e.what());
+			}
+		}
+	};
+
+	if (NumDecodeWorkers == 0 || Messages.size() < MIN_PATCHES_TO_DECODE_IN_PARALLEL)
+	{
+		for (size_t Chunk = 0; Chunk < NumChunks; ++Chunk)
+		{
+			DecodeChunk(Chunk);
+		}
+
+		return;
+	}
+
+	if (!DecodeExecutor)
+	{
+		DecodeExecutor = std::make_unique<csp::WorkStealingExecutor>(NumDecodeWorkers);
+	}
+
+	// Workers and the calling thread take chunks until there are none left. A worker that only starts once every chunk has been
+	// taken returns without touching the messages, so it doesn't matter if it runs after this function has returned.
+	auto Batch		 = std::make_shared<DecodeBatch>();
+	Batch->NumChunks = NumChunks;
+
+	const auto DecodeChunks = [Batch, DecodeChunk]()
+	{
+		for (size_t Chunk = Batch->NextChunk++; Chunk < Batch->NumChunks; Chunk = Batch->NextChunk++)
+		{
+			DecodeChunk(Chunk);
+
+			std::scoped_lock Lock(Batch->Mutex);
+
+			if (++Batch->NumChunksDone == Batch->NumChunks)
+			{
+				Batch->Done.notify_one();
+			}
+		}
+	};
+
+	const size_t NumTasks = std::min(NumDecodeWorkers, NumChunks - 1);
+
+	for (size_t i = 0; i < NumTasks; ++i)
+	{
+		DecodeExecutor->Enqueue(
+			[DecodeChunks](void*) -> void*
+			{
+				DecodeChunks();
+
+				return nullptr;
+			},
+			ETaskPriority::High);
+	}
+
+	DecodeChunks();
+
+	std::unique_lock Lock(Batch->Mutex);
+	Batch->Done.wait(Lock,
+					 [&Batch]()
+					 {
+						 return Batch->NumChunksDone == Batch->NumChunks;
+					 });
+}
+
+} // namespace csp::multiplayer
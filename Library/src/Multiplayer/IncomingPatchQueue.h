@@ -0,0 +1,177 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "CSP/Multiplayer/IEntitySerialiser.h"
+#include "CSP/Multiplayer/ReplicatedValue.h"
+
+#include <signalrclient/signalr_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace csp
+{
+
+class WorkStealingExecutor;
+
+} // namespace csp
+
+
+namespace csp::multiplayer
+{
+
+/// <summary>
+/// An entity patch received from the server, decoded into plain values so that it can be merged with later patches for the
+/// same entity, and applied without reading msgpack again.
+/// </summary>
+struct IncomingEntityPatch
+{
+	struct Component
+	{
+		uint16_t Id;
+		uint64_t Type;
+		std::vector<std::pair<uint64_t, ReplicatedValue>> Properties;
+	};
+
+	/// <summary>
+	/// Decodes a msgpack encoded patch, as received by OnObjectPatch. Throws if the patch is malformed.
+	/// </summary>
+	static IncomingEntityPatch Decode(const signalr::value& EntityMessage);
+
+	/// <summary>
+	/// Folds a later patch for the same entity into this one, so that applying the result is equivalent to applying both in turn.
+	///     Later property and view component values replace earlier ones. Returns false, leaving both patches unchanged, if the
+	/// patches can't be merged: if either destroys the entity, or if a component changes type between them, since whether it
+	/// is added, updated or removed depends on the component the entity holds when the patch is applied.
+	/// </summary>
+	bool Merge(IncomingEntityPatch& Later);
+
+	uint64_t EntityId		= 0;
+	uint64_t OwnerId		= 0;
+	bool Destroy			= false;
+	bool ShouldUpdateParent = false;
+	bool HasParentId		= false;
+	uint64_t ParentId		= 0;
+
+	// False if the patch had no components section at all, rather than an empty one
+	bool HasComponents = false;
+	std::vector<std::pair<uint16_t, ReplicatedValue>> ViewComponents;
+	// In the order they were first written
+	std::vector<Component> Components;
+};
+
+
+/// <summary>
+/// Reads the components of a decoded patch through the deserialiser interface, so that SpaceEntity::DeserialiseFromPatch can
+/// apply it in the same way as a patch read straight from msgpack. Only the component functions are supported, as the entity
+/// fields are read from the patch directly. The patch must outlive the reader.
+/// </summary>
+class IncomingEntityPatchReader : public IEntityDeserialiser
+{
+public:
+	IncomingEntityPatchReader(const IncomingEntityPatch& InPatch);
+
+	void EnterEntity() override;
+	void LeaveEntity() override;
+	bool ReadBool() override;
+	uint8_t ReadByte() override;
+	double ReadDouble() override;
+	int64_t ReadInt64() override;
+	uint64_t ReadUInt64() override;
+	csp::common::String ReadString() override;
+	csp::common::Vector2 ReadVector2() override;
+	csp::common::Vector3 ReadVector3() override;
+	csp::common::Vector4 ReadVector4() override;
+	bool NextValueIsNull() override;
+	bool NextValueIsArray() override;
+	void EnterComponents() override;
+	void LeaveComponents() override;
+	void EnterArray(CSP_OUT uint32_t& OutLength) override;
+	void LeaveArray() override;
+	uint64_t GetNumComponents() override;
+	uint64_t GetNumRealComponents() override;
+	void EnterComponent(CSP_OUT uint16_t& OutId, CSP_OUT uint64_t& OutType) override;
+	void LeaveComponent() override;
+	uint64_t GetNumProperties() override;
+	ReplicatedValue ReadProperty(CSP_OUT uint64_t& OutId) override;
+	ReplicatedValue GetViewComponent(uint16_t Id) override;
+	bool HasViewComponent(uint16_t Id) override;
+	void Skip() override;
+
+private:
+	const IncomingEntityPatch& Patch;
+
+	bool InComponents		= false;
+	size_t CurrentComponent = 0;
+	bool InComponent		= false;
+	size_t CurrentProperty	= 0;
+};
+
+
+/// <summary>
+/// Collects the patches received from the server between frames, and turns them into the list of patches to apply.
+///     Push() may be called from any thread, and only holds the queue's own lock while copying the patch in. Flush() decodes every
+/// queued patch, spreading the work over a small pool of decode workers when there are enough of them to be worth it, and then
+/// merges the patches for each entity, so that an entity which was patched several times since the last flush is only updated
+/// once. A patch destroying an entity is never merged, and nothing received after it is merged with anything received before it,
+/// so the patches are applied in an order consistent with the order they were received in.
+/// </summary>
+class IncomingPatchQueue
+{
+public:
+	/// <param name="InNumDecodeWorkers">Number of worker threads used to decode patches. With 0, patches are decoded on the thread calling
+	/// Flush(). Workers are only started the first time they're needed.</param>
+	explicit IncomingPatchQueue(size_t InNumDecodeWorkers);
+	IncomingPatchQueue(const IncomingPatchQueue&) = delete;
+	~IncomingPatchQueue();
+
+	/// <summary>
+	/// The number of decode workers used by SpaceEntitySystem, based on the number of hardware threads.
+	/// </summary>
+	static size_t GetDefaultNumDecodeWorkers();
+
+	void Push(const signalr::value& EntityMessage);
+	void Clear();
+	size_t GetSize() const;
+
+	/// <summary>
+	/// Takes every queued patch and returns them decoded and merged, in the order they should be applied.
+	/// Patches which can't be decoded are logged and dropped.
+	/// </summary>
+	std::vector<IncomingEntityPatch> Flush();
+
+	/// <summary>
+	/// Merges a list of decoded patches in place, in the same way as Flush().
+	/// </summary>
+	static void Coalesce(std::vector<IncomingEntityPatch>& Patches);
+
+private:
+	void Decode(const std::vector<signalr::value>& Messages, std::vector<IncomingEntityPatch>& OutPatches, std::vector<char>& OutDecoded);
+
+	size_t NumDecodeWorkers;
+	std::unique_ptr<csp::WorkStealingExecutor> DecodeExecutor;
+
+	mutable std::mutex Mutex;
+	std::vector<signalr::value> Pending;
+};
+
+} // namespace csp::multiplayer
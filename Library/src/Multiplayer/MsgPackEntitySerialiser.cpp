@@ -0,0 +1,1016 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MsgPackEntitySerialiser.h"
+
+#include "Multiplayer/SpaceEntityKeys.h"
+
+#include <Debug/Logging.h>
+#include <cassert>
+#include <cstring>
+
+
+namespace
+{
+
+// Containers are written with space for the largest possible header, as the number of elements isn't known until they're closed
+constexpr size_t kMaxContainerHeaderSize = 5;
+
+size_t WriteContainerHeader(char* Out, uint32_t Count, bool IsMap)
+{
+	if (Count < 16)
+	{
+		Out[0] = static_cast<char>((IsMap ? 0x80 : 0x90) | Count);
+
+		return 1;
+	}
+
+	if (Count <= 0xFFFF)
+	{
+		Out[0] = static_cast<char>(IsMap ? 0xDE : 0xDC);
+		Out[1] = static_cast<char>(Count >> 8);
+		Out[2] = static_cast<char>(Count);
+
+		return 3;
+	}
+
+	Out[0] = static_cast<char>(IsMap ? 0xDF : 0xDD);
+	Out[1] = static_cast<char>(Count >> 24);
+	Out[2] = static_cast<char>(Count >> 16);
+	Out[3] = static_cast<char>(Count >> 8);
+	Out[4] = static_cast<char>(Count);
+
+	return 5;
+}
+
+double AsDouble(const msgpack::object& Object)
+{
+	switch (Object.type)
+	{
+		case msgpack::type::object_type::FLOAT32:
+		case msgpack::type::object_type::FLOAT64:
+			return Object.via.f64;
+		case msgpack::type::object_type::POSITIVE_INTEGER:
+			return static_cast<double>(Object.via.u64);
+		case msgpack::type::object_type::NEGATIVE_INTEGER:
+			return static_cast<double>(Object.via.i64);
+		default:
+			throw std::runtime_error("Value is not a number!");
+	}
+}
+
+bool IsNullOrEmptyMap(const msgpack::object& Object)
+{
+	// The signalr::value path converts empty maps to null, so we do the same to keep the two deserialisers interchangeable
+	return Object.type == msgpack::type::object_type::NIL || (Object.type == msgpack::type::object_type::MAP && Object.via.map.size == 0);
+}
+
+// Without a reference function msgpack copies every string and binary value into the object handle's zone. Returning true leaves them
+// pointing into the buffer being unpacked instead.
+bool ReferenceInPlace(msgpack::type::object_type /*Type*/, std::size_t /*Size*/, void* /*UserData*/)
+{
+	return true;
+}
+
+} // namespace
+
+
+namespace csp::multiplayer
+{
+using namespace msgpack_typeids;
+
+MsgPackEntitySerialiser::MsgPackEntitySerialiser()
+	: CurrentState(SerialiserState::Initial)
+	, Packer(Buffer)
+	, EntityStart(0)
+	, FieldCount(0)
+	, ArrayOffset(0)
+	, ArrayCount(0)
+	, ComponentsOffset(0)
+	, PropertiesOffset(0)
+{
+}
+
+void MsgPackEntitySerialiser::BeginEntity()
+{
+	assert(CurrentState == SerialiserState::Initial && "Entity already begun!");
+
+	CurrentState = SerialiserState::InEntity;
+
+	// Keeps its capacity, so we only allocate when an entity is larger than any we've written before
+	Buffer.Bytes.clear();
+	Buffer.Bytes.resize(kMaxContainerHeaderSize);
+	FieldCount = 0;
+}
+
+void MsgPackEntitySerialiser::EndEntity()
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not yet begun!");
+
+	CurrentState = SerialiserState::Initial;
+
+	// Rather than moving the whole entity down, the header is written immediately before the fields and the unused space is skipped
+	char Header[kMaxContainerHeaderSize];
+	const size_t HeaderSize = WriteContainerHeader(Header, FieldCount, false);
+	EntityStart				= kMaxContainerHeaderSize - HeaderSize;
+	std::memcpy(Buffer.Bytes.data() + EntityStart, Header, HeaderSize);
+}
+
+void MsgPackEntitySerialiser::WriteBool(bool Value)
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			++FieldCount;
+			break;
+		case SerialiserState::InArray:
+			++ArrayCount;
+			break;
+		default:
+			throw std::runtime_error("WriteBool() function not supported in current state!");
+	}
+
+	Value ? Packer.pack_true() : Packer.pack_false();
+}
+
+void MsgPackEntitySerialiser::WriteByte(uint8_t Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteByte() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_uint64(Value);
+}
+
+void MsgPackEntitySerialiser::WriteDouble(double Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteDouble() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_double(Value);
+}
+
+void MsgPackEntitySerialiser::WriteInt64(int64_t Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteInt64() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_int64(Value);
+}
+
+void MsgPackEntitySerialiser::WriteUInt64(uint64_t Value)
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			++FieldCount;
+			break;
+		case SerialiserState::InArray:
+			++ArrayCount;
+			break;
+		default:
+			throw std::runtime_error("WriteUInt64() function not supported in current state!");
+	}
+
+	Packer.pack_uint64(Value);
+}
+
+void MsgPackEntitySerialiser::WriteString(const csp::common::String& Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteString() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_str(static_cast<uint32_t>(Value.Length()));
+	Packer.pack_str_body(Value.c_str(), static_cast<uint32_t>(Value.Length()));
+}
+
+void MsgPackEntitySerialiser::WriteVector2(const csp::common::Vector2& Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteVector2() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_array(2);
+	Packer.pack_double(Value.X);
+	Packer.pack_double(Value.Y);
+}
+
+void MsgPackEntitySerialiser::WriteVector3(const csp::common::Vector3& Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteVector3() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_array(3);
+	Packer.pack_double(Value.X);
+	Packer.pack_double(Value.Y);
+	Packer.pack_double(Value.Z);
+}
+
+void MsgPackEntitySerialiser::WriteVector4(const csp::common::Vector4& Value)
+{
+	assert(CurrentState == SerialiserState::InEntity && "WriteVector4() function not supported in current state!");
+
+	++FieldCount;
+	Packer.pack_array(4);
+	Packer.pack_double(Value.X);
+	Packer.pack_double(Value.Y);
+	Packer.pack_double(Value.Z);
+	Packer.pack_double(Value.W);
+}
+
+void MsgPackEntitySerialiser::WriteNull()
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			++FieldCount;
+			break;
+		case SerialiserState::InArray:
+			++ArrayCount;
+			break;
+		default:
+			throw std::runtime_error("WriteNull() function not supported in current state!");
+	}
+
+	Packer.pack_nil();
+}
+
+void MsgPackEntitySerialiser::BeginComponents()
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not yet begun or components already begun!");
+
+	CurrentState	 = SerialiserState::InComponents;
+	ComponentsOffset = BeginContainer();
+	Components.clear();
+}
+
+void MsgPackEntitySerialiser::EndComponents()
+{
+	assert(CurrentState == SerialiserState::InComponents && "Components not yet begun or component begun!");
+
+	CurrentState = SerialiserState::InEntity;
+
+	EndContainer(ComponentsOffset, static_cast<uint32_t>(Components.size()), true);
+	++FieldCount;
+}
+
+void MsgPackEntitySerialiser::BeginComponent(uint16_t Id, uint64_t Type)
+{
+	assert(CurrentState == SerialiserState::InComponents && "Components not yet begun or component already begun!");
+
+	CurrentState = SerialiserState::InComponent;
+
+	// [ UINT16_DICTIONARY, [ { PropertyId: [ Type, [ Value ] ], ... } ] ]
+	BeginMapEntry(Components, Id);
+	Packer.pack_array(2);
+	Packer.pack_uint64(ItemComponentData::UINT16_DICTIONARY);
+	Packer.pack_array(1);
+
+	PropertiesOffset = BeginContainer();
+	Properties.clear();
+
+	// As with the signalr serialiser, the component type is stored as a property so that it can be read back when deserialising
+	BeginMapEntry(Properties, COMPONENT_KEY_COMPONENTTYPE);
+	WriteValueHeader(ItemComponentData::UINT64);
+	Packer.pack_uint64(Type);
+}
+
+void MsgPackEntitySerialiser::EndComponent()
+{
+	assert(CurrentState == SerialiserState::InComponent && "Component not yet begun or property begun!");
+
+	CurrentState = SerialiserState::InComponents;
+
+	EndContainer(PropertiesOffset, static_cast<uint32_t>(Properties.size()), true);
+}
+
+void MsgPackEntitySerialiser::BeginArray()
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not yet begun or array already begun!");
+
+	CurrentState = SerialiserState::InArray;
+	ArrayOffset	 = BeginContainer();
+	ArrayCount	 = 0;
+}
+
+void MsgPackEntitySerialiser::EndArray()
+{
+	assert(CurrentState == SerialiserState::InArray && "Array not yet begun!");
+
+	CurrentState = SerialiserState::InEntity;
+
+	EndContainer(ArrayOffset, ArrayCount, false);
+	++FieldCount;
+}
+
+void MsgPackEntitySerialiser::WriteProperty(uint64_t Id, const ReplicatedValue& Value)
+{
+	assert(CurrentState == SerialiserState::InComponent && "Component not yet begun!");
+
+	// Property IDs are stored as 16 bit keys, as in SignalRMsgPackEntitySerialiser
+	BeginMapEntry(Properties, static_cast<uint16_t>(Id));
+	WriteReplicatedValue(Value);
+}
+
+void MsgPackEntitySerialiser::AddViewComponent(uint16_t Id, const ReplicatedValue& Value)
+{
+	switch (Value.GetReplicatedValueType())
+	{
+		case ReplicatedValueType::String:
+		case ReplicatedValueType::Vector2:
+		case ReplicatedValueType::Vector3:
+		case ReplicatedValueType::Vector4:
+		case ReplicatedValueType::Integer:
+			break;
+		default:
+			throw std::runtime_error("Unsupported ViewComponent type!");
+	}
+
+	BeginMapEntry(Components, Id);
+	WriteReplicatedValue(Value);
+}
+
+const char* MsgPackEntitySerialiser::GetData() const
+{
+	return Buffer.Bytes.data() + EntityStart;
+}
+
+size_t MsgPackEntitySerialiser::GetSize() const
+{
+	return Buffer.Bytes.size() - EntityStart;
+}
+
+signalr::value MsgPackEntitySerialiser::Finalise() const
+{
+	return signalr::value::from_packed(reinterpret_cast<const uint8_t*>(GetData()), GetSize());
+}
+
+size_t MsgPackEntitySerialiser::BeginContainer()
+{
+	const size_t Offset = Buffer.Bytes.size();
+	Buffer.Bytes.resize(Offset + kMaxContainerHeaderSize);
+
+	return Offset;
+}
+
+void MsgPackEntitySerialiser::EndContainer(size_t Offset, uint32_t Count, bool IsMap)
+{
+	auto& Bytes = Buffer.Bytes;
+
+	const size_t HeaderSize = WriteContainerHeader(Bytes.data() + Offset, Count, IsMap);
+
+	// Close the gap between the header and the contents. Containers nested inside an entity are small, so this is cheap.
+	const size_t ContentOffset = Offset + kMaxContainerHeaderSize;
+	std::memmove(Bytes.data() + Offset + HeaderSize, Bytes.data() + ContentOffset, Bytes.size() - ContentOffset);
+	Bytes.resize(Bytes.size() - (kMaxContainerHeaderSize - HeaderSize));
+}
+
+void MsgPackEntitySerialiser::BeginMapEntry(std::vector<MapEntry>& Entries, uint64_t Key)
+{
+	auto& Bytes = Buffer.Bytes;
+
+	// Keys are almost always unique, so a linear search of the handful of entries in a component is all we need
+	for (size_t i = 0; i < Entries.size(); ++i)
+	{
+		if (Entries[i].Key != Key)
+		{
+			continue;
+		}
+
+		// Replace the earlier value by removing it from the buffer. It can only be followed by other entries of the same map.
+		const size_t EntryStart = Entries[i].Offset;
+		const size_t EntryEnd	= (i + 1 < Entries.size()) ? Entries[i + 1].Offset : Bytes.size();
+		const size_t EntrySize	= EntryEnd - EntryStart;
+
+		Bytes.erase(Bytes.begin() + EntryStart, Bytes.begin() + EntryEnd);
+
+		for (size_t j = i + 1; j < Entries.size(); ++j)
+		{
+			Entries[j].Offset -= EntrySize;
+		}
+
+		Entries.erase(Entries.begin() + i);
+
+		break;
+	}
+
+	Entries.push_back({Key, Bytes.size()});
+	Packer.pack_uint64(Key);
+}
+
+void MsgPackEntitySerialiser::WriteValueHeader(uint64_t Type)
+{
+	// [ Type, [ Value ] ]
+	Packer.pack_array(2);
+	Packer.pack_uint64(Type);
+	Packer.pack_array(1);
+}
+
+void MsgPackEntitySerialiser::WriteReplicatedValue(const ReplicatedValue& Value)
+{
+	switch (Value.GetReplicatedValueType())
+	{
+		case ReplicatedValueType::Boolean:
+			WriteValueHeader(ItemComponentData::BOOL);
+			Value.GetBool() ? Packer.pack_true() : Packer.pack_false();
+			break;
+		case ReplicatedValueType::Integer:
+			WriteValueHeader(ItemComponentData::INT64);
+			Packer.pack_int64(Value.GetInt());
+			break;
+		case ReplicatedValueType::Float:
+			WriteValueHeader(ItemComponentData::FLOAT);
+			Packer.pack_double(Value.GetFloat());
+			break;
+		case ReplicatedValueType::String:
+			WriteValueHeader(ItemComponentData::STRING);
+			Packer.pack_str(static_cast<uint32_t>(Value.GetString().Length()));
+			Packer.pack_str_body(Value.GetString().c_str(), static_cast<uint32_t>(Value.GetString().Length()));
+			break;
+		case ReplicatedValueType::Vector2:
+		{
+			const auto& Vector = Value.GetVector2();
+			WriteValueHeader(ItemComponentData::FLOAT_ARRAY);
+			Packer.pack_array(2);
+			Packer.pack_double(Vector.X);
+			Packer.pack_double(Vector.Y);
+			break;
+		}
+		case ReplicatedValueType::Vector3:
+		{
+			const auto& Vector = Value.GetVector3();
+			WriteValueHeader(ItemComponentData::FLOAT_ARRAY);
+			Packer.pack_array(3);
+			Packer.pack_double(Vector.X);
+			Packer.pack_double(Vector.Y);
+			Packer.pack_double(Vector.Z);
+			break;
+		}
+		case ReplicatedValueType::Vector4:
+		{
+			const auto& Vector = Value.GetVector4();
+			WriteValueHeader(ItemComponentData::FLOAT_ARRAY);
+			Packer.pack_array(4);
+			Packer.pack_double(Vector.X);
+			Packer.pack_double(Vector.Y);
+			Packer.pack_double(Vector.Z);
+			Packer.pack_double(Vector.W);
+			break;
+		}
+		default:
+			throw std::runtime_error("Unsupported property type!");
+	}
+}
+
+
+
+MsgPackEntityDeserialiser::MsgPackEntityDeserialiser(const char* Data, size_t Size)
+{
+	ObjectHandle = msgpack::unpack(Data, Size, ReferenceInPlace);
+}
+
+MsgPackEntityDeserialiser::MsgPackEntityDeserialiser(const signalr::value& PackedObject)
+{
+	size_t Size;
+	const uint8_t* Data = PackedObject.as_packed(Size);
+
+	ObjectHandle = msgpack::unpack(reinterpret_cast<const char*>(Data), Size, ReferenceInPlace);
+}
+
+MsgPackEntityDeserialiser::MsgPackEntityDeserialiser(signalr::value&& PackedObject)
+	: OwnedPackedObject(std::move(PackedObject))
+{
+	size_t Size;
+	const uint8_t* Data = OwnedPackedObject.as_packed(Size);
+
+	ObjectHandle = msgpack::unpack(reinterpret_cast<const char*>(Data), Size, ReferenceInPlace);
+}
+
+void MsgPackEntityDeserialiser::EnterEntity()
+{
+	assert(CurrentState == SerialiserState::Initial && "Entity already entered!");
+
+	const msgpack::object& Object = ObjectHandle.get();
+
+	if (Object.type != msgpack::type::object_type::ARRAY)
+	{
+		throw std::runtime_error("Entity is not an array!");
+	}
+
+	CurrentState = SerialiserState::InEntity;
+	CurrentField = Object.via.array.ptr;
+	FieldsEnd	 = Object.via.array.ptr + Object.via.array.size;
+}
+
+void MsgPackEntityDeserialiser::LeaveEntity()
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not entered!");
+
+	CurrentState = SerialiserState::Initial;
+	CurrentField = nullptr;
+	FieldsEnd	 = nullptr;
+}
+
+bool MsgPackEntityDeserialiser::ReadBool()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::BOOLEAN && "Current field is not a boolean!");
+
+	return Value.via.boolean;
+}
+
+uint8_t MsgPackEntityDeserialiser::ReadByte()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::POSITIVE_INTEGER && "Current field is not a byte!");
+
+	return Value.via.u64 & 0xFF;
+}
+
+double MsgPackEntityDeserialiser::ReadDouble()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert((Value.type == msgpack::type::object_type::FLOAT64 || Value.type == msgpack::type::object_type::FLOAT32)
+		   && "Current field is not a double!");
+
+	return Value.via.f64;
+}
+
+int64_t MsgPackEntityDeserialiser::ReadInt64()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert((Value.type == msgpack::type::object_type::POSITIVE_INTEGER || Value.type == msgpack::type::object_type::NEGATIVE_INTEGER)
+		   && "Current field is not an integer!");
+
+	return Value.via.i64;
+}
+
+uint64_t MsgPackEntityDeserialiser::ReadUInt64()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::POSITIVE_INTEGER && "Current field is not an unsigned integer!");
+
+	return Value.via.u64;
+}
+
+csp::common::String MsgPackEntityDeserialiser::ReadString()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::STR && "Current field is not a string!");
+
+	return csp::common::String(Value.via.str.ptr, Value.via.str.size);
+}
+
+csp::common::Vector2 MsgPackEntityDeserialiser::ReadVector2()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::ARRAY && Value.via.array.size == 2 && "Current field is not a Vector2!");
+
+	const auto* Array = Value.via.array.ptr;
+
+	return {(float) AsDouble(Array[0]), (float) AsDouble(Array[1])};
+}
+
+csp::common::Vector3 MsgPackEntityDeserialiser::ReadVector3()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::ARRAY && Value.via.array.size == 3 && "Current field is not a Vector3!");
+
+	const auto* Array = Value.via.array.ptr;
+
+	return {(float) AsDouble(Array[0]), (float) AsDouble(Array[1]), (float) AsDouble(Array[2])};
+}
+
+csp::common::Vector4 MsgPackEntityDeserialiser::ReadVector4()
+{
+	const msgpack::object& Value = NextValue();
+
+	assert(Value.type == msgpack::type::object_type::ARRAY && Value.via.array.size == 4 && "Current field is not a Vector4!");
+
+	const auto* Array = Value.via.array.ptr;
+
+	return {(float) AsDouble(Array[0]), (float) AsDouble(Array[1]), (float) AsDouble(Array[2]), (float) AsDouble(Array[3])};
+}
+
+bool MsgPackEntityDeserialiser::NextValueIsNull()
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			return IsNullOrEmptyMap(*CurrentField);
+		case SerialiserState::InArray:
+			return IsNullOrEmptyMap(*CurrentArrayElement);
+		default:
+			throw std::runtime_error("NextValueIsNull() function not supported in current state!");
+	}
+}
+
+bool MsgPackEntityDeserialiser::NextValueIsArray()
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			return CurrentField->type == msgpack::type::object_type::ARRAY;
+		case SerialiserState::InArray:
+			return CurrentArrayElement->type == msgpack::type::object_type::ARRAY;
+		default:
+			throw std::runtime_error("NextValueIsArray() function not supported in current state!");
+	}
+}
+
+void MsgPackEntityDeserialiser::EnterArray(CSP_OUT uint32_t& OutLength)
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not entered or array already entered!");
+	assert(CurrentField->type == msgpack::type::object_type::ARRAY && "Current field is not an array!");
+
+	CurrentState		= SerialiserState::InArray;
+	CurrentArrayElement = CurrentField->via.array.ptr;
+	ArrayEnd			= CurrentField->via.array.ptr + CurrentField->via.array.size;
+
+	OutLength = CurrentField->via.array.size;
+}
+
+void MsgPackEntityDeserialiser::LeaveArray()
+{
+	assert(CurrentState == SerialiserState::InArray && "Array not entered!");
+
+	CurrentState		= SerialiserState::InEntity;
+	CurrentArrayElement = nullptr;
+	ArrayEnd			= nullptr;
+
+	++CurrentField;
+}
+
+void MsgPackEntityDeserialiser::EnterComponents()
+{
+	assert(CurrentState == SerialiserState::InEntity && "Entity not entered or components already entered!");
+
+	CurrentState = SerialiserState::InComponents;
+
+	if (CurrentField->type == msgpack::type::object_type::MAP)
+	{
+		ComponentsBegin = CurrentField->via.map.ptr;
+		ComponentsEnd	= CurrentField->via.map.ptr + CurrentField->via.map.size;
+	}
+	else
+	{
+		assert(IsNullOrEmptyMap(*CurrentField) && "Current field is not a map!");
+
+		ComponentsBegin = nullptr;
+		ComponentsEnd	= nullptr;
+	}
+
+	CurrentComponent = ComponentsBegin;
+}
+
+void MsgPackEntityDeserialiser::LeaveComponents()
+{
+	assert(CurrentState == SerialiserState::InComponents && "Components not entered or component entered!");
+
+	CurrentState	 = SerialiserState::InEntity;
+	ComponentsBegin	 = nullptr;
+	ComponentsEnd	 = nullptr;
+	CurrentComponent = nullptr;
+}
+
+uint64_t MsgPackEntityDeserialiser::GetNumComponents()
+{
+	assert(CurrentState >= SerialiserState::InComponents && "Components not entered!");
+
+	return ComponentsEnd - ComponentsBegin;
+}
+
+uint64_t MsgPackEntityDeserialiser::GetNumRealComponents()
+{
+	assert(CurrentState >= SerialiserState::InComponents && "Components not entered!");
+
+	uint64_t Count = 0;
+
+	for (const auto* Component = ComponentsBegin; Component != ComponentsEnd; ++Component)
+	{
+		if (Component->key.via.u64 < COMPONENT_KEY_END_COMPONENTS)
+		{
+			++Count;
+		}
+	}
+
+	return Count;
+}
+
+void MsgPackEntityDeserialiser::EnterComponent(CSP_OUT uint16_t& OutId, CSP_OUT uint64_t& OutType)
+{
+	assert(CurrentState == SerialiserState::InComponents && "Components not entered or component already entered!");
+
+	IsMsgPackSerialiser = false;
+
+	CurrentState = SerialiserState::InComponent;
+
+	// Unlike the std::map used by the signalr deserialiser, the components are in the order they were sent, so view components
+	// may be interleaved with regular components. They're read separately by GetViewComponent(), so skip over them here.
+	for (;;)
+	{
+		OutId = static_cast<uint16_t>(CurrentComponent->key.via.u64);
+
+		if (OutId <= COMPONENT_KEY_END_COMPONENTS)
+		{
+			break;
+		}
+
+		++CurrentComponent;
+	}
+
+	// [ DataType, [ Data ] ]
+	const msgpack::object& Component = CurrentComponent->val;
+	const uint64_t DataType			 = Component.via.array.ptr[0].via.u64;
+	const msgpack::object& Data		 = Component.via.array.ptr[1].via.array.ptr[0];
+
+	if (DataType == ItemComponentData::UINT16_DICTIONARY)
+	{
+		CurrentProperty		   = nullptr;
+		PropertiesEnd		   = nullptr;
+		ComponentPropertyCount = 0;
+
+		if (Data.type == msgpack::type::object_type::MAP)
+		{
+			CurrentProperty = Data.via.map.ptr;
+			PropertiesEnd	= Data.via.map.ptr + Data.via.map.size;
+		}
+
+		for (const auto* Property = CurrentProperty; Property != PropertiesEnd; ++Property)
+		{
+			// The component type is stored alongside the properties, but isn't one of them
+			if (Property->key.via.u64 == COMPONENT_KEY_COMPONENTTYPE)
+			{
+				OutType = Property->val.via.array.ptr[1].via.array.ptr[0].via.u64;
+			}
+			else
+			{
+				++ComponentPropertyCount;
+			}
+		}
+	}
+	else if (DataType == ItemComponentData::UINT8_ARRAY) // Support for reading legacy, MsgPacked component data, in a raw binary format. Eventually
+														 // this will be removed.
+	{
+		IsMsgPackSerialiser = true;
+
+		size_t Offset = 0;
+
+		auto ComponentHandle = msgpack::unpack(Data.via.bin.ptr, Data.via.bin.size, Offset, ReferenceInPlace);
+		OutType				 = ComponentHandle.get().via.u64;
+
+		ComponentHandle		   = msgpack::unpack(Data.via.bin.ptr, Data.via.bin.size, Offset, ReferenceInPlace);
+		ComponentPropertyCount = ComponentHandle.get().via.u64;
+
+		// Points into the entity's buffer, so stays valid once ComponentHandle has gone
+		ComponentHandle		 = msgpack::unpack(Data.via.bin.ptr, Data.via.bin.size, Offset, ReferenceInPlace);
+		LegacyPropertyData	 = ComponentHandle.get().via.bin.ptr;
+		LegacyPropertySize	 = ComponentHandle.get().via.bin.size;
+		LegacyPropertyOffset = 0;
+	}
+	else
+	{
+		CSP_LOG_ERROR_MSG("Unsupported data type of serialised data");
+	}
+}
+
+void MsgPackEntityDeserialiser::LeaveComponent()
+{
+	assert(CurrentState == SerialiserState::InComponent && "Component not entered!");
+
+	CurrentState = SerialiserState::InComponents;
+	++CurrentComponent;
+}
+
+uint64_t MsgPackEntityDeserialiser::GetNumProperties()
+{
+	assert(CurrentState == SerialiserState::InComponent && "Component not entered!");
+
+	return ComponentPropertyCount;
+}
+
+ReplicatedValue MsgPackEntityDeserialiser::ReadProperty(CSP_OUT uint64_t& OutId)
+{
+	assert(CurrentState == SerialiserState::InComponent && "Component not entered or property already entered!");
+
+	if (IsMsgPackSerialiser) // Support for deserialising properties within a legacy MsgPacked component, this will be removed in future.
+	{
+		OutId			= NextLegacyValue().via.u64;
+		const auto Type = (ReplicatedValueType) NextLegacyValue().via.u64;
+
+		const msgpack::object& Value = NextLegacyValue();
+
+		switch (Type)
+		{
+			case ReplicatedValueType::Boolean:
+				return Value.via.boolean;
+			case ReplicatedValueType::Integer:
+				return Value.via.i64;
+			case ReplicatedValueType::Float:
+				return (float) Value.via.f64;
+			case ReplicatedValueType::String:
+				return csp::common::String(Value.via.str.ptr, Value.via.str.size);
+			case ReplicatedValueType::Vector2:
+				return csp::common::Vector2 {(float) Value.via.array.ptr[0].via.f64, (float) Value.via.array.ptr[1].via.f64};
+			case ReplicatedValueType::Vector3:
+				return csp::common::Vector3 {(float) Value.via.array.ptr[0].via.f64,
+											 (float) Value.via.array.ptr[1].via.f64,
+											 (float) Value.via.array.ptr[2].via.f64};
+			case ReplicatedValueType::Vector4:
+				return csp::common::Vector4 {(float) Value.via.array.ptr[0].via.f64,
+											 (float) Value.via.array.ptr[1].via.f64,
+											 (float) Value.via.array.ptr[2].via.f64,
+											 (float) Value.via.array.ptr[3].via.f64};
+			default:
+				throw std::runtime_error("Unsupported property type!");
+		}
+	}
+
+	if (CurrentProperty != PropertiesEnd && CurrentProperty->key.via.u64 == COMPONENT_KEY_COMPONENTTYPE)
+	{
+		++CurrentProperty;
+	}
+
+	if (CurrentProperty == PropertiesEnd)
+	{
+		throw std::runtime_error("No more properties to read!");
+	}
+
+	const msgpack::object_kv& Property = *CurrentProperty++;
+
+	// [ Type, [ Value ] ]
+	OutId						 = Property.key.via.u64;
+	const auto ValueType		 = (ItemComponentData) Property.val.via.array.ptr[0].via.u64;
+	const msgpack::object& Value = Property.val.via.array.ptr[1].via.array.ptr[0];
+
+	switch (ValueType)
+	{
+		case ItemComponentData::BOOL:
+			return Value.via.boolean;
+		case ItemComponentData::INT64:
+			return Value.via.i64;
+		case ItemComponentData::DOUBLE:
+		case ItemComponentData::FLOAT:
+			return (float) AsDouble(Value);
+		case ItemComponentData::STRING:
+			return csp::common::String(Value.via.str.ptr, Value.via.str.size);
+		case ItemComponentData::FLOAT_ARRAY:
+		{
+			const auto* Array = Value.via.array.ptr;
+
+			if (Value.via.array.size == 3)
+			{
+				return csp::common::Vector3 {(float) AsDouble(Array[0]), (float) AsDouble(Array[1]), (float) AsDouble(Array[2])};
+			}
+			else if (Value.via.array.size == 2)
+			{
+				return csp::common::Vector2 {(float) AsDouble(Array[0]), (float) AsDouble(Array[1])};
+			}
+			else
+			{
+				return csp::common::Vector4 {(float) AsDouble(Array[0]),
+											 (float) AsDouble(Array[1]),
+											 (float) AsDouble(Array[2]),
+											 (float) AsDouble(Array[3])};
+			}
+		}
+		default:
+			throw std::runtime_error("Unsupported property type!");
+	}
+}
+
+ReplicatedValue MsgPackEntityDeserialiser::GetViewComponent(uint16_t Id)
+{
+	const msgpack::object* Component = FindComponent(Id);
+
+	if (Component == nullptr)
+	{
+		return ReplicatedValue();
+	}
+
+	const msgpack::object& ComponentValue = Component->via.array.ptr[1].via.array.ptr[0];
+
+	switch (ComponentValue.type)
+	{
+		case msgpack::type::object_type::STR:
+			return ReplicatedValue(csp::common::String(ComponentValue.via.str.ptr, ComponentValue.via.str.size));
+		case msgpack::type::object_type::ARRAY:
+		{
+			const auto* Array = ComponentValue.via.array.ptr;
+
+			if (ComponentValue.via.array.size == 3)
+			{
+				return ReplicatedValue(csp::common::Vector3 {(float) AsDouble(Array[0]), (float) AsDouble(Array[1]), (float) AsDouble(Array[2])});
+			}
+
+			if (ComponentValue.via.array.size == 4)
+			{
+				return ReplicatedValue(csp::common::Vector4 {(float) AsDouble(Array[0]),
+															 (float) AsDouble(Array[1]),
+															 (float) AsDouble(Array[2]),
+															 (float) AsDouble(Array[3])});
+			}
+
+			return ReplicatedValue();
+		}
+		case msgpack::type::object_type::NEGATIVE_INTEGER:
+			return ReplicatedValue(ComponentValue.via.i64);
+		case msgpack::type::object_type::POSITIVE_INTEGER:
+			return ReplicatedValue(static_cast<int64_t>(ComponentValue.via.u64));
+		default:
+			throw std::runtime_error("Unsupported ViewComponent type!");
+	}
+}
+
+bool MsgPackEntityDeserialiser::HasViewComponent(uint16_t Id)
+{
+	return FindComponent(Id) != nullptr;
+}
+
+void MsgPackEntityDeserialiser::GetViewComponentIds(std::vector<uint16_t>& OutIds) const
+{
+	assert(CurrentState >= SerialiserState::InComponents && "Components not entered!");
+
+	for (const auto* Component = ComponentsBegin; Component != ComponentsEnd; ++Component)
+	{
+		if (Component->key.via.u64 >= COMPONENT_KEYS_START_VIEWS)
+		{
+			OutIds.push_back(static_cast<uint16_t>(Component->key.via.u64));
+		}
+	}
+}
+
+void MsgPackEntityDeserialiser::Skip()
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			++CurrentField;
+			break;
+		case SerialiserState::InArray:
+			++CurrentArrayElement;
+			break;
+		default:
+			throw std::runtime_error("Skip() function not supported in current state!");
+	}
+}
+
+const msgpack::object& MsgPackEntityDeserialiser::NextValue()
+{
+	switch (CurrentState)
+	{
+		case SerialiserState::InEntity:
+			assert(CurrentField != FieldsEnd && "No more fields to read!");
+
+			return *CurrentField++;
+		case SerialiserState::InArray:
+			assert(CurrentArrayElement != ArrayEnd && "No more array elements to read!");
+
+			return *CurrentArrayElement++;
+		case SerialiserState::InComponent:
+			return NextLegacyValue();
+		default:
+			throw std::runtime_error("Read function not supported in current state!");
+	}
+}
+
+const msgpack::object* MsgPackEntityDeserialiser::FindComponent(uint16_t Id) const
+{
+	// Entities only have a handful of components, so a linear search is quicker than building an index
+	for (const auto* Component = ComponentsBegin; Component != ComponentsEnd; ++Component)
+	{
+		if (Component->key.via.u64 == Id)
+		{
+			return &Component->val;
+		}
+	}
+
+	return nullptr;
+}
+
+const msgpack::object& MsgPackEntityDeserialiser::NextLegacyValue()
+{
+	LegacyObjectHandle = msgpack::unpack(LegacyPropertyData, LegacyPropertySize, LegacyPropertyOffset, ReferenceInPlace);
+
+	return LegacyObjectHandle.get();
+}
+
+} // namespace csp::multiplayer
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "CSP/Multiplayer/IEntitySerialiser.h"
+#include "MultiplayerConstants.h"
+#include "SignalRMsgPackEntitySerialiser.h"
+
+#include <msgpack/pack.hpp>
+#include <msgpack/unpack.hpp>
+#include <signalrclient/signalr_value.h>
+#include <vector>
+
+
+namespace csp::multiplayer
+{
+
+/// <summary>
+/// Writes an entity straight into a msgpack encoded byte buffer, producing exactly the same structure as
+/// SignalRMsgPackEntitySerialiser without building an intermediate tree of signalr::value's.
+///     The buffer is kept between entities, so once it has grown to fit the largest entity, serialising doesn't allocate.
+/// Usage is the same as SignalRMsgPackEntitySerialiser. Once EndEntity() has been called, the encoded entity can be read
+/// with GetData() and GetSize(), or wrapped in a packed signalr::value with Finalise(). Both are only valid until the next
+/// call to BeginEntity().
+/// </summary>
+class MsgPackEntitySerialiser : public IEntitySerialiser
+{
+public:
+	MsgPackEntitySerialiser();
+	MsgPackEntitySerialiser(const MsgPackEntitySerialiser&) = delete;
+
+	void BeginEntity() override;
+	void EndEntity() override;
+	void WriteBool(bool Value) override;
+	void WriteByte(uint8_t Value) override;
+	void WriteDouble(double Value) override;
+	void WriteInt64(int64_t Value) override;
+	void WriteUInt64(uint64_t Value) override;
+	void WriteString(const csp::common::String& Value) override;
+	void WriteVector2(const csp::common::Vector2& Value) override;
+	void WriteVector3(const csp::common::Vector3& Value) override;
+	void WriteVector4(const csp::common::Vector4& Value) override;
+	void WriteNull() override;
+	void BeginComponents() override;
+	void EndComponents() override;
+	void BeginComponent(uint16_t Id, uint64_t Type) override;
+	void EndComponent() override;
+	void BeginArray() override;
+	void EndArray() override;
+	void WriteProperty(uint64_t Id, const ReplicatedValue& Value) override;
+	void AddViewComponent(uint16_t Id, const ReplicatedValue& Value) override;
+
+	const char* GetData() const;
+	size_t GetSize() const;
+
+	/// <summary>
+	/// Returns the encoded entity as a packed signalr value, which the messagepack hub protocol writes to the message as-is.
+	/// </summary>
+	signalr::value Finalise() const;
+
+private:
+	struct WriteBuffer
+	{
+		std::vector<char> Bytes;
+
+		// Interface used by msgpack::packer
+		void write(const char* Data, size_t Size)
+		{
+			Bytes.insert(Bytes.end(), Data, Data + Size);
+		}
+	};
+
+	// Keyed entries of the map currently being written, so that writing a key a second time replaces the first value
+	// in the same way as it would in the std::map used by SignalRMsgPackEntitySerialiser.
+	struct MapEntry
+	{
+		uint64_t Key;
+		size_t Offset;
+	};
+
+	size_t BeginContainer();
+	void EndContainer(size_t Offset, uint32_t Count, bool IsMap);
+	void BeginMapEntry(std::vector<MapEntry>& Entries, uint64_t Key);
+
+	void WriteValueHeader(uint64_t Type);
+	void WriteReplicatedValue(const ReplicatedValue& Value);
+
+	SerialiserState CurrentState;
+	WriteBuffer Buffer;
+	msgpack::packer<WriteBuffer> Packer;
+
+	size_t EntityStart;
+	uint32_t FieldCount;
+	size_t ArrayOffset;
+	uint32_t ArrayCount;
+	size_t ComponentsOffset;
+	std::vector<MapEntry> Components;
+	size_t PropertiesOffset;
+	std::vector<MapEntry> Properties;
+};
+
+
+/// <summary>
+/// Reads an entity directly from a msgpack encoded buffer written by MsgPackEntitySerialiser, or received from the server.
+///     The buffer is parsed once into a msgpack object tree, and values are read from that as they are requested, rather
+/// than first being copied into signalr::value's. Strings and binary data are not copied out of the buffer, so the tree
+/// points into it, and the buffer must stay alive for as long as the deserialiser. Construct from an rvalue signalr::value
+/// to have the deserialiser keep the buffer alive itself.
+/// </summary>
+class MsgPackEntityDeserialiser : public IEntityDeserialiser
+{
+public:
+	/// <summary>
+	/// Reads from a buffer owned by the caller, which must outlive the deserialiser.
+	/// </summary>
+	MsgPackEntityDeserialiser(const char* Data, size_t Size);
+	/// <summary>
+	/// Reads from a signalr value of type packed, such as the arguments of hub methods registered as packed argument targets.
+	/// The value must outlive the deserialiser.
+	/// </summary>
+	MsgPackEntityDeserialiser(const signalr::value& PackedObject);
+	/// <summary>
+	/// Takes ownership of a signalr value of type packed, keeping its buffer alive for as long as the deserialiser.
+	/// </summary>
+	MsgPackEntityDeserialiser(signalr::value&& PackedObject);
+
+	void EnterEntity() override;
+	void LeaveEntity() override;
+	bool ReadBool() override;
+	uint8_t ReadByte() override;
+	double ReadDouble() override;
+	int64_t ReadInt64() override;
+	uint64_t ReadUInt64() override;
+	csp::common::String ReadString() override;
+	csp::common::Vector2 ReadVector2() override;
+	csp::common::Vector3 ReadVector3() override;
+	csp::common::Vector4 ReadVector4() override;
+	/** As with SignalRMsgPackEntityDeserialiser, an empty map is treated as null. */
+	bool NextValueIsNull() override;
+	bool NextValueIsArray() override;
+	void EnterComponents() override;
+	void LeaveComponents() override;
+	void EnterArray(CSP_OUT uint32_t& OutLength) override;
+	void LeaveArray() override;
+	/** Returns total number of components, including view components. If iterating components by this count, subtract number of view components. */
+	uint64_t GetNumComponents() override;
+	/** Returns number of components that are not view components. */
+	uint64_t GetNumRealComponents() override;
+	/** Ignores view components. */
+	void EnterComponent(CSP_OUT uint16_t& OutId, CSP_OUT uint64_t& OutType) override;
+	void LeaveComponent() override;
+	uint64_t GetNumProperties() override;
+	ReplicatedValue ReadProperty(CSP_OUT uint64_t& OutId) override;
+	ReplicatedValue GetViewComponent(uint16_t Id) override;
+	bool HasViewComponent(uint16_t Id) override;
+	void Skip() override;
+
+	/// <summary>
+	/// Appends the ids of the view components present in the entity's components, in the order they were written.
+	/// Only valid once the components have been entered.
+	/// </summary>
+	void GetViewComponentIds(std::vector<uint16_t>& OutIds) const;
+
+private:
+	const msgpack::object& NextValue();
+	const msgpack::object* FindComponent(uint16_t Id) const;
+	const msgpack::object& NextLegacyValue();
+
+	// Only set when constructed from an rvalue, in which case ObjectHandle points into its buffer
+	signalr::value OwnedPackedObject;
+	msgpack::object_handle ObjectHandle;
+	SerialiserState CurrentState = SerialiserState::Initial;
+
+	const msgpack::object* CurrentField			= nullptr;
+	const msgpack::object* FieldsEnd			= nullptr;
+	const msgpack::object* CurrentArrayElement	= nullptr;
+	const msgpack::object* ArrayEnd				= nullptr;
+	const msgpack::object_kv* ComponentsBegin	= nullptr;
+	const msgpack::object_kv* ComponentsEnd		= nullptr;
+	const msgpack::object_kv* CurrentComponent	= nullptr;
+	const msgpack::object_kv* CurrentProperty	= nullptr;
+	const msgpack::object_kv* PropertiesEnd		= nullptr;
+	size_t ComponentPropertyCount				= 0;
+
+// Used to read legacy components, which store their properties as a msgpack encoded byte array
+#pragma region MsgPackVariables
+	bool IsMsgPackSerialiser		= false;
+	const char* LegacyPropertyData	= nullptr;
+	size_t LegacyPropertySize		= 0;
+	size_t LegacyPropertyOffset		= 0;
+	msgpack::object_handle LegacyObjectHandle;
+#pragma endregion
+};
+
+} // namespace csp::multiplayer
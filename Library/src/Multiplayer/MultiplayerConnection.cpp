@@ -409,14 +409,23 @@ void MultiplayerConnection::StartEventMessageListening()
 
 		if (EventType == "AssetDetailBlobChanged")
 		{
+			AssetChangedEventDeserialiser Deserialiser;
+			Deserialiser.Parse(EventValues);
+			const AssetDetailBlobParams& Params = Deserialiser.GetEventParams();
+
+			// Caches of asset details need to know about the change whether or not the client is listening for it
+			csp::events::Event* ChangedEvent
+				= csp::events::EventSystem::Get().AllocateEvent(csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID);
+			ChangedEvent->AddString("AssetId", Params.AssetId.c_str());
+			ChangedEvent->AddString("AssetCollectionId", Params.AssetCollectionId.c_str());
+			csp::events::EventSystem::Get().EnqueueEvent(ChangedEvent);
+
 			if (!AssetDetailBlobChangedCallback)
 			{
 				return;
 			}
 
-			AssetChangedEventDeserialiser Deserialiser;
-			Deserialiser.Parse(EventValues);
-			AssetDetailBlobChangedCallback(Deserialiser.GetEventParams());
+			AssetDetailBlobChangedCallback(Params);
 		}
 		else if (EventType == "ConversationSystem")
 		{
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PatchBatcher.h"
+
+#include <cstring>
+
+
+namespace
+{
+
+// Largest possible msgpack array header, which is reserved at the start of each message
+constexpr size_t MAX_ARRAY_HEADER_SIZE				   = 5;
+constexpr char HEADER_PLACEHOLDER[MAX_ARRAY_HEADER_SIZE] = {};
+
+struct ArrayHeader
+{
+	char Data[MAX_ARRAY_HEADER_SIZE];
+	size_t Size = 0;
+
+	// Interface used by msgpack::packer
+	void write(const char* Bytes, size_t Length)
+	{
+		std::memcpy(Data + Size, Bytes, Length);
+		Size += Length;
+	}
+};
+
+} // namespace
+
+
+namespace csp::multiplayer
+{
+
+PatchBatcher::PatchBatcher(size_t InFrameBudget, size_t InMaxMessageSize, SendCallback InSend)
+	: FrameBudget(InFrameBudget)
+	, MaxMessageSize(InMaxMessageSize)
+	, Send(std::move(InSend))
+	, NumPatchesInMessage(0)
+	, BytesAdded(0)
+	, NumMessagesSent(0)
+{
+	Message.write(HEADER_PLACEHOLDER, MAX_ARRAY_HEADER_SIZE);
+}
+
+bool PatchBatcher::HasBudget() const
+{
+	return FrameBudget == 0 || BytesAdded < FrameBudget;
+}
+
+void PatchBatcher::Add(const char* Patch, size_t Size)
+{
+	if (MaxMessageSize != 0 && NumPatchesInMessage > 0 && Message.size() - MAX_ARRAY_HEADER_SIZE + Size > MaxMessageSize)
+	{
+		Flush();
+	}
+
+	Message.write(Patch, Size);
+	++NumPatchesInMessage;
+	BytesAdded += Size;
+}
+
+void PatchBatcher::Flush()
+{
+	if (NumPatchesInMessage == 0)
+	{
+		return;
+	}
+
+	// The array header can only be written once we know how many patches the message holds, so it's written into the space reserved
+	// for it, right-aligned against the first patch
+	ArrayHeader Header;
+	msgpack::packer<ArrayHeader>(Header).pack_array(NumPatchesInMessage);
+
+	char* Start = Message.data() + MAX_ARRAY_HEADER_SIZE - Header.Size;
+	std::memcpy(Start, Header.Data, Header.Size);
+
+	const auto Patches = signalr::value::from_packed(reinterpret_cast<const uint8_t*>(Start), Message.data() + Message.size() - Start);
+
+	Send(Patches, NumPatchesInMessage);
+
+	Message.clear();
+	Message.write(HEADER_PLACEHOLDER, MAX_ARRAY_HEADER_SIZE);
+	NumPatchesInMessage = 0;
+	++NumMessagesSent;
+}
+
+size_t PatchBatcher::GetBytesAdded() const
+{
+	return BytesAdded;
+}
+
+size_t PatchBatcher::GetNumMessagesSent() const
+{
+	return NumMessagesSent;
+}
+
+} // namespace csp::multiplayer
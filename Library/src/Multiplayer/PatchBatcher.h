@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <msgpack/pack.hpp>
+#include <msgpack/sbuffer.hpp>
+#include <signalrclient/signalr_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+
+namespace csp::multiplayer
+{
+
+/// <summary>
+/// Groups the encoded patches sent in a single frame into SendObjectPatches messages.
+///     Patches are added in priority order. A message is sent as soon as adding the next patch would take it over the maximum message
+/// size, so no message is larger than the limit unless it holds a single patch that is larger by itself. Once the frame budget has been
+/// used, HasBudget() returns false and the caller should leave any remaining patches for the next frame.
+/// A limit of 0 means unlimited. Flush() must be called once all of the frame's patches have been added.
+/// </summary>
+class PatchBatcher
+{
+public:
+	/// <summary>
+	/// Called with the packed array of patches making up each message, and the number of patches in it.
+	/// </summary>
+	typedef std::function<void(const signalr::value& Patches, uint32_t NumPatches)> SendCallback;
+
+	PatchBatcher(size_t InFrameBudget, size_t InMaxMessageSize, SendCallback InSend);
+	PatchBatcher(const PatchBatcher&) = delete;
+
+	/// <summary>
+	/// Returns false once the patches added this frame have used up the frame budget. The first patch of a frame is always allowed.
+	/// </summary>
+	bool HasBudget() const;
+
+	/// <summary>
+	/// Adds a msgpack encoded patch to the current message, sending the message first if the patch would not fit in it.
+	/// </summary>
+	void Add(const char* Patch, size_t Size);
+
+	/// <summary>
+	/// Sends the current message, if it holds any patches.
+	/// </summary>
+	void Flush();
+
+	size_t GetBytesAdded() const;
+	size_t GetNumMessagesSent() const;
+
+private:
+	size_t FrameBudget;
+	size_t MaxMessageSize;
+	SendCallback Send;
+
+	msgpack::sbuffer Message;
+	uint32_t NumPatchesInMessage;
+
+	size_t BytesAdded;
+	size_t NumMessagesSent;
+};
+
+} // namespace csp::multiplayer
@@ -87,7 +87,7 @@ void EntityScript::RunScript(const csp::common::String& ScriptSource)
 
 	if (SpaceEntitySystemPtr)
 	{
-		RunScriptLocally = SpaceEntitySystemPtr->CheckIfWeShouldRunScriptsLocally();
+		RunScriptLocally = SpaceEntitySystemPtr->CheckIfWeShouldRunScriptsLocally(Entity);
 	}
 
 	if (RunScriptLocally)
@@ -97,7 +97,7 @@ void EntityScript::RunScript(const csp::common::String& ScriptSource)
 	else
 	{
 
-		SpaceEntitySystemPtr->RunScriptRemotely(Entity->GetId(), ScriptSource);
+		SpaceEntitySystemPtr->RunScriptRemotely(Entity, ScriptSource);
 	}
 }
 
@@ -256,6 +256,10 @@ void EntityScript::SubscribeToMessage(const csp::common::String Message, const c
 
 		MessageMap.insert(SubscribedMessageMap::value_type(Message, OnMessageCallback));
 	}
+
+	// Cache the callback's function handle now so posting the message doesn't need to compile a script to call it.
+	// If the callback isn't defined yet, or the script later replaces it, it is resolved again when the message is posted.
+	ScriptSystem->ResolveFunction(Entity->GetId(), OnMessageCallback);
 }
 
 void EntityScript::PostMessageToScript(const csp::common::String Message, const csp::common::String MessageParamsJson)
@@ -266,7 +270,25 @@ void EntityScript::PostMessageToScript(const csp::common::String Message, const
 	{
 		const csp::common::String& OnMessageCallback = It->second;
 
-		// Generate a call to the callback with the correct parameters
+		bool RunScriptLocally = true;
+
+		if (SpaceEntitySystemPtr)
+		{
+			RunScriptLocally = SpaceEntitySystemPtr->CheckIfWeShouldRunScriptsLocally(Entity);
+		}
+
+		// Fast path: call the cached function handle directly with the message and params as JS strings
+		if (RunScriptLocally && ScriptSystem->CallFunction(Entity->GetId(), OnMessageCallback, Message, MessageParamsJson))
+		{
+			if (Message != SCRIPT_MSG_ENTITY_TICK)
+			{
+				CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose, "PostMessageToScript: %s -> %s\n", Message.c_str(), OnMessageCallback.c_str());
+			}
+
+			return;
+		}
+
+		// Otherwise generate a call to the callback with the correct parameters, to be evaluated locally or by the leader
 		csp::common::String ScriptText
 			= csp::common::StringFormat("%s('%s','%s')", OnMessageCallback.c_str(), Message.c_str(), MessageParamsJson.c_str());
 
@@ -22,6 +22,7 @@
 #include "CSP/Multiplayer/SpaceEntitySystem.h"
 #include "CSP/Systems/Script/ScriptSystem.h"
 #include "CSP/Systems/SystemsManager.h"
+#include "Common/RecursiveSharedMutex.h"
 #include "Debug/Logging.h"
 #include "Memory/Memory.h"
 #include "Multiplayer/Script/ComponentBinding/AnimatedModelSpaceComponentScriptInterface.h"
@@ -49,6 +50,8 @@
 #include "ScriptHelpers.h"
 #include "quickjspp.hpp"
 
+#include <shared_mutex>
+
 
 namespace csp::multiplayer
 {
@@ -68,7 +71,7 @@ public:
 
 		if (EntitySystem)
 		{
-			EntitySystem->LockEntityUpdate();
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
 
 			for (size_t i = 0; i < EntitySystem->GetNumEntities(); ++i)
 			{
@@ -77,8 +80,6 @@ public:
 				uint64_t Id = Entity->GetId();
 				EntityIds.push_back(Id);
 			}
-
-			EntitySystem->UnlockEntityUpdate();
 		}
 
 		return EntityIds;
@@ -90,15 +91,13 @@ public:
 
 		if (EntitySystem)
 		{
-			EntitySystem->LockEntityUpdate();
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
 
 			for (size_t i = 0; i < EntitySystem->GetNumEntities(); ++i)
 			{
 				SpaceEntity* Entity = EntitySystem->GetEntityByIndex(i);
 				Entities.push_back(Entity->GetScriptInterface());
 			}
-
-			EntitySystem->UnlockEntityUpdate();
 		}
 
 		return Entities;
@@ -110,6 +109,8 @@ public:
 
 		if (EntitySystem)
 		{
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
+
 			for (size_t i = 0; i < EntitySystem->GetNumObjects(); ++i)
 			{
 				SpaceEntity* Entity = EntitySystem->GetObjectByIndex(i);
@@ -126,6 +127,8 @@ public:
 
 		if (EntitySystem)
 		{
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
+
 			for (size_t i = 0; i < EntitySystem->GetNumAvatars(); ++i)
 			{
 				SpaceEntity* Entity = EntitySystem->GetAvatarByIndex(i);
@@ -142,19 +145,27 @@ public:
 
 		if (EntitySystem)
 		{
-			EntitySystem->LockEntityUpdate();
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
 
-			for (size_t i = 0; i < EntitySystem->GetNumEntities(); ++i)
+			const auto It = EntitySystem->EntityIdIndex->find(EntityId);
+
+			if (It == EntitySystem->EntityIdIndex->end())
 			{
-				const SpaceEntity* Entity = EntitySystem->GetEntityByIndex(i);
-				if (Entity->GetId() == EntityId)
+				return IndexOfEntity;
+			}
+
+			// The index only maps ids to entities, so the position in the list still has to be found,
+			// but by pointer and only for entities that are known to exist
+			const SpaceEntity* Entity = It->second;
+
+			for (size_t i = 0; i < EntitySystem->Entities.Size(); ++i)
+			{
+				if (EntitySystem->Entities[i] == Entity)
 				{
 					IndexOfEntity = static_cast<int32_t>(i);
 					break;
 				}
 			}
-
-			EntitySystem->UnlockEntityUpdate();
 		}
 
 		return IndexOfEntity;
@@ -162,22 +173,18 @@ public:
 
 	EntityScriptInterface* GetEntityById(int64_t EntityId)
 	{
-		EntityScriptInterface* ScriptInterface;
+		EntityScriptInterface* ScriptInterface = nullptr;
+
 		if (EntitySystem)
 		{
-			EntitySystem->LockEntityUpdate();
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
 
-			for (size_t i = 0; i < EntitySystem->GetNumEntities(); ++i)
+			const auto It = EntitySystem->EntityIdIndex->find(EntityId);
+
+			if (It != EntitySystem->EntityIdIndex->end())
 			{
-				SpaceEntity* Entity = EntitySystem->GetEntityByIndex(i);
-				if (Entity->GetId() == EntityId)
-				{
-					ScriptInterface = Entity->GetScriptInterface();
-					break;
-				}
+				ScriptInterface = It->second->GetScriptInterface();
 			}
-
-			EntitySystem->UnlockEntityUpdate();
 		}
 
 		return ScriptInterface;
@@ -185,22 +192,16 @@ public:
 
 	EntityScriptInterface* GetEntityByName(std::string EntityName)
 	{
-		EntityScriptInterface* ScriptInterface;
+		EntityScriptInterface* ScriptInterface = nullptr;
+
 		if (EntitySystem)
 		{
-			EntitySystem->LockEntityUpdate();
+			std::shared_lock EntitiesLocker(*EntitySystem->EntitiesLock);
 
-			for (size_t i = 0; i < EntitySystem->GetNumEntities(); ++i)
+			if (const auto* NamedEntities = EntitySystem->FindEntitiesByName(EntityName.c_str()))
 			{
-				SpaceEntity* Entity = EntitySystem->GetEntityByIndex(i);
-				if (Entity->GetName() == EntityName.c_str())
-				{
-					ScriptInterface = Entity->GetScriptInterface();
-					break;
-				}
+				ScriptInterface = NamedEntities->front()->GetScriptInterface();
 			}
-
-			EntitySystem->UnlockEntityUpdate();
 		}
 
 		return ScriptInterface;
@@ -24,6 +24,7 @@
 #include <Poco/Net/HTTPResponse.h>
 #include <Poco/Net/HTTPSClientSession.h>
 #include <Poco/Net/NetException.h>
+#include <Poco/Net/SocketAddress.h>
 #include <chrono>
 #include <stdexcept>
 #include <thread>
@@ -35,12 +36,15 @@ using namespace std::chrono_literals;
 constexpr const size_t INITIAL_BUFFER_SIZE = 8192;
 constexpr const size_t RECEIVE_BLOCK_SIZE  = 4096;
 
+// The receive thread blocks on the socket until data arrives or Stop wakes it. This timeout is only a safety net.
+const Poco::Timespan RECEIVE_POLL_TIMEOUT(1, 0);
+
 
 
 namespace csp::multiplayer
 {
 
-CSPWebSocketClientPOCO::CSPWebSocketClientPOCO() noexcept : StopFlag(false), PocoWebSocket(nullptr)
+CSPWebSocketClientPOCO::CSPWebSocketClientPOCO() noexcept : PocoWebSocket(nullptr), WakeSocket(nullptr), ReceiveReady(false), StopFlag(false)
 {
 }
 
@@ -54,27 +58,23 @@ void CSPWebSocketClientPOCO::Start(const std::string& Url, CallbackHandler Callb
 {
 	CSP_PROFILE_SCOPED();
 
-	std::string endpoint = csp::CSPFoundation::GetEndpoints().MultiplayerServiceURI.c_str();
-	auto index			 = endpoint.find(':');
-	std::string protocol = endpoint.substr(0, index);
-	index += 3; // "://"
-	auto endIndex	   = endpoint.find('/', index);
-	std::string domain = endpoint.substr(index, endIndex - index);
-	index			   = endIndex;
-	std::string path   = endpoint.substr(index);
+	Connect(Poco::URI(csp::CSPFoundation::GetEndpoints().MultiplayerServiceURI.c_str()), Callback);
+}
 
+void CSPWebSocketClientPOCO::Connect(const Poco::URI& Endpoint, CallbackHandler Callback)
+{
 	Poco::Net::HTTPClientSession* cs;
 
-	if (protocol == "https")
+	if (Endpoint.getScheme() == "https" || Endpoint.getScheme() == "wss")
 	{
-		cs = CSP_NEW Poco::Net::HTTPSClientSession(domain, 443);
+		cs = CSP_NEW Poco::Net::HTTPSClientSession(Endpoint.getHost(), Endpoint.getPort());
 	}
 	else
 	{
-		cs = CSP_NEW Poco::Net::HTTPClientSession(domain, 80);
+		cs = CSP_NEW Poco::Net::HTTPClientSession(Endpoint.getHost(), Endpoint.getPort());
 	}
 
-	Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
+	Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, Endpoint.getPathEtc(), Poco::Net::HTTPMessage::HTTP_1_1);
 	Poco::Net::HTTPResponse response;
 
 	if (csp::web::HttpAuth::GetAccessToken().c_str() != nullptr)
@@ -84,11 +84,16 @@ void CSPWebSocketClientPOCO::Start(const std::string& Url, CallbackHandler Callb
 		request.set("Authorization", Str);
 	}
 
-	StopFlag = false;
+	StopFlag	 = false;
+	ReceiveReady = false;
 
 	try
 	{
 		PocoWebSocket = CSP_NEW Poco::Net::WebSocket(*cs, request, response);
+
+		WakeSocket = CSP_NEW Poco::Net::DatagramSocket(Poco::Net::SocketAddress("127.0.0.1", 0), false);
+		WakeSocket->connect(WakeSocket->address());
+
 		// Receive worker thread
 		ReceiveThread = std::thread(
 			[this]()
@@ -124,6 +129,8 @@ void CSPWebSocketClientPOCO::Stop(CallbackHandler Callback)
 		// If the ReceiveThread is locked then the other thread will never finish because itd will be waiting for the ReceiveThread to join
 		Mutex.unlock();
 
+		WakeReceiveThread();
+
 		// POCO doesn't like close being called in the middle of
 		// receiveFrame, so wait for receive thread to close
 		if (std::this_thread::get_id() != ReceiveThread.get_id())
@@ -148,6 +155,12 @@ void CSPWebSocketClientPOCO::Stop(CallbackHandler Callback)
 
 		CSP_DELETE(PocoWebSocket);
 		PocoWebSocket = nullptr;
+
+		if (WakeSocket)
+		{
+			CSP_DELETE(WakeSocket);
+			WakeSocket = nullptr;
+		}
 	}
 	else
 	{
@@ -201,8 +214,14 @@ void CSPWebSocketClientPOCO::Receive(ReceiveHandler Callback)
 	{
 		assert(PocoWebSocket && "Web socket not created! Please call Start() before calling Receive().");
 
-		ReceiveCallback = Callback;
-		ReceiveReady	= true;
+		{
+			std::scoped_lock Lock(ReceiveMutex);
+
+			ReceiveCallback = Callback;
+			ReceiveReady	= true;
+		}
+
+		ReceiveCondition.notify_one();
 	}
 	else if (Callback)
 	{
@@ -217,7 +236,6 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 	auto CurrentBufferSize	= INITIAL_BUFFER_SIZE;
 	auto CurrentBufferIndex = 0;
 	auto SkipWait			= false;
-	auto SocketPollTimeout	= Poco::Timespan(1000);
 	auto ShouldRead			= true;
 
 	for (;;)
@@ -226,20 +244,16 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 
 		if (StopFlag)
 		{
+			CSP_FREE(Buffer);
+
 			return;
 		}
 
-		if (!SkipWait)
+		if (!SkipWait && !WaitForReceiveReady())
 		{
-			while (!ReceiveReady)
-			{
-				std::this_thread::sleep_for(500ns);
+			CSP_FREE(Buffer);
 
-				if (StopFlag)
-				{
-					return;
-				}
-			}
+			return;
 		}
 
 		SkipWait = false;
@@ -257,14 +271,11 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 
 			try
 			{
-				while (!PocoWebSocket->poll(SocketPollTimeout, Poco::Net::WebSocket::SELECT_READ))
+				if (!WaitForSocketReadable())
 				{
-					std::this_thread::sleep_for(500ns);
+					CSP_FREE(Buffer);
 
-					if (StopFlag)
-					{
-						return;
-					}
+					return;
 				}
 			}
 			catch (const std::exception& e)
@@ -313,6 +324,8 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 
 		if (StopFlag)
 		{
+			CSP_FREE(Buffer);
+
 			return;
 		}
 
@@ -354,8 +367,17 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 			}
 
 			HandshakeReceived = true;
-			ReceiveReady	  = false;
-			ReceiveCallback(CallbackMessage, true);
+
+			ReceiveHandler Callback;
+
+			{
+				std::scoped_lock Lock(ReceiveMutex);
+
+				ReceiveReady = false;
+				Callback	 = ReceiveCallback;
+			}
+
+			Callback(CallbackMessage, true);
 
 			continue;
 		}
@@ -392,7 +414,15 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 		 *  message to be processed
 		 */
 		std::string CallbackMessage(Buffer, Length + i);
-		ReceiveReady = false;
+
+		ReceiveHandler Callback;
+
+		{
+			std::scoped_lock Lock(ReceiveMutex);
+
+			ReceiveReady = false;
+			Callback	 = ReceiveCallback;
+		}
 
 		// Move remaining data to beginning of buffer
 		if (Length < CurrentBufferIndex - i)
@@ -409,13 +439,78 @@ void CSPWebSocketClientPOCO::ReceiveThreadFunc()
 			ShouldRead		   = true;
 		}
 
-		auto Callback = ReceiveCallback;
 		Callback(CallbackMessage, true);
 	}
 
 	StopFlag = false;
 }
 
+bool CSPWebSocketClientPOCO::WaitForReceiveReady()
+{
+	std::unique_lock<std::mutex> Lock(ReceiveMutex);
+
+	ReceiveCondition.wait(Lock,
+						  [this]()
+						  {
+							  return ReceiveReady || StopFlag;
+						  });
+
+	return !StopFlag;
+}
+
+bool CSPWebSocketClientPOCO::WaitForSocketReadable()
+{
+	// Data may already have been read from the socket and be buffered by the TLS layer, in which case the socket itself won't poll as readable
+	if (PocoWebSocket->available() > 0)
+	{
+		return true;
+	}
+
+	while (!StopFlag)
+	{
+		Poco::Net::Socket::SocketList ReadList = {*PocoWebSocket, *WakeSocket};
+		Poco::Net::Socket::SocketList WriteList;
+		Poco::Net::Socket::SocketList ExceptList = {*PocoWebSocket};
+
+		if (Poco::Net::Socket::select(ReadList, WriteList, ExceptList, RECEIVE_POLL_TIMEOUT) == 0)
+		{
+			continue;
+		}
+
+		if (StopFlag)
+		{
+			break;
+		}
+
+		// Let receiveFrame report any socket error
+		return true;
+	}
+
+	return false;
+}
+
+void CSPWebSocketClientPOCO::WakeReceiveThread()
+{
+	{
+		std::scoped_lock Lock(ReceiveMutex);
+	}
+
+	ReceiveCondition.notify_all();
+
+	if (WakeSocket)
+	{
+		try
+		{
+			const char WakeByte = 0;
+			WakeSocket->sendBytes(&WakeByte, 1);
+		}
+		catch (const std::exception&)
+		{
+			// The receive thread will still notice StopFlag when its poll times out
+		}
+	}
+}
+
 void CSPWebSocketClientPOCO::HandleReceiveError(const std::string& Message)
 {
 	CSP_LOG_ERROR_MSG(Message.c_str());
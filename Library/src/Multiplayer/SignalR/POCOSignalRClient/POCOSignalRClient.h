@@ -17,20 +17,31 @@
 
 #include "Multiplayer/WebSocketClient.h"
 
+#include <Poco/Net/DatagramSocket.h>
 #include <Poco/Net/WebSocket.h>
+#include <Poco/URI.h>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <signalrclient/signalr_client_config.h>
 #include <signalrclient/hub_exception.h>
 #include <thread>
 
 
+#ifdef CSP_TESTS
+class CSPEngine_WebSocketClientTests_WebSocketReceiveLatencyTest_Test;
+#endif
+
 
 namespace csp::multiplayer
 {
 
 class CSPWebSocketClientPOCO : public IWebSocketClient
 {
+#ifdef CSP_TESTS
+	friend class ::CSPEngine_WebSocketClientTests_WebSocketReceiveLatencyTest_Test;
+#endif
+
 public:
 	CSPWebSocketClientPOCO() noexcept;
 	~CSPWebSocketClientPOCO();
@@ -41,15 +52,30 @@ public:
 	void Receive(ReceiveHandler Callback) override;
 
 private:
+	void Connect(const Poco::URI& Endpoint, CallbackHandler Callback);
+
 	void ReceiveThreadFunc();
 	void HandleReceiveError(const std::string& Message);
 
+	// Both block until there is something to do, and return false if we were woken because the client is stopping
+	bool WaitForReceiveReady();
+	bool WaitForSocketReadable();
+
+	// Wakes the receive thread if it is blocked waiting on the socket
+	void WakeReceiveThread();
+
 	Poco::Net::WebSocket* PocoWebSocket;
+	// Loopback socket that is polled alongside the web socket, so that Stop can interrupt a blocking poll
+	Poco::Net::DatagramSocket* WakeSocket;
 
 	std::thread ReceiveThread;
 	std::mutex Mutex;
-	std::atomic_bool ReceiveReady;
+
+	std::mutex ReceiveMutex;
+	std::condition_variable ReceiveCondition;
+	bool ReceiveReady;
 	ReceiveHandler ReceiveCallback;
+
 	std::atomic_bool StopFlag;
 };
 
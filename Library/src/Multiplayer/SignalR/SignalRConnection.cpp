@@ -18,6 +18,8 @@
 #include "Debug/Logging.h"
 #include "SignalRClient.h"
 
+#include <set>
+
 #if ENABLE_SIGNALR_LOGGING
 	#include <iostream>
 
@@ -35,6 +37,10 @@ using namespace signalr;
 namespace csp::multiplayer
 {
 
+// Hub methods whose arguments are handed to us still msgpack encoded, so that they can be read without building a signalr::value tree.
+// Entity patches are by far the most frequent messages we receive, and are read with MsgPackEntityDeserialiser.
+const std::set<std::string> PackedArgumentMethods = {"OnObjectPatch"};
+
 #if ENABLE_SIGNALR_LOGGING
 class stdout_log_writer : public log_writer
 {
@@ -69,7 +75,7 @@ SignalRConnection::SignalRConnection(const std::string& BaseUri, const uint32_t
 							 return WebsocketClient;
 						 })
 					 .skip_negotiation(true)
-					 .with_messagepack_hub_protocol()
+					 .with_messagepack_hub_protocol(PackedArgumentMethods)
 #if ENABLE_SIGNALR_LOGGING
 					 .with_logging(std::make_shared<stdout_log_writer>(), trace_level::verbose)
 #else
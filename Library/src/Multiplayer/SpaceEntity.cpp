@@ -50,6 +50,7 @@
 #include "signalrclient/signalr_value.h"
 
 #include <chrono>
+#include <cstring>
 #include <glm/gtc/quaternion.hpp>
 #include <thread>
 
@@ -103,6 +104,9 @@ SpaceEntity::SpaceEntity()
 	, EntityLock(CSP_NEW std::mutex)
 	, ComponentsLock(CSP_NEW std::mutex)
 	, PropertiesLock(CSP_NEW std::mutex)
+	, GlobalTransform {{0, 0, 0}, {0, 0, 0, 1}, {1, 1, 1}}
+	, GlobalTransformDirty(true)
+	, GlobalTransformLock(CSP_NEW std::mutex)
 	, RefCount(CSP_NEW std::atomic_int(0))
 	, SelectedId(0)
 	, ParentId(nullptr)
@@ -128,6 +132,9 @@ SpaceEntity::SpaceEntity(SpaceEntitySystem* InEntitySystem)
 	, EntityLock(CSP_NEW std::mutex)
 	, ComponentsLock(CSP_NEW std::mutex)
 	, PropertiesLock(CSP_NEW std::mutex)
+	, GlobalTransform {{0, 0, 0}, {0, 0, 0, 1}, {1, 1, 1}}
+	, GlobalTransformDirty(true)
+	, GlobalTransformLock(CSP_NEW std::mutex)
 	, RefCount(CSP_NEW std::atomic_int(0))
 	, SelectedId(0)
 	, ParentId(nullptr)
@@ -155,6 +162,8 @@ SpaceEntity::~SpaceEntity()
 	CSP_DELETE(EntityLock);
 	CSP_DELETE(ComponentsLock);
 	CSP_DELETE(PropertiesLock);
+	CSP_DELETE(GlobalTransformLock);
+
 	CSP_DELETE(RefCount);
 }
 
@@ -201,15 +210,11 @@ const SpaceTransform& SpaceEntity::GetTransform() const
 
 SpaceTransform SpaceEntity::GetGlobalTransform() const
 {
-	if (Parent != nullptr)
-	{
-		SpaceTransform GlobalTransform;
-		GlobalTransform.Position = GetGlobalPosition();
-		GlobalTransform.Rotation = GetGlobalRotation();
-		GlobalTransform.Scale	 = GetGlobalScale();
-		return GlobalTransform;
-	}
-	return Transform;
+	std::scoped_lock<std::mutex> GlobalTransformLocker(*GlobalTransformLock);
+
+	UpdateGlobalTransform();
+
+	return GlobalTransform;
 }
 
 const csp::common::Vector3& SpaceEntity::GetPosition() const
@@ -219,16 +224,7 @@ const csp::common::Vector3& SpaceEntity::GetPosition() const
 
 csp::common::Vector3 SpaceEntity::GetGlobalPosition() const
 {
-	if (Parent != nullptr)
-	{
-		glm::mat4 ParentTransform = computeParentMat4(Parent->GetGlobalTransform());
-
-		glm::vec3 GlobalEntityPosition = ParentTransform * glm::vec4(Transform.Position.X, Transform.Position.Y, Transform.Position.Z, 1.0f);
-
-		return {GlobalEntityPosition.x, GlobalEntityPosition.y, GlobalEntityPosition.z};
-	}
-	else
-		return Transform.Position;
+	return GetGlobalTransform().Position;
 }
 
 void SpaceEntity::SetPosition(const csp::common::Vector3& Value)
@@ -258,17 +254,7 @@ const csp::common::Vector4& SpaceEntity::GetRotation() const
 
 csp::common::Vector4 SpaceEntity::GetGlobalRotation() const
 {
-	if (Parent != nullptr)
-	{
-		csp::common::Vector4 GlobalRotation = Parent->GetGlobalRotation();
-		glm::quat Orientation {Transform.Rotation.W, Transform.Rotation.X, Transform.Rotation.Y, Transform.Rotation.Z};
-		glm::quat GlobalOrientation(GlobalRotation.W, GlobalRotation.X, GlobalRotation.Y, GlobalRotation.Z);
-
-		glm::quat FinalOrientation = GlobalOrientation * Orientation;
-		return csp::common::Vector4 {FinalOrientation.x, FinalOrientation.y, FinalOrientation.z, FinalOrientation.w};
-	}
-	else
-		return Transform.Rotation;
+	return GetGlobalTransform().Rotation;
 }
 
 void SpaceEntity::SetRotation(const csp::common::Vector4& Value)
@@ -298,9 +284,7 @@ const csp::common::Vector3& SpaceEntity::GetScale() const
 
 csp::common::Vector3 SpaceEntity::GetGlobalScale() const
 {
-	if (Parent != nullptr)
-		return Parent->GetGlobalScale() * Transform.Scale;
-	return Transform.Scale;
+	return GetGlobalTransform().Scale;
 }
 
 void SpaceEntity::SetScale(const csp::common::Vector3& Value)
@@ -725,6 +709,7 @@ void SpaceEntity::Deserialise(IEntityDeserialiser& Deserialiser)
 			Transform.Position = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_POSITION).GetVector3();
 			Transform.Rotation = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_ROTATION).GetVector4();
 			Transform.Scale	   = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_SCALE).GetVector3();
+			MarkGlobalTransformDirty();
 
 			const ReplicatedValue SelectedIdValue = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_SELECTEDCLIENTID);
 
@@ -770,7 +755,7 @@ void SpaceEntity::DeserialiseFromPatch(IEntityDeserialiser& Deserialiser)
 
 			if (Deserialiser.HasViewComponent(COMPONENT_KEY_VIEW_ENTITYNAME))
 			{
-				Name		= Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_ENTITYNAME).GetString();
+				SetNameInternal(Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_ENTITYNAME).GetString());
 				UpdateFlags = SpaceEntityUpdateFlags(UpdateFlags | UPDATE_FLAGS_NAME);
 			}
 
@@ -778,18 +763,21 @@ void SpaceEntity::DeserialiseFromPatch(IEntityDeserialiser& Deserialiser)
 			{
 				Transform.Position = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_POSITION).GetVector3();
 				UpdateFlags		   = SpaceEntityUpdateFlags(UpdateFlags | UPDATE_FLAGS_POSITION);
+				MarkGlobalTransformDirty();
 			}
 
 			if (Deserialiser.HasViewComponent(COMPONENT_KEY_VIEW_ROTATION))
 			{
 				Transform.Rotation = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_ROTATION).GetVector4();
 				UpdateFlags		   = SpaceEntityUpdateFlags(UpdateFlags | UPDATE_FLAGS_ROTATION);
+				MarkGlobalTransformDirty();
 			}
 
 			if (Deserialiser.HasViewComponent(COMPONENT_KEY_VIEW_SCALE))
 			{
 				Transform.Scale = Deserialiser.GetViewComponent(COMPONENT_KEY_VIEW_SCALE).GetVector3();
 				UpdateFlags		= SpaceEntityUpdateFlags(UpdateFlags | UPDATE_FLAGS_SCALE);
+				MarkGlobalTransformDirty();
 			}
 
 			if (Deserialiser.HasViewComponent(COMPONENT_KEY_VIEW_SELECTEDCLIENTID))
@@ -976,20 +964,23 @@ void SpaceEntity::ApplyLocalPatch(bool InvokeUpdateCallback)
 				switch (PropertyKey)
 				{
 					case COMPONENT_KEY_VIEW_ENTITYNAME:
-						Name		= DirtyProperties[PropertyKey].GetString();
+						SetNameInternal(DirtyProperties[PropertyKey].GetString());
 						UpdateFlags = static_cast<SpaceEntityUpdateFlags>(UpdateFlags | UPDATE_FLAGS_NAME);
 						break;
 					case COMPONENT_KEY_VIEW_POSITION:
 						Transform.Position = DirtyProperties[PropertyKey].GetVector3();
 						UpdateFlags		   = static_cast<SpaceEntityUpdateFlags>(UpdateFlags | UPDATE_FLAGS_POSITION);
+						MarkGlobalTransformDirty();
 						break;
 					case COMPONENT_KEY_VIEW_ROTATION:
 						Transform.Rotation = DirtyProperties[PropertyKey].GetVector4();
 						UpdateFlags		   = static_cast<SpaceEntityUpdateFlags>(UpdateFlags | UPDATE_FLAGS_ROTATION);
+						MarkGlobalTransformDirty();
 						break;
 					case COMPONENT_KEY_VIEW_SCALE:
 						Transform.Scale = DirtyProperties[PropertyKey].GetVector3();
 						UpdateFlags		= static_cast<SpaceEntityUpdateFlags>(UpdateFlags | UPDATE_FLAGS_SCALE);
+						MarkGlobalTransformDirty();
 						break;
 					case COMPONENT_KEY_VIEW_SELECTEDCLIENTID:
 						SelectedId	= DirtyProperties[PropertyKey].GetInt();
@@ -1325,6 +1316,22 @@ void SpaceEntity::AddChildEntitiy(SpaceEntity* ChildEntity)
 	ChildEntities.Append(ChildEntity);
 }
 
+void SpaceEntity::SetNameInternal(const csp::common::String& Value)
+{
+	if (Name == Value)
+	{
+		return;
+	}
+
+	const csp::common::String OldName = Name;
+	Name							  = Value;
+
+	if (EntitySystem != nullptr)
+	{
+		EntitySystem->OnEntityNameChanged(this, OldName);
+	}
+}
+
 void SpaceEntity::ResolveParentChildRelationship()
 {
 	// Entity has been re-parented
@@ -1338,6 +1345,7 @@ void SpaceEntity::ResolveParentChildRelationship()
 
 		// Set our new parent
 		Parent = GetSpaceEntitySystem()->FindSpaceEntityById(*ParentId);
+		MarkGlobalTransformDirty();
 
 		if (Parent != nullptr)
 		{
@@ -1356,10 +1364,78 @@ void SpaceEntity::ResolveParentChildRelationship()
 		{
 			Parent->ChildEntities.RemoveItem(this);
 			Parent = nullptr;
+			MarkGlobalTransformDirty();
 		}
 	}
 }
 
+void SpaceEntity::MarkGlobalTransformDirty()
+{
+	{
+		std::scoped_lock<std::mutex> GlobalTransformLocker(*GlobalTransformLock);
+
+		// A dirty entity's descendants are always dirty too, so there's nothing further to do
+		if (GlobalTransformDirty)
+		{
+			return;
+		}
+
+		GlobalTransformDirty = true;
+	}
+
+	for (size_t i = 0; i < ChildEntities.Size(); ++i)
+	{
+		ChildEntities[i]->MarkGlobalTransformDirty();
+	}
+}
+
+void SpaceEntity::UpdateGlobalTransform() const
+{
+	if (!GlobalTransformDirty)
+	{
+		return;
+	}
+
+	if (Parent != nullptr)
+	{
+		glm::mat4 ParentMatrix;
+		glm::quat ParentOrientation;
+		csp::common::Vector3 ParentScale;
+
+		{
+			std::scoped_lock<std::mutex> ParentLocker(*Parent->GlobalTransformLock);
+
+			Parent->UpdateGlobalTransform();
+
+			std::memcpy(&ParentMatrix, Parent->GlobalMatrix, sizeof(ParentMatrix));
+			ParentOrientation = glm::quat(Parent->GlobalTransform.Rotation.W,
+										  Parent->GlobalTransform.Rotation.X,
+										  Parent->GlobalTransform.Rotation.Y,
+										  Parent->GlobalTransform.Rotation.Z);
+			ParentScale		  = Parent->GlobalTransform.Scale;
+		}
+
+		glm::vec3 Position = ParentMatrix * glm::vec4(Transform.Position.X, Transform.Position.Y, Transform.Position.Z, 1.0f);
+		glm::quat Orientation
+			= ParentOrientation * glm::quat(Transform.Rotation.W, Transform.Rotation.X, Transform.Rotation.Y, Transform.Rotation.Z);
+
+		GlobalTransform.Position = {Position.x, Position.y, Position.z};
+		GlobalTransform.Rotation = {Orientation.x, Orientation.y, Orientation.z, Orientation.w};
+		GlobalTransform.Scale	 = ParentScale * Transform.Scale;
+	}
+	else
+	{
+		GlobalTransform = Transform;
+	}
+
+	// Built once here rather than by every child that needs it
+	const glm::mat4 Matrix = computeParentMat4(GlobalTransform);
+	static_assert(sizeof(Matrix) == sizeof(GlobalMatrix));
+	std::memcpy(GlobalMatrix, &Matrix, sizeof(GlobalMatrix));
+
+	GlobalTransformDirty = false;
+}
+
 csp::multiplayer::EntityScriptInterface* SpaceEntity::GetScriptInterface()
 {
 	return ScriptInterface;
@@ -26,12 +26,16 @@
 #include "CSP/Systems/Spaces/SpaceSystem.h"
 #include "CSP/Systems/SystemsManager.h"
 #include "CSP/Systems/Users/UserSystem.h"
+#include "Common/RecursiveSharedMutex.h"
 #include "Debug/Logging.h"
 #include "Events/EventListener.h"
 #include "Events/EventSystem.h"
 #include "Memory/Memory.h"
 #include "Multiplayer/Election/ClientElectionManager.h"
+#include "Multiplayer/IncomingPatchQueue.h"
 #include "Multiplayer/MultiplayerConstants.h"
+#include "Multiplayer/MsgPackEntitySerialiser.h"
+#include "Multiplayer/PatchBatcher.h"
 #include "Multiplayer/Script/EntityScriptBinding.h"
 #include "Multiplayer/SignalR/SignalRClient.h"
 #include "Multiplayer/SignalR/SignalRConnection.h"
@@ -43,12 +47,15 @@
 	#include "Multiplayer/SignalR/POCOSignalRClient/POCOSignalRClient.h"
 #endif
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <iostream>
 #include <map>
+#include <shared_mutex>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 
 using namespace std::chrono_literals;
@@ -191,15 +198,21 @@ SpaceEntitySystem::SpaceEntitySystem(MultiplayerConnection* InMultiplayerConnect
 	, Connection(nullptr)
 	, EventHandler(CSP_NEW SpaceEntityEventHandler(this))
 	, ElectionManager(nullptr)
-	, EntitiesLock(CSP_NEW std::recursive_mutex)
+	, EntitiesLock(CSP_NEW csp::RecursiveSharedMutex)
 	, TickEntitiesLock(CSP_NEW std::mutex)
+	, PendingEntitiesLock(CSP_NEW std::mutex)
 	, PendingAdds(CSP_NEW(SpaceEntityQueue))
 	, PendingRemoves(CSP_NEW(SpaceEntityQueue))
 	, PendingOutgoingUpdateUniqueSet(CSP_NEW(SpaceEntitySet))
-	, PendingIncomingUpdates(CSP_NEW(PatchMessageQueue))
+	, PendingIncomingUpdates(CSP_NEW IncomingPatchQueue(IncomingPatchQueue::GetDefaultNumDecodeWorkers()))
+	, PatchSerialiser(CSP_NEW MsgPackEntitySerialiser())
+	, EntityIdIndex(CSP_NEW(SpaceEntityIdMap))
+	, EntityNameIndex(CSP_NEW(SpaceEntityNameMap))
 	, EnableEntityTick(false)
 	, LastTickTime(std::chrono::system_clock::now())
 	, EntityPatchRate(90)
+	, EntityPatchFrameBudget(128 * 1024)
+	, MaxEntityPatchMessageSize(30 * 1024)
 	, SequenceHierarchyChangedCallback(nullptr)
 {
 	Initialise();
@@ -212,12 +225,17 @@ SpaceEntitySystem::~SpaceEntitySystem()
 	CSP_DELETE(EventHandler);
 
 	CSP_DELETE(TickEntitiesLock);
+	CSP_DELETE(PendingEntitiesLock);
 	CSP_DELETE(EntitiesLock);
 
 	CSP_DELETE(PendingAdds);
 	CSP_DELETE(PendingRemoves);
 	CSP_DELETE(PendingOutgoingUpdateUniqueSet);
 	CSP_DELETE(PendingIncomingUpdates);
+	CSP_DELETE(PatchSerialiser);
+
+	CSP_DELETE(EntityIdIndex);
+	CSP_DELETE(EntityNameIndex);
 }
 
 void SpaceEntitySystem::Initialise()
@@ -323,6 +341,7 @@ void SpaceEntitySystem::CreateAvatar(const csp::common::String& InName,
 
 			Entities.Append(NewAvatar);
 			Avatars.Append(NewAvatar);
+			AddEntityToIndex(NewAvatar);
 			NewAvatar->ApplyLocalPatch(false);
 
 			if (ElectionManager != nullptr)
@@ -415,62 +434,122 @@ void SpaceEntitySystem::LocalDestroyEntity(SpaceEntity* Entity)
 
 SpaceEntity* SpaceEntitySystem::FindSpaceEntity(const csp::common::String& InName)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 
-	for (size_t i = 0; i < Entities.Size(); ++i)
+	const auto* NamedEntities = FindEntitiesByName(InName);
+
+	return NamedEntities != nullptr ? NamedEntities->front() : nullptr;
+}
+
+SpaceEntity* SpaceEntitySystem::FindSpaceEntityById(uint64_t EntityId)
+{
+	std::shared_lock EntitiesLocker(*EntitiesLock);
+
+	const auto It = EntityIdIndex->find(EntityId);
+
+	return It != EntityIdIndex->end() ? It->second : nullptr;
+}
+
+SpaceEntity* SpaceEntitySystem::FindSpaceAvatar(const csp::common::String& InName)
+{
+	std::shared_lock EntitiesLocker(*EntitiesLock);
+
+	if (const auto* NamedEntities = FindEntitiesByName(InName))
 	{
-		if (Entities[i]->GetName() == InName)
+		for (SpaceEntity* Entity : *NamedEntities)
 		{
-			return Entities[i];
+			if (Entity->GetEntityType() == SpaceEntityType::Avatar)
+			{
+				return Entity;
+			}
 		}
 	}
 
 	return nullptr;
 }
 
-SpaceEntity* SpaceEntitySystem::FindSpaceEntityById(uint64_t EntityId)
+SpaceEntity* SpaceEntitySystem::FindSpaceObject(const csp::common::String& InName)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 
-	for (size_t i = 0; i < Entities.Size(); ++i)
+	if (const auto* NamedEntities = FindEntitiesByName(InName))
 	{
-		if (Entities[i]->GetId() == EntityId)
+		for (SpaceEntity* Entity : *NamedEntities)
 		{
-			return Entities[i];
+			if (Entity->GetEntityType() == SpaceEntityType::Object)
+			{
+				return Entity;
+			}
 		}
 	}
 
 	return nullptr;
 }
 
-SpaceEntity* SpaceEntitySystem::FindSpaceAvatar(const csp::common::String& InName)
+const std::vector<SpaceEntity*>* SpaceEntitySystem::FindEntitiesByName(const csp::common::String& InName) const
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	const auto It = EntityNameIndex->find(InName.c_str());
 
-	for (size_t i = 0; i < Avatars.Size(); ++i)
+	return It != EntityNameIndex->end() ? &It->second : nullptr;
+}
+
+void SpaceEntitySystem::AddEntityToIndex(SpaceEntity* Entity)
+{
+	EntityIdIndex->insert_or_assign(Entity->GetId(), Entity);
+	(*EntityNameIndex)[Entity->GetName().c_str()].push_back(Entity);
+}
+
+void SpaceEntitySystem::RemoveEntityFromIndex(SpaceEntity* Entity)
+{
+	const auto IdIt = EntityIdIndex->find(Entity->GetId());
+
+	if (IdIt != EntityIdIndex->end() && IdIt->second == Entity)
+	{
+		EntityIdIndex->erase(IdIt);
+	}
+
+	const auto NameIt = EntityNameIndex->find(Entity->GetName().c_str());
+
+	if (NameIt != EntityNameIndex->end())
 	{
-		if (Avatars[i]->GetName() == InName)
+		auto& NamedEntities = NameIt->second;
+		NamedEntities.erase(std::remove(NamedEntities.begin(), NamedEntities.end(), Entity), NamedEntities.end());
+
+		if (NamedEntities.empty())
 		{
-			return Avatars[i];
+			EntityNameIndex->erase(NameIt);
 		}
 	}
-
-	return nullptr;
 }
 
-SpaceEntity* SpaceEntitySystem::FindSpaceObject(const csp::common::String& InName)
+void SpaceEntitySystem::OnEntityNameChanged(SpaceEntity* Entity, const csp::common::String& OldName)
 {
 	std::scoped_lock EntitiesLocker(*EntitiesLock);
 
-	for (size_t i = 0; i < Objects.Size(); ++i)
+	const auto OldIt = EntityNameIndex->find(OldName.c_str());
+
+	if (OldIt == EntityNameIndex->end())
 	{
-		if (Objects[i]->GetName() == InName)
-		{
-			return Objects[i];
-		}
+		// The entity has not been added to the system yet, it will be indexed under its new name when it is
+		return;
 	}
 
-	return nullptr;
+	auto& OldNamedEntities = OldIt->second;
+	const auto EntityIt	   = std::find(OldNamedEntities.begin(), OldNamedEntities.end(), Entity);
+
+	if (EntityIt == OldNamedEntities.end())
+	{
+		return;
+	}
+
+	OldNamedEntities.erase(EntityIt);
+
+	if (OldNamedEntities.empty())
+	{
+		EntityNameIndex->erase(OldIt);
+	}
+
+	(*EntityNameIndex)[Entity->GetName().c_str()].push_back(Entity);
 }
 
 void SpaceEntitySystem::RegisterEntityScriptAsModule(SpaceEntity* NewEntity)
@@ -539,7 +618,8 @@ void SpaceEntitySystem::BindOnObjectMessage()
 	Connection->On("OnObjectMessage",
 				   [this](const signalr::value& Params)
 				   {
-					   // Params is an array of all params sent, so grab the first
+					   // Params is an array of all params sent, so grab the first. OnObjectMessage is not a packed argument method, so this
+					   // is the entity already decoded into signalr::value's, and the new entity is created from it straight away.
 					   auto& EntityMessage = Params.as_array()[0];
 
 					   SpaceEntity* NewEntity = CreateRemotelyRetrievedEntity(EntityMessage, this);
@@ -561,12 +641,10 @@ void SpaceEntitySystem::BindOnObjectPatch()
 	Connection->On("OnObjectPatch",
 				   [this](const signalr::value& Params)
 				   {
-					   std::scoped_lock EntitiesLocker(*EntitiesLock);
-
 					   // Params is an array of all params sent, so grab the first
 					   auto& EntityMessage = Params.as_array()[0];
 
-					   PendingIncomingUpdates->emplace_back(CSP_NEW signalr::value(EntityMessage));
+					   PendingIncomingUpdates->Push(EntityMessage);
 				   });
 }
 
@@ -577,7 +655,6 @@ void SpaceEntitySystem::BindOnRequestToSendObject()
 				   {
 					   const uint64_t EntityID = Params.as_array()[0].as_uinteger();
 
-					   // TODO: add ability to check for ID or get by ID from Entity List (maybe change to Map<EntityID, Entity> ?)
 					   if (SpaceEntity* MatchedEntity = FindSpaceEntityById(EntityID))
 					   {
 						   SignalRMsgPackEntitySerialiser Serialiser;
@@ -723,11 +800,18 @@ void SpaceEntitySystem::LocalDestroyAllEntities()
 	Objects.Clear();
 	Avatars.Clear();
 	RootHierarchyEntities.Clear();
+	EntityIdIndex->clear();
+	EntityNameIndex->clear();
 
 	// Clear adds/removes, we don't want to mutate if we're cleaning everything else.
-	PendingAdds->clear();
-	PendingRemoves->clear();
-	PendingIncomingUpdates->clear();
+	{
+		std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
+
+		PendingAdds->clear();
+		PendingRemoves->clear();
+	}
+
+	PendingIncomingUpdates->Clear();
 
 	UnlockEntityUpdate();
 }
@@ -758,13 +842,10 @@ void SpaceEntitySystem::QueueEntityUpdate(SpaceEntity* EntityToUpdate)
 
 void SpaceEntitySystem::RemoveEntity(SpaceEntity* EntityToRemove)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	// Only the pending queue is touched here, so that removing an entity doesn't need the entity lock exclusively, and so can be done
+	// by code running under a shared lock such as the script tick. The entity leaves the entity lists when removes are flushed.
+	std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
 	PendingRemoves->emplace_back(EntityToRemove);
-
-	// Remove from the unique set to indicate it could be queued again if needed.
-	PendingOutgoingUpdateUniqueSet->erase(EntityToRemove);
-
-	RootHierarchyEntities.RemoveItem(EntityToRemove);
 }
 
 void SpaceEntitySystem::TickEntities()
@@ -818,6 +899,7 @@ void SpaceEntitySystem::OnAllEntitiesCreated()
 			SpaceEntity* ParentEntity = FindSpaceEntityById(*Entity->ParentId);
 			// Set the entities parent
 			Entity->Parent = ParentEntity;
+			Entity->MarkGlobalTransformDirty();
 			// Set the parents child
 			ParentEntity->ChildEntities.Append(Entity);
 		}
@@ -901,6 +983,7 @@ void SpaceEntitySystem::ResolveParentChildForDeletion(SpaceEntity* Deletion)
 	{
 		Deletion->ChildEntities[i]->RemoveParentEntity();
 		Deletion->ChildEntities[i]->Parent = nullptr;
+		Deletion->ChildEntities[i]->MarkGlobalTransformDirty();
 	}
 }
 
@@ -954,7 +1037,9 @@ void SpaceEntitySystem::ClaimScriptOwnershipFromClient(uint64_t ClientId)
 
 void SpaceEntitySystem::TickEntityScripts()
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	// Scripts only read the entity graph, or queue changes through AddEntity, RemoveEntity and MarkEntityForUpdate, none of which need the
+	// entity lock exclusively. A shared lock lets other threads keep reading entities while scripts tick.
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 
 	const auto CurrentTime = std::chrono::system_clock::now();
 	const auto DeltaTimeMS = std::chrono::duration_cast<std::chrono::milliseconds>(CurrentTime - LastTickTime).count();
@@ -962,7 +1047,17 @@ void SpaceEntitySystem::TickEntityScripts()
 
 	const csp::common::String DeltaTimeJSON = JSONStringFromDeltaTime(static_cast<double>(DeltaTimeMS));
 
-	if (IsLeaderElectionEnabled())
+	if (IsScriptAuthorityPartitioningEnabled())
+	{
+		for (size_t i = 0; i < Entities.Size(); ++i)
+		{
+			if (ElectionManager->IsLocalClientScriptAuthority(GetScriptAuthorityKey(Entities[i])))
+			{
+				Entities[i]->GetScript()->PostMessageToScript(SCRIPT_MSG_ENTITY_TICK, DeltaTimeJSON);
+			}
+		}
+	}
+	else if (IsLeaderElectionEnabled())
 	{
 		if (ElectionManager->IsLocalClientLeader())
 		{
@@ -1039,6 +1134,39 @@ bool SpaceEntitySystem::IsLeaderElectionEnabled() const
 	return (ElectionManager != nullptr);
 }
 
+void SpaceEntitySystem::EnableScriptAuthorityPartitioning()
+{
+	EnableLeaderElection();
+	ElectionManager->SetScriptAuthorityPartitioned(true);
+}
+
+void SpaceEntitySystem::DisableScriptAuthorityPartitioning()
+{
+	if (ElectionManager != nullptr)
+	{
+		ElectionManager->SetScriptAuthorityPartitioned(false);
+	}
+}
+
+bool SpaceEntitySystem::IsScriptAuthorityPartitioningEnabled() const
+{
+	return (ElectionManager != nullptr) && ElectionManager->IsScriptAuthorityPartitioned();
+}
+
+uint64_t SpaceEntitySystem::GetScriptAuthorityId(const SpaceEntity* Entity) const
+{
+	if (ElectionManager == nullptr || Entity == nullptr)
+	{
+		return 0;
+	}
+
+	std::shared_lock EntitiesLocker(*EntitiesLock);
+
+	const ClientProxy* Authority = ElectionManager->GetScriptAuthority(GetScriptAuthorityKey(Entity));
+
+	return (Authority != nullptr) ? Authority->GetId() : 0;
+}
+
 uint64_t SpaceEntitySystem::GetLeaderId() const
 {
 	if (ElectionManager != nullptr && ElectionManager->GetLeader() != nullptr)
@@ -1051,6 +1179,14 @@ uint64_t SpaceEntitySystem::GetLeaderId() const
 	}
 }
 
+void SpaceEntitySystem::SetLeaderHeartbeatTimeout(uint32_t TimeoutMS)
+{
+	if (ElectionManager != nullptr)
+	{
+		ElectionManager->SetLeaderHeartbeatTimeout(std::chrono::milliseconds(TimeoutMS));
+	}
+}
+
 ComponentBase* SpaceEntitySystem::FindComponentById(uint16_t Id)
 {
 	// Search for component id across all entites
@@ -1079,11 +1215,60 @@ void SpaceEntitySystem::SetEntityPatchRateLimitEnabled(bool Enabled)
 	EntityPatchRateLimitEnabled = Enabled;
 }
 
+uint32_t SpaceEntitySystem::GetEntityPatchFrameBudget() const
+{
+	return EntityPatchFrameBudget;
+}
+
+void SpaceEntitySystem::SetEntityPatchFrameBudget(uint32_t Bytes)
+{
+	EntityPatchFrameBudget = Bytes;
+}
+
+uint32_t SpaceEntitySystem::GetMaxEntityPatchMessageSize() const
+{
+	return MaxEntityPatchMessageSize;
+}
+
+void SpaceEntitySystem::SetMaxEntityPatchMessageSize(uint32_t Bytes)
+{
+	MaxEntityPatchMessageSize = Bytes;
+}
+
 const csp::common::List<SpaceEntity*>* SpaceEntitySystem::GetRootHierarchyEntities() const
 {
 	return &RootHierarchyEntities;
 }
 
+void SpaceEntitySystem::UpdateWorldTransforms()
+{
+	std::shared_lock EntitiesLocker(*EntitiesLock);
+
+	std::vector<SpaceEntity*> Pending;
+	Pending.reserve(Entities.Size());
+
+	for (size_t i = 0; i < RootHierarchyEntities.Size(); ++i)
+	{
+		Pending.push_back(RootHierarchyEntities[i]);
+	}
+
+	// Children are appended behind their parent, so by the time we reach an entity its parent's transform is already up to date
+	for (size_t i = 0; i < Pending.size(); ++i)
+	{
+		SpaceEntity* Entity = Pending[i];
+
+		{
+			std::scoped_lock<std::mutex> GlobalTransformLocker(*Entity->GlobalTransformLock);
+			Entity->UpdateGlobalTransform();
+		}
+
+		for (size_t j = 0; j < Entity->ChildEntities.Size(); ++j)
+		{
+			Pending.push_back(Entity->ChildEntities[j]);
+		}
+	}
+}
+
 void SpaceEntitySystem::CreateSequenceHierarchy(const common::Optional<uint64_t>& ParentId,
 												const common::Array<uint64_t>& HierarchyItemIds,
 												SequenceHierarchyResultCallback Callback)
@@ -1199,7 +1384,18 @@ void SpaceEntitySystem::SetSequenceHierarchyChangedCallback(SequenceHierarchyCha
 	SequenceHierarchyChangedCallback = Callback;
 }
 
-bool SpaceEntitySystem::CheckIfWeShouldRunScriptsLocally() const
+uint64_t SpaceEntitySystem::GetScriptAuthorityKey(const SpaceEntity* Entity) const
+{
+	// Scripts in the same hierarchy often talk to each other, so they are all run by the client with authority over the root
+	while (Entity->GetParentEntity() != nullptr)
+	{
+		Entity = Entity->GetParentEntity();
+	}
+
+	return Entity->GetId();
+}
+
+bool SpaceEntitySystem::CheckIfWeShouldRunScriptsLocally(const SpaceEntity* Entity) const
 {
 	if (!IsLeaderElectionEnabled())
 	{
@@ -1207,6 +1403,11 @@ bool SpaceEntitySystem::CheckIfWeShouldRunScriptsLocally() const
 		// (Run scripts locally if client is object owner)
 		return true;
 	}
+	else if (ElectionManager->IsScriptAuthorityPartitioned())
+	{
+		// Only run script locally if we have authority over the entity's hierarchy
+		return ElectionManager->IsLocalClientScriptAuthority(GetScriptAuthorityKey(Entity));
+	}
 	else
 	{
 		// Only run script locally if we are the Leader
@@ -1214,16 +1415,16 @@ bool SpaceEntitySystem::CheckIfWeShouldRunScriptsLocally() const
 	}
 }
 
-void SpaceEntitySystem::RunScriptRemotely(int64_t ContextId, const csp::common::String& ScriptText)
+void SpaceEntitySystem::RunScriptRemotely(const SpaceEntity* Entity, const csp::common::String& ScriptText)
 {
-	// Run script on a remote leader...
+	// Run script on a remote leader, or on the client with authority over the entity if authority is partitioned...
 	CSP_LOG_FORMAT(csp::systems::LogLevel::VeryVerbose, "RunScriptRemotely Script='%s'", ScriptText.c_str());
 
-	ClientProxy* LeaderProxy = ElectionManager->GetLeader();
+	ClientProxy* AuthorityProxy = ElectionManager->GetScriptAuthority(GetScriptAuthorityKey(Entity));
 
-	if (LeaderProxy)
+	if (AuthorityProxy)
 	{
-		LeaderProxy->RunScript(ContextId, ScriptText);
+		AuthorityProxy->RunScript(Entity->GetId(), ScriptText);
 	}
 }
 
@@ -1246,48 +1447,53 @@ void SpaceEntitySystem::UnlockEntityUpdate() const
 
 size_t SpaceEntitySystem::GetNumEntities() const
 {
-	std::scoped_lock<std::recursive_mutex> EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Entities.Size();
 }
 
 size_t SpaceEntitySystem::GetNumAvatars() const
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Avatars.Size();
 }
 
 size_t SpaceEntitySystem::GetNumObjects() const
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Objects.Size();
 }
 
 SpaceEntity* SpaceEntitySystem::GetEntityByIndex(const size_t EntityIndex)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Entities[EntityIndex];
 }
 
 SpaceEntity* SpaceEntitySystem::GetAvatarByIndex(const size_t AvatarIndex)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Avatars[AvatarIndex];
 }
 
 SpaceEntity* SpaceEntitySystem::GetObjectByIndex(const size_t ObjectIndex)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::shared_lock EntitiesLocker(*EntitiesLock);
 	return Objects[ObjectIndex];
 }
 
 void SpaceEntitySystem::AddEntity(SpaceEntity* EntityToAdd)
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
+	std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
 	PendingAdds->emplace_back(EntityToAdd);
 }
 
-void SendPatches(csp::multiplayer::SignalRConnection* Connection, const csp::common::List<SpaceEntity*> PendingEntities)
+void SendPatches(csp::multiplayer::SignalRConnection* Connection, const signalr::value& Patches)
 {
+	if (Connection == nullptr)
+	{
+		return;
+	}
+
 	const std::function LocalCallback = [](const signalr::value& /*Result*/, const std::exception_ptr& Except)
 	{
 		try
@@ -1303,60 +1509,81 @@ void SendPatches(csp::multiplayer::SignalRConnection* Connection, const csp::com
 		}
 	};
 
-	SignalRMsgPackEntitySerialiser Serialiser;
-	std::vector<signalr::value> ObjectPatches;
-
-	for (int i = 0; i < PendingEntities.Size(); ++i)
-	{
-		PendingEntities[i]->SerialisePatch(Serialiser);
-		auto SerialisedEntity = Serialiser.Finalise();
-		ObjectPatches.push_back(SerialisedEntity);
-	}
-
-	const std::vector InvokeArguments = {signalr::value(ObjectPatches)};
+	// Patches is a packed array of msgpack encoded patches, which the hub protocol copies into the message as-is
+	const std::vector InvokeArguments = {Patches};
 
 	Connection->Invoke("SendObjectPatches", InvokeArguments, LocalCallback);
 }
 
 void SpaceEntitySystem::ProcessPendingEntityOperations()
 {
-	std::scoped_lock EntitiesLocker(*EntitiesLock);
-	csp::common::List<SpaceEntity*> PendingEntities;
 	// we run pending entity operations in a specific order
 	// 1 - flush pending adds - we do this first to ensure any attempts to apply updates after are successful
 	// 2 - flush pending updates - first the local representation, then the remote representation (with rate limiting)
 	// 3 - flush pending removes - we do this last so any pending updates can still mutate state on entities that are pending removal
+	// Each step takes the entity lock separately, and incoming patches take it once per patch, so that threads reading entities are only
+	// ever held up by a single step rather than the whole flush.
 
 	// adds
-	std::unordered_set<SpaceEntity*> AddedEntities;
-	while (PendingAdds->empty() == false)
 	{
-		SpaceEntity* PendingAddEntity = PendingAdds->front();
+		std::scoped_lock EntitiesLocker(*EntitiesLock);
 
-		// we only want to add an entity once, even though a client could have queued it for updates multiple times
-		if (AddedEntities.find(PendingAddEntity) == AddedEntities.end())
+		SpaceEntityQueue Adds;
+
+		{
+			std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
+			Adds.swap(*PendingAdds);
+		}
+
+		std::unordered_set<SpaceEntity*> AddedEntities;
+		while (Adds.empty() == false)
 		{
-			AddPendingEntity(PendingAddEntity);
-			AddedEntities.emplace(PendingAddEntity);
+			SpaceEntity* PendingAddEntity = Adds.front();
+
+			// we only want to add an entity once, even though a client could have queued it for updates multiple times
+			if (AddedEntities.find(PendingAddEntity) == AddedEntities.end())
+			{
+				AddPendingEntity(PendingAddEntity);
+				AddedEntities.emplace(PendingAddEntity);
+			}
+			Adds.pop_front();
 		}
-		PendingAdds->pop_front();
 	}
 
 	// local updates
-	while (PendingIncomingUpdates->empty() == false)
+	// Patches are decoded and merged per entity without holding the entity lock, so only applying them holds up readers
+	const std::vector<IncomingEntityPatch> IncomingUpdates = PendingIncomingUpdates->Flush();
+
+	for (const auto& IncomingUpdate : IncomingUpdates)
 	{
-		ApplyIncomingPatch(PendingIncomingUpdates->front());
-		PendingIncomingUpdates->pop_front();
+		std::scoped_lock EntitiesLocker(*EntitiesLock);
+		ApplyIncomingPatch(IncomingUpdate);
 	}
 
 	// remote updates
 	{
+		std::scoped_lock EntitiesLocker(*EntitiesLock);
+
+		{
+			std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
+
+			// Entities about to be removed have nothing left to send, and could be queued again if they were re-added
+			for (SpaceEntity* PendingRemoveEntity : *PendingRemoves)
+			{
+				PendingOutgoingUpdateUniqueSet->erase(PendingRemoveEntity);
+			}
+		}
+
+		csp::common::List<SpaceEntity*> PendingEntities;
+
+		const milliseconds CurrentTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+
+		std::vector<SpaceEntity*> ReadyEntities;
+
 		for (auto it = PendingOutgoingUpdateUniqueSet->begin(); it != PendingOutgoingUpdateUniqueSet->end();)
 		{
 			SpaceEntity* PendingEntity = *it;
 
-			const milliseconds CurrentTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-
 			if (CurrentTime - PendingEntity->TimeOfLastPatch >= EntityPatchRate || !EntityPatchRateLimitEnabled)
 			{
 				// If the entity is not owned by us, and not a transferable entity, it is not allowed to modify the entity.
@@ -1370,54 +1597,103 @@ void SpaceEntitySystem::ProcessPendingEntityOperations()
 					continue;
 				}
 
-				// since we are aiming to mutate the data for this entity remotely, we need to claim ownership over it
-				PendingEntity->OwnerId = MultiplayerConnectionInst->GetClientId();
-				ClaimScriptOwnership(PendingEntity);
-
-				PendingEntities.Append(PendingEntity);
+				ReadyEntities.push_back(PendingEntity);
+			}
 
-				if (PendingEntity->EntityPatchSentCallback != nullptr)
-				{
-					PendingEntity->EntityPatchSentCallback(true);
-				}
+			++it;
+		}
 
-				PendingEntity->TimeOfLastPatch = CurrentTime;
-				it							   = PendingOutgoingUpdateUniqueSet->erase(it);
-			}
-			else
+		// If there isn't the budget to send everything this frame, avatars go first, as other users notice them lagging more than anything
+		// else, then whichever entity has gone longest without a patch
+		std::sort(ReadyEntities.begin(),
+				  ReadyEntities.end(),
+				  [](const SpaceEntity* Lhs, const SpaceEntity* Rhs)
+				  {
+					  const bool LhsIsAvatar = Lhs->Type == SpaceEntityType::Avatar;
+					  const bool RhsIsAvatar = Rhs->Type == SpaceEntityType::Avatar;
+
+					  if (LhsIsAvatar != RhsIsAvatar)
+					  {
+						  return LhsIsAvatar;
+					  }
+
+					  if (Lhs->TimeOfLastPatch != Rhs->TimeOfLastPatch)
+					  {
+						  return Lhs->TimeOfLastPatch < Rhs->TimeOfLastPatch;
+					  }
+
+					  return Lhs->Id < Rhs->Id;
+				  });
+
+		PatchBatcher Batcher(EntityPatchFrameBudget,
+							 MaxEntityPatchMessageSize,
+							 [this](const signalr::value& Patches, uint32_t /*NumPatches*/)
+							 {
+								 SendPatches(Connection, Patches);
+							 });
+
+		for (SpaceEntity* PendingEntity : ReadyEntities)
+		{
+			// Anything we don't have the budget for stays queued. Further changes to it are merged into its pending patch, so it's
+			// sent once with the latest state rather than once per change.
+			if (!Batcher.HasBudget())
 			{
-				++it;
+				break;
 			}
-		}
 
-		// Only send if there are patches in list
-		if (PendingEntities.Size() != 0)
-		{
-			// Send list of PendingEntities to chs
-			SendPatches(Connection, PendingEntities);
+			// since we are aiming to mutate the data for this entity remotely, we need to claim ownership over it
+			PendingEntity->OwnerId = MultiplayerConnectionInst->GetClientId();
+			ClaimScriptOwnership(PendingEntity);
+
+			PendingEntity->SerialisePatch(*PatchSerialiser);
+			Batcher.Add(PatchSerialiser->GetData(), PatchSerialiser->GetSize());
+
+			PendingEntities.Append(PendingEntity);
 
-			// Loop through and apply local patches from generated list
-			for (int i = 0; i < PendingEntities.Size(); ++i)
+			if (PendingEntity->EntityPatchSentCallback != nullptr)
 			{
-				PendingEntities[i]->ApplyLocalPatch(true);
+				PendingEntity->EntityPatchSentCallback(true);
 			}
+
+			PendingEntity->TimeOfLastPatch = CurrentTime;
+			PendingOutgoingUpdateUniqueSet->erase(PendingEntity);
+		}
+
+		Batcher.Flush();
+
+		// Loop through and apply local patches from generated list
+		for (int i = 0; i < PendingEntities.Size(); ++i)
+		{
+			PendingEntities[i]->ApplyLocalPatch(true);
 		}
 	}
 
 	// removes
-	std::unordered_set<SpaceEntity*> RemovedEntities;
-	while (PendingRemoves->empty() == false)
 	{
-		SpaceEntity* PendingRemoveEntity = PendingRemoves->front();
+		std::scoped_lock EntitiesLocker(*EntitiesLock);
+
+		SpaceEntityQueue Removes;
 
-		// we only want to remove an entity once, even though a client could have queued it for updates multiple times
-		if (RemovedEntities.find(PendingRemoveEntity) == RemovedEntities.end())
 		{
-			RemovedEntities.emplace(PendingRemoveEntity);
+			std::scoped_lock PendingEntitiesLocker(*PendingEntitiesLock);
+			Removes.swap(*PendingRemoves);
+		}
+
+		std::unordered_set<SpaceEntity*> RemovedEntities;
+		while (Removes.empty() == false)
+		{
+			SpaceEntity* PendingRemoveEntity = Removes.front();
+
+			// we only want to remove an entity once, even though a client could have queued it for updates multiple times
+			if (RemovedEntities.find(PendingRemoveEntity) == RemovedEntities.end())
+			{
+				RemovedEntities.emplace(PendingRemoveEntity);
 
-			RemovePendingEntity(PendingRemoves->front());
+				PendingOutgoingUpdateUniqueSet->erase(PendingRemoveEntity);
+				RemovePendingEntity(PendingRemoveEntity);
+			}
+			Removes.pop_front();
 		}
-		PendingRemoves->pop_front();
 	}
 }
 
@@ -1426,6 +1702,7 @@ void SpaceEntitySystem::AddPendingEntity(SpaceEntity* EntityToAdd)
 	if (FindSpaceEntityById(EntityToAdd->GetId()) == nullptr)
 	{
 		Entities.Append(EntityToAdd);
+		AddEntityToIndex(EntityToAdd);
 
 		switch (EntityToAdd->GetEntityType())
 		{
@@ -1472,6 +1749,7 @@ void SpaceEntitySystem::RemovePendingEntity(SpaceEntity* EntityToRemove)
 	RootHierarchyEntities.RemoveItem(EntityToRemove);
 	ResolveParentChildForDeletion(EntityToRemove);
 
+	RemoveEntityFromIndex(EntityToRemove);
 	Entities.RemoveItem(EntityToRemove);
 
 	CSP_DELETE(EntityToRemove);
@@ -1575,6 +1853,7 @@ void SpaceEntitySystem::CreateObjectInternal(const csp::common::String& InName,
 
 			Entities.Append(NewObject);
 			Objects.Append(NewObject);
+			AddEntityToIndex(NewObject);
 			Callback(NewObject);
 		};
 
@@ -1589,92 +1868,53 @@ void SpaceEntitySystem::CreateObjectInternal(const csp::common::String& InName,
 	Connection->Invoke("GenerateObjectIds", Params, LocalIDCallback);
 }
 
-void SpaceEntitySystem::ApplyIncomingPatch(const signalr::value* EntityMessage)
+void SpaceEntitySystem::ApplyIncomingPatch(const IncomingEntityPatch& Patch)
 {
-	SignalRMsgPackEntityDeserialiser Deserialiser(*EntityMessage);
+	SpaceEntity* Entity = FindSpaceEntityById(Patch.EntityId);
 
-	Deserialiser.EnterEntity();
+	if (Patch.Destroy)
 	{
-		const uint64_t EntityID					 = Deserialiser.ReadUInt64();
-		const uint64_t OwnerID					 = Deserialiser.ReadUInt64();
-		const bool Destroy						 = Deserialiser.ReadBool();
-		bool ShouldUpdateParent					 = false;
-		csp::common::Optional<uint64_t> ParentId = nullptr;
-
-		if (Deserialiser.NextValueIsArray())
+		// Deletion
+		if (Entity != nullptr)
 		{
-			uint32_t size = 0;
-			Deserialiser.EnterArray(size);
+			if (Entity->GetEntityType() == SpaceEntityType::Avatar)
 			{
-				ShouldUpdateParent = Deserialiser.ReadBool();
+				// All clients will take ownership of deleted avatars scripts
+				// Last client which receives patch will end up with ownership
+				ClaimScriptOwnershipFromClient(Entity->GetOwnerId());
 
-				if (Deserialiser.NextValueIsNull())
+				// Loop through all entities and check if the deleted avatar owned any of them. If they did, deselect them.
+				// This covers disconnected clients as their avatar gets cleaned up after timing out.
+				for (int j = 0; j < Entities.Size(); ++j)
 				{
-					Deserialiser.Skip();
-				}
-				else
-				{
-					ParentId = Deserialiser.ReadUInt64();
+					if (Entities[j]->GetSelectingClientID() == Patch.EntityId)
+					{
+						Entities[j]->Deselect();
+						SelectedEntities.RemoveItem(Entities[j]);
+					}
 				}
 			}
-			Deserialiser.LeaveArray();
-		}
 
-		if (Destroy)
+			LocalDestroyEntity(Entity);
+		}
+	}
+	else
+	{
+		// Update
+		if (Entity != nullptr)
 		{
-			// Deletion
-			for (int i = 0; i < Entities.Size(); ++i)
-			{
-				SpaceEntity* Entity = Entities[i];
+			IncomingEntityPatchReader Reader(Patch);
 
-				if (Entity->GetId() == EntityID)
-				{
-					if (Entity->GetEntityType() == SpaceEntityType::Avatar)
-					{
-						// All clients will take ownership of deleted avatars scripts
-						// Last client which receives patch will end up with ownership
-						ClaimScriptOwnershipFromClient(Entity->GetOwnerId());
-
-						// Loop through all entities and check if the deleted avatar owned any of them. If they did, deselect them.
-						// This covers disconnected clients as their avatar gets cleaned up after timing out.
-						for (int j = 0; j < Entities.Size(); ++j)
-						{
-							if (Entities[j]->GetSelectingClientID() == EntityID)
-							{
-								Entities[j]->Deselect();
-								SelectedEntities.RemoveItem(Entities[j]);
-							}
-						}
-					}
-
-					LocalDestroyEntity(Entity);
-				}
-			}
+			Entity->ShouldUpdateParent = Patch.ShouldUpdateParent;
+			Entity->ParentId		   = Patch.HasParentId ? csp::common::Optional<uint64_t>(Patch.ParentId) : nullptr;
+			Entity->DeserialiseFromPatch(Reader);
+			Entity->OwnerId = Patch.OwnerId;
 		}
 		else
 		{
-			bool EntityFound = false;
-
-			// Update
-			for (int i = 0; i < Entities.Size(); ++i)
-			{
-				if (Entities[i]->GetId() == EntityID)
-				{
-					EntityFound						= true;
-					Entities[i]->ShouldUpdateParent = ShouldUpdateParent;
-					Entities[i]->ParentId			= ParentId;
-					Entities[i]->DeserialiseFromPatch(Deserialiser);
-					Entities[i]->OwnerId = OwnerID;
-				}
-			}
-
-			if (!EntityFound)
-			{
-				CSP_LOG_FORMAT(csp::systems::LogLevel::Error, "Failed to find an entity with ID %d when recieved a patch message.", EntityID);
-			}
+			CSP_LOG_FORMAT(csp::systems::LogLevel::Error, "Failed to find an entity with ID %d when recieved a patch message.", Patch.EntityId);
 		}
 	}
-	Deserialiser.LeaveEntity();
 }
 
 void SpaceEntitySystem::HandleException(const std::exception_ptr& Except, const std::string& ExceptionDescription)
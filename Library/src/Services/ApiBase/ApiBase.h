@@ -97,34 +97,40 @@ public:
 
 		JsonDoc.Parse(Json.c_str());
 
-		if (JsonDoc.IsArray())
-		{
-			Array.resize(JsonDoc.Size());
+		FromJsonValue(JsonDoc);
+	}
 
-			for (rapidjson::SizeType i = 0; i < JsonDoc.Size(); i++)
-			{
-				rapidjson::Value& Val = JsonDoc[i];
+	/// @brief Reads the elements from either an array, or an object with an "items" array.
+	/// Each element is read straight from the parsed value, without parsing it again.
+	virtual void FromJsonValue(const rapidjson::Value& Json) override
+	{
+		const rapidjson::Value* Items = nullptr;
 
-				DtoType& Dto = Array[i];
-				Dto.FromJson(csp::web::JsonObjectToString(Val));
-			}
+		if (Json.IsArray())
+		{
+			Items = &Json;
 		}
-		else if (JsonDoc.HasMember("items"))
+		else if (Json.IsObject())
 		{
-			if (!JsonDoc["items"].IsArray())
+			const auto ItemsMember = Json.FindMember("items");
+
+			if (ItemsMember == Json.MemberEnd() || !ItemsMember->value.IsArray())
 			{
 				return;
 			}
 
-			Array.resize(JsonDoc["items"].Size());
+			Items = &ItemsMember->value;
+		}
+		else
+		{
+			return;
+		}
 
-			for (rapidjson::SizeType i = 0; i < JsonDoc["items"].Size(); i++)
-			{
-				rapidjson::Value& Val = JsonDoc["items"][i];
+		Array.resize(Items->Size());
 
-				DtoType& Dto = Array[i];
-				Dto.FromJson(csp::web::JsonObjectToString(Val));
-			}
+		for (rapidjson::SizeType i = 0; i < Items->Size(); i++)
+		{
+			Array[i].FromJsonValue((*Items)[i]);
 		}
 	}
 
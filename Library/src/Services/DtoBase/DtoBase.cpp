@@ -26,6 +26,11 @@ utility::string_t DtoBase::ToJson() const
 	return Empty;
 }
 
+void DtoBase::FromJsonValue(const rapidjson::Value& Json)
+{
+	FromJson(csp::web::JsonObjectToString(Json));
+}
+
 
 
 utility::string_t EnumBase::ToJson() const
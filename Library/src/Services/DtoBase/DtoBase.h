@@ -50,6 +50,14 @@ public:
 	virtual void FromJson(const utility::string_t& Json)
 	{
 	}
+
+	/// @brief Reads this Dto from a value in an already parsed document.
+	///
+	/// Used when the Dto is part of a larger response, such as an element of a DtoArray. The default implementation writes the value
+	/// back out to a string and passes it to FromJson, which parses it again, so a response is only parsed once when its Dtos override
+	/// this to read their members from the value directly. The Dtos in this tree do, but the generated service Dtos only implement
+	/// FromJson, and still take the default path until the service generator emits an override.
+	virtual void FromJsonValue(const rapidjson::Value& Json);
 };
 
 class EnumBase
@@ -86,6 +94,9 @@ public:
 	void FromJson(const utility::string_t& Json) override
 	{
 	}
+	void FromJsonValue(const rapidjson::Value& Json) override
+	{
+	}
 };
 
 } // namespace csp::services
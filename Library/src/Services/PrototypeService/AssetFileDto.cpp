@@ -30,4 +30,8 @@ void AssetFileDto::FromJson(const csp::common::String& Json)
 {
 }
 
+void AssetFileDto::FromJsonValue(const rapidjson::Value& Json)
+{
+}
+
 } // namespace csp::services
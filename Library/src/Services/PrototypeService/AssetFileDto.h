@@ -28,6 +28,7 @@ public:
 	virtual ~AssetFileDto();
 
 	void FromJson(const csp::common::String& Json) override;
+	void FromJsonValue(const rapidjson::Value& Json) override;
 };
 
 } // namespace csp::services
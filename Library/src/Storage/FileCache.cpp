@@ -0,0 +1,490 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Storage/FileCache.h"
+
+#include "Common/Scheduler.h"
+#include "Common/Wrappers.h"
+#include "Debug/Logging.h"
+#include "Storage/FileUtils.h"
+#include "Storage/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+
+namespace
+{
+
+constexpr int kIndexVersion = 1;
+
+constexpr const char* kBlobDirectory = "blobs";
+constexpr const char* kIndexFileName = "index.json";
+
+// How long after a change the index is written, so that the changes made while downloading a batch of files are saved together
+constexpr std::chrono::milliseconds kIndexSaveDelay(500);
+
+
+bool IsValidContentHash(const std::string& ContentHash)
+{
+	return !ContentHash.empty() && std::all_of(ContentHash.begin(),
+											   ContentHash.end(),
+											   [](unsigned char c)
+											   {
+												   return std::isalnum(c) != 0;
+											   });
+}
+
+} // namespace
+
+
+namespace csp
+{
+
+FileCache::FileCache(const FilePath& InRootDirectory, uint64_t InMaxSize)
+	: RootDirectory(InRootDirectory)
+	, MaxSize(InMaxSize)
+	, TotalSize(0)
+	, Valid(false)
+	, IndexDirty(false)
+	, IndexSaveScheduled(false)
+	, SaveTarget(std::make_shared<IndexSaveTarget>())
+{
+	SaveTarget->Cache = this;
+
+	std::error_code Error;
+	std::filesystem::create_directories(std::filesystem::path(RootDirectory) / kBlobDirectory, Error);
+
+	if (Error)
+	{
+		CSP_LOG_ERROR_FORMAT("Unable to create file cache directory %s: %s", RootDirectory.c_str(), Error.message().c_str());
+
+		return;
+	}
+
+	Valid = true;
+
+	std::scoped_lock Lock(Mutex);
+
+	Load();
+	EvictToBudget();
+}
+
+FileCache::~FileCache()
+{
+	std::scoped_lock SaveLock(SaveTarget->SaveMutex);
+	SaveTarget->Cache = nullptr;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Persists the order in which entries were last read, along with any change that hasn't been saved yet
+		IndexDirty = true;
+	}
+
+	SaveIndex();
+}
+
+bool FileCache::IsValid() const
+{
+	return Valid;
+}
+
+bool FileCache::GetValidators(const std::string& Key, Validators& OutValidators) const
+{
+	std::scoped_lock Lock(Mutex);
+
+	const auto It = Entries.find(Key);
+
+	if (It == Entries.end())
+	{
+		return false;
+	}
+
+	OutValidators = It->second.EntryValidators;
+
+	return true;
+}
+
+bool FileCache::Read(const std::string& Key, const ReadCallback& Callback)
+{
+	std::string ContentHash;
+	uint64_t ExpectedSize;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		const auto It = Entries.find(Key);
+
+		if (It == Entries.end())
+		{
+			return false;
+		}
+
+		LruKeys.splice(LruKeys.begin(), LruKeys, It->second.LruPosition);
+
+		ContentHash	 = It->second.ContentHash;
+		ExpectedSize = Blobs.at(ContentHash).Size;
+	}
+
+	// The file is read without holding the lock, as it may be large. If it's evicted meanwhile, the open mapping keeps it readable.
+	MappedFile File(GetBlobPath(ContentHash));
+
+	if (!File.IsMapped() || File.GetSize() != ExpectedSize)
+	{
+		CSP_LOG_WARN_FORMAT("Cached file for %s is missing or corrupt, discarding it", Key.c_str());
+
+		Remove(Key);
+
+		return false;
+	}
+
+	Callback(File.GetData(), File.GetSize());
+
+	return true;
+}
+
+bool FileCache::Store(const std::string& Key, const std::string& ContentHash, const char* Data, size_t Size, const Validators& InValidators)
+{
+	if (!Valid || !IsValidContentHash(ContentHash))
+	{
+		return false;
+	}
+
+	if (MaxSize > 0 && Size > MaxSize)
+	{
+		// Whatever was cached before is out of date now
+		Remove(Key);
+
+		return false;
+	}
+
+	bool BlobExists;
+
+	{
+		std::scoped_lock Lock(Mutex);
+		BlobExists = Blobs.count(ContentHash) > 0;
+	}
+
+	// Content we already have doesn't need writing again, otherwise write it outside of the lock
+	if (!BlobExists && !WriteFileAtomic(GetBlobPath(ContentHash), Data, Size))
+	{
+		CSP_LOG_ERROR_FORMAT("Unable to write cached file for %s", Key.c_str());
+
+		Remove(Key);
+
+		return false;
+	}
+
+	std::scoped_lock Lock(Mutex);
+
+	// The file we found may have been evicted since we looked
+	if (BlobExists && Blobs.count(ContentHash) == 0 && !WriteFileAtomic(GetBlobPath(ContentHash), Data, Size))
+	{
+		return false;
+	}
+
+	const auto It = Entries.find(Key);
+
+	if (It != Entries.end())
+	{
+		RemoveEntry(It);
+	}
+
+	AddEntry(Key, ContentHash, Size, InValidators);
+	EvictToBudget();
+	MarkIndexDirty();
+
+	return true;
+}
+
+void FileCache::Remove(const std::string& Key)
+{
+	std::scoped_lock Lock(Mutex);
+
+	const auto It = Entries.find(Key);
+
+	if (It != Entries.end())
+	{
+		RemoveEntry(It);
+		MarkIndexDirty();
+	}
+}
+
+void FileCache::Clear()
+{
+	std::scoped_lock Lock(Mutex);
+
+	while (!Entries.empty())
+	{
+		RemoveEntry(Entries.begin());
+	}
+
+	MarkIndexDirty();
+}
+
+uint64_t FileCache::GetSize() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return TotalSize;
+}
+
+size_t FileCache::GetNumEntries() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Entries.size();
+}
+
+uint64_t FileCache::GetMaxSize() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return MaxSize;
+}
+
+void FileCache::SetMaxSize(uint64_t InMaxSize)
+{
+	std::scoped_lock Lock(Mutex);
+
+	MaxSize = InMaxSize;
+
+	EvictToBudget();
+	MarkIndexDirty();
+}
+
+FilePath FileCache::GetBlobPath(const std::string& ContentHash) const
+{
+	return (std::filesystem::path(RootDirectory) / kBlobDirectory / ContentHash).string();
+}
+
+FilePath FileCache::GetIndexPath() const
+{
+	return (std::filesystem::path(RootDirectory) / kIndexFileName).string();
+}
+
+void FileCache::AddEntry(const std::string& Key, const std::string& ContentHash, uint64_t Size, const Validators& InValidators)
+{
+	auto& EntryBlob = Blobs[ContentHash];
+
+	if (EntryBlob.RefCount == 0)
+	{
+		EntryBlob.Size = Size;
+		TotalSize += Size;
+	}
+
+	++EntryBlob.RefCount;
+
+	LruKeys.push_front(Key);
+	Entries[Key] = {ContentHash, InValidators, LruKeys.begin()};
+}
+
+void FileCache::RemoveEntry(EntryMap::iterator It)
+{
+	const auto BlobIt = Blobs.find(It->second.ContentHash);
+
+	if (--BlobIt->second.RefCount == 0)
+	{
+		TotalSize -= BlobIt->second.Size;
+
+		std::error_code Error;
+		std::filesystem::remove(GetBlobPath(BlobIt->first), Error);
+
+		Blobs.erase(BlobIt);
+	}
+
+	LruKeys.erase(It->second.LruPosition);
+	Entries.erase(It);
+}
+
+void FileCache::EvictToBudget()
+{
+	while (MaxSize > 0 && TotalSize > MaxSize && !LruKeys.empty())
+	{
+		RemoveEntry(Entries.find(LruKeys.back()));
+	}
+}
+
+void FileCache::Load()
+{
+	std::string Json;
+
+	if (ReadFile(GetIndexPath(), Json))
+	{
+		rapidjson::Document Index;
+		Index.Parse(Json.c_str(), Json.length());
+
+		if (!Index.HasParseError() && Index.IsObject() && Index.HasMember("version") && Index["version"].IsInt()
+			&& Index["version"].GetInt() == kIndexVersion && Index.HasMember("entries") && Index["entries"].IsArray())
+		{
+			// Entries are stored least recently used first
+			for (const auto& Item : Index["entries"].GetArray())
+			{
+				if (!Item.IsObject() || !Item.HasMember("key") || !Item["key"].IsString() || !Item.HasMember("hash") || !Item["hash"].IsString()
+					|| !Item.HasMember("size") || !Item["size"].IsUint64())
+				{
+					continue;
+				}
+
+				const std::string ContentHash = Item["hash"].GetString();
+				const uint64_t Size			  = Item["size"].GetUint64();
+
+				if (!IsValidContentHash(ContentHash))
+				{
+					continue;
+				}
+
+				// Only trust files that are still the size we wrote them as
+				std::error_code Error;
+				const auto FileSize = std::filesystem::file_size(GetBlobPath(ContentHash), Error);
+
+				if (Error || FileSize != Size)
+				{
+					continue;
+				}
+
+				Validators EntryValidators;
+
+				if (Item.HasMember("etag") && Item["etag"].IsString())
+				{
+					EntryValidators.ETag = Item["etag"].GetString();
+				}
+
+				if (Item.HasMember("lastModified") && Item["lastModified"].IsString())
+				{
+					EntryValidators.LastModified = Item["lastModified"].GetString();
+				}
+
+				const std::string Key = Item["key"].GetString();
+				const auto It		  = Entries.find(Key);
+
+				if (It != Entries.end())
+				{
+					RemoveEntry(It);
+				}
+
+				AddEntry(Key, ContentHash, Size, EntryValidators);
+			}
+		}
+		else
+		{
+			CSP_LOG_WARN_FORMAT("File cache index in %s is unreadable, starting with an empty cache", RootDirectory.c_str());
+		}
+	}
+
+	// Remove anything left behind that isn't referenced, such as files whose entries were lost or partially written temporary files
+	std::error_code Error;
+
+	for (const auto& File : std::filesystem::directory_iterator(std::filesystem::path(RootDirectory) / kBlobDirectory, Error))
+	{
+		if (Blobs.count(File.path().filename().string()) == 0)
+		{
+			std::error_code RemoveError;
+			std::filesystem::remove(File.path(), RemoveError);
+		}
+	}
+}
+
+void FileCache::MarkIndexDirty()
+{
+	IndexDirty = true;
+
+	if (!Valid || IndexSaveScheduled)
+	{
+		return;
+	}
+
+	IndexSaveScheduled = true;
+
+	GetScheduler()->ScheduleAfter(kIndexSaveDelay,
+								  [Target = SaveTarget]()
+								  {
+									  std::scoped_lock SaveLock(Target->SaveMutex);
+
+									  if (Target->Cache != nullptr)
+									  {
+										  Target->Cache->SaveIndex();
+									  }
+								  });
+}
+
+std::string FileCache::SerialiseIndex() const
+{
+	rapidjson::Document Index(rapidjson::kObjectType);
+	auto& Allocator = Index.GetAllocator();
+
+	rapidjson::Value Items(rapidjson::kArrayType);
+
+	for (auto It = LruKeys.rbegin(); It != LruKeys.rend(); ++It)
+	{
+		const Entry& CachedEntry = Entries.at(*It);
+
+		rapidjson::Value Item(rapidjson::kObjectType);
+		Item.AddMember("key", rapidjson::Value(It->c_str(), Allocator), Allocator);
+		Item.AddMember("hash", rapidjson::Value(CachedEntry.ContentHash.c_str(), Allocator), Allocator);
+		Item.AddMember("size", rapidjson::Value(Blobs.at(CachedEntry.ContentHash).Size), Allocator);
+		Item.AddMember("etag", rapidjson::Value(CachedEntry.EntryValidators.ETag.c_str(), Allocator), Allocator);
+		Item.AddMember("lastModified", rapidjson::Value(CachedEntry.EntryValidators.LastModified.c_str(), Allocator), Allocator);
+
+		Items.PushBack(Item, Allocator);
+	}
+
+	Index.AddMember("version", kIndexVersion, Allocator);
+	Index.AddMember("entries", Items, Allocator);
+
+	rapidjson::StringBuffer Buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> Writer(Buffer);
+	Index.Accept(Writer);
+
+	return std::string(Buffer.GetString(), Buffer.GetSize());
+}
+
+void FileCache::SaveIndex()
+{
+	if (!Valid)
+	{
+		return;
+	}
+
+	std::string Json;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		IndexSaveScheduled = false;
+
+		if (!IndexDirty)
+		{
+			return;
+		}
+
+		IndexDirty = false;
+		Json	   = SerialiseIndex();
+	}
+
+	// Only one save runs at a time, as they all hold SaveMutex, so an older index can't overwrite a newer one
+	if (!WriteFileAtomic(GetIndexPath(), Json.data(), Json.size()))
+	{
+		CSP_LOG_ERROR_FORMAT("Unable to write file cache index in %s", RootDirectory.c_str());
+	}
+}
+
+} // namespace csp
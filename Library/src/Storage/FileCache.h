@@ -15,16 +15,122 @@
  */
 #pragma once
 
+#include "Storage/FileUtils.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace csp
 {
 
-using FilePath = std::string;
-
-struct FileCache
+/// @brief Persistent, content-addressed cache of downloaded files.
+/// Each file is stored once, named by the hash of its content, and any number of keys (usually the URLs the file was downloaded from) can
+/// refer to it. Alongside each key we keep the ETag and Last-Modified validators the file was served with, so that callers can revalidate
+/// a cached file with a conditional request rather than downloading it again.
+/// When the total size of the cached files goes over budget, the least recently used keys are evicted. Cache hits are read through a
+/// memory mapping of the cached file. The index of entries is written shortly after a change, so a burst of changes only writes it
+/// once, and again when the cache is destroyed. All methods are thread-safe.
+class FileCache
 {
-};
+public:
+	struct Validators
+	{
+		std::string ETag;
+		std::string LastModified;
+	};
+
+	/// @brief Receives the content of a cached file. Data is only valid for the duration of the call.
+	using ReadCallback = std::function<void(const char* Data, size_t Size)>;
+
+	/// @param InRootDirectory Directory to keep the cache in. It is created if it doesn't exist, and a cache previously stored there is reloaded.
+	/// @param InMaxSize Budget for the total size of cached files, in bytes. 0 means unlimited.
+	FileCache(const FilePath& InRootDirectory, uint64_t InMaxSize);
+	FileCache(const FileCache&) = delete;
+	~FileCache();
+
+	/// @brief Returns false if the cache directory couldn't be created, in which case nothing will be cached.
+	bool IsValid() const;
+
+	/// @brief Gets the validators that the file cached for Key was stored with. Returns false if nothing is cached for Key.
+	bool GetValidators(const std::string& Key, Validators& OutValidators) const;
+
+	/// @brief Maps the file cached for Key and passes its content to Callback, marking it as the most recently used.
+	/// Returns false, without calling Callback, if nothing is cached for Key or the cached file can no longer be read.
+	bool Read(const std::string& Key, const ReadCallback& Callback);
+
+	/// @brief Caches Data for Key, replacing anything previously cached for it, then evicts older entries if the cache is over budget.
+	/// @param ContentHash Hash of Data, used to name the cached file. Must only contain alphanumeric characters.
+	/// @return False if Data couldn't be cached, for example because it is larger than the whole budget.
+	bool Store(const std::string& Key, const std::string& ContentHash, const char* Data, size_t Size, const Validators& InValidators);
+
+	void Remove(const std::string& Key);
+	void Clear();
+
+	/// @brief Total size of the cached files, in bytes. Files shared by several keys are only counted once.
+	uint64_t GetSize() const;
+	size_t GetNumEntries() const;
+
+	uint64_t GetMaxSize() const;
+	void SetMaxSize(uint64_t InMaxSize);
 
+private:
+	struct Entry
+	{
+		std::string ContentHash;
+		Validators EntryValidators;
+		std::list<std::string>::iterator LruPosition;
+	};
+
+	struct Blob
+	{
+		uint64_t Size;
+		uint32_t RefCount;
+	};
+
+	using EntryMap = std::unordered_map<std::string, Entry>;
+
+	// Shared with the scheduled index save, which may still be running when the cache is destroyed. The destructor clears Cache while
+	// holding SaveMutex, so a save either finishes before the cache goes away or sees that it has gone.
+	struct IndexSaveTarget
+	{
+		std::mutex SaveMutex;
+		FileCache* Cache = nullptr;
+	};
+
+	FilePath GetBlobPath(const std::string& ContentHash) const;
+	FilePath GetIndexPath() const;
+
+	// These all expect Mutex to be held
+	void AddEntry(const std::string& Key, const std::string& ContentHash, uint64_t Size, const Validators& InValidators);
+	void RemoveEntry(EntryMap::iterator It);
+	void EvictToBudget();
+	void Load();
+	void MarkIndexDirty();
+	std::string SerialiseIndex() const;
+
+	// Expects SaveTarget->SaveMutex to be held, and Mutex not to be
+	void SaveIndex();
+
+	FilePath RootDirectory;
+	uint64_t MaxSize;
+	uint64_t TotalSize;
+	bool Valid;
+
+	EntryMap Entries;
+	std::unordered_map<std::string, Blob> Blobs;
+	// Most recently used first
+	std::list<std::string> LruKeys;
+
+	bool IndexDirty;
+	bool IndexSaveScheduled;
+	std::shared_ptr<IndexSaveTarget> SaveTarget;
+
+	mutable std::mutex Mutex;
+};
 
 } // namespace csp
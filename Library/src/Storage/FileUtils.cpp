@@ -0,0 +1,102 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Storage/FileUtils.h"
+
+#include "Common/Wrappers.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+
+namespace
+{
+
+// Used to give temporary files unique names when several threads write the same file at once
+std::atomic_uint32_t TempFileCounter = 0;
+
+
+bool WriteFile(const csp::FilePath& Path, const char* Data, size_t Size)
+{
+	FILE* File = FOPEN(Path.c_str(), "wb");
+
+	if (File == nullptr)
+	{
+		return false;
+	}
+
+	const bool Written = (Size == 0) || (fwrite(Data, 1, Size, File) == Size);
+
+	return (fclose(File) == 0) && Written;
+}
+
+} // namespace
+
+
+namespace csp
+{
+
+bool ReadFile(const FilePath& Path, std::string& OutContent)
+{
+	FILE* File = FOPEN(Path.c_str(), "rb");
+
+	if (File == nullptr)
+	{
+		return false;
+	}
+
+	char Buffer[4096];
+	size_t BytesRead;
+
+	while ((BytesRead = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+	{
+		OutContent.append(Buffer, BytesRead);
+	}
+
+	fclose(File);
+
+	return true;
+}
+
+bool WriteFileAtomic(const FilePath& Path, const char* Data, size_t Size)
+{
+	std::stringstream TempPath;
+	TempPath << Path << ".tmp" << std::this_thread::get_id() << "-" << TempFileCounter++;
+
+	if (!WriteFile(TempPath.str(), Data, Size))
+	{
+		std::error_code Error;
+		std::filesystem::remove(TempPath.str(), Error);
+
+		return false;
+	}
+
+	std::error_code Error;
+	std::filesystem::rename(TempPath.str(), Path, Error);
+
+	if (Error)
+	{
+		std::filesystem::remove(TempPath.str(), Error);
+
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace csp
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace csp
+{
+
+using FilePath = std::string;
+
+/// @brief Reads the whole of a file, appending it to OutContent. Returns false if the file couldn't be opened.
+bool ReadFile(const FilePath& Path, std::string& OutContent);
+
+/// @brief Writes Data to a temporary file alongside Path and then renames it into place, so that a crash part way through never leaves a
+/// truncated file. Safe to call from several threads at once for the same Path.
+bool WriteFileAtomic(const FilePath& Path, const char* Data, size_t Size);
+
+} // namespace csp
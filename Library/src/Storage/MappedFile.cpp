@@ -0,0 +1,206 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Storage/MappedFile.h"
+
+#if defined(CSP_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+namespace csp
+{
+
+MappedFile::MappedFile(const FilePath& Path)
+{
+#if defined(CSP_WINDOWS)
+	FileHandle = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (FileHandle == INVALID_HANDLE_VALUE)
+	{
+		FileHandle = nullptr;
+
+		return;
+	}
+
+	LARGE_INTEGER FileSize;
+
+	if (!GetFileSizeEx(static_cast<HANDLE>(FileHandle), &FileSize))
+	{
+		return;
+	}
+
+	Size = static_cast<size_t>(FileSize.QuadPart);
+
+	Map(PAGE_READONLY, FILE_MAP_READ);
+#else
+	FileDescriptor = open(Path.c_str(), O_RDONLY);
+
+	if (FileDescriptor < 0)
+	{
+		return;
+	}
+
+	struct stat Stat;
+
+	if (fstat(FileDescriptor, &Stat) != 0)
+	{
+		return;
+	}
+
+	Size = static_cast<size_t>(Stat.st_size);
+
+	Map(PROT_READ, MAP_PRIVATE);
+#endif
+}
+
+MappedFile::MappedFile(const FilePath& Path, size_t InSize) : Size(InSize), Writable(true)
+{
+#if defined(CSP_WINDOWS)
+	FileHandle = CreateFileA(Path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (FileHandle == INVALID_HANDLE_VALUE)
+	{
+		FileHandle = nullptr;
+
+		return;
+	}
+
+	LARGE_INTEGER FileSize;
+	FileSize.QuadPart = static_cast<LONGLONG>(Size);
+
+	if (!SetFilePointerEx(static_cast<HANDLE>(FileHandle), FileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(static_cast<HANDLE>(FileHandle)))
+	{
+		return;
+	}
+
+	Map(PAGE_READWRITE, FILE_MAP_WRITE);
+#else
+	FileDescriptor = open(Path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (FileDescriptor < 0)
+	{
+		return;
+	}
+
+	if (ftruncate(FileDescriptor, static_cast<off_t>(Size)) != 0)
+	{
+		return;
+	}
+
+	Map(PROT_READ | PROT_WRITE, MAP_SHARED);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(CSP_WINDOWS)
+	if (Data != nullptr)
+	{
+		UnmapViewOfFile(Data);
+	}
+
+	if (MappingHandle != nullptr)
+	{
+		CloseHandle(static_cast<HANDLE>(MappingHandle));
+	}
+
+	if (FileHandle != nullptr)
+	{
+		CloseHandle(static_cast<HANDLE>(FileHandle));
+	}
+#else
+	if (Data != nullptr)
+	{
+		munmap(Data, Size);
+	}
+
+	if (FileDescriptor >= 0)
+	{
+		close(FileDescriptor);
+	}
+#endif
+}
+
+bool MappedFile::IsMapped() const
+{
+	return Mapped;
+}
+
+const char* MappedFile::GetData() const
+{
+	// Empty files can't be mapped, but are still valid
+	return (Data != nullptr) ? Data : "";
+}
+
+char* MappedFile::GetMutableData()
+{
+	return Writable ? Data : nullptr;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return Size;
+}
+
+#if defined(CSP_WINDOWS)
+void MappedFile::Map(unsigned long Protection, unsigned long Access)
+{
+	if (Size > 0)
+	{
+		MappingHandle = CreateFileMappingA(static_cast<HANDLE>(FileHandle), nullptr, Protection, 0, 0, nullptr);
+
+		if (MappingHandle == nullptr)
+		{
+			return;
+		}
+
+		Data = static_cast<char*>(MapViewOfFile(static_cast<HANDLE>(MappingHandle), Access, 0, 0, 0));
+
+		if (Data == nullptr)
+		{
+			return;
+		}
+	}
+
+	Mapped = true;
+}
+#else
+void MappedFile::Map(unsigned long Protection, unsigned long Flags)
+{
+	if (Size > 0)
+	{
+		void* Mapping = mmap(nullptr, Size, static_cast<int>(Protection), static_cast<int>(Flags), FileDescriptor, 0);
+
+		if (Mapping == MAP_FAILED)
+		{
+			return;
+		}
+
+		Data = static_cast<char*>(Mapping);
+	}
+
+	Mapped = true;
+}
+#endif
+
+} // namespace csp
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "Storage/FileUtils.h"
+
+#include <cstddef>
+
+namespace csp
+{
+
+/// @brief Memory mapping of a whole file.
+/// Existing files are mapped read-only. A file can also be created at a given size and mapped for writing, so that data can be written
+/// straight into it without going through an intermediate buffer. Changes to a writable mapping are written to the file when it's unmapped.
+class MappedFile
+{
+public:
+	/// @brief Maps an existing file for reading.
+	explicit MappedFile(const FilePath& Path);
+
+	/// @brief Creates the file at Path, replacing any existing file, with a size of Size bytes, and maps it for writing.
+	MappedFile(const FilePath& Path, size_t InSize);
+
+	MappedFile(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool IsMapped() const;
+
+	const char* GetData() const;
+
+	/// @brief Returns null unless the file was mapped for writing.
+	char* GetMutableData();
+
+	size_t GetSize() const;
+
+private:
+	// Takes the platform's page protection and mapping flags
+	void Map(unsigned long Protection, unsigned long Flags);
+
+#if defined(CSP_WINDOWS)
+	// Windows HANDLEs, kept as void* so that this header doesn't need to include windows.h
+	void* FileHandle	= nullptr;
+	void* MappingHandle = nullptr;
+#else
+	int FileDescriptor = -1;
+#endif
+	char* Data	  = nullptr;
+	size_t Size	  = 0;
+	bool Mapped	  = false;
+	bool Writable = false;
+};
+
+} // namespace csp
@@ -360,6 +360,29 @@ void AssetDataResult::OnResponse(const csp::services::ApiResponseBase* ApiRespon
 	ResultBase::OnResponse(ApiResponse);
 }
 
+AssetDataBatchResult::AssetDataBatchResult(void*)
+{
+}
+
+AssetDataBatchResult::AssetDataBatchResult(csp::systems::EResultCode ResCode, uint16_t HttpResCode) : ResultBase(ResCode, HttpResCode)
+{
+}
+
+uint32_t AssetDataBatchResult::GetNumAssets() const
+{
+	return NumAssets;
+}
+
+uint32_t AssetDataBatchResult::GetNumFailed() const
+{
+	return NumFailed;
+}
+
+uint32_t AssetDataBatchResult::GetNumDownloads() const
+{
+	return NumDownloads;
+}
+
 const csp::common::String& Asset::GetThirdPartyPackagedAssetIdentifier() const
 {
 	return ThirdPartyPackagedAssetIdentifier;
@@ -18,14 +18,25 @@
 
 #include "CallHelpers.h"
 #include "Common/Algorithm.h"
+#include "Events/EventListener.h"
+#include "Events/EventSystem.h"
 #include "LODHelpers.h"
 #include "Services/PrototypeService/Api.h"
+#include "Systems/Assets/LODChainCache.h"
+#include "Systems/Assets/LODPrefetch.h"
 #include "Systems/ResultHelpers.h"
+#include "Web/HttpResponseSink.h"
 #include "Web/RemoteFileManager.h"
 
 // StringFormat needs to be here due to clashing headers
 #include "CSP/Common/StringFormat.h"
 
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 
 using namespace csp;
 using namespace csp::common;
@@ -34,6 +45,11 @@ namespace chs = services::generated::prototypeservice;
 
 constexpr int DEFAULT_SKIP_NUMBER		= 0;
 constexpr int DEFAULT_RESULT_MAX_NUMBER = 100;
+// Size of the pieces asset data of unknown length is written to files in, and passed to chunk callbacks in
+constexpr size_t ASSET_DATA_CHUNK_SIZE = 256 * 1024;
+// Most collections whose LOD chains are cached at once, and how long each is cached for
+constexpr size_t LOD_CHAIN_CACHE_CAPACITY			   = 500;
+constexpr std::chrono::minutes LOD_CHAIN_CACHE_MAX_AGE = std::chrono::minutes(15);
 
 
 namespace
@@ -142,13 +158,107 @@ std::shared_ptr<chs::PrototypeDto> CreatePrototypeDto(const Optional<String>& Sp
 	return PrototypeInfo;
 }
 
+// Tracks the assets of a batch download that are still waiting for their results
+struct AssetDataBatchState
+{
+	std::mutex Mutex;
+	uint32_t NumRemaining		  = 0;
+	uint32_t NumFailed			  = 0;
+	uint16_t FailedHttpResultCode = 0;
+};
+
+// The LOD chain of a collection may change once any of its assets have been created, changed or deleted
+template <typename ResultT>
+std::function<void(const ResultT&)>
+	InvalidateLODChainOnCompletion(systems::LODChainCache* Cache, const String& AssetCollectionId, std::function<void(const ResultT&)> Callback)
+{
+	return [Cache, AssetCollectionId = std::string(AssetCollectionId.c_str()), Callback](const ResultT& Result)
+	{
+		if (Result.GetResultCode() != systems::EResultCode::InProgress)
+		{
+			Cache->Invalidate(AssetCollectionId);
+		}
+
+		INVOKE_IF_NOT_NULL(Callback, Result);
+	};
+}
+
 } // namespace
 
 
 namespace csp::systems
 {
 
-AssetSystem::AssetSystem() : SystemBase(), PrototypeAPI(nullptr), AssetDetailAPI(nullptr), FileManager(nullptr)
+// Reads the assets that make up LOD chains through the asset system
+class AssetSystemLODStore : public LODChainCache::IStore
+{
+public:
+	AssetSystemLODStore(AssetSystem* InAssetSystem);
+
+	void GetModelAssets(const std::string& AssetCollectionId, LODChainCache::AssetsCallback Callback) override;
+
+private:
+	AssetSystem* AssetSystemPtr;
+};
+
+
+class AssetSystemEventHandler : public csp::events::EventListener
+{
+public:
+	AssetSystemEventHandler(AssetSystem* InAssetSystem);
+
+	void OnEvent(const csp::events::Event& InEvent) override;
+
+private:
+	AssetSystem* AssetSystemPtr;
+};
+
+
+AssetSystemLODStore::AssetSystemLODStore(AssetSystem* InAssetSystem) : AssetSystemPtr(InAssetSystem)
+{
+}
+
+void AssetSystemLODStore::GetModelAssets(const std::string& AssetCollectionId, LODChainCache::AssetsCallback Callback)
+{
+	AssetsResultCallback InternalCallback = [Callback](const AssetsResult& Result)
+	{
+		if (Result.GetResultCode() == EResultCode::InProgress)
+		{
+			return;
+		}
+
+		Callback(Result.GetResultCode() == EResultCode::Success, Result.GetHttpResultCode(), Result.GetAssets());
+	};
+
+	AssetSystemPtr->GetAssetsByCriteria({AssetCollectionId.c_str()}, nullptr, nullptr, Array<EAssetType> {EAssetType::MODEL}, InternalCallback);
+}
+
+
+AssetSystemEventHandler::AssetSystemEventHandler(AssetSystem* InAssetSystem) : AssetSystemPtr(InAssetSystem)
+{
+}
+
+void AssetSystemEventHandler::OnEvent(const csp::events::Event& InEvent)
+{
+	if (InEvent.GetId() == csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID)
+	{
+		AssetSystemPtr->LODCache->OnAssetChanged(InEvent.GetString("AssetId"), InEvent.GetString("AssetCollectionId"));
+	}
+	else if (InEvent.GetId() == csp::events::USERSERVICE_LOGOUT_EVENT_ID)
+	{
+		AssetSystemPtr->LODCache->Clear();
+	}
+}
+
+
+AssetSystem::AssetSystem()
+	: SystemBase()
+	, PrototypeAPI(nullptr)
+	, AssetDetailAPI(nullptr)
+	, FileManager(nullptr)
+	, LODStore(nullptr)
+	, LODCache(nullptr)
+	, EventHandler(nullptr)
 {
 }
 
@@ -158,10 +268,27 @@ AssetSystem::AssetSystem(web::WebClient* InWebClient) : SystemBase(InWebClient)
 	AssetDetailAPI = CSP_NEW chs::AssetDetailApi(InWebClient);
 
 	FileManager = CSP_NEW web::RemoteFileManager(InWebClient);
+
+	LODStore	 = CSP_NEW AssetSystemLODStore(this);
+	LODCache	 = CSP_NEW LODChainCache(LODStore, LOD_CHAIN_CACHE_CAPACITY, LOD_CHAIN_CACHE_MAX_AGE);
+	EventHandler = CSP_NEW AssetSystemEventHandler(this);
+
+	csp::events::EventSystem::Get().RegisterListener(csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID, EventHandler);
+	csp::events::EventSystem::Get().RegisterListener(csp::events::USERSERVICE_LOGOUT_EVENT_ID, EventHandler);
 }
 
 AssetSystem::~AssetSystem()
 {
+	if (EventHandler != nullptr)
+	{
+		csp::events::EventSystem::Get().UnRegisterListener(csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID, EventHandler);
+		csp::events::EventSystem::Get().UnRegisterListener(csp::events::USERSERVICE_LOGOUT_EVENT_ID, EventHandler);
+	}
+
+	CSP_DELETE(EventHandler);
+	CSP_DELETE(LODCache);
+	CSP_DELETE(LODStore);
+
 	CSP_DELETE(FileManager);
 
 	CSP_DELETE(AssetDetailAPI);
@@ -207,8 +334,10 @@ void AssetSystem::DeleteAssetCollection(const AssetCollection& AssetCollection,
 		return;
 	}
 
+	const NullResultCallback InternalCallback = InvalidateLODChainOnCompletion<NullResult>(LODCache, PrototypeId, Callback);
+
 	services::ResponseHandlerPtr ResponseHandler
-		= PrototypeAPI->CreateHandler<NullResultCallback, NullResult, void, services::NullDto>(Callback,
+		= PrototypeAPI->CreateHandler<NullResultCallback, NullResult, void, services::NullDto>(InternalCallback,
 																							   nullptr,
 																							   web::EResponseCodes::ResponseNoContent);
 
@@ -488,8 +617,10 @@ void AssetSystem::CreateAsset(const AssetCollection& AssetCollection,
 	Platform.push_back(DefaultPlatform);
 	AssetInfo->SetSupportedPlatforms(Platform);
 
+	const AssetResultCallback InternalCallback = InvalidateLODChainOnCompletion<AssetResult>(LODCache, AssetCollection.Id, Callback);
+
 	services::ResponseHandlerPtr ResponseHandler
-		= AssetDetailAPI->CreateHandler<AssetResultCallback, AssetResult, void, chs::AssetDetailDto>(Callback,
+		= AssetDetailAPI->CreateHandler<AssetResultCallback, AssetResult, void, chs::AssetDetailDto>(InternalCallback,
 																									 nullptr,
 																									 web::EResponseCodes::ResponseCreated);
 
@@ -519,8 +650,11 @@ void AssetSystem::UpdateAsset(const Asset& Asset, AssetResultCallback Callback)
 		StringFormat("%s|%d", Asset.GetThirdPartyPackagedAssetIdentifier().c_str(), static_cast<int>(Asset.GetThirdPartyPlatformType())));
 
 	AssetInfo->SetAssetType(ConvertAssetTypeToString(Asset.Type));
+
+	const AssetResultCallback InternalCallback = InvalidateLODChainOnCompletion<AssetResult>(LODCache, Asset.AssetCollectionId, Callback);
+
 	services::ResponseHandlerPtr ResponseHandler
-		= AssetDetailAPI->CreateHandler<AssetResultCallback, AssetResult, void, chs::AssetDetailDto>(Callback,
+		= AssetDetailAPI->CreateHandler<AssetResultCallback, AssetResult, void, chs::AssetDetailDto>(InternalCallback,
 																									 nullptr,
 																									 web::EResponseCodes::ResponseCreated);
 	static_cast<chs::AssetDetailApi*>(AssetDetailAPI)
@@ -529,8 +663,10 @@ void AssetSystem::UpdateAsset(const Asset& Asset, AssetResultCallback Callback)
 
 void AssetSystem::DeleteAsset(const AssetCollection& AssetCollection, const Asset& Asset, NullResultCallback Callback)
 {
+	const NullResultCallback InternalCallback = InvalidateLODChainOnCompletion<NullResult>(LODCache, AssetCollection.Id, Callback);
+
 	services::ResponseHandlerPtr ResponseHandler
-		= AssetDetailAPI->CreateHandler<NullResultCallback, NullResult, void, services::NullDto>(Callback,
+		= AssetDetailAPI->CreateHandler<NullResultCallback, NullResult, void, services::NullDto>(InternalCallback,
 																								 nullptr,
 																								 web::EResponseCodes::ResponseNoContent);
 
@@ -720,6 +856,8 @@ void AssetSystem::UploadAssetDataEx(const AssetCollection& AssetCollection,
 		INVOKE_IF_NOT_NULL(Callback, Result);
 	};
 
+	InternalCallback = InvalidateLODChainOnCompletion<UriResult>(LODCache, AssetCollection.Id, InternalCallback);
+
 	services::ResponseHandlerPtr ResponseHandler
 		= AssetDetailAPI->CreateHandler<UriResultCallback, UriResult, void, services::NullDto>(InternalCallback,
 																							   nullptr,
@@ -747,6 +885,148 @@ void AssetSystem::DownloadAssetDataEx(const Asset& Asset, CancellationToken& Can
 	FileManager->GetFile(Asset.Uri, ResponseHandler, CancellationToken);
 }
 
+void AssetSystem::DownloadAssetDataToFile(const Asset& Asset,
+										  const String& FilePath,
+										  CancellationToken& CancellationToken,
+										  UInt64ResultCallback Callback)
+{
+	auto Sink = std::make_shared<web::FileResponseSink>(FilePath.c_str(), ASSET_DATA_CHUNK_SIZE);
+
+	DownloadAssetDataToSink(Asset, Sink, true, CancellationToken, Callback);
+}
+
+void AssetSystem::DownloadAssetDataToBuffer(const Asset& Asset,
+											void* Buffer,
+											size_t BufferSize,
+											CancellationToken& CancellationToken,
+											UInt64ResultCallback Callback)
+{
+	auto Sink = std::make_shared<web::BufferResponseSink>(static_cast<char*>(Buffer), BufferSize);
+
+	DownloadAssetDataToSink(Asset, Sink, true, CancellationToken, Callback);
+}
+
+void AssetSystem::DownloadAssetDataInChunks(const Asset& Asset,
+											AssetDataChunkCallback ChunkCallback,
+											CancellationToken& CancellationToken,
+											UInt64ResultCallback Callback)
+{
+	auto Sink = std::make_shared<web::CallbackResponseSink>(
+		[ChunkCallback](size_t Offset, const char* Data, size_t Length)
+		{
+			INVOKE_IF_NOT_NULL(ChunkCallback, Offset, Data, Length);
+		},
+		ASSET_DATA_CHUNK_SIZE);
+
+	// Chunks are passed on in order, so can't be downloaded as ranges
+	DownloadAssetDataToSink(Asset, Sink, false, CancellationToken, Callback);
+}
+
+void AssetSystem::DownloadAssetDataBatch(const Array<Asset>& Assets,
+										 const Array<int32_t>& Priorities,
+										 uint32_t MaxConcurrentDownloads,
+										 CancellationToken& CancellationToken,
+										 AssetDataBatchItemCallback ItemCallback,
+										 AssetDataBatchResultCallback Callback)
+{
+	std::unordered_set<std::string> Uris;
+
+	for (size_t i = 0; i < Assets.Size(); ++i)
+	{
+		Uris.insert(Assets[i].Uri.c_str());
+	}
+
+	const uint32_t NumAssets	= static_cast<uint32_t>(Assets.Size());
+	const uint32_t NumDownloads = static_cast<uint32_t>(Uris.size());
+
+	if (NumAssets == 0)
+	{
+		AssetDataBatchResult Result(EResultCode::Success, static_cast<uint16_t>(web::EResponseCodes::ResponseOK));
+		INVOKE_IF_NOT_NULL(Callback, Result);
+
+		return;
+	}
+
+	auto State			= std::make_shared<AssetDataBatchState>();
+	State->NumRemaining = NumAssets;
+
+	std::vector<web::BatchFileRequest> Requests;
+	Requests.reserve(Assets.Size());
+
+	for (size_t i = 0; i < Assets.Size(); ++i)
+	{
+		AssetDataResultCallback InternalCallback = [ItemCallback, Callback, State, NumAssets, NumDownloads, i](const AssetDataResult& Result)
+		{
+			INVOKE_IF_NOT_NULL(ItemCallback, i, Result);
+
+			if (Result.GetResultCode() == EResultCode::InProgress)
+			{
+				return;
+			}
+
+			std::unique_lock Lock(State->Mutex);
+
+			if (Result.GetResultCode() != EResultCode::Success)
+			{
+				if (State->NumFailed++ == 0)
+				{
+					State->FailedHttpResultCode = Result.GetHttpResultCode();
+				}
+			}
+
+			if (--State->NumRemaining > 0)
+			{
+				return;
+			}
+
+			AssetDataBatchResult BatchResult(State->NumFailed == 0 ? EResultCode::Success : EResultCode::Failed,
+											 State->NumFailed == 0 ? static_cast<uint16_t>(web::EResponseCodes::ResponseOK)
+																   : State->FailedHttpResultCode);
+			BatchResult.NumAssets	 = NumAssets;
+			BatchResult.NumFailed	 = State->NumFailed;
+			BatchResult.NumDownloads = NumDownloads;
+
+			Lock.unlock();
+
+			INVOKE_IF_NOT_NULL(Callback, BatchResult);
+		};
+
+		services::ResponseHandlerPtr ResponseHandler
+			= AssetDetailAPI->CreateHandler<AssetDataResultCallback, AssetDataResult, void, services::AssetFileDto>(InternalCallback, nullptr);
+
+		Requests.push_back({Assets[i].Uri, i < Priorities.Size() ? Priorities[i] : 0, ResponseHandler});
+	}
+
+	FileManager->GetFileBatch(Requests, MaxConcurrentDownloads, CancellationToken);
+}
+
+void AssetSystem::DownloadAssetDataToSink(const Asset& Asset,
+										  const std::shared_ptr<web::IHttpResponseSink>& Sink,
+										  bool InRanges,
+										  CancellationToken& CancellationToken,
+										  UInt64ResultCallback Callback)
+{
+	UInt64ResultCallback InternalCallback = [Callback, Sink](const UInt64Result& Result)
+	{
+		UInt64Result InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
+		InternalResult.SetValue(Sink->GetSize());
+
+		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+	};
+
+	services::ResponseHandlerPtr ResponseHandler
+		= AssetDetailAPI->CreateHandler<UInt64ResultCallback, UInt64Result, void, services::NullDto>(InternalCallback, nullptr);
+
+	if (InRanges)
+	{
+		FileManager->GetFileInRanges(Asset.Uri, Sink, web::RangedDownloadOptions(), ResponseHandler, CancellationToken);
+	}
+	else
+	{
+		FileManager->GetFile(Asset.Uri, Sink, ResponseHandler, CancellationToken);
+	}
+}
+
 void AssetSystem::GetAssetDataSize(const Asset& Asset, UInt64ResultCallback Callback)
 {
 	HTTPHeadersResultCallback InternalCallback = [Callback](const HTTPHeadersResult& Result)
@@ -770,22 +1050,59 @@ void AssetSystem::GetAssetDataSize(const Asset& Asset, UInt64ResultCallback Call
 	FileManager->GetResponseHeaders(Asset.Uri, ResponseHandler);
 }
 
+bool AssetSystem::EnableAssetDataCache(const String& Directory, uint64_t MaxSizeBytes)
+{
+#ifdef CSP_WASM
+	CSP_LOG_WARN_MSG("The asset data cache is not supported on WASM.");
+
+	return false;
+#else
+	if (Directory.IsEmpty())
+	{
+		CSP_LOG_ERROR_MSG("A directory must be provided to enable the asset data cache.");
+
+		return false;
+	}
+
+	return FileManager->EnableFileCache(Directory.c_str(), MaxSizeBytes);
+#endif
+}
+
+void AssetSystem::DisableAssetDataCache()
+{
+	FileManager->DisableFileCache();
+}
+
+void AssetSystem::ClearAssetDataCache()
+{
+	if (const auto FileCache = FileManager->GetFileCache())
+	{
+		FileCache->Clear();
+	}
+}
+
+uint64_t AssetSystem::GetAssetDataCacheSize() const
+{
+	const auto FileCache = FileManager->GetFileCache();
+
+	return (FileCache != nullptr) ? FileCache->GetSize() : 0;
+}
+
 CSP_ASYNC_RESULT void AssetSystem::GetLODChain(const AssetCollection& AssetCollection, LODChainResultCallback Callback)
 {
-	auto GetAssetsCallback = [AssetCollection, Callback](const AssetsResult& Result)
+	LODChainCache::ChainCallback InternalCallback = [Callback](bool Succeeded, uint16_t HttpResultCode, const LODChain& Chain)
 	{
-		LODChainResult LODResult(Result.GetResultCode(), Result.GetHttpResultCode());
+		LODChainResult LODResult(Succeeded ? EResultCode::Success : EResultCode::Failed, HttpResultCode);
 
-		if (Result.GetResultCode() == EResultCode::Success)
+		if (Succeeded)
 		{
-			LODChain Chain = CreateLODChainFromAssets(Result.GetAssets(), AssetCollection.Id);
-			LODResult.SetLODChain(std::move(Chain));
+			LODResult.SetLODChain(Chain);
 		}
 
 		INVOKE_IF_NOT_NULL(Callback, LODResult);
 	};
 
-	GetAssetsByCriteria({AssetCollection.Id}, nullptr, nullptr, Array<EAssetType> {EAssetType::MODEL}, GetAssetsCallback);
+	LODCache->GetChain(AssetCollection.Id.c_str(), InternalCallback);
 }
 
 CSP_ASYNC_RESULT_WITH_PROGRESS void
@@ -842,4 +1159,37 @@ CSP_ASYNC_RESULT_WITH_PROGRESS void
 	GetAssetsByCriteria({InAsset.AssetCollectionId}, nullptr, nullptr, Array<EAssetType> {EAssetType::MODEL}, GetAssetsCallback);
 }
 
+void AssetSystem::PrefetchLODChain(const LODChain& Chain,
+								   uint64_t MaxBytesPerSecond,
+								   CancellationToken& CancellationToken,
+								   LODAssetDataCallback LevelCallback,
+								   NullResultCallback Callback)
+{
+	LODPrefetch::DownloadFunction Download
+		= [this, Token = &CancellationToken, LevelCallback](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+	{
+		AssetDataResultCallback InternalCallback = [LevelCallback, LODLevel = Level.Level, Downloaded](const AssetDataResult& Result)
+		{
+			INVOKE_IF_NOT_NULL(LevelCallback, LODLevel, Result);
+
+			if (Result.GetResultCode() == EResultCode::InProgress)
+			{
+				return;
+			}
+
+			Downloaded(Result.GetResultCode() == EResultCode::Success, Result.GetHttpResultCode(), Result.GetDataLength());
+		};
+
+		DownloadAssetDataEx(Level.Asset, *Token, InternalCallback);
+	};
+
+	LODPrefetch::CompleteCallback InternalCallback = [Callback](bool Succeeded, uint16_t HttpResultCode)
+	{
+		NullResult Result(Succeeded ? EResultCode::Success : EResultCode::Failed, HttpResultCode);
+		INVOKE_IF_NOT_NULL(Callback, Result);
+	};
+
+	std::make_shared<LODPrefetch>(Chain, MaxBytesPerSecond, CancellationToken, Download, InternalCallback)->Start();
+}
+
 } // namespace csp::systems
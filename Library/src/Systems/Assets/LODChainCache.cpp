@@ -0,0 +1,256 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Systems/Assets/LODChainCache.h"
+
+#include "Systems/Assets/LODHelpers.h"
+
+
+namespace
+{
+
+constexpr uint16_t kResponseOK = 200;
+
+} // namespace
+
+
+namespace csp::systems
+{
+
+LODChainCache::LODChainCache(IStore* InStore, size_t InCapacity, Clock::duration InMaxAge)
+	: Store(InStore)
+	, Capacity(InCapacity)
+	, MaxAge(InMaxAge)
+	, Generation(0)
+{
+}
+
+void LODChainCache::GetChain(const std::string& AssetCollectionId, ChainCallback Callback)
+{
+	LODChain Cached;
+	bool IsCached	 = false;
+	bool ShouldFetch = false;
+	uint64_t FetchGeneration;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		const auto It = Entries.find(AssetCollectionId);
+
+		if (It != Entries.end() && Clock::now() - It->second.FetchedAt < MaxAge)
+		{
+			Cached	 = It->second.Chain;
+			IsCached = true;
+			Lru.splice(Lru.begin(), Lru, It->second.LruPosition);
+		}
+		else
+		{
+			auto& Callbacks = Waiting[AssetCollectionId];
+			ShouldFetch		= Callbacks.empty();
+			Callbacks.push_back(std::move(Callback));
+		}
+
+		FetchGeneration = Generation;
+	}
+
+	if (IsCached)
+	{
+		if (Callback)
+		{
+			Callback(true, kResponseOK, Cached);
+		}
+
+		return;
+	}
+
+	if (ShouldFetch)
+	{
+		AssetsCallback InternalCallback
+			= [this, AssetCollectionId, FetchGeneration](bool Succeeded, uint16_t HttpResultCode, const csp::common::Array<Asset>& Assets)
+		{
+			OnFetched(AssetCollectionId, FetchGeneration, Succeeded, HttpResultCode, Assets);
+		};
+
+		Store->GetModelAssets(AssetCollectionId, InternalCallback);
+	}
+}
+
+void LODChainCache::Invalidate(const std::string& AssetCollectionId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Erase(AssetCollectionId);
+
+	if (Waiting.count(AssetCollectionId) > 0)
+	{
+		Stale.insert(AssetCollectionId);
+	}
+}
+
+void LODChainCache::OnAssetChanged(const std::string& AssetId, const std::string& AssetCollectionId)
+{
+	if (!AssetCollectionId.empty())
+	{
+		Invalidate(AssetCollectionId);
+
+		return;
+	}
+
+	if (AssetId.empty())
+	{
+		return;
+	}
+
+	std::scoped_lock Lock(Mutex);
+
+	std::vector<std::string> Changed;
+
+	for (const auto& [CollectionId, Cached] : Entries)
+	{
+		const auto& LODAssets = Cached.Chain.LODAssets;
+
+		for (size_t i = 0; i < LODAssets.Size(); ++i)
+		{
+			if (AssetId == LODAssets[i].Asset.Id.c_str())
+			{
+				Changed.push_back(CollectionId);
+
+				break;
+			}
+		}
+	}
+
+	for (const auto& CollectionId : Changed)
+	{
+		Erase(CollectionId);
+	}
+}
+
+void LODChainCache::Clear()
+{
+	std::vector<ChainCallback> Failed;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		for (auto& Item : Waiting)
+		{
+			for (auto& Callback : Item.second)
+			{
+				Failed.push_back(std::move(Callback));
+			}
+		}
+
+		Entries.clear();
+		Lru.clear();
+		Waiting.clear();
+		Stale.clear();
+		++Generation;
+	}
+
+	const LODChain Empty;
+
+	for (const auto& Callback : Failed)
+	{
+		if (Callback)
+		{
+			Callback(false, 0, Empty);
+		}
+	}
+}
+
+size_t LODChainCache::GetNumChains() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Entries.size();
+}
+
+void LODChainCache::OnFetched(const std::string& AssetCollectionId,
+							  uint64_t FetchGeneration,
+							  bool Succeeded,
+							  uint16_t HttpResultCode,
+							  const csp::common::Array<Asset>& Assets)
+{
+	LODChain Chain;
+
+	// Parsed before taking the lock, as it looks through the styles of every asset in the collection
+	if (Succeeded)
+	{
+		Chain = CreateLODChainFromAssets(Assets, AssetCollectionId.c_str());
+	}
+
+	std::vector<ChainCallback> Completed;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Anything waiting on a request from before the cache was cleared has already been failed
+		if (FetchGeneration != Generation)
+		{
+			return;
+		}
+
+		if (Succeeded && Stale.count(AssetCollectionId) == 0)
+		{
+			Insert(AssetCollectionId, Chain, Clock::now());
+		}
+
+		Stale.erase(AssetCollectionId);
+
+		const auto It = Waiting.find(AssetCollectionId);
+
+		if (It != Waiting.end())
+		{
+			Completed = std::move(It->second);
+			Waiting.erase(It);
+		}
+	}
+
+	for (const auto& Callback : Completed)
+	{
+		if (Callback)
+		{
+			Callback(Succeeded, HttpResultCode, Chain);
+		}
+	}
+}
+
+void LODChainCache::Insert(const std::string& AssetCollectionId, const LODChain& Chain, Clock::time_point Now)
+{
+	Erase(AssetCollectionId);
+
+	Lru.push_front(AssetCollectionId);
+	Entries.emplace(AssetCollectionId, Entry {Chain, Now, Lru.begin()});
+
+	while (Entries.size() > Capacity && !Lru.empty())
+	{
+		Entries.erase(Lru.back());
+		Lru.pop_back();
+	}
+}
+
+void LODChainCache::Erase(const std::string& AssetCollectionId)
+{
+	const auto It = Entries.find(AssetCollectionId);
+
+	if (It != Entries.end())
+	{
+		Lru.erase(It->second.LruPosition);
+		Entries.erase(It);
+	}
+}
+
+} // namespace csp::systems
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "CSP/Systems/Assets/LOD.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace csp::systems
+{
+
+/// @brief Cache of the LOD chain of each asset collection, parsed once from the collection's assets.
+/// Chains are kept until they are older than the maximum age or the collection's assets change, up to a fixed number of them, after
+/// which the least recently used chain is discarded. A collection is only fetched once at a time; callers asking for a chain that is
+/// already being fetched wait for the same response.
+/// All methods are thread-safe, and callbacks are never called with the lock held.
+class LODChainCache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	using ChainCallback	 = std::function<void(bool Succeeded, uint16_t HttpResultCode, const LODChain& Chain)>;
+	using AssetsCallback = std::function<void(bool Succeeded, uint16_t HttpResultCode, const csp::common::Array<Asset>& Assets)>;
+
+	/// @brief Where the assets that make up chains are read from.
+	class IStore
+	{
+	public:
+		virtual ~IStore() = default;
+
+		/// @brief Reads the model assets in a collection.
+		virtual void GetModelAssets(const std::string& AssetCollectionId, AssetsCallback Callback) = 0;
+	};
+
+	/// @param InCapacity Most chains kept at once.
+	LODChainCache(IStore* InStore, size_t InCapacity, Clock::duration InMaxAge);
+	LODChainCache(const LODChainCache&) = delete;
+
+	void GetChain(const std::string& AssetCollectionId, ChainCallback Callback);
+
+	/// @brief Discards a collection's chain, so that it is read again next time. A response already in flight isn't cached.
+	void Invalidate(const std::string& AssetCollectionId);
+
+	/// @brief Discards the chain of the collection an asset belongs to. Either id may be empty.
+	void OnAssetChanged(const std::string& AssetId, const std::string& AssetCollectionId);
+
+	/// @brief Discards everything, failing any callers that are waiting.
+	void Clear();
+
+	size_t GetNumChains() const;
+
+private:
+	struct Entry
+	{
+		LODChain Chain;
+		Clock::time_point FetchedAt;
+		std::list<std::string>::iterator LruPosition;
+	};
+
+	void OnFetched(const std::string& AssetCollectionId,
+				   uint64_t FetchGeneration,
+				   bool Succeeded,
+				   uint16_t HttpResultCode,
+				   const csp::common::Array<Asset>& Assets);
+
+	// These expect Mutex to be held
+	void Insert(const std::string& AssetCollectionId, const LODChain& Chain, Clock::time_point Now);
+	void Erase(const std::string& AssetCollectionId);
+
+	IStore* Store;
+	size_t Capacity;
+	Clock::duration MaxAge;
+
+	std::unordered_map<std::string, Entry> Entries;
+	// Most recently used first
+	std::list<std::string> Lru;
+
+	// Callers waiting for each collection that is being fetched
+	std::unordered_map<std::string, std::vector<ChainCallback>> Waiting;
+	// Collections invalidated while being fetched, whose responses mustn't be cached
+	std::unordered_set<std::string> Stale;
+
+	// Goes up whenever the cache is cleared, so that responses to requests made before then are ignored
+	uint64_t Generation;
+
+	mutable std::mutex Mutex;
+};
+
+} // namespace csp::systems
@@ -18,26 +18,48 @@
 #include "Common/Algorithm.h"
 #include "Debug/Logging.h"
 
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
+namespace
+{
+
+constexpr char LOD_STYLE_PREFIX[] = "lod:";
+
+} // namespace
+
 namespace csp::systems
 {
 
 csp::common::String CreateLODStyleVar(int LODLevel)
 {
-	return std::string("lod:" + std::to_string(LODLevel)).c_str();
+	return (LOD_STYLE_PREFIX + std::to_string(LODLevel)).c_str();
 }
 
 int GetLODLevelFromStylesArray(const csp::common::Array<csp::common::String>& Styles)
 {
+	constexpr size_t PrefixLength = sizeof(LOD_STYLE_PREFIX) - 1;
+
 	for (size_t i = 0; i < Styles.Size(); ++i)
 	{
-		std::string Style = Styles[i].c_str();
-		size_t Pos		  = Style.find("lod:");
+		const char* Style = Styles[i].c_str();
+
+		if (strncmp(Style, LOD_STYLE_PREFIX, PrefixLength) != 0)
+		{
+			continue;
+		}
+
+		// Levels can have any number of digits, but nothing else
+		const char* Digits = Style + PrefixLength;
+		char* End		   = nullptr;
+		const long Level   = std::strtol(Digits, &End, 10);
 
-		if (Pos != std::string::npos)
+		if (End != Digits && *End == '\0' && isdigit(static_cast<unsigned char>(*Digits)) && Level <= INT_MAX)
 		{
-			return std::stoi(Style.substr(4, 1));
+			return static_cast<int>(Level);
 		}
 	}
 
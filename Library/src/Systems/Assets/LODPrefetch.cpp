@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Systems/Assets/LODPrefetch.h"
+
+#include "CSP/Web/HTTPResponseCodes.h"
+#include "CallHelpers.h"
+#include "Common/Scheduler.h"
+
+#include <algorithm>
+
+
+namespace csp::systems
+{
+
+LODPrefetch::LODPrefetch(const LODChain& Chain,
+						 uint64_t InMaxBytesPerSecond,
+						 csp::common::CancellationToken& InCancellationToken,
+						 DownloadFunction InDownload,
+						 CompleteCallback InCallback)
+	: MaxBytesPerSecond(InMaxBytesPerSecond)
+	, CancellationToken(&InCancellationToken)
+	, Download(std::move(InDownload))
+	, Callback(std::move(InCallback))
+	, NextLevel(0)
+	, NumBytesDownloaded(0)
+	, Failed(false)
+	, FailedHttpResultCode(0)
+{
+	Levels.reserve(Chain.LODAssets.Size());
+
+	for (size_t i = 0; i < Chain.LODAssets.Size(); ++i)
+	{
+		Levels.push_back(Chain.LODAssets[i]);
+	}
+
+	// Higher levels have less detail
+	std::stable_sort(Levels.begin(),
+					 Levels.end(),
+					 [](const LODAsset& A, const LODAsset& B)
+					 {
+						 return A.Level > B.Level;
+					 });
+}
+
+void LODPrefetch::Start()
+{
+	StartTime = Clock::now();
+
+	DownloadNext();
+}
+
+LODPrefetch::Clock::duration LODPrefetch::GetBudgetDelay(uint64_t NumBytes, uint64_t MaxBytesPerSecond)
+{
+	if (MaxBytesPerSecond == 0)
+	{
+		return Clock::duration::zero();
+	}
+
+	const std::chrono::duration<double> Seconds(static_cast<double>(NumBytes) / static_cast<double>(MaxBytesPerSecond));
+
+	return std::chrono::duration_cast<Clock::duration>(Seconds);
+}
+
+void LODPrefetch::DownloadNext()
+{
+	if (NextLevel < Levels.size() && CancellationToken->Cancelled())
+	{
+		if (!Failed)
+		{
+			Failed				 = true;
+			FailedHttpResultCode = 0;
+		}
+
+		NextLevel = Levels.size();
+	}
+
+	if (NextLevel == Levels.size())
+	{
+		INVOKE_IF_NOT_NULL(Callback, !Failed, Failed ? FailedHttpResultCode : static_cast<uint16_t>(csp::web::EResponseCodes::ResponseOK));
+
+		return;
+	}
+
+	const LODAsset& Level = Levels[NextLevel++];
+
+	Download(Level,
+			 [Self = shared_from_this()](bool Succeeded, uint16_t HttpResultCode, uint64_t NumBytes)
+			 {
+				 Self->OnDownloaded(Succeeded, HttpResultCode, NumBytes);
+			 });
+}
+
+void LODPrefetch::OnDownloaded(bool Succeeded, uint16_t HttpResultCode, uint64_t NumBytes)
+{
+	if (!Succeeded && !Failed)
+	{
+		Failed				 = true;
+		FailedHttpResultCode = HttpResultCode;
+	}
+
+	NumBytesDownloaded += NumBytes;
+
+	// Levels after the first wait until everything downloaded so far fits within the budget
+	const auto Delay = StartTime + GetBudgetDelay(NumBytesDownloaded, MaxBytesPerSecond) - Clock::now();
+
+	if (NextLevel == Levels.size() || Delay <= Clock::duration::zero())
+	{
+		DownloadNext();
+
+		return;
+	}
+
+	const ScheduledTaskId TaskId = GetScheduler()->ScheduleAfter(Delay,
+																 [Self = shared_from_this()]()
+																 {
+																	 Self->DownloadNext();
+																 });
+
+	// The scheduler rejects timers once it has shut down, so give up on the remaining levels rather than never calling back
+	if (TaskId == InvalidScheduledTaskId)
+	{
+		if (!Failed)
+		{
+			Failed				 = true;
+			FailedHttpResultCode = 0;
+		}
+
+		NextLevel = Levels.size();
+
+		DownloadNext();
+	}
+}
+
+} // namespace csp::systems
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "CSP/Common/CancellationToken.h"
+#include "CSP/Systems/Assets/LOD.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+namespace csp::systems
+{
+
+/// @brief Downloads the assets of a LOD chain from the coarsest level to the finest, so that something can be shown as soon as possible.
+/// The coarsest level is downloaded straight away. Finer levels follow one at a time in the background, each started no sooner than
+/// the bytes downloaded so far allow under a bandwidth budget, so that refining one model doesn't hold up everything else in the space.
+class LODPrefetch : public std::enable_shared_from_this<LODPrefetch>
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	using DownloadedCallback = std::function<void(bool Succeeded, uint16_t HttpResultCode, uint64_t NumBytes)>;
+	using DownloadFunction	 = std::function<void(const LODAsset& Level, DownloadedCallback Callback)>;
+	using CompleteCallback	 = std::function<void(bool Succeeded, uint16_t HttpResultCode)>;
+
+	/// @param InMaxBytesPerSecond Average rate the levels are downloaded at, at most. 0 means unlimited.
+	/// @param InDownload Downloads one level. Only one level is downloaded at a time.
+	/// @param InCallback Called once every level has been downloaded or the prefetch has been cancelled. Fails if any level failed.
+	LODPrefetch(const LODChain& Chain,
+				uint64_t InMaxBytesPerSecond,
+				csp::common::CancellationToken& InCancellationToken,
+				DownloadFunction InDownload,
+				CompleteCallback InCallback);
+
+	void Start();
+
+	/// @brief How long to wait after starting, having downloaded NumBytes, before downloading more.
+	static Clock::duration GetBudgetDelay(uint64_t NumBytes, uint64_t MaxBytesPerSecond);
+
+private:
+	void DownloadNext();
+	void OnDownloaded(bool Succeeded, uint16_t HttpResultCode, uint64_t NumBytes);
+
+	// Coarsest first
+	std::vector<LODAsset> Levels;
+	uint64_t MaxBytesPerSecond;
+	csp::common::CancellationToken* CancellationToken;
+	DownloadFunction Download;
+	CompleteCallback Callback;
+
+	// Levels are downloaded one after another, so none of this is touched by more than one thread at a time
+	size_t NextLevel;
+	Clock::time_point StartTime;
+	uint64_t NumBytesDownloaded;
+	bool Failed;
+	uint16_t FailedHttpResultCode;
+};
+
+} // namespace csp::systems
@@ -76,6 +76,9 @@ void ScriptContext::Shutdown()
 	Modules.clear();
 	Imports.clear();
 
+	// Function handles hold references into the context, so they must be released before it is destroyed
+	Functions.clear();
+
 	CSP_DELETE(Context);
 }
 
@@ -124,6 +127,57 @@ bool ScriptContext::ExistsInContext(const csp::common::String& ObjectName)
 	return !isExcept;
 }
 
+bool ScriptContext::ResolveFunction(const csp::common::String& FunctionName)
+{
+	qjs::Value Function = Context->global()[FunctionName.c_str()];
+
+	if (!JS_IsFunction(Context->ctx, Function.v))
+	{
+		Functions.erase(FunctionName.c_str());
+		return false;
+	}
+
+	Functions.insert_or_assign(FunctionName.c_str(), std::move(Function));
+
+	return true;
+}
+
+bool ScriptContext::CallFunction(const csp::common::String& FunctionName, const csp::common::String& Arg0, const csp::common::String& Arg1)
+{
+	JSContext* Ctx = Context->ctx;
+
+	// The script may have replaced the function since its handle was cached, so the handle is checked against the current global on
+	// every call. Reading a property is still far cheaper than compiling a call.
+	qjs::Value Current		 = Context->global()[FunctionName.c_str()];
+	FunctionMap::iterator It = Functions.find(FunctionName.c_str());
+
+	if (It == Functions.end() || !JS_IsObject(Current.v) || JS_VALUE_GET_PTR(It->second.v) != JS_VALUE_GET_PTR(Current.v))
+	{
+		if (!JS_IsFunction(Ctx, Current.v))
+		{
+			Functions.erase(FunctionName.c_str());
+			return false;
+		}
+
+		It = Functions.insert_or_assign(FunctionName.c_str(), std::move(Current)).first;
+	}
+
+	JSValue Args[2] = {JS_NewStringLen(Ctx, Arg0.c_str(), Arg0.Length()), JS_NewStringLen(Ctx, Arg1.c_str(), Arg1.Length())};
+
+	JSValue Result = JS_Call(Ctx, It->second.v, JS_UNDEFINED, 2, Args);
+
+	if (JS_IsException(Result))
+	{
+		csp_dump_error(Ctx);
+	}
+
+	JS_FreeValue(Ctx, Result);
+	JS_FreeValue(Ctx, Args[0]);
+	JS_FreeValue(Ctx, Args[1]);
+
+	return true;
+}
+
 void ScriptContext::AddImport(const csp::common::String& Url)
 {
 	bool Exists = false;
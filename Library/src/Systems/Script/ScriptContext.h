@@ -46,6 +46,15 @@ public:
 
 	bool ExistsInContext(const csp::common::String& ObjectName);
 
+	// Resolves a function on globalThis and caches its handle so it can be called without compiling any script source.
+	// Returns false if no function with this name currently exists in the context.
+	bool ResolveFunction(const csp::common::String& FunctionName);
+
+	// Calls a function previously resolved with ResolveFunction, resolving it again if it isn't cached or the script has replaced it,
+	// passing each argument as a JS string.
+	// Returns false only if the function could not be resolved; exceptions thrown by the function itself are logged.
+	bool CallFunction(const csp::common::String& FunctionName, const csp::common::String& Arg0, const csp::common::String& Arg1);
+
 	size_t GetNumImportedModules() const;
 	const char* GetImportedModule(size_t Index) const;
 
@@ -59,6 +68,7 @@ private:
 
 	using ModuleMap		  = std::map<std::string, ScriptModule*>;
 	using ImportedModules = std::vector<std::string>;
+	using FunctionMap	  = std::map<std::string, qjs::Value>;
 
 	uint64_t ContextId;
 	ScriptSystem* TheScriptSystem;
@@ -67,6 +77,7 @@ private:
 	qjs::Runtime* Runtime;
 	ModuleMap Modules;
 	ImportedModules Imports;
+	FunctionMap Functions;
 };
 
 } // namespace csp::systems
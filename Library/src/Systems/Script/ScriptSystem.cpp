@@ -182,6 +182,32 @@ bool ScriptSystem::ExistsInContext(int64_t ContextId, const csp::common::String&
 }
 
 
+bool ScriptSystem::ResolveFunction(int64_t ContextId, const csp::common::String& FunctionName)
+{
+	ScriptContext* TheScriptContext = TheScriptRuntime->GetContext(ContextId);
+	if (TheScriptContext == nullptr)
+	{
+		return false;
+	}
+
+	return TheScriptContext->ResolveFunction(FunctionName);
+}
+
+bool ScriptSystem::CallFunction(int64_t ContextId,
+								const csp::common::String& FunctionName,
+								const csp::common::String& Arg0,
+								const csp::common::String& Arg1)
+{
+	ScriptContext* TheScriptContext = TheScriptRuntime->GetContext(ContextId);
+	if (TheScriptContext == nullptr)
+	{
+		return false;
+	}
+
+	return TheScriptContext->CallFunction(FunctionName, Arg0, Arg1);
+}
+
+
 void* ScriptSystem::GetContext(int64_t ContextId)
 {
 	return (void*) TheScriptRuntime->GetContext(ContextId)->Context;
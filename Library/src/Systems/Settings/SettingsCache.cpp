@@ -0,0 +1,653 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Systems/Settings/SettingsCache.h"
+
+#include "Common/Scheduler.h"
+#include "Debug/Logging.h"
+#include "Storage/FileUtils.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+
+namespace
+{
+
+constexpr int kFileVersion = 1;
+
+// Long enough to write the file once for a burst of responses, such as the reads made on login
+constexpr std::chrono::milliseconds kSaveDelay(500);
+
+constexpr uint16_t kResponseOK = 200;
+
+} // namespace
+
+
+namespace csp::systems
+{
+
+SettingsCache::SettingsCache(IStore* InStore, Clock::duration InMaxAge)
+	: Store(InStore)
+	, MaxAge(InMaxAge)
+	, Generation(0)
+	, Dirty(false)
+	, SaveScheduled(false)
+	, Target(std::make_shared<SaveTarget>())
+{
+	Target->Cache = this;
+}
+
+SettingsCache::~SettingsCache()
+{
+	std::scoped_lock SaveLock(Target->SaveMutex);
+	Target->Cache = nullptr;
+
+	// Writes anything that changed since the last scheduled save
+	Save();
+}
+
+void SettingsCache::SetUser(const std::string& InUserId)
+{
+	{
+		std::scoped_lock Lock(Mutex);
+
+		if (InUserId == UserId)
+		{
+			return;
+		}
+	}
+
+	Clear();
+
+	std::scoped_lock Lock(Mutex);
+
+	UserId = InUserId;
+	Load();
+}
+
+bool SettingsCache::EnablePersistence(const std::string& InFilePath)
+{
+	std::scoped_lock Lock(Mutex);
+
+	FilePath = InFilePath;
+
+	return Load();
+}
+
+void SettingsCache::DisablePersistence()
+{
+	std::scoped_lock Lock(Mutex);
+
+	FilePath.clear();
+}
+
+void SettingsCache::Clear()
+{
+	std::vector<Waiter> Waiting;
+	std::vector<WriteCallback> Pending;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		for (auto& Cached : Entries)
+		{
+			std::move(Cached.second.Waiting.begin(), Cached.second.Waiting.end(), std::back_inserter(Waiting));
+			std::move(Cached.second.PendingCallbacks.begin(), Cached.second.PendingCallbacks.end(), std::back_inserter(Pending));
+		}
+
+		Entries.clear();
+		Portraits.clear();
+		WritingContexts.clear();
+		++Generation;
+	}
+
+	for (const auto& Callback : Waiting)
+	{
+		Callback(false, 0);
+	}
+
+	for (const auto& Callback : Pending)
+	{
+		if (Callback)
+		{
+			Callback(false, 0);
+		}
+	}
+}
+
+void SettingsCache::Invalidate()
+{
+	std::scoped_lock Lock(Mutex);
+
+	for (auto& Cached : Entries)
+	{
+		if (Cached.second.Version == Cached.second.WrittenVersion)
+		{
+			Cached.second.IsKnown = false;
+		}
+	}
+
+	Portraits.clear();
+	MarkDirty();
+}
+
+void SettingsCache::Get(const std::string& Context, const std::string& Key, ValueCallback Callback)
+{
+	std::unique_lock Lock(Mutex);
+
+	Entry& Cached = Entries[{Context, Key}];
+
+	if (IsFresh(Cached))
+	{
+		const std::string Value = Cached.Value;
+		Lock.unlock();
+
+		Callback(true, kResponseOK, Value);
+
+		return;
+	}
+
+	Cached.Waiting.push_back(
+		[this, Context, Key, Callback](bool Succeeded, uint16_t HttpResultCode)
+		{
+			std::string Value;
+
+			if (Succeeded)
+			{
+				// A change made since the value was fetched is returned rather than the fetched value
+				std::scoped_lock Lock(Mutex);
+
+				const auto It = Entries.find({Context, Key});
+				Value		  = (It != Entries.end()) ? It->second.Value : "";
+			}
+
+			Callback(Succeeded, HttpResultCode, Value);
+		});
+
+	const bool ShouldFetch = !Cached.IsFetching;
+	Cached.IsFetching	   = true;
+
+	Lock.unlock();
+
+	if (ShouldFetch)
+	{
+		Fetch(Context, Key);
+	}
+}
+
+void SettingsCache::Set(const std::string& Context, const std::string& Key, const std::string& Value, WriteCallback Callback)
+{
+	{
+		std::scoped_lock Lock(Mutex);
+
+		Entry& Cached  = Entries[{Context, Key}];
+		Cached.Value   = Value;
+		Cached.IsKnown = true;
+		++Cached.Version;
+		Cached.PendingCallbacks.push_back(std::move(Callback));
+	}
+
+	Flush(Context);
+}
+
+void SettingsCache::Modify(const std::string& Context, const std::string& Key, Mutation Change, WriteCallback Callback)
+{
+	std::unique_lock Lock(Mutex);
+
+	Entry& Cached = Entries[{Context, Key}];
+
+	if (IsFresh(Cached))
+	{
+		Lock.unlock();
+		ApplyChange(Context, Key, std::move(Change), std::move(Callback));
+
+		return;
+	}
+
+	Cached.Waiting.push_back(
+		[this, Context, Key, Change, Callback](bool Succeeded, uint16_t HttpResultCode)
+		{
+			if (Succeeded)
+			{
+				ApplyChange(Context, Key, Change, Callback);
+			}
+			else if (Callback)
+			{
+				Callback(false, HttpResultCode);
+			}
+		});
+
+	const bool ShouldFetch = !Cached.IsFetching;
+	Cached.IsFetching	   = true;
+
+	Lock.unlock();
+
+	if (ShouldFetch)
+	{
+		Fetch(Context, Key);
+	}
+}
+
+bool SettingsCache::GetPortraitUri(const std::string& InUserId, std::string& OutUri) const
+{
+	std::scoped_lock Lock(Mutex);
+
+	const auto It = Portraits.find(InUserId);
+
+	if (It == Portraits.end() || Clock::now() - It->second.FetchedAt > MaxAge)
+	{
+		return false;
+	}
+
+	OutUri = It->second.Uri;
+
+	return true;
+}
+
+void SettingsCache::SetPortraitUri(const std::string& InUserId,
+								   const std::string& Uri,
+								   const std::string& AssetId,
+								   const std::string& AssetCollectionId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Portraits[InUserId] = {Uri, AssetId, AssetCollectionId, Clock::now()};
+}
+
+void SettingsCache::RemovePortraitUri(const std::string& InUserId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Portraits.erase(InUserId);
+}
+
+void SettingsCache::OnAssetChanged(const std::string& AssetId, const std::string& AssetCollectionId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	for (auto It = Portraits.begin(); It != Portraits.end();)
+	{
+		if ((!AssetId.empty() && It->second.AssetId == AssetId) || (!AssetCollectionId.empty() && It->second.AssetCollectionId == AssetCollectionId))
+		{
+			It = Portraits.erase(It);
+		}
+		else
+		{
+			++It;
+		}
+	}
+}
+
+size_t SettingsCache::GetNumEntries() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Entries.size();
+}
+
+void SettingsCache::Fetch(const std::string& Context, const std::string& Key)
+{
+	uint64_t FetchGeneration;
+	uint64_t FetchVersion;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		FetchGeneration = Generation;
+		FetchVersion	= Entries[{Context, Key}].Version;
+	}
+
+	Store->Get(Context,
+			   Key,
+			   [this, Context, Key, FetchGeneration, FetchVersion](bool Succeeded, uint16_t HttpResultCode, const std::string& Value)
+			   {
+				   std::vector<Waiter> Waiting;
+
+				   {
+					   std::scoped_lock Lock(Mutex);
+
+					   // Anything waiting on a fetch from before the cache was cleared has already been failed
+					   if (FetchGeneration != Generation)
+					   {
+						   return;
+					   }
+
+					   Entry& Cached	 = Entries[{Context, Key}];
+					   Cached.IsFetching = false;
+
+					   // If the value has been set since it was fetched, the new value is kept
+					   if (Succeeded && Cached.Version == FetchVersion)
+					   {
+						   Cached.Value		= Value;
+						   Cached.IsKnown	= true;
+						   Cached.FetchedAt = Clock::now();
+						   MarkDirty();
+					   }
+
+					   Waiting.swap(Cached.Waiting);
+				   }
+
+				   for (const auto& Callback : Waiting)
+				   {
+					   Callback(Succeeded, HttpResultCode);
+				   }
+			   });
+}
+
+void SettingsCache::ApplyChange(const std::string& Context, const std::string& Key, Mutation Change, WriteCallback Callback)
+{
+	{
+		std::unique_lock Lock(Mutex);
+
+		Entry& Cached = Entries[{Context, Key}];
+
+		if (!Cached.IsKnown)
+		{
+			// The cache was cleared since the value was read, so read it again
+			Lock.unlock();
+			Modify(Context, Key, std::move(Change), std::move(Callback));
+
+			return;
+		}
+
+		if (!Change(Cached.Value))
+		{
+			Lock.unlock();
+
+			if (Callback)
+			{
+				Callback(true, kResponseOK);
+			}
+
+			return;
+		}
+
+		++Cached.Version;
+		Cached.PendingCallbacks.push_back(std::move(Callback));
+	}
+
+	Flush(Context);
+}
+
+void SettingsCache::Flush(const std::string& Context)
+{
+	std::map<std::string, std::string> Values;
+	std::vector<std::pair<std::string, uint64_t>> SentVersions;
+	auto Callbacks = std::make_shared<std::vector<WriteCallback>>();
+	uint64_t FlushGeneration;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Changes made while a write is in flight are sent together once it completes
+		if (WritingContexts.count(Context) > 0)
+		{
+			return;
+		}
+
+		for (auto It = Entries.lower_bound({Context, ""}); It != Entries.end() && It->first.first == Context; ++It)
+		{
+			Entry& Cached = It->second;
+
+			if (Cached.PendingCallbacks.empty())
+			{
+				continue;
+			}
+
+			Values[It->first.second] = Cached.Value;
+			SentVersions.emplace_back(It->first.second, Cached.Version);
+			std::move(Cached.PendingCallbacks.begin(), Cached.PendingCallbacks.end(), std::back_inserter(*Callbacks));
+			Cached.PendingCallbacks.clear();
+		}
+
+		if (Values.empty())
+		{
+			return;
+		}
+
+		WritingContexts.insert(Context);
+		FlushGeneration = Generation;
+	}
+
+	Store->Put(Context,
+			   Values,
+			   [this, Context, SentVersions, Callbacks, FlushGeneration](bool Succeeded, uint16_t HttpResultCode)
+			   {
+				   bool IsCurrent;
+
+				   {
+					   std::scoped_lock Lock(Mutex);
+
+					   IsCurrent = (FlushGeneration == Generation);
+
+					   if (IsCurrent)
+					   {
+						   WritingContexts.erase(Context);
+
+						   for (const auto& [Key, Version] : SentVersions)
+						   {
+							   const auto It = Entries.find({Context, Key});
+
+							   if (It == Entries.end())
+							   {
+								   continue;
+							   }
+
+							   Entry& Cached = It->second;
+
+							   if (Succeeded)
+							   {
+								   Cached.WrittenVersion = std::max(Cached.WrittenVersion, Version);
+								   Cached.FetchedAt		 = Clock::now();
+								   MarkDirty();
+							   }
+							   else if (Cached.Version == Version)
+							   {
+								   // We no longer know what the value is, so it is read again next time
+								   Cached.IsKnown		 = false;
+								   Cached.WrittenVersion = Version;
+							   }
+						   }
+					   }
+				   }
+
+				   for (const auto& Callback : *Callbacks)
+				   {
+					   if (Callback)
+					   {
+						   Callback(Succeeded, HttpResultCode);
+					   }
+				   }
+
+				   if (IsCurrent)
+				   {
+					   Flush(Context);
+				   }
+			   });
+}
+
+bool SettingsCache::IsFresh(const Entry& CachedEntry) const
+{
+	if (!CachedEntry.IsKnown)
+	{
+		return false;
+	}
+
+	// Values with changes that haven't been confirmed yet are always newer than the settings service's
+	return CachedEntry.Version != CachedEntry.WrittenVersion || Clock::now() - CachedEntry.FetchedAt <= MaxAge;
+}
+
+bool SettingsCache::Load()
+{
+	std::error_code Error;
+
+	// Nothing has been cached yet, or we don't know whose settings to load until the user logs in
+	if (FilePath.empty() || UserId.empty() || !std::filesystem::exists(FilePath, Error))
+	{
+		return true;
+	}
+
+	std::string Json;
+
+	if (!ReadFile(FilePath, Json))
+	{
+		CSP_LOG_ERROR_FORMAT("Unable to read settings cache file %s", FilePath.c_str());
+
+		return false;
+	}
+
+	rapidjson::Document Document;
+	Document.Parse(Json.c_str(), Json.length());
+
+	if (Document.HasParseError() || !Document.IsObject() || !Document.HasMember("version") || !Document["version"].IsInt()
+		|| Document["version"].GetInt() != kFileVersion || !Document.HasMember("user") || !Document["user"].IsString()
+		|| !Document.HasMember("entries") || !Document["entries"].IsArray())
+	{
+		CSP_LOG_WARN_FORMAT("Settings cache file %s is unreadable, ignoring it", FilePath.c_str());
+
+		return false;
+	}
+
+	// The file only holds one user's settings at a time
+	if (UserId != Document["user"].GetString())
+	{
+		return true;
+	}
+
+	for (const auto& Item : Document["entries"].GetArray())
+	{
+		if (!Item.IsObject() || !Item.HasMember("context") || !Item["context"].IsString() || !Item.HasMember("key") || !Item["key"].IsString()
+			|| !Item.HasMember("value") || !Item["value"].IsString() || !Item.HasMember("fetched") || !Item["fetched"].IsInt64())
+		{
+			continue;
+		}
+
+		Entry& Cached = Entries[{Item["context"].GetString(), Item["key"].GetString()}];
+
+		// Don't replace anything read or written in this session
+		if (Cached.IsKnown || Cached.IsFetching)
+		{
+			continue;
+		}
+
+		Cached.Value	 = Item["value"].GetString();
+		Cached.IsKnown	 = true;
+		Cached.FetchedAt = Clock::time_point(std::chrono::seconds(Item["fetched"].GetInt64()));
+	}
+
+	return true;
+}
+
+void SettingsCache::MarkDirty()
+{
+	Dirty = true;
+
+	if (SaveScheduled)
+	{
+		return;
+	}
+
+	SaveScheduled = true;
+
+	GetScheduler()->ScheduleAfter(kSaveDelay,
+								  [Target = Target]()
+								  {
+									  std::scoped_lock SaveLock(Target->SaveMutex);
+
+									  if (Target->Cache != nullptr)
+									  {
+										  Target->Cache->Save();
+									  }
+								  });
+}
+
+void SettingsCache::Save()
+{
+	std::string SavePath;
+	std::string Json;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		SaveScheduled = false;
+
+		if (!Dirty)
+		{
+			return;
+		}
+
+		Dirty = false;
+
+		if (FilePath.empty() || UserId.empty())
+		{
+			return;
+		}
+
+		SavePath = FilePath;
+		Json	 = Serialise();
+	}
+
+	if (!WriteFileAtomic(SavePath, Json.c_str(), Json.length()))
+	{
+		CSP_LOG_ERROR_FORMAT("Unable to write settings cache file %s", SavePath.c_str());
+	}
+}
+
+std::string SettingsCache::Serialise() const
+{
+	rapidjson::Document Document(rapidjson::kObjectType);
+	auto& Allocator = Document.GetAllocator();
+
+	rapidjson::Value Items(rapidjson::kArrayType);
+
+	for (const auto& [Key, Cached] : Entries)
+	{
+		// Only values the settings service has confirmed are kept
+		if (!Cached.IsKnown || Cached.Version != Cached.WrittenVersion)
+		{
+			continue;
+		}
+
+		const int64_t Fetched = std::chrono::duration_cast<std::chrono::seconds>(Cached.FetchedAt.time_since_epoch()).count();
+
+		rapidjson::Value Item(rapidjson::kObjectType);
+		Item.AddMember("context", rapidjson::Value(Key.first.c_str(), Allocator), Allocator);
+		Item.AddMember("key", rapidjson::Value(Key.second.c_str(), Allocator), Allocator);
+		Item.AddMember("value",
+					   rapidjson::Value(Cached.Value.c_str(), static_cast<rapidjson::SizeType>(Cached.Value.length()), Allocator),
+					   Allocator);
+		Item.AddMember("fetched", rapidjson::Value(Fetched), Allocator);
+
+		Items.PushBack(Item, Allocator);
+	}
+
+	Document.AddMember("version", kFileVersion, Allocator);
+	Document.AddMember("user", rapidjson::Value(UserId.c_str(), Allocator), Allocator);
+	Document.AddMember("entries", Items, Allocator);
+
+	rapidjson::StringBuffer Buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> Writer(Buffer);
+	Document.Accept(Writer);
+
+	return std::string(Buffer.GetString(), Buffer.GetSize());
+}
+
+} // namespace csp::systems
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace csp::systems
+{
+
+/// @brief Cache of the current user's settings that also batches writes to them.
+/// Each value is read from the settings service once and then served from memory until it is older than the maximum age. Changes are
+/// applied to the cached value straight away and written back behind the caller. Only one write per context is in flight at a time:
+/// changes made while it is in flight are collected and sent together in a single write once it completes. Changes that depend on the
+/// current value, such as adding to a list, are applied one after another to the cached value, so concurrent changes can't overwrite
+/// each other.
+/// Every local change bumps the value's version stamp, so a read or write response that was in flight during a newer change never
+/// replaces the newer value.
+/// The cache can also be kept in a file, so that settings read in one session can be read without a round trip in the next. It also keeps
+/// the URIs of users' avatar portraits. The file is written shortly after the cache changes, rather than on every response, and when
+/// the cache is destroyed. All methods are thread-safe, and callbacks are never called with the lock held.
+class SettingsCache
+{
+public:
+	using Clock = std::chrono::system_clock;
+
+	using ValueCallback = std::function<void(bool Succeeded, uint16_t HttpResultCode, const std::string& Value)>;
+	using WriteCallback = std::function<void(bool Succeeded, uint16_t HttpResultCode)>;
+
+	/// @brief Changes a value in place. Returns false if the value doesn't need to change, in which case nothing is written.
+	/// Called with the lock held, so it must not call back into the cache.
+	using Mutation = std::function<bool(std::string& Value)>;
+
+	/// @brief Where settings are read from and written to.
+	class IStore
+	{
+	public:
+		virtual ~IStore() = default;
+
+		virtual void Get(const std::string& Context, const std::string& Key, ValueCallback Callback) = 0;
+
+		/// @brief Writes several values in the same context at once.
+		virtual void Put(const std::string& Context, const std::map<std::string, std::string>& Values, WriteCallback Callback) = 0;
+	};
+
+	SettingsCache(IStore* InStore, Clock::duration InMaxAge);
+	SettingsCache(const SettingsCache&) = delete;
+	~SettingsCache();
+
+	/// @brief Sets the user whose settings are cached. Changing user discards everything cached for the previous one.
+	void SetUser(const std::string& UserId);
+
+	/// @brief Keeps the cached settings in a file, loading any that were cached there for the current user.
+	/// Only values that have been confirmed by the settings service are kept in the file.
+	/// @return False if the file exists but couldn't be read.
+	bool EnablePersistence(const std::string& InFilePath);
+	void DisablePersistence();
+
+	/// @brief Discards everything, failing any reads and changes that are waiting. Writes already in flight still call back.
+	void Clear();
+
+	/// @brief Marks every cached value and portrait URI as out of date, so they are read again next time. Changes that haven't been
+	/// written yet are kept.
+	void Invalidate();
+
+	void Get(const std::string& Context, const std::string& Key, ValueCallback Callback);
+	void Set(const std::string& Context, const std::string& Key, const std::string& Value, WriteCallback Callback);
+
+	/// @brief Applies Change to the current value, reading it first if it isn't cached, and writes the result back.
+	void Modify(const std::string& Context, const std::string& Key, Mutation Change, WriteCallback Callback);
+
+	bool GetPortraitUri(const std::string& UserId, std::string& OutUri) const;
+	void SetPortraitUri(const std::string& UserId, const std::string& Uri, const std::string& AssetId, const std::string& AssetCollectionId);
+	void RemovePortraitUri(const std::string& UserId);
+
+	/// @brief Discards any portrait URI for the given asset or asset collection.
+	void OnAssetChanged(const std::string& AssetId, const std::string& AssetCollectionId);
+
+	size_t GetNumEntries() const;
+
+private:
+	using Waiter   = std::function<void(bool Succeeded, uint16_t HttpResultCode)>;
+	using EntryKey = std::pair<std::string, std::string>;
+
+	struct Entry
+	{
+		std::string Value;
+		// Goes up with every local change. WrittenVersion is the latest change the settings service has confirmed.
+		uint64_t Version		= 0;
+		uint64_t WrittenVersion = 0;
+		Clock::time_point FetchedAt;
+		bool IsKnown	= false;
+		bool IsFetching = false;
+		// Reads and changes waiting for the value to be fetched
+		std::vector<Waiter> Waiting;
+		// Callbacks for changes that haven't been sent yet
+		std::vector<WriteCallback> PendingCallbacks;
+	};
+
+	struct Portrait
+	{
+		std::string Uri;
+		std::string AssetId;
+		std::string AssetCollectionId;
+		Clock::time_point FetchedAt;
+	};
+
+	// Shared with the scheduled save, which may still be running when the cache is destroyed. The destructor clears Cache while holding
+	// SaveMutex, so a save either finishes before the cache goes away or sees that it has gone.
+	struct SaveTarget
+	{
+		// Held from taking a snapshot until it is written, so that an older snapshot never replaces a newer one in the file
+		std::mutex SaveMutex;
+		SettingsCache* Cache = nullptr;
+	};
+
+	void Fetch(const std::string& Context, const std::string& Key);
+	void ApplyChange(const std::string& Context, const std::string& Key, Mutation Change, WriteCallback Callback);
+	void Flush(const std::string& Context);
+
+	// Writes the file from a snapshot taken under the lock, if anything has changed since the last one. Expects Target->SaveMutex to be
+	// held, and Mutex not to be.
+	void Save();
+
+	// These expect Mutex to be held
+	bool IsFresh(const Entry& CachedEntry) const;
+	bool Load();
+	void MarkDirty();
+	std::string Serialise() const;
+
+	IStore* Store;
+	Clock::duration MaxAge;
+	std::string UserId;
+	std::string FilePath;
+
+	std::map<EntryKey, Entry> Entries;
+	std::map<std::string, Portrait> Portraits;
+	// Contexts with a write in flight
+	std::set<std::string> WritingContexts;
+	// Goes up whenever the cache is cleared, so that responses to requests made before then are ignored
+	uint64_t Generation;
+
+	bool Dirty;
+	bool SaveScheduled;
+	std::shared_ptr<SaveTarget> Target;
+
+	mutable std::mutex Mutex;
+};
+
+} // namespace csp::systems
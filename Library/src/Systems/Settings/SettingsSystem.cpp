@@ -22,20 +22,27 @@
 #include "CSP/Systems/Assets/AssetSystem.h"
 #include "CSP/Systems/Users/UserSystem.h"
 #include "CallHelpers.h"
+#include "Events/EventListener.h"
+#include "Events/EventSystem.h"
 #include "Services/ApiBase/ApiBase.h"
 #include "Services/UserService/Api.h"
 #include "Services/UserService/Dto.h"
 #include "Systems/ResultHelpers.h"
+#include "Systems/Settings/SettingsCache.h"
 #include "Systems/Spaces/SpaceSystemHelpers.h"
 
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <rapidjson/rapidjson.h>
 #include <sstream>
+#include <string>
 
 
 constexpr int MAX_RECENT_SPACES								= 50;
 constexpr const char* AVATAR_PORTRAIT_ASSET_NAME			= "AVATAR_PORTRAIT_ASSET_";
 constexpr const char* AVATAR_PORTRAIT_ASSET_COLLECTION_NAME = "AVATAR_PORTRAIT_ASSET_COLLECTION_";
+constexpr std::chrono::minutes SETTINGS_CACHE_MAX_AGE		= std::chrono::minutes(15);
 
 
 using namespace csp::common;
@@ -43,72 +50,109 @@ using namespace csp::common;
 namespace chs = csp::services::generated::userservice;
 
 
-namespace csp::systems
+namespace
 {
 
-SettingsSystem::SettingsSystem() : SystemBase(), SettingsAPI(nullptr)
+// Cached settings belong to whoever is logged in now
+csp::systems::SettingsCache& GetUserCache(csp::systems::SettingsCache* Cache)
 {
-}
+	const auto* UserSystem = csp::systems::SystemsManager::Get().GetUserSystem();
+	Cache->SetUser(UserSystem->GetLoginState().UserId.c_str());
 
-SettingsSystem::SettingsSystem(web::WebClient* InWebClient) : SystemBase(InWebClient)
-{
-	SettingsAPI = CSP_NEW chs::SettingsApi(InWebClient);
+	return *Cache;
 }
 
-SettingsSystem::~SettingsSystem()
+csp::systems::SettingsCache::WriteCallback ToWriteCallback(csp::systems::NullResultCallback Callback)
 {
-	CSP_DELETE(SettingsAPI);
+	return [Callback](bool Succeeded, uint16_t HttpResultCode)
+	{
+		csp::systems::NullResult InternalResult(Succeeded ? csp::systems::EResultCode::Success : csp::systems::EResultCode::Failed, HttpResultCode);
+		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+	};
 }
 
-void SettingsSystem::SetSettingValue(const String& InContext, const String& InKey, const String& InValue, NullResultCallback Callback) const
+// The current user's portrait URI changes once it has been replaced or removed
+csp::systems::NullResultCallback ForgetOwnPortraitOnCompletion(csp::systems::SettingsCache* Cache, csp::systems::NullResultCallback Callback)
 {
-	auto& SystemsManager   = SystemsManager::Get();
-	const auto* UserSystem = SystemsManager.GetUserSystem();
+	const auto* UserSystem	 = csp::systems::SystemsManager::Get().GetUserSystem();
+	const std::string UserId = UserSystem->GetLoginState().UserId.c_str();
 
-	const auto& UserId = UserSystem->GetLoginState().UserId;
-
-	auto InSettings = std::make_shared<chs::SettingsDto>();
-	std::map<String, String> NewSettings;
-	NewSettings.clear();
-	NewSettings.insert(std::make_pair(InKey, InValue));
-	InSettings->SetSettings(NewSettings);
-
-	SettingsResultCallback InternalCallback = [InKey, Callback](const SettingsCollectionResult& Result)
+	return [Cache, UserId, Callback](const csp::systems::NullResult& Result)
 	{
-		if (Result.GetResultCode() == EResultCode::InProgress)
+		if (Result.GetResultCode() != csp::systems::EResultCode::InProgress)
 		{
-			return;
+			Cache->RemovePortraitUri(UserId);
 		}
 
-		NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+		INVOKE_IF_NOT_NULL(Callback, Result);
 	};
+}
 
-	services::ResponseHandlerPtr SettingsResponseHandler
-		= SettingsAPI->CreateHandler<SettingsResultCallback, SettingsCollectionResult, void, chs::SettingsDto>(InternalCallback,
-																											   nullptr,
-																											   web::EResponseCodes::ResponseOK);
+List<String> SplitSpaceIds(const std::string& Value)
+{
+	if (Value.empty())
+	{
+		return {};
+	}
 
-	static_cast<chs::SettingsApi*>(SettingsAPI)->apiV1UsersUserIdSettingsContextPut(UserId, InContext, InSettings, SettingsResponseHandler);
+	return String(Value.c_str()).Split(',');
 }
 
-void SettingsSystem::GetSettingValue(const String& InContext, const String& InKey, StringResultCallback Callback) const
+} // namespace
+
+
+namespace csp::systems
+{
+
+// Reads and writes settings through the settings service
+class SettingsServiceStore : public SettingsCache::IStore
+{
+public:
+	SettingsServiceStore(csp::services::ApiBase* InSettingsAPI);
+
+	void Get(const std::string& Context, const std::string& Key, SettingsCache::ValueCallback Callback) override;
+	void Put(const std::string& Context, const std::map<std::string, std::string>& Values, SettingsCache::WriteCallback Callback) override;
+
+private:
+	csp::services::ApiBase* SettingsAPI;
+};
+
+
+class SettingsSystemEventHandler : public csp::events::EventListener
+{
+public:
+	SettingsSystemEventHandler(SettingsSystem* InSettingsSystem);
+
+	void OnEvent(const csp::events::Event& InEvent) override;
+
+private:
+	SettingsSystem* SettingsSystemPtr;
+};
+
+
+
+SettingsServiceStore::SettingsServiceStore(csp::services::ApiBase* InSettingsAPI) : SettingsAPI(InSettingsAPI)
+{
+}
+
+void SettingsServiceStore::Get(const std::string& Context, const std::string& Key, SettingsCache::ValueCallback Callback)
 {
 	auto& SystemsManager	  = SystemsManager::Get();
 	const auto* UserSystem	  = SystemsManager.GetUserSystem();
+	const String InKey		  = Key.c_str();
 	std::vector<String> MyKey = {InKey};
 
 	const auto& UserId = UserSystem->GetLoginState().UserId;
 
 	SettingsResultCallback InternalCallback = [InKey, Callback](const SettingsCollectionResult& Result)
 	{
-		StringResult StringResult(Result.GetResultCode(), Result.GetHttpResultCode());
-
 		if (Result.GetResultCode() == EResultCode::InProgress)
 		{
 			return;
 		}
 
+		std::string Value;
+
 		if (Result.GetResultCode() == EResultCode::Success)
 		{
 			// Only attempt to read settings if result is valid
@@ -117,20 +161,46 @@ void SettingsSystem::GetSettingValue(const String& InContext, const String& InKe
 
 			if (Settings.HasKey(InKey))
 			{
-				StringResult.SetValue(Settings[InKey]);
-			}
-			else
-			{
-				StringResult.SetValue("");
+				Value = Settings[InKey].c_str();
 			}
 		}
-		else
+
+		Callback(Result.GetResultCode() == EResultCode::Success, Result.GetHttpResultCode(), Value);
+	};
+
+	services::ResponseHandlerPtr SettingsResponseHandler
+		= SettingsAPI->CreateHandler<SettingsResultCallback, SettingsCollectionResult, void, chs::SettingsDto>(InternalCallback,
+																											   nullptr,
+																											   web::EResponseCodes::ResponseOK);
+
+	static_cast<chs::SettingsApi*>(SettingsAPI)->apiV1UsersUserIdSettingsContextGet(UserId, Context.c_str(), MyKey, SettingsResponseHandler);
+}
+
+void SettingsServiceStore::Put(const std::string& Context, const std::map<std::string, std::string>& Values, SettingsCache::WriteCallback Callback)
+{
+	auto& SystemsManager   = SystemsManager::Get();
+	const auto* UserSystem = SystemsManager.GetUserSystem();
+
+	const auto& UserId = UserSystem->GetLoginState().UserId;
+
+	auto InSettings = std::make_shared<chs::SettingsDto>();
+	std::map<String, String> NewSettings;
+
+	for (const auto& [Key, Value] : Values)
+	{
+		NewSettings.insert(std::make_pair(String(Key.c_str()), String(Value.c_str())));
+	}
+
+	InSettings->SetSettings(NewSettings);
+
+	SettingsResultCallback InternalCallback = [Callback](const SettingsCollectionResult& Result)
+	{
+		if (Result.GetResultCode() == EResultCode::InProgress)
 		{
-			// Handle failure state
-			StringResult.SetValue("");
+			return;
 		}
 
-		INVOKE_IF_NOT_NULL(Callback, StringResult);
+		Callback(Result.GetResultCode() == EResultCode::Success, Result.GetHttpResultCode());
 	};
 
 	services::ResponseHandlerPtr SettingsResponseHandler
@@ -138,7 +208,72 @@ void SettingsSystem::GetSettingValue(const String& InContext, const String& InKe
 																											   nullptr,
 																											   web::EResponseCodes::ResponseOK);
 
-	static_cast<chs::SettingsApi*>(SettingsAPI)->apiV1UsersUserIdSettingsContextGet(UserId, InContext, MyKey, SettingsResponseHandler);
+	static_cast<chs::SettingsApi*>(SettingsAPI)->apiV1UsersUserIdSettingsContextPut(UserId, Context.c_str(), InSettings, SettingsResponseHandler);
+}
+
+
+SettingsSystemEventHandler::SettingsSystemEventHandler(SettingsSystem* InSettingsSystem) : SettingsSystemPtr(InSettingsSystem)
+{
+}
+
+void SettingsSystemEventHandler::OnEvent(const csp::events::Event& InEvent)
+{
+	if (InEvent.GetId() == csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID)
+	{
+		SettingsSystemPtr->Cache->OnAssetChanged(InEvent.GetString("AssetId"), InEvent.GetString("AssetCollectionId"));
+	}
+	else if (InEvent.GetId() == csp::events::USERSERVICE_LOGOUT_EVENT_ID)
+	{
+		SettingsSystemPtr->Cache->Clear();
+	}
+}
+
+
+SettingsSystem::SettingsSystem() : SystemBase(), SettingsAPI(nullptr), Store(nullptr), Cache(nullptr), EventHandler(nullptr)
+{
+}
+
+SettingsSystem::SettingsSystem(web::WebClient* InWebClient) : SystemBase(InWebClient)
+{
+	SettingsAPI	 = CSP_NEW chs::SettingsApi(InWebClient);
+	Store		 = CSP_NEW SettingsServiceStore(SettingsAPI);
+	Cache		 = CSP_NEW SettingsCache(Store, SETTINGS_CACHE_MAX_AGE);
+	EventHandler = CSP_NEW SettingsSystemEventHandler(this);
+
+	csp::events::EventSystem::Get().RegisterListener(csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID, EventHandler);
+	csp::events::EventSystem::Get().RegisterListener(csp::events::USERSERVICE_LOGOUT_EVENT_ID, EventHandler);
+}
+
+SettingsSystem::~SettingsSystem()
+{
+	if (EventHandler != nullptr)
+	{
+		csp::events::EventSystem::Get().UnRegisterListener(csp::events::MULTIPLAYERSYSTEM_ASSET_DETAIL_BLOB_CHANGED_EVENT_ID, EventHandler);
+		csp::events::EventSystem::Get().UnRegisterListener(csp::events::USERSERVICE_LOGOUT_EVENT_ID, EventHandler);
+	}
+
+	CSP_DELETE(EventHandler);
+	CSP_DELETE(Cache);
+	CSP_DELETE(Store);
+	CSP_DELETE(SettingsAPI);
+}
+
+void SettingsSystem::SetSettingValue(const String& InContext, const String& InKey, const String& InValue, NullResultCallback Callback) const
+{
+	GetUserCache(Cache).Set(InContext.c_str(), InKey.c_str(), InValue.c_str(), ToWriteCallback(Callback));
+}
+
+void SettingsSystem::GetSettingValue(const String& InContext, const String& InKey, StringResultCallback Callback) const
+{
+	SettingsCache::ValueCallback InternalCallback = [Callback](bool Succeeded, uint16_t HttpResultCode, const std::string& Value)
+	{
+		StringResult InternalResult(Succeeded ? EResultCode::Success : EResultCode::Failed, HttpResultCode);
+		InternalResult.SetValue(Value.c_str());
+
+		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+	};
+
+	GetUserCache(Cache).Get(InContext.c_str(), InKey.c_str(), InternalCallback);
 }
 
 void SettingsSystem::SetNDAStatus(bool InValue, NullResultCallback Callback)
@@ -182,19 +317,16 @@ void SettingsSystem::GetNewsletterStatus(BooleanResultCallback Callback)
 
 void SettingsSystem::AddRecentlyVisitedSpace(const String InSpaceID, NullResultCallback Callback)
 {
-	StringArrayResultCallback GetRecentSpacesCallback = [=](StringArrayResult Result)
+	// Applied to the cached list, so that concurrent calls can't overwrite each other's changes
+	SettingsCache::Mutation AddSpace = [InSpaceID](std::string& Value)
 	{
-		if (Result.GetResultCode() == EResultCode::Failed)
-		{
-			NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-			INVOKE_IF_NOT_NULL(Callback, InternalResult);
+		auto RecentSpaces = SplitSpaceIds(Value);
 
-			return;
+		if (RecentSpaces.Size() > 0 && RecentSpaces[0] == InSpaceID)
+		{
+			return false;
 		}
 
-		const auto& RecentSpacesArray = Result.GetValue();
-
-		auto RecentSpaces = RecentSpacesArray.ToList();
 		RecentSpaces.Insert(0, InSpaceID);
 
 		// Remove duplicate entry
@@ -215,12 +347,12 @@ void SettingsSystem::AddRecentlyVisitedSpace(const String InSpaceID, NullResultC
 			RecentSpaces.Remove(MAX_RECENT_SPACES);
 		}
 
-		auto RecentSpacesString = String::Join(RecentSpaces, ',');
+		Value = String::Join(RecentSpaces, ',').c_str();
 
-		SetSettingValue("UserSettings", "RecentSpaces", RecentSpacesString, Callback);
+		return true;
 	};
 
-	GetRecentlyVisitedSpaces(GetRecentSpacesCallback);
+	GetUserCache(Cache).Modify("UserSettings", "RecentSpaces", AddSpace, ToWriteCallback(Callback));
 }
 
 void SettingsSystem::GetRecentlyVisitedSpaces(StringArrayResultCallback Callback)
@@ -258,84 +390,44 @@ void SettingsSystem::ClearRecentlyVisitedSpaces(NullResultCallback Callback)
 
 void SettingsSystem::AddBlockedSpace(const String InSpaceID, NullResultCallback Callback)
 {
-	StringArrayResultCallback GetBlockedSpacesCallback = [=](StringArrayResult Result)
+	SettingsCache::Mutation AddSpace = [InSpaceID](std::string& Value)
 	{
-		if (Result.GetResultCode() == EResultCode::Failed)
-		{
-			NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-			INVOKE_IF_NOT_NULL(Callback, InternalResult);
-
-			return;
-		}
-
-		const auto& BlockedSpacesArray = Result.GetValue();
+		auto BlockedSpaces = SplitSpaceIds(Value);
 
 		// Ignore if space already blocked
-		for (int i = 0; i < BlockedSpacesArray.Size(); ++i)
+		if (BlockedSpaces.Contains(InSpaceID))
 		{
-			if (BlockedSpacesArray[i] == InSpaceID)
-			{
-				NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-				INVOKE_IF_NOT_NULL(Callback, InternalResult);
-
-				return;
-			}
+			return false;
 		}
 
-		auto BlockedSpaces = BlockedSpacesArray.ToList();
 		BlockedSpaces.Insert(0, InSpaceID);
+		Value = String::Join(BlockedSpaces, ',').c_str();
 
-		auto BlockedSpacesString = String::Join(BlockedSpaces, ',');
-
-		SetSettingValue("UserSettings", "BlockedSpaces", BlockedSpacesString, Callback);
+		return true;
 	};
 
-	GetBlockedSpaces(GetBlockedSpacesCallback);
+	GetUserCache(Cache).Modify("UserSettings", "BlockedSpaces", AddSpace, ToWriteCallback(Callback));
 }
 
 void SettingsSystem::RemoveBlockedSpace(const String InSpaceID, NullResultCallback Callback)
 {
-	StringArrayResultCallback GetBlockedSpacesCallback = [=](StringArrayResult Result)
+	SettingsCache::Mutation RemoveSpace = [InSpaceID](std::string& Value)
 	{
-		if (Result.GetResultCode() == EResultCode::Failed)
-		{
-			NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-			INVOKE_IF_NOT_NULL(Callback, InternalResult);
-
-			return;
-		}
-
-		const auto& BlockedSpacesArray = Result.GetValue();
-		auto FoundSpace				   = false;
+		auto BlockedSpaces = SplitSpaceIds(Value);
 
 		// Ignore if space not blocked
-		for (int i = 0; i < BlockedSpacesArray.Size(); ++i)
+		if (!BlockedSpaces.Contains(InSpaceID))
 		{
-			if (BlockedSpacesArray[i] == InSpaceID)
-			{
-				FoundSpace = true;
-
-				break;
-			}
+			return false;
 		}
 
-		if (!FoundSpace)
-		{
-			NullResult InternalResult(Result.GetResultCode(), Result.GetHttpResultCode());
-			INVOKE_IF_NOT_NULL(Callback, InternalResult);
-
-			return;
-		}
-
-		auto BlockedSpaces = BlockedSpacesArray.ToList();
 		BlockedSpaces.RemoveItem(InSpaceID);
+		Value = String::Join(BlockedSpaces, ',').c_str();
 
-		auto BlockedSpacesString = String::Join(BlockedSpaces, ',');
-
-		SetSettingValue("UserSettings", "BlockedSpaces", BlockedSpacesString, Callback);
+		return true;
 	};
 
-	GetBlockedSpaces(GetBlockedSpacesCallback);
+	GetUserCache(Cache).Modify("UserSettings", "BlockedSpaces", RemoveSpace, ToWriteCallback(Callback));
 }
 
 void SettingsSystem::GetBlockedSpaces(StringArrayResultCallback Callback)
@@ -373,6 +465,8 @@ void SettingsSystem::ClearBlockedSpaces(NullResultCallback Callback)
 
 void SettingsSystem::UpdateAvatarPortrait(const FileAssetDataSource& NewAvatarPortrait, NullResultCallback Callback)
 {
+	Callback = ForgetOwnPortraitOnCompletion(Cache, Callback);
+
 	AssetCollectionsResultCallback AvatarPortraitAssetCollCallback = [=](const AssetCollectionsResult& AssetCollResult)
 	{
 		if (AssetCollResult.GetResultCode() == EResultCode::Success)
@@ -436,6 +530,16 @@ void SettingsSystem::UpdateAvatarPortrait(const FileAssetDataSource& NewAvatarPo
 
 void SettingsSystem::GetAvatarPortrait(const csp::common::String InUserID, UriResultCallback Callback)
 {
+	std::string CachedUri;
+
+	if (Cache->GetPortraitUri(InUserID.c_str(), CachedUri))
+	{
+		const UriResult InternalResult(CachedUri.c_str());
+		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+
+		return;
+	}
+
 	AssetCollectionsResultCallback AvatarPortraitAssetCollCallback = [=](const AssetCollectionsResult& AssetCollResult)
 	{
 		if (AssetCollResult.GetResultCode() == EResultCode::Success)
@@ -460,7 +564,13 @@ void SettingsSystem::GetAvatarPortrait(const csp::common::String InUserID, UriRe
 
 						if (Assets.Size() > 0)
 						{
-							const UriResult InternalResult(AssetsResult.GetAssets()[0].Uri);
+							const auto& PortraitAsset = Assets[0];
+							Cache->SetPortraitUri(InUserID.c_str(),
+												  PortraitAsset.Uri.c_str(),
+												  PortraitAsset.Id.c_str(),
+												  PortraitAsset.AssetCollectionId.c_str());
+
+							const UriResult InternalResult(PortraitAsset.Uri);
 							INVOKE_IF_NOT_NULL(Callback, InternalResult);
 						}
 						else
@@ -495,6 +605,8 @@ void SettingsSystem::GetAvatarPortrait(const csp::common::String InUserID, UriRe
 
 void SettingsSystem::UpdateAvatarPortraitWithBuffer(const BufferAssetDataSource& NewAvatarPortrait, NullResultCallback Callback)
 {
+	Callback = ForgetOwnPortraitOnCompletion(Cache, Callback);
+
 	AssetCollectionsResultCallback ThumbnailAssetCollCallback = [=](const AssetCollectionsResult& AssetCollResult)
 	{
 		if (AssetCollResult.GetResultCode() == EResultCode::Success)
@@ -774,6 +886,8 @@ void SettingsSystem::GetAvatarPortraitAsset(const AssetCollection& AvatarPortrai
 
 void SettingsSystem::RemoveAvatarPortrait(NullResultCallback Callback)
 {
+	Callback = ForgetOwnPortraitOnCompletion(Cache, Callback);
+
 	const auto AssetSystem = SystemsManager::Get().GetAssetSystem();
 
 	AssetCollectionsResultCallback PortraitAvatarAssetCollCallback = [=](const AssetCollectionsResult& AssetCollResult)
@@ -983,4 +1097,19 @@ void SettingsSystem::GetAvatarInfo(AvatarInfoResultCallback Callback)
 	GetSettingValue("UserSettings", "AvatarInfo", GetSettingCallback);
 }
 
+bool SettingsSystem::EnablePersistentSettingsCache(const String& FilePath)
+{
+	return GetUserCache(Cache).EnablePersistence(FilePath.c_str());
+}
+
+void SettingsSystem::DisablePersistentSettingsCache()
+{
+	Cache->DisablePersistence();
+}
+
+void SettingsSystem::ClearSettingsCache()
+{
+	Cache->Invalidate();
+}
+
 } // namespace csp::systems
@@ -15,6 +15,7 @@
  */
 #include "CSP/Systems/SystemsManager.h"
 
+#include "CSP/CSPFoundation.h"
 #include "CSP/Multiplayer/MultiplayerConnection.h"
 #include "CSP/Systems/Analytics/AnalyticsSystem.h"
 #include "CSP/Systems/Assets/AssetSystem.h"
@@ -195,7 +196,7 @@ void SystemsManager::CreateSystems()
 #ifdef CSP_WASM
 	WebClient = CSP_NEW csp::web::EmscriptenWebClient(80, csp::web::ETransferProtocol::HTTPS);
 #else
-	WebClient = CSP_NEW csp::web::POCOWebClient(80, csp::web::ETransferProtocol::HTTPS);
+	WebClient = CSP_NEW csp::web::POCOWebClient(80, csp::web::ETransferProtocol::HTTPS, true, csp::CSPFoundation::GetMaxConcurrentWebRequests());
 #endif
 	ScriptSystem = CSP_NEW csp::systems::ScriptSystem();
 
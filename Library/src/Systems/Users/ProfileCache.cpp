@@ -0,0 +1,396 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Systems/Users/ProfileCache.h"
+
+#include <algorithm>
+
+
+namespace
+{
+
+constexpr uint16_t kResponseOK = 200;
+
+} // namespace
+
+
+namespace csp::systems
+{
+
+ProfileCache::ProfileCache(IStore* InStore, size_t InCapacity, Clock::duration InMaxAge, Clock::duration InBatchWindow, size_t InMaxBatchSize)
+	: Store(InStore)
+	, Capacity(InCapacity)
+	, MaxAge(InMaxAge)
+	, BatchWindow(InBatchWindow)
+	, MaxBatchSize(std::max<size_t>(InMaxBatchSize, 1))
+	, IsFlushScheduled(false)
+	, FlushTask(0)
+	, ScheduledFlushTarget(std::make_shared<FlushTarget>())
+	, Generation(0)
+{
+	ScheduledFlushTarget->Cache = this;
+}
+
+ProfileCache::~ProfileCache()
+{
+	std::scoped_lock FlushLock(ScheduledFlushTarget->FlushMutex);
+	ScheduledFlushTarget->Cache = nullptr;
+
+	std::scoped_lock Lock(Mutex);
+
+	if (IsFlushScheduled)
+	{
+		GetScheduler()->CancelTask(FlushTask);
+	}
+}
+
+void ProfileCache::GetProfiles(const std::vector<std::string>& UserIds, ProfilesCallback Callback)
+{
+	auto NewRequest		 = std::make_shared<Request>();
+	NewRequest->Callback = std::move(Callback);
+
+	bool IsComplete		= false;
+	bool ShouldFlush	= false;
+	bool ShouldSchedule = false;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		const auto Now = Clock::now();
+		std::unordered_set<std::string> Seen;
+
+		for (const auto& UserId : UserIds)
+		{
+			// Each user is only returned once, however many times they were asked for
+			if (!Seen.insert(UserId).second)
+			{
+				continue;
+			}
+
+			NewRequest->UserIds.push_back(UserId);
+
+			const auto It = Entries.find(UserId);
+
+			if (It != Entries.end() && Now - It->second.FetchedAt < MaxAge)
+			{
+				NewRequest->Found[UserId] = It->second.Profile;
+				Touch(It->second);
+
+				continue;
+			}
+
+			++NewRequest->NumWaiting;
+			Waiting[UserId].push_back(NewRequest);
+
+			if (Requested.insert(UserId).second)
+			{
+				Queued.push_back(UserId);
+			}
+		}
+
+		// Once the lock is released, the request belongs to whichever response completes it
+		IsComplete = (NewRequest->NumWaiting == 0);
+
+		if (Queued.size() >= MaxBatchSize)
+		{
+			ShouldFlush = true;
+		}
+		else if (!Queued.empty() && !IsFlushScheduled)
+		{
+			IsFlushScheduled = true;
+			ShouldSchedule	 = true;
+		}
+
+		// Scheduled with the lock held so that FlushTask is set before anything can try to cancel it
+		if (ShouldSchedule)
+		{
+			FlushTask = GetScheduler()->ScheduleAfter(BatchWindow,
+													  [Target = ScheduledFlushTarget]()
+													  {
+														  std::scoped_lock FlushLock(Target->FlushMutex);
+
+														  if (Target->Cache != nullptr)
+														  {
+															  Target->Cache->Flush();
+														  }
+													  });
+		}
+	}
+
+	if (IsComplete)
+	{
+		NewRequest->HttpResultCode = kResponseOK;
+		Complete(*NewRequest);
+
+		return;
+	}
+
+	if (ShouldFlush)
+	{
+		Flush();
+	}
+}
+
+void ProfileCache::AddProfile(const BasicProfile& Profile)
+{
+	std::scoped_lock Lock(Mutex);
+
+	Insert(Profile, Clock::now());
+}
+
+void ProfileCache::Invalidate(const std::string& UserId)
+{
+	std::scoped_lock Lock(Mutex);
+
+	const auto It = Entries.find(UserId);
+
+	if (It != Entries.end())
+	{
+		Lru.erase(It->second.LruPosition);
+		Entries.erase(It);
+	}
+
+	if (Requested.count(UserId) > 0)
+	{
+		Stale.insert(UserId);
+	}
+}
+
+void ProfileCache::Clear()
+{
+	std::vector<std::shared_ptr<Request>> Failed;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		for (auto& Item : Waiting)
+		{
+			for (auto& WaitingRequest : Item.second)
+			{
+				// Requests waiting on several users are only failed once
+				if (!WaitingRequest->Failed)
+				{
+					WaitingRequest->Failed		   = true;
+					WaitingRequest->HttpResultCode = 0;
+					Failed.push_back(WaitingRequest);
+				}
+			}
+		}
+
+		Entries.clear();
+		Lru.clear();
+		Queued.clear();
+		Requested.clear();
+		Stale.clear();
+		Waiting.clear();
+		++Generation;
+	}
+
+	for (const auto& FailedRequest : Failed)
+	{
+		Complete(*FailedRequest);
+	}
+}
+
+void ProfileCache::Flush()
+{
+	std::vector<std::vector<std::string>> Batches;
+	uint64_t FlushGeneration;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Does nothing if this is the scheduled flush
+		if (IsFlushScheduled)
+		{
+			GetScheduler()->CancelTask(FlushTask);
+			IsFlushScheduled = false;
+		}
+
+		for (size_t Start = 0; Start < Queued.size(); Start += MaxBatchSize)
+		{
+			const size_t End = std::min(Start + MaxBatchSize, Queued.size());
+			Batches.emplace_back(Queued.begin() + Start, Queued.begin() + End);
+		}
+
+		Queued.clear();
+		FlushGeneration = Generation;
+	}
+
+	for (const auto& Batch : Batches)
+	{
+		Store->GetBasicProfiles(Batch,
+								[this, Batch, FlushGeneration](bool Succeeded, uint16_t HttpResultCode, const std::vector<BasicProfile>& Profiles)
+								{
+									OnFetched(Batch, FlushGeneration, Succeeded, HttpResultCode, Profiles);
+								});
+	}
+}
+
+size_t ProfileCache::GetNumProfiles() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return Entries.size();
+}
+
+void ProfileCache::OnFetched(const std::vector<std::string>& UserIds,
+							 uint64_t FetchGeneration,
+							 bool Succeeded,
+							 uint16_t HttpResultCode,
+							 const std::vector<BasicProfile>& Profiles)
+{
+	std::vector<std::shared_ptr<Request>> Completed;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		// Anything waiting on a request from before the cache was cleared has already been failed
+		if (FetchGeneration != Generation)
+		{
+			return;
+		}
+
+		const auto Now = Clock::now();
+
+		if (Succeeded)
+		{
+			for (const auto& Profile : Profiles)
+			{
+				const std::string UserId = Profile.UserId.c_str();
+
+				if (Requested.count(UserId) == 0)
+				{
+					continue;
+				}
+
+				if (Stale.count(UserId) == 0)
+				{
+					Insert(Profile, Now);
+				}
+
+				const auto It = Waiting.find(UserId);
+
+				if (It == Waiting.end())
+				{
+					continue;
+				}
+
+				for (auto& WaitingRequest : It->second)
+				{
+					WaitingRequest->Found[UserId] = Profile;
+				}
+			}
+		}
+
+		for (const auto& UserId : UserIds)
+		{
+			Requested.erase(UserId);
+			Stale.erase(UserId);
+
+			const auto It = Waiting.find(UserId);
+
+			if (It == Waiting.end())
+			{
+				continue;
+			}
+
+			for (auto& WaitingRequest : It->second)
+			{
+				if (!Succeeded && !WaitingRequest->Failed)
+				{
+					WaitingRequest->Failed		   = true;
+					WaitingRequest->HttpResultCode = HttpResultCode;
+				}
+
+				if (--WaitingRequest->NumWaiting == 0)
+				{
+					if (!WaitingRequest->Failed)
+					{
+						WaitingRequest->HttpResultCode = HttpResultCode;
+					}
+
+					Completed.push_back(WaitingRequest);
+				}
+			}
+
+			Waiting.erase(It);
+		}
+	}
+
+	for (const auto& CompletedRequest : Completed)
+	{
+		Complete(*CompletedRequest);
+	}
+}
+
+void ProfileCache::Complete(const Request& Completed)
+{
+	if (!Completed.Callback)
+	{
+		return;
+	}
+
+	std::vector<BasicProfile> Profiles;
+
+	if (!Completed.Failed)
+	{
+		Profiles.reserve(Completed.Found.size());
+
+		for (const auto& UserId : Completed.UserIds)
+		{
+			const auto It = Completed.Found.find(UserId);
+
+			if (It != Completed.Found.end())
+			{
+				Profiles.push_back(It->second);
+			}
+		}
+	}
+
+	Completed.Callback(!Completed.Failed, Completed.HttpResultCode, Profiles);
+}
+
+void ProfileCache::Insert(const BasicProfile& Profile, Clock::time_point Now)
+{
+	const std::string UserId = Profile.UserId.c_str();
+
+	auto It = Entries.find(UserId);
+
+	if (It == Entries.end())
+	{
+		Lru.push_front(UserId);
+		It = Entries.emplace(UserId, Entry {Profile, Now, Lru.begin()}).first;
+	}
+	else
+	{
+		It->second.Profile	 = Profile;
+		It->second.FetchedAt = Now;
+		Touch(It->second);
+	}
+
+	while (Entries.size() > Capacity && !Lru.empty())
+	{
+		Entries.erase(Lru.back());
+		Lru.pop_back();
+	}
+}
+
+void ProfileCache::Touch(Entry& Cached)
+{
+	Lru.splice(Lru.begin(), Lru, Cached.LruPosition);
+}
+
+} // namespace csp::systems
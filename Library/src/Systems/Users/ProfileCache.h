@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "CSP/Systems/Users/Profile.h"
+#include "Common/Scheduler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace csp::systems
+{
+
+/// @brief Cache of users' basic profiles that also merges requests for them.
+/// Profiles are kept until they are older than the maximum age, up to a fixed number of them, after which the least recently used
+/// profile is discarded. Users that aren't cached are queued rather than requested straight away, and everything queued within a short
+/// window is requested together, so that many small requests made at around the same time, such as when a crowd of avatars joins a
+/// space, become a few large ones. A user that has already been requested is never requested again while the request is in flight;
+/// callers wait for the same response instead.
+/// All methods are thread-safe, and callbacks are never called with the lock held.
+class ProfileCache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/// @brief Called with the requested users' profiles, in the order they were asked for. Users without a profile are left out.
+	using ProfilesCallback = std::function<void(bool Succeeded, uint16_t HttpResultCode, const std::vector<BasicProfile>& Profiles)>;
+
+	/// @brief Where profiles are read from.
+	class IStore
+	{
+	public:
+		virtual ~IStore() = default;
+
+		virtual void GetBasicProfiles(const std::vector<std::string>& UserIds, ProfilesCallback Callback) = 0;
+	};
+
+	/// @param InCapacity Most profiles kept at once.
+	/// @param InBatchWindow How long users are queued for before they are requested.
+	/// @param InMaxBatchSize Most users asked for in one request. A full batch is requested straight away.
+	ProfileCache(IStore* InStore, size_t InCapacity, Clock::duration InMaxAge, Clock::duration InBatchWindow, size_t InMaxBatchSize);
+	~ProfileCache();
+	ProfileCache(const ProfileCache&) = delete;
+
+	void GetProfiles(const std::vector<std::string>& UserIds, ProfilesCallback Callback);
+
+	/// @brief Caches a profile read some other way, such as with a full profile.
+	void AddProfile(const BasicProfile& Profile);
+
+	/// @brief Discards a user's profile, so that it is read again next time. A response already in flight isn't cached.
+	void Invalidate(const std::string& UserId);
+
+	/// @brief Discards everything, failing any requests that are waiting.
+	void Clear();
+
+	/// @brief Requests everything that is queued now rather than at the end of the window.
+	void Flush();
+
+	size_t GetNumProfiles() const;
+
+private:
+	struct Entry
+	{
+		BasicProfile Profile;
+		Clock::time_point FetchedAt;
+		std::list<std::string>::iterator LruPosition;
+	};
+
+	// A call to GetProfiles that is waiting for some of its users to be fetched
+	struct Request
+	{
+		std::vector<std::string> UserIds;
+		std::unordered_map<std::string, BasicProfile> Found;
+		size_t NumWaiting = 0;
+		bool Failed		  = false;
+		uint16_t HttpResultCode;
+		ProfilesCallback Callback;
+	};
+
+	// Shared with the scheduled flush, which may already have been handed to a worker when the cache is destroyed, so cancelling it
+	// isn't enough. The destructor clears Cache while holding FlushMutex, so a flush either finishes before the cache goes away or sees
+	// that it has gone.
+	struct FlushTarget
+	{
+		std::mutex FlushMutex;
+		ProfileCache* Cache = nullptr;
+	};
+
+	void OnFetched(const std::vector<std::string>& UserIds,
+				   uint64_t FetchGeneration,
+				   bool Succeeded,
+				   uint16_t HttpResultCode,
+				   const std::vector<BasicProfile>& Profiles);
+
+	static void Complete(const Request& Completed);
+
+	// These expect Mutex to be held
+	void Insert(const BasicProfile& Profile, Clock::time_point Now);
+	void Touch(Entry& Cached);
+
+	IStore* Store;
+	size_t Capacity;
+	Clock::duration MaxAge;
+	Clock::duration BatchWindow;
+	size_t MaxBatchSize;
+
+	std::unordered_map<std::string, Entry> Entries;
+	// Most recently used first
+	std::list<std::string> Lru;
+
+	// Users waiting to be requested, and everyone queued or in flight
+	std::vector<std::string> Queued;
+	std::unordered_set<std::string> Requested;
+	// Users invalidated while in flight, whose responses mustn't be cached
+	std::unordered_set<std::string> Stale;
+	std::unordered_map<std::string, std::vector<std::shared_ptr<Request>>> Waiting;
+
+	bool IsFlushScheduled;
+	ScheduledTaskId FlushTask;
+	std::shared_ptr<FlushTarget> ScheduledFlushTarget;
+	// Goes up whenever the cache is cleared, so that responses to requests made before then are ignored
+	uint64_t Generation;
+
+	mutable std::mutex Mutex;
+};
+
+} // namespace csp::systems
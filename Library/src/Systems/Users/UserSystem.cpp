@@ -25,14 +25,24 @@
 #include "Services/AggregationService/Api.h"
 #include "Services/UserService/Api.h"
 #include "Systems/Users/Authentication.h"
+#include "Systems/Users/ProfileCache.h"
 
 #include <CallHelpers.h>
+#include <chrono>
+#include <string>
+#include <vector>
 
 
 namespace chs_user		  = csp::services::generated::userservice;
 namespace chs_aggregation = csp::services::generated::aggregationservice;
 
 
+constexpr size_t PROFILE_CACHE_CAPACITY							 = 2000;
+constexpr std::chrono::minutes PROFILE_CACHE_MAX_AGE			 = std::chrono::minutes(5);
+constexpr std::chrono::milliseconds PROFILE_REQUEST_BATCH_WINDOW = std::chrono::milliseconds(50);
+constexpr size_t MAX_PROFILES_PER_REQUEST						 = 100;
+
+
 namespace
 {
 
@@ -49,6 +59,49 @@ namespace csp::systems
 
 const char* EMPTY_SPACE_STRING = " ";
 
+// Reads basic profiles through the user service
+class UserServiceProfileStore : public ProfileCache::IStore
+{
+public:
+	UserServiceProfileStore(csp::services::ApiBase* InProfileAPI) : ProfileAPI(InProfileAPI)
+	{
+	}
+
+	void GetBasicProfiles(const std::vector<std::string>& UserIds, ProfileCache::ProfilesCallback Callback) override
+	{
+		std::vector<csp::common::String> InUserIds;
+		InUserIds.reserve(UserIds.size());
+
+		for (const auto& UserId : UserIds)
+		{
+			InUserIds.push_back(UserId.c_str());
+		}
+
+		BasicProfilesResultCallback InternalCallback = [Callback](const BasicProfilesResult& Result)
+		{
+			if (Result.GetResultCode() == EResultCode::InProgress)
+			{
+				return;
+			}
+
+			const auto& Profiles = Result.GetProfiles();
+			Callback(Result.GetResultCode() == EResultCode::Success,
+					 Result.GetHttpResultCode(),
+					 std::vector<BasicProfile>(Profiles.Data(), Profiles.Data() + Profiles.Size()));
+		};
+
+		csp::services::ResponseHandlerPtr ResponseHandler
+			= ProfileAPI->CreateHandler<BasicProfilesResultCallback, BasicProfilesResult, void, csp::services::DtoArray<chs_user::ProfileLiteDto> >(
+				InternalCallback,
+				nullptr);
+
+		static_cast<chs_user::ProfileApi*>(ProfileAPI)->apiV1UsersLiteGet(InUserIds, ResponseHandler);
+	}
+
+private:
+	csp::services::ApiBase* ProfileAPI;
+};
+
 csp::common::String ConvertExternalAuthProvidersToString(EThirdPartyAuthenticationProviders Provider)
 {
 	switch (Provider)
@@ -82,7 +135,14 @@ csp::common::String FormatScopesForURL(csp::common::Array<csp::common::String> S
 	return FormattedScopes;
 }
 
-UserSystem::UserSystem() : SystemBase(), AuthenticationAPI(nullptr), ProfileAPI(nullptr), PingAPI(nullptr), ExternalServiceProxyApi(nullptr)
+UserSystem::UserSystem()
+	: SystemBase()
+	, AuthenticationAPI(nullptr)
+	, ProfileAPI(nullptr)
+	, PingAPI(nullptr)
+	, ExternalServiceProxyApi(nullptr)
+	, ProfileStore(nullptr)
+	, BasicProfileCache(nullptr)
 {
 }
 
@@ -93,10 +153,19 @@ UserSystem::UserSystem(csp::web::WebClient* InWebClient) : SystemBase(InWebClien
 	PingAPI					= CSP_NEW chs_user::PingApi(InWebClient);
 	ExternalServiceProxyApi = CSP_NEW chs_aggregation::ExternalServiceProxyApi(InWebClient);
 	StripeAPI				= CSP_NEW chs_user::StripeApi(InWebClient);
+
+	ProfileStore	  = CSP_NEW UserServiceProfileStore(ProfileAPI);
+	BasicProfileCache = CSP_NEW ProfileCache(ProfileStore,
+											 PROFILE_CACHE_CAPACITY,
+											 PROFILE_CACHE_MAX_AGE,
+											 PROFILE_REQUEST_BATCH_WINDOW,
+											 MAX_PROFILES_PER_REQUEST);
 }
 
 UserSystem::~UserSystem()
 {
+	CSP_DELETE(BasicProfileCache);
+	CSP_DELETE(ProfileStore);
 	CSP_DELETE(PingAPI);
 	CSP_DELETE(ProfileAPI);
 	CSP_DELETE(AuthenticationAPI);
@@ -470,6 +539,8 @@ void UserSystem::Logout(NullResultCallback Callback)
 	{
 		CurrentLoginState.State = ELoginState::LogoutRequested;
 
+		BasicProfileCache->Clear();
+
 		// Disconnect MultiplayerConnection before logging out
 		csp::multiplayer::MultiplayerConnection::ErrorCodeCallbackHandler ErrorCallback = [Callback, this](csp::multiplayer::ErrorCode ErrCode)
 		{
@@ -607,8 +678,18 @@ void UserSystem::ResetUserPassword(const csp::common::String& Token,
 
 void UserSystem::UpdateUserDisplayName(const csp::common::String& UserId, const csp::common::String& NewUserDisplayName, NullResultCallback Callback)
 {
+	NullResultCallback UpdateCallback = [this, UserId, Callback](const NullResult& Result)
+	{
+		if (Result.GetResultCode() != EResultCode::InProgress)
+		{
+			BasicProfileCache->Invalidate(UserId.c_str());
+		}
+
+		INVOKE_IF_NOT_NULL(Callback, Result);
+	};
+
 	const csp::services::ResponseHandlerPtr ResponseHandler
-		= ProfileAPI->CreateHandler<NullResultCallback, NullResult, void, csp::services::NullDto>(Callback, nullptr);
+		= ProfileAPI->CreateHandler<NullResultCallback, NullResult, void, csp::services::NullDto>(UpdateCallback, nullptr);
 
 	static_cast<chs_user::ProfileApi*>(ProfileAPI)->apiV1UsersUserIdDisplayNamePut(UserId, NewUserDisplayName, ResponseHandler);
 }
@@ -671,34 +752,47 @@ void UserSystem::GetProfileByUserId(const csp::common::String& InUserId, Profile
 {
 	const csp::common::String UserId = InUserId;
 
+	// Full profiles aren't cached, as they hold account details that can change elsewhere, but they are a fresh basic profile
+	ProfileResultCallback GetProfileCallback = [this, Callback](const ProfileResult& Result)
+	{
+		if (Result.GetResultCode() == EResultCode::Success)
+		{
+			BasicProfileCache->AddProfile(Result.GetProfile());
+		}
+
+		INVOKE_IF_NOT_NULL(Callback, Result);
+	};
+
 	csp::services::ResponseHandlerPtr ResponseHandler
-		= ProfileAPI->CreateHandler<ProfileResultCallback, ProfileResult, void, chs_user::ProfileDto>(Callback, nullptr);
+		= ProfileAPI->CreateHandler<ProfileResultCallback, ProfileResult, void, chs_user::ProfileDto>(GetProfileCallback, nullptr);
 
 	static_cast<chs_user::ProfileApi*>(ProfileAPI)->apiV1UsersUserIdGet(UserId, ResponseHandler);
 }
 
 void UserSystem::GetProfilesByUserId(const csp::common::Array<csp::common::String>& InUserIds, BasicProfilesResultCallback Callback)
 {
-	const std::vector<csp::common::String> UserIds(InUserIds.Data(), InUserIds.Data() + InUserIds.Size());
-
-	csp::services::ResponseHandlerPtr ResponseHandler
-		= ProfileAPI->CreateHandler<BasicProfilesResultCallback, BasicProfilesResult, void, csp::services::DtoArray<chs_user::ProfileLiteDto> >(
-			Callback,
-			nullptr);
-
-	static_cast<chs_user::ProfileApi*>(ProfileAPI)->apiV1UsersLiteGet(UserIds, ResponseHandler);
+	GetBasicProfilesByUserId(InUserIds, Callback);
 }
 
 void UserSystem::GetBasicProfilesByUserId(const csp::common::Array<csp::common::String>& InUserIds, BasicProfilesResultCallback Callback)
 {
-	const std::vector<csp::common::String> UserIds(InUserIds.Data(), InUserIds.Data() + InUserIds.Size());
+	std::vector<std::string> UserIds;
+	UserIds.reserve(InUserIds.Size());
 
-	csp::services::ResponseHandlerPtr ResponseHandler
-		= ProfileAPI->CreateHandler<BasicProfilesResultCallback, BasicProfilesResult, void, csp::services::DtoArray<chs_user::ProfileLiteDto> >(
-			Callback,
-			nullptr);
+	for (size_t i = 0; i < InUserIds.Size(); ++i)
+	{
+		UserIds.push_back(InUserIds[i].c_str());
+	}
+
+	ProfileCache::ProfilesCallback InternalCallback = [Callback](bool Succeeded, uint16_t HttpResultCode, const std::vector<BasicProfile>& Profiles)
+	{
+		BasicProfilesResult InternalResult(Succeeded ? EResultCode::Success : EResultCode::Failed, HttpResultCode);
+		InternalResult.GetProfiles() = csp::common::Array<BasicProfile>(Profiles.data(), Profiles.size());
+
+		INVOKE_IF_NOT_NULL(Callback, InternalResult);
+	};
 
-	static_cast<chs_user::ProfileApi*>(ProfileAPI)->apiV1UsersLiteGet(UserIds, ResponseHandler);
+	BasicProfileCache->GetProfiles(UserIds, InternalCallback);
 }
 
 void UserSystem::Ping(NullResultCallback Callback)
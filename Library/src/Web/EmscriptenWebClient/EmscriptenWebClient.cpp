@@ -19,6 +19,7 @@
 #include "CSP/Common/Map.h"
 #include "CSP/Common/String.h"
 #include "Debug/Logging.h"
+#include "Web/HttpResponseSink.h"
 
 #include <assert.h>
 #include <emscripten/emscripten.h>
@@ -58,7 +59,22 @@ void OnFetchSuccessOrError(emscripten_fetch_t* Fetch)
 
 	if (Fetch->numBytes)
 	{
-		Request->SetResponseData(Fetch->data, Fetch->numBytes);
+		// Fetch has already collected the body, so it can only be copied to the sink once it's complete
+		auto* Sink = Request->GetCallback()->GetResponseSink();
+
+		const auto Status = static_cast<csp::web::EResponseCodes>(Fetch->status);
+
+		if (Sink != nullptr && (Status == csp::web::EResponseCodes::ResponseOK || Status == csp::web::EResponseCodes::ResponsePartialContent))
+		{
+			if (!csp::web::WriteToResponseSink(*Sink, Fetch->data, Fetch->numBytes))
+			{
+				Request->SetResponseCode(csp::web::EResponseCodes::ResponseRequestEntityTooLarge);
+			}
+		}
+		else
+		{
+			Request->SetResponseData(Fetch->data, Fetch->numBytes);
+		}
 	}
 
 	csp::common::Map<csp::common::String, csp::common::String> Headers;
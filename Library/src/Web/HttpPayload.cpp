@@ -91,6 +91,11 @@ void HttpPayload::AllocateContent(size_t DataLength)
 	Content = csp::common::String(DataLength);
 }
 
+char* HttpPayload::GetMutableContentData()
+{
+	return const_cast<char*>(Content.c_str());
+}
+
 /// @brief Write content to the payload from the specified buffer
 /// @param Offset
 /// @param Data
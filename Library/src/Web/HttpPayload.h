@@ -49,6 +49,8 @@ public:
 	void SetContent(const char* Data, size_t DataLength);
 
 	void AllocateContent(size_t DataLength);
+	/// @brief Returns the content for writing to in place, e.g. after AllocateContent.
+	char* GetMutableContentData();
 	void WriteContent(size_t Offset, const char* Data, size_t DataLength);
 	size_t ReadContent(size_t Offset, void* Data, size_t DataLength) const;
 
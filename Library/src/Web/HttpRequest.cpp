@@ -38,7 +38,7 @@ HttpRequest::HttpRequest(WebClient* InClient,
 	, IsAutoRetryEnabled(true)
 	, RetryCount(0)
 	, RefCount(0)
-	, SendDelay(0)
+	, Priority(ERequestPriority::Normal)
 {
 	if (&CancellationToken == &csp::common::CancellationToken::Dummy())
 	{
@@ -205,7 +205,7 @@ bool HttpRequest::CheckForAutoRetry(const uint32_t MaxRetries)
 	EResponseCodes ErrorCodeValue = GetResponse().GetResponseCode();
 
 	if (IsAutoRetryEnabled && (ErrorCodeValue != EResponseCodes::ResponseOK) && (ErrorCodeValue != EResponseCodes::ResponseCreated)
-		&& (ErrorCodeValue != EResponseCodes::ResponseNoContent))
+		&& (ErrorCodeValue != EResponseCodes::ResponseNoContent) && (ErrorCodeValue != EResponseCodes::ResponsePartialContent))
 	{
 		RetryIssued = Retry(MaxRetries);
 	}
@@ -233,14 +233,14 @@ uint32_t HttpRequest::GetRetryCount() const
 	return RetryCount;
 }
 
-void HttpRequest::SetSendDelay(const std::chrono::milliseconds InSendDelay)
+void HttpRequest::SetPriority(ERequestPriority InPriority)
 {
-	SendDelay = InSendDelay;
+	Priority = InPriority;
 }
 
-const std::chrono::milliseconds HttpRequest::GetSendDelay()
+ERequestPriority HttpRequest::GetPriority() const
 {
-	return SendDelay;
+	return Priority;
 }
 
 void HttpRequest::EnableAutoRetry(bool Enable)
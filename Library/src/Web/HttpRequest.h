@@ -58,6 +58,14 @@ enum class ERequestVerb : uint8_t
 constexpr uint32_t DefaultNumRequestRetries = 4;
 constexpr uint32_t DefaultRetriesDelayInMs	= 100;
 
+/// @brief Order in which queued requests are sent when there are more requests than WebClient workers
+enum class ERequestPriority : uint8_t
+{
+	High,
+	Normal,
+	Low
+};
+
 class HttpRequest
 {
 public:
@@ -101,8 +109,8 @@ public:
 	uint32_t GetRefCount() const;
 	uint32_t GetRetryCount() const;
 
-	void SetSendDelay(const std::chrono::milliseconds InSendDelay);
-	const std::chrono::milliseconds GetSendDelay();
+	void SetPriority(ERequestPriority InPriority);
+	ERequestPriority GetPriority() const;
 
 	void Cancel();
 	bool Cancelled();
@@ -124,7 +132,7 @@ private:
 	uint32_t RetryCount;
 	std::atomic_uint32_t RefCount;
 
-	std::chrono::milliseconds SendDelay;
+	ERequestPriority Priority;
 
 	HttpProgress Progress;
 	csp::common::CancellationToken* CancellationToken;
@@ -24,6 +24,7 @@ namespace csp::web
 
 class HttpRequest;
 class HttpResponse;
+class IHttpResponseSink;
 
 struct IHttpResponseHandler
 {
@@ -34,6 +35,12 @@ struct IHttpResponseHandler
 		return false;
 	}
 
+	/// @brief Returns a sink to write the response body to as it is received, instead of collecting it in the response payload.
+	virtual IHttpResponseSink* GetResponseSink()
+	{
+		return nullptr;
+	}
+
 	virtual ~IHttpResponseHandler() = default;
 };
 
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Web/HttpResponseSink.h"
+
+#include "Common/Wrappers.h"
+#include "Web/HttpPayload.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace csp::web
+{
+
+bool WriteToResponseSink(IHttpResponseSink& Sink, const char* Data, size_t Length)
+{
+	if (!Sink.Begin(Length))
+	{
+		Sink.End(false);
+
+		return false;
+	}
+
+	size_t Offset = 0;
+
+	while (Offset < Length)
+	{
+		size_t WriteLength = Length - Offset;
+		char* Buffer	   = Sink.GetWriteBuffer(Offset, WriteLength);
+
+		if (Buffer == nullptr || WriteLength == 0)
+		{
+			Sink.End(false);
+
+			return false;
+		}
+
+		memcpy(Buffer, Data + Offset, WriteLength);
+		Sink.OnWritten(Offset, WriteLength);
+
+		Offset += WriteLength;
+	}
+
+	Sink.End(true);
+
+	return true;
+}
+
+
+PayloadResponseSink::PayloadResponseSink(HttpPayload& InPayload) : Payload(InPayload), Capacity(0), Size(0)
+{
+}
+
+bool PayloadResponseSink::Begin(size_t ContentLength)
+{
+	Size = 0;
+	Buffer.clear();
+
+	if (ContentLength == UnknownLength)
+	{
+		Capacity = UnknownLength;
+	}
+	else
+	{
+		Capacity = ContentLength;
+		Payload.AllocateContent(ContentLength);
+	}
+
+	return true;
+}
+
+char* PayloadResponseSink::GetWriteBuffer(size_t Offset, size_t& InOutLength)
+{
+	if (Capacity == UnknownLength)
+	{
+		if (Buffer.size() < Offset + InOutLength)
+		{
+			Buffer.resize(Offset + InOutLength);
+		}
+
+		return Buffer.data() + Offset;
+	}
+
+	if (Offset >= Capacity)
+	{
+		return nullptr;
+	}
+
+	InOutLength = std::min(InOutLength, Capacity - Offset);
+
+	return Payload.GetMutableContentData() + Offset;
+}
+
+void PayloadResponseSink::OnWritten(size_t Offset, size_t Length)
+{
+	Size = std::max(Size, Offset + Length);
+}
+
+void PayloadResponseSink::End(bool Succeeded)
+{
+	if (Capacity == UnknownLength && Succeeded)
+	{
+		Payload.SetContent(Buffer.data(), Size);
+	}
+
+	Buffer.clear();
+	Buffer.shrink_to_fit();
+}
+
+size_t PayloadResponseSink::GetSize() const
+{
+	return Size;
+}
+
+
+BufferResponseSink::BufferResponseSink(char* InBuffer, size_t InCapacity) : Buffer(InBuffer), Capacity(InCapacity), Size(0)
+{
+}
+
+bool BufferResponseSink::Begin(size_t ContentLength)
+{
+	Size = 0;
+
+	return ContentLength == UnknownLength || ContentLength <= Capacity;
+}
+
+char* BufferResponseSink::GetWriteBuffer(size_t Offset, size_t& InOutLength)
+{
+	if (Offset >= Capacity)
+	{
+		return nullptr;
+	}
+
+	InOutLength = std::min(InOutLength, Capacity - Offset);
+
+	return Buffer + Offset;
+}
+
+void BufferResponseSink::OnWritten(size_t Offset, size_t Length)
+{
+	Size = std::max(Size, Offset + Length);
+}
+
+void BufferResponseSink::End(bool /*Succeeded*/)
+{
+}
+
+size_t BufferResponseSink::GetSize() const
+{
+	return Size;
+}
+
+size_t BufferResponseSink::GetCapacity() const
+{
+	return Capacity;
+}
+
+
+FileResponseSink::FileResponseSink(const csp::FilePath& InPath, size_t InChunkSize)
+	: Path(InPath), ChunkSize(InChunkSize), Size(0), File(nullptr)
+{
+}
+
+FileResponseSink::~FileResponseSink()
+{
+	Close();
+}
+
+bool FileResponseSink::Begin(size_t ContentLength)
+{
+	Close();
+	Size = 0;
+
+	if (ContentLength != UnknownLength)
+	{
+		Mapping = std::make_unique<csp::MappedFile>(Path, ContentLength);
+
+		return Mapping->IsMapped();
+	}
+
+	File = FOPEN(Path.c_str(), "wb");
+
+	if (File == nullptr)
+	{
+		return false;
+	}
+
+	Buffer.resize(ChunkSize);
+
+	return true;
+}
+
+char* FileResponseSink::GetWriteBuffer(size_t Offset, size_t& InOutLength)
+{
+	if (Mapping != nullptr)
+	{
+		if (Offset >= Mapping->GetSize())
+		{
+			return nullptr;
+		}
+
+		InOutLength = std::min(InOutLength, Mapping->GetSize() - Offset);
+
+		return Mapping->GetMutableData() + Offset;
+	}
+
+	if (File == nullptr)
+	{
+		return nullptr;
+	}
+
+	InOutLength = std::min(InOutLength, Buffer.size());
+
+	return Buffer.data();
+}
+
+void FileResponseSink::OnWritten(size_t Offset, size_t Length)
+{
+	if (File != nullptr && fwrite(Buffer.data(), 1, Length, File) != Length)
+	{
+		// Stop taking data. The request will fail when it next asks for somewhere to write.
+		fclose(File);
+		File = nullptr;
+
+		return;
+	}
+
+	Size = std::max(Size, Offset + Length);
+}
+
+void FileResponseSink::End(bool Succeeded)
+{
+	const bool Written = (Mapping != nullptr) || (File != nullptr && fflush(File) == 0);
+
+	Close();
+
+	if (!Succeeded || !Written)
+	{
+		remove(Path.c_str());
+	}
+}
+
+size_t FileResponseSink::GetSize() const
+{
+	return Size;
+}
+
+void FileResponseSink::Close()
+{
+	// Unmapping writes the mapped body to the file
+	Mapping.reset();
+
+	if (File != nullptr)
+	{
+		fclose(File);
+		File = nullptr;
+	}
+
+	Buffer.clear();
+	Buffer.shrink_to_fit();
+}
+
+
+CallbackResponseSink::CallbackResponseSink(ChunkCallback InCallback, size_t InChunkSize)
+	: Callback(std::move(InCallback)), ChunkSize(InChunkSize), Size(0)
+{
+}
+
+bool CallbackResponseSink::Begin(size_t /*ContentLength*/)
+{
+	Size = 0;
+	Buffer.resize(ChunkSize);
+
+	return true;
+}
+
+char* CallbackResponseSink::GetWriteBuffer(size_t /*Offset*/, size_t& InOutLength)
+{
+	InOutLength = std::min(InOutLength, Buffer.size());
+
+	return Buffer.data();
+}
+
+void CallbackResponseSink::OnWritten(size_t Offset, size_t Length)
+{
+	if (Callback)
+	{
+		Callback(Offset, Buffer.data(), Length);
+	}
+
+	Size = std::max(Size, Offset + Length);
+}
+
+void CallbackResponseSink::End(bool /*Succeeded*/)
+{
+	Buffer.clear();
+	Buffer.shrink_to_fit();
+}
+
+size_t CallbackResponseSink::GetSize() const
+{
+	return Size;
+}
+
+} // namespace csp::web
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "Storage/MappedFile.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+namespace csp::web
+{
+
+class HttpPayload;
+
+/// @brief Destination for the body of an HTTP response, written as it is received rather than collected in the response payload.
+/// The web client asks the sink for memory and reads the body straight into it, so a sink backed by the body's final destination,
+/// such as a caller's buffer or a mapped file, receives the body without it being copied. If a request is retried, Begin is called
+/// again and the body is written again from the start.
+class IHttpResponseSink
+{
+public:
+	/// @brief Passed to Begin when the response has no Content-Length header.
+	static constexpr size_t UnknownLength = static_cast<size_t>(-1);
+
+	virtual ~IHttpResponseSink() = default;
+
+	/// @brief Called before the body is read, with its length if known.
+	/// @return False if the sink can't take a body of this length.
+	virtual bool Begin(size_t ContentLength) = 0;
+
+	/// @brief Returns memory to write up to InOutLength bytes of the body into, starting at Offset, and sets InOutLength to the number of
+	/// bytes that can be written there. Returns null if the sink has no more room.
+	virtual char* GetWriteBuffer(size_t Offset, size_t& InOutLength) = 0;
+
+	/// @brief Called once Length bytes have been written to the memory returned by the last call to GetWriteBuffer.
+	virtual void OnWritten(size_t Offset, size_t Length) = 0;
+
+	/// @brief Called once the whole body has been written, or with Succeeded false if the request failed or was cancelled part way through.
+	virtual void End(bool Succeeded) = 0;
+
+	/// @brief Returns the number of bytes of the body written so far.
+	virtual size_t GetSize() const = 0;
+
+	/// @brief Returns the length of the longest body the sink can take, or UnknownLength if there is no fixed limit.
+	virtual size_t GetCapacity() const
+	{
+		return UnknownLength;
+	}
+};
+
+
+/// @brief Writes a body that is already in memory, such as a cached file, to a sink in the same way as the web client would.
+/// @return False if the sink couldn't take all of it.
+bool WriteToResponseSink(IHttpResponseSink& Sink, const char* Data, size_t Length);
+
+
+/// @brief Collects the body in a response payload, which is what happens when a request has no sink of its own.
+/// When the length is known, the payload is allocated up front and the body is read straight into it.
+class PayloadResponseSink : public IHttpResponseSink
+{
+public:
+	explicit PayloadResponseSink(HttpPayload& InPayload);
+
+	bool Begin(size_t ContentLength) override;
+	char* GetWriteBuffer(size_t Offset, size_t& InOutLength) override;
+	void OnWritten(size_t Offset, size_t Length) override;
+	void End(bool Succeeded) override;
+	size_t GetSize() const override;
+
+private:
+	HttpPayload& Payload;
+	size_t Capacity;
+	size_t Size;
+
+	// Holds a body of unknown length until it's complete
+	std::vector<char> Buffer;
+};
+
+
+/// @brief Writes the body into a fixed size buffer owned by the caller. Bodies longer than the buffer are rejected.
+class BufferResponseSink : public IHttpResponseSink
+{
+public:
+	BufferResponseSink(char* InBuffer, size_t InCapacity);
+
+	bool Begin(size_t ContentLength) override;
+	char* GetWriteBuffer(size_t Offset, size_t& InOutLength) override;
+	void OnWritten(size_t Offset, size_t Length) override;
+	void End(bool Succeeded) override;
+	size_t GetSize() const override;
+	size_t GetCapacity() const override;
+
+private:
+	char* Buffer;
+	size_t Capacity;
+	size_t Size;
+};
+
+
+/// @brief Writes the body to a file, replacing any existing file. When the length is known, the file is created at its full size and
+/// mapped, and the body is read straight into the mapping. The file is removed if the request fails.
+class FileResponseSink : public IHttpResponseSink
+{
+public:
+	/// @param InChunkSize Size of the buffer used to write bodies of unknown length.
+	FileResponseSink(const csp::FilePath& InPath, size_t InChunkSize);
+	~FileResponseSink();
+
+	bool Begin(size_t ContentLength) override;
+	char* GetWriteBuffer(size_t Offset, size_t& InOutLength) override;
+	void OnWritten(size_t Offset, size_t Length) override;
+	void End(bool Succeeded) override;
+	size_t GetSize() const override;
+
+private:
+	void Close();
+
+	csp::FilePath Path;
+	size_t ChunkSize;
+	size_t Size;
+
+	std::unique_ptr<csp::MappedFile> Mapping;
+	FILE* File;
+	std::vector<char> Buffer;
+};
+
+
+/// @brief Hands the body to a function in chunks as it is received. The chunks are read into a buffer owned by the sink, which is
+/// reused, so the function must copy out anything it wants to keep.
+class CallbackResponseSink : public IHttpResponseSink
+{
+public:
+	using ChunkCallback = std::function<void(size_t Offset, const char* Data, size_t Length)>;
+
+	CallbackResponseSink(ChunkCallback InCallback, size_t InChunkSize);
+
+	bool Begin(size_t ContentLength) override;
+	char* GetWriteBuffer(size_t Offset, size_t& InOutLength) override;
+	void OnWritten(size_t Offset, size_t Length) override;
+	void End(bool Succeeded) override;
+	size_t GetSize() const override;
+
+private:
+	ChunkCallback Callback;
+	size_t ChunkSize;
+	size_t Size;
+
+	std::vector<char> Buffer;
+};
+
+} // namespace csp::web
@@ -297,7 +297,14 @@ template <class T, typename std::enable_if_t<!std::is_base_of_v<csp::services::D
 template <typename T, typename std::enable_if_t<std::is_base_of_v<csp::services::DtoBase, T>>*>
 inline void JsonValueToType(const rapidjson::Value& Value, T& Type)
 {
-	Type.FromJson(Value.IsString() ? CSP_TEXT(Value.GetString()) : JsonObjectToString(Value));
+	if (Value.IsString())
+	{
+		Type.FromJson(CSP_TEXT(Value.GetString()));
+	}
+	else
+	{
+		Type.FromJsonValue(Value);
+	}
 }
 
 
@@ -320,11 +327,13 @@ template <typename U> inline void JsonValueToType(const rapidjson::Value& Value,
 {
 	assert(Value.IsArray());
 
+	Type.reserve(Type.size() + Value.Size());
+
 	for (auto i = 0U; i < Value.Size(); ++i)
 	{
 		U Element;
 		JsonValueToType(Value[i], Element);
-		Type.push_back(Element);
+		Type.push_back(std::move(Element));
 	}
 }
 
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Web/POCOWebClient/POCOSessionPool.h"
+
+#include <Poco/Net/Socket.h>
+#include <Poco/Timespan.h>
+
+
+namespace csp::web
+{
+
+POCOSessionPool::POCOSessionPool(Poco::Net::Context::Ptr InContext, size_t InMaxSessionsPerHost, std::chrono::milliseconds InIdleTimeout)
+	: Context(InContext), MaxSessionsPerHost(InMaxSessionsPerHost), IdleTimeout(InIdleTimeout)
+{
+}
+
+POCOSessionPool::~POCOSessionPool()
+{
+	Clear();
+}
+
+POCOSessionPool::SessionPtr POCOSessionPool::Acquire(const std::string& Host, uint16_t Port, bool* OutIsReused)
+{
+	// Sessions we can't reuse are closed once the lock has been released, as closing a TLS connection writes to the socket
+	std::vector<SessionPtr> DiscardedSessions;
+
+	if (OutIsReused != nullptr)
+	{
+		*OutIsReused = false;
+	}
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		HostEntry& Entry = Hosts[MakeHostKey(Host, Port)];
+		PurgeExpiredSessions(Entry, Clock::now(), DiscardedSessions);
+
+		while (!Entry.IdleSessions.empty())
+		{
+			SessionPtr Session = std::move(Entry.IdleSessions.back().Session);
+			Entry.IdleSessions.pop_back();
+
+			if (IsSessionHealthy(*Session))
+			{
+				++PoolStats.SessionsReused;
+
+				if (OutIsReused != nullptr)
+				{
+					*OutIsReused = true;
+				}
+
+				return Session;
+			}
+
+			++PoolStats.SessionsStale;
+			DiscardedSessions.push_back(std::move(Session));
+		}
+	}
+
+	return Create(Host, Port);
+}
+
+POCOSessionPool::SessionPtr POCOSessionPool::Create(const std::string& Host, uint16_t Port)
+{
+	Poco::Net::Session::Ptr TlsSession;
+	std::chrono::milliseconds SessionIdleTimeout;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		++PoolStats.SessionsCreated;
+
+		TlsSession		   = Hosts[MakeHostKey(Host, Port)].TlsSession;
+		SessionIdleTimeout = IdleTimeout;
+	}
+
+	auto Session = std::make_unique<Poco::Net::HTTPSClientSession>(Host, Port, Context, TlsSession);
+	Session->setKeepAlive(true);
+	// Poco transparently reconnects a session that has been idle for longer than its keep-alive timeout
+	Session->setKeepAliveTimeout(Poco::Timespan(static_cast<Poco::Timespan::TimeDiff>(SessionIdleTimeout.count()) * Poco::Timespan::MILLISECONDS));
+
+	return Session;
+}
+
+void POCOSessionPool::Release(SessionPtr Session)
+{
+	if (!Session || !Session->connected())
+	{
+		return;
+	}
+
+	std::scoped_lock Lock(Mutex);
+
+	HostEntry& Entry = Hosts[MakeHostKey(Session->getHost(), Session->getPort())];
+
+	// Remember the negotiated TLS session so that new connections to this host can use an abbreviated handshake
+	if (Context->sessionCacheEnabled() && !Session->sslSession().isNull())
+	{
+		Entry.TlsSession = Session->sslSession();
+	}
+
+	if (Entry.IdleSessions.size() >= MaxSessionsPerHost)
+	{
+		return;
+	}
+
+	Entry.IdleSessions.push_back({std::move(Session), Clock::now()});
+}
+
+void POCOSessionPool::Clear()
+{
+	std::unordered_map<std::string, HostEntry> ClearedHosts;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		ClearedHosts.swap(Hosts);
+	}
+}
+
+void POCOSessionPool::SetMaxSessionsPerHost(size_t InMaxSessionsPerHost)
+{
+	std::vector<SessionPtr> DiscardedSessions;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		MaxSessionsPerHost = InMaxSessionsPerHost;
+
+		for (auto& [Key, Entry] : Hosts)
+		{
+			// Close the least recently used sessions first
+			while (Entry.IdleSessions.size() > MaxSessionsPerHost)
+			{
+				DiscardedSessions.push_back(std::move(Entry.IdleSessions.front().Session));
+				Entry.IdleSessions.pop_front();
+			}
+		}
+	}
+}
+
+size_t POCOSessionPool::GetMaxSessionsPerHost() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return MaxSessionsPerHost;
+}
+
+void POCOSessionPool::SetIdleTimeout(std::chrono::milliseconds InIdleTimeout)
+{
+	std::scoped_lock Lock(Mutex);
+
+	IdleTimeout = InIdleTimeout;
+}
+
+std::chrono::milliseconds POCOSessionPool::GetIdleTimeout() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return IdleTimeout;
+}
+
+size_t POCOSessionPool::GetIdleSessionCount() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	size_t Count = 0;
+
+	for (const auto& [Key, Entry] : Hosts)
+	{
+		Count += Entry.IdleSessions.size();
+	}
+
+	return Count;
+}
+
+POCOSessionPool::Stats POCOSessionPool::GetStats() const
+{
+	std::scoped_lock Lock(Mutex);
+
+	return PoolStats;
+}
+
+std::string POCOSessionPool::MakeHostKey(const std::string& Host, uint16_t Port)
+{
+	return Host + ":" + std::to_string(Port);
+}
+
+bool POCOSessionPool::IsSessionHealthy(Poco::Net::HTTPSClientSession& Session)
+{
+	if (!Session.connected())
+	{
+		return false;
+	}
+
+	try
+	{
+		// An idle keep-alive connection should have nothing to read. If it is readable, the server has either closed it
+		// or sent data we weren't expecting, and in both cases it can't be used for another request.
+		return !Session.socket().poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ | Poco::Net::Socket::SELECT_ERROR);
+	}
+	catch (const Poco::Exception&)
+	{
+		return false;
+	}
+}
+
+void POCOSessionPool::PurgeExpiredSessions(HostEntry& Entry, Clock::time_point Now, std::vector<SessionPtr>& OutDiscardedSessions)
+{
+	while (!Entry.IdleSessions.empty() && (Now - Entry.IdleSessions.front().LastUsed) >= IdleTimeout)
+	{
+		OutDiscardedSessions.push_back(std::move(Entry.IdleSessions.front().Session));
+		Entry.IdleSessions.pop_front();
+		++PoolStats.SessionsExpired;
+	}
+}
+
+} // namespace csp::web
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <Poco/Net/Context.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/Session.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace csp::web
+{
+
+/// @brief Keeps idle keep-alive HTTPS sessions open so that consecutive requests to the same host skip the TCP and TLS handshakes.
+/// The pool is shared by all of the WebClient worker threads. A session is owned exclusively by the thread that acquired it until it is
+/// released back to the pool, at which point it becomes available to any other thread sending to the same host and port.
+class POCOSessionPool
+{
+public:
+	using SessionPtr = std::unique_ptr<Poco::Net::HTTPSClientSession>;
+
+	struct Stats
+	{
+		uint64_t SessionsCreated = 0;
+		uint64_t SessionsReused	 = 0;
+		uint64_t SessionsExpired = 0;
+		uint64_t SessionsStale	 = 0;
+	};
+
+	POCOSessionPool(Poco::Net::Context::Ptr InContext,
+					size_t InMaxSessionsPerHost = 8,
+					std::chrono::milliseconds InIdleTimeout = std::chrono::milliseconds(30000));
+	~POCOSessionPool();
+
+	POCOSessionPool(const POCOSessionPool&)			   = delete;
+	POCOSessionPool& operator=(const POCOSessionPool&) = delete;
+
+	/// @brief Returns a healthy idle session for the given host, or a new one if none is available.
+	/// New sessions resume the most recent TLS session negotiated with the host when the context has session caching enabled.
+	/// @param OutIsReused If given, set to whether the session was taken from the pool. The server may still close a pooled session
+	/// between the health check and the next request being sent on it.
+	SessionPtr Acquire(const std::string& Host, uint16_t Port, bool* OutIsReused = nullptr);
+
+	/// @brief Returns a new session for the given host, without looking for an idle one.
+	SessionPtr Create(const std::string& Host, uint16_t Port);
+
+	/// @brief Returns a session to the pool once its response has been fully consumed.
+	/// Sessions that have been closed, or that would take a host over its idle limit, are destroyed instead.
+	void Release(SessionPtr Session);
+
+	/// @brief Closes all idle sessions and forgets any cached TLS sessions.
+	void Clear();
+
+	/// @brief Maximum number of idle sessions kept open for a single host and port. A value of 0 disables pooling.
+	void SetMaxSessionsPerHost(size_t InMaxSessionsPerHost);
+	size_t GetMaxSessionsPerHost() const;
+
+	/// @brief Idle sessions older than this are closed rather than reused, as most servers will have dropped them by then.
+	void SetIdleTimeout(std::chrono::milliseconds InIdleTimeout);
+	std::chrono::milliseconds GetIdleTimeout() const;
+
+	size_t GetIdleSessionCount() const;
+	Stats GetStats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct IdleSession
+	{
+		SessionPtr Session;
+		Clock::time_point LastUsed;
+	};
+
+	struct HostEntry
+	{
+		// Most recently released sessions are at the back, so expired sessions accumulate at the front.
+		std::deque<IdleSession> IdleSessions;
+		Poco::Net::Session::Ptr TlsSession;
+	};
+
+	static std::string MakeHostKey(const std::string& Host, uint16_t Port);
+	static bool IsSessionHealthy(Poco::Net::HTTPSClientSession& Session);
+
+	void PurgeExpiredSessions(HostEntry& Entry, Clock::time_point Now, std::vector<SessionPtr>& OutDiscardedSessions);
+
+	Poco::Net::Context::Ptr Context;
+
+	size_t MaxSessionsPerHost;
+	std::chrono::milliseconds IdleTimeout;
+
+	std::unordered_map<std::string, HostEntry> Hosts;
+	Stats PoolStats;
+
+	mutable std::mutex Mutex;
+};
+
+} // namespace csp::web
@@ -16,6 +16,7 @@
 #include "POCOWebClient.h"
 
 #include "Debug/Logging.h"
+#include "Web/HttpResponseSink.h"
 
 #include <Poco/File.h>
 #include <Poco/MD5Engine.h>
@@ -25,6 +26,8 @@
 #include <Poco/Net/HTMLForm.h>
 #include <Poco/Net/HTTPRequest.h>
 #include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/NetException.h>
+#include <Poco/Net/SSLException.h>
 #include <Poco/Net/SSLManager.h>
 #include <Poco/Net/StringPartSource.h>
 #include <Poco/StreamCopier.h>
@@ -45,21 +48,44 @@ template <size_t N> constexpr size_t CStringLength(char const (&)[N])
 	return N - 1;
 }
 
+// Errors seen when the server has closed a connection before any of the response arrived
+bool IsClosedConnectionError(const Poco::Exception& Ex)
+{
+	return dynamic_cast<const Poco::Net::NoMessageException*>(&Ex) != nullptr
+		   || dynamic_cast<const Poco::Net::ConnectionResetException*>(&Ex) != nullptr
+		   || dynamic_cast<const Poco::Net::ConnectionAbortedException*>(&Ex) != nullptr
+		   || dynamic_cast<const Poco::Net::SSLConnectionUnexpectedlyClosedException*>(&Ex) != nullptr;
+}
+
 } // namespace
 
 
 namespace csp::web
 {
 
-/// @brief Size of stack space used for async streaming upload and download
+/// @brief Size of stack space used for async streaming upload, and for draining unread response bodies
 const uint32_t kPOCOAsyncBufferSize = 2 * 1024;
 
+/// @brief Largest amount of a response body read at once. Bodies are read straight into their destination, so this only sets how often
+/// progress is reported and cancellation is checked while downloading.
+const size_t kPOCOResponseReadSize = 256 * 1024;
+
+/// @brief Largest unread response body we will read through in order to return a connection to the session pool
+const std::streamsize kPOCOMaxDrainSize = 64 * 1024;
+
+/// @brief Maximum number of idle keep-alive connections kept open per host
+const size_t kPOCOMaxSessionsPerHost = 8;
+
+/// @brief How long an idle keep-alive connection is kept open before it is closed
+const std::chrono::milliseconds kPOCOSessionIdleTimeout = std::chrono::milliseconds(30000);
+
 EResponseCodes GetOlyResponseCode(Poco::Net::HTTPResponse::HTTPStatus PocoResponseCode)
 {
 	return (EResponseCodes) PocoResponseCode;
 }
 
-POCOWebClient::POCOWebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh) : WebClient(InPort, Tp, AutoRefresh)
+POCOWebClient::POCOWebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh, uint32_t MaxConcurrentRequests)
+	: WebClient(InPort, Tp, AutoRefresh, MaxConcurrentRequests)
 {
 	Poco::Net::initializeSSL();
 
@@ -69,14 +95,20 @@ POCOWebClient::POCOWebClient(const Port InPort, const ETransferProtocol Tp, bool
 	PocoContext
 		= Poco::makeAuto<Poco::Net::Context>(Poco::Net::Context::CLIENT_USE, "", Poco::Net::Context::VerificationMode::VERIFY_RELAXED, 9, true);
 
+	// Allow new connections to resume a previously negotiated TLS session rather than performing a full handshake
+	PocoContext->enableSessionCache(true);
+
 	// TODO: Get rid of singleton usage entirely. Until then, we can't create multiple instances of Connected Spaces Platform.
 	Poco::Net::SSLManager::instance().initializeClient(PrivateKeyHandler, CertHandler, PocoContext);
 
+	SessionPool = new POCOSessionPool(PocoContext, kPOCOMaxSessionsPerHost, kPOCOSessionIdleTimeout);
+
 	Cookies = new std::remove_pointer_t<decltype(Cookies)>();
 }
 
 POCOWebClient::~POCOWebClient()
 {
+	delete SessionPool;
 	delete Cookies;
 }
 
@@ -119,7 +151,6 @@ void POCOWebClient::Get(HttpRequest& Request)
 
 	Poco::URI Uri(Request.GetUri().GetAsStdString());
 
-	Poco::Net::HTTPSClientSession ClientSession(Uri.getHost(), Uri.getPort(), PocoContext);
 	Poco::Net::HTTPRequest PocoRequest(Poco::Net::HTTPRequest::HTTP_GET, Uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
 
 	for (auto Header : Request.GetPayload().GetHeaders())
@@ -129,10 +160,9 @@ void POCOWebClient::Get(HttpRequest& Request)
 
 	AddCookie(PocoRequest);
 
-	ClientSession.sendRequest(PocoRequest);
-
+	POCOSessionPool::SessionPtr ClientSession;
 	Poco::Net::HTTPResponse PocoResponse;
-	std::istream& ResponseStream = ClientSession.receiveResponse(PocoResponse);
+	std::istream& ResponseStream = *SendReceive(ClientSession, Uri, PocoRequest, PocoResponse, nullptr);
 	Request.SetResponseCode(GetOlyResponseCode(PocoResponse.getStatus()));
 
 	{
@@ -141,10 +171,13 @@ void POCOWebClient::Get(HttpRequest& Request)
 		PocoResponse.getCookies(*Cookies);
 	}
 
-	if (PocoResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
+	// Partial content is the response to a range request
+	if (PocoResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK || PocoResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_PARTIAL_CONTENT)
 	{
-		ProcessResponseAsync(ClientSession, PocoResponse, ResponseStream, Request);
+		ProcessResponseAsync(*ClientSession, PocoResponse, ResponseStream, Request);
 	}
+
+	ReleaseSession(std::move(ClientSession), PocoResponse, ResponseStream);
 }
 
 void POCOWebClient::AddCookie(Poco::Net::HTTPRequest& PocoRequest)
@@ -181,7 +214,6 @@ void POCOWebClient::Post(HttpRequest& Request)
 
 	Poco::URI Uri(Request.GetUri().GetAsStdString());
 
-	Poco::Net::HTTPSClientSession ClientSession(Uri.getHost(), Uri.getPort(), PocoContext);
 	Poco::Net::HTTPRequest PocoRequest(Poco::Net::HTTPRequest::HTTP_POST, Uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
 
 	for (auto Header : Request.GetPayload().GetHeaders())
@@ -193,16 +225,24 @@ void POCOWebClient::Post(HttpRequest& Request)
 
 	size_t ContentLength = Request.GetPayload().GetContent().Length();
 	PocoRequest.setContentLength(ContentLength);
-	std::ostream& RequestStream = ClientSession.sendRequest(PocoRequest);
-	ProcessRequestAsync(ClientSession, PocoRequest, RequestStream, Request);
 
-	if (Request.Cancelled())
+	auto WriteBody = [this, &PocoRequest, &Request](Poco::Net::HTTPClientSession& ClientSession, std::ostream& RequestStream)
+	{
+		ProcessRequestAsync(ClientSession, PocoRequest, RequestStream, Request);
+
+		return !Request.Cancelled();
+	};
+
+	POCOSessionPool::SessionPtr ClientSession;
+	Poco::Net::HTTPResponse PocoResponse;
+	std::istream* ResponseStreamPtr = SendReceive(ClientSession, Uri, PocoRequest, PocoResponse, WriteBody);
+
+	if (ResponseStreamPtr == nullptr)
 	{
 		return;
 	}
 
-	Poco::Net::HTTPResponse PocoResponse;
-	std::istream& ResponseStream = ClientSession.receiveResponse(PocoResponse);
+	std::istream& ResponseStream = *ResponseStreamPtr;
 	Request.SetResponseCode(GetOlyResponseCode(PocoResponse.getStatus()));
 
 	{
@@ -230,16 +270,23 @@ void POCOWebClient::Post(HttpRequest& Request)
 					   {
 						   return std::tolower(c);
 					   });
-		std::transform(Val.begin(),
-					   Val.end(),
-					   Val.begin(),
-					   [](unsigned char c)
-					   {
-						   return std::tolower(c);
-					   });
+
+		// Cache validators are sent back to the server in conditional requests, so must be kept exactly as they were received
+		if (Key != "etag" && Key != "last-modified")
+		{
+			std::transform(Val.begin(),
+						   Val.end(),
+						   Val.begin(),
+						   [](unsigned char c)
+						   {
+							   return std::tolower(c);
+						   });
+		}
 
 		Payload.AddHeader(Key.c_str(), Val.c_str());
 	}
+
+	ReleaseSession(std::move(ClientSession), PocoResponse, ResponseStream);
 }
 
 void POCOWebClient::Put(HttpRequest& Request)
@@ -248,7 +295,6 @@ void POCOWebClient::Put(HttpRequest& Request)
 
 	Poco::URI Uri(Request.GetUri().GetAsStdString());
 
-	Poco::Net::HTTPSClientSession ClientSession(Uri.getHost(), Uri.getPort(), PocoContext);
 	Poco::Net::HTTPRequest PocoRequest(Poco::Net::HTTPRequest::HTTP_PUT, Uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
 
 	for (auto Header : Request.GetPayload().GetHeaders())
@@ -260,16 +306,24 @@ void POCOWebClient::Put(HttpRequest& Request)
 
 	size_t ContentLength = Request.GetPayload().GetContent().Length();
 	PocoRequest.setContentLength(ContentLength);
-	std::ostream& RequestStream = ClientSession.sendRequest(PocoRequest);
-	ProcessRequestAsync(ClientSession, PocoRequest, RequestStream, Request);
 
-	if (Request.Cancelled())
+	auto WriteBody = [this, &PocoRequest, &Request](Poco::Net::HTTPClientSession& ClientSession, std::ostream& RequestStream)
+	{
+		ProcessRequestAsync(ClientSession, PocoRequest, RequestStream, Request);
+
+		return !Request.Cancelled();
+	};
+
+	POCOSessionPool::SessionPtr ClientSession;
+	Poco::Net::HTTPResponse PocoResponse;
+	std::istream* ResponseStreamPtr = SendReceive(ClientSession, Uri, PocoRequest, PocoResponse, WriteBody);
+
+	if (ResponseStreamPtr == nullptr)
 	{
 		return;
 	}
 
-	Poco::Net::HTTPResponse PocoResponse;
-	std::istream& ResponseStream = ClientSession.receiveResponse(PocoResponse);
+	std::istream& ResponseStream = *ResponseStreamPtr;
 	Request.SetResponseCode(GetOlyResponseCode(PocoResponse.getStatus()));
 
 	{
@@ -284,6 +338,8 @@ void POCOWebClient::Put(HttpRequest& Request)
 		Poco::StreamCopier::copyToString(ResponseStream, ResponseString);
 		Request.SetResponseData(ResponseString.c_str(), ResponseString.length());
 	}
+
+	ReleaseSession(std::move(ClientSession), PocoResponse, ResponseStream);
 }
 
 void POCOWebClient::Delete(HttpRequest& Request)
@@ -292,7 +348,6 @@ void POCOWebClient::Delete(HttpRequest& Request)
 
 	Poco::URI Uri(Request.GetUri().GetAsStdString());
 
-	Poco::Net::HTTPSClientSession ClientSession(Uri.getHost(), Uri.getPort(), PocoContext);
 	Poco::Net::HTTPRequest PocoRequest(Poco::Net::HTTPRequest::HTTP_DELETE, Uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
 
 	for (auto Header : Request.GetPayload().GetHeaders())
@@ -304,10 +359,17 @@ void POCOWebClient::Delete(HttpRequest& Request)
 
 	const std::string Body(Request.GetPayload().GetContent().c_str());
 	PocoRequest.setContentLength(Body.length());
-	ClientSession.sendRequest(PocoRequest) << Body;
 
+	auto WriteBody = [&Body](Poco::Net::HTTPClientSession& /*ClientSession*/, std::ostream& RequestStream)
+	{
+		RequestStream << Body;
+
+		return true;
+	};
+
+	POCOSessionPool::SessionPtr ClientSession;
 	Poco::Net::HTTPResponse PocoResponse;
-	std::istream& ResponseStream = ClientSession.receiveResponse(PocoResponse);
+	std::istream& ResponseStream = *SendReceive(ClientSession, Uri, PocoRequest, PocoResponse, WriteBody);
 	Request.SetResponseCode(GetOlyResponseCode(PocoResponse.getStatus()));
 
 	{
@@ -322,6 +384,8 @@ void POCOWebClient::Delete(HttpRequest& Request)
 		Poco::StreamCopier::copyToString(ResponseStream, ResponseString);
 		Request.SetResponseData(ResponseString.c_str(), ResponseString.length());
 	}
+
+	ReleaseSession(std::move(ClientSession), PocoResponse, ResponseStream);
 }
 
 void POCOWebClient::Head(HttpRequest& Request)
@@ -330,7 +394,6 @@ void POCOWebClient::Head(HttpRequest& Request)
 
 	Poco::URI Uri(Request.GetUri().GetAsStdString());
 
-	Poco::Net::HTTPSClientSession ClientSession(Uri.getHost(), Uri.getPort(), PocoContext);
 	Poco::Net::HTTPRequest PocoRequest(Poco::Net::HTTPRequest::HTTP_HEAD, Uri.getPathAndQuery(), Poco::Net::HTTPRequest::HTTP_1_1);
 
 	for (auto Header : Request.GetPayload().GetHeaders())
@@ -340,10 +403,9 @@ void POCOWebClient::Head(HttpRequest& Request)
 
 	AddCookie(PocoRequest);
 
-	ClientSession.sendRequest(PocoRequest);
-
+	POCOSessionPool::SessionPtr ClientSession;
 	Poco::Net::HTTPResponse PocoResponse;
-	std::istream& ResponseStream = ClientSession.receiveResponse(PocoResponse);
+	std::istream& ResponseStream = *SendReceive(ClientSession, Uri, PocoRequest, PocoResponse, nullptr);
 	Request.SetResponseCode(GetOlyResponseCode(PocoResponse.getStatus()));
 
 	{
@@ -354,46 +416,69 @@ void POCOWebClient::Head(HttpRequest& Request)
 
 	if (PocoResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
 	{
-		ProcessResponseAsync(ClientSession, PocoResponse, ResponseStream, Request);
+		ProcessResponseAsync(*ClientSession, PocoResponse, ResponseStream, Request);
 	}
+
+	ReleaseSession(std::move(ClientSession), PocoResponse, ResponseStream);
 }
 
-void POCOWebClient::ProcessResponseAsync(Poco::Net::HTTPClientSession& ClientSession,
+std::istream* POCOWebClient::SendReceive(POCOSessionPool::SessionPtr& ClientSession,
+										 const Poco::URI& Uri,
+										 Poco::Net::HTTPRequest& PocoRequest,
 										 Poco::Net::HTTPResponse& PocoResponse,
-										 std::istream& ResponseStream,
-										 HttpRequest& Request)
+										 const RequestBodyWriter& WriteBody)
 {
-	CSP_PROFILE_SCOPED();
+	bool IsReused = false;
+	ClientSession = SessionPool->Acquire(Uri.getHost(), Uri.getPort(), &IsReused);
 
-	std::streamsize ContentLength = PocoResponse.getContentLength();
+	// Only requests the server can safely apply twice may be replayed once the request has gone out, as a closed connection
+	// seen while waiting for the response doesn't tell us whether the server already acted on it
+	const std::string& Method = PocoRequest.getMethod();
+	const bool IsIdempotent	  = Method == Poco::Net::HTTPRequest::HTTP_GET || Method == Poco::Net::HTTPRequest::HTTP_HEAD
+							  || Method == Poco::Net::HTTPRequest::HTTP_DELETE;
 
-	if (ContentLength == Poco::Net::HTTPMessage::UNKNOWN_CONTENT_LENGTH || ContentLength == 0)
+	while (true)
 	{
-		return;
-	}
+		bool IsRequestSent = false;
 
-	std::streamsize TotalRead = 0;
+		try
+		{
+			std::ostream& RequestStream = ClientSession->sendRequest(PocoRequest);
+			IsRequestSent				= true;
 
-	Request.AllocateResponseData(ContentLength);
+			if (WriteBody && !WriteBody(*ClientSession, RequestStream))
+			{
+				return nullptr;
+			}
 
-	char Buffer[kPOCOAsyncBufferSize];
-
-	while (ResponseStream.good() && TotalRead < ContentLength)
-	{
-		if (Request.Cancelled())
+			return &ClientSession->receiveResponse(PocoResponse);
+		}
+		catch (const Poco::Exception& Ex)
 		{
-			ClientSession.abort();
-			return;
+			// The server may close a keep-alive connection while it sits idle in the pool, which we only find out about when the next
+			// request fails. If the request can't have reached the server, or is safe to repeat, it is sent once more on a new connection.
+			if (!IsReused || !IsClosedConnectionError(Ex) || (IsRequestSent && !IsIdempotent))
+			{
+				throw;
+			}
+
+			IsReused = false;
+			ClientSession = SessionPool->Create(Uri.getHost(), Uri.getPort());
 		}
+	}
+}
 
-		ResponseStream.read(Buffer, sizeof(Buffer));
-		std::streamsize Read = ResponseStream.gcount();
-		Request.WriteResponseData(TotalRead, Buffer, Read);
+void POCOWebClient::ProcessResponseAsync(Poco::Net::HTTPClientSession& ClientSession,
+										 Poco::Net::HTTPResponse& PocoResponse,
+										 std::istream& ResponseStream,
+										 HttpRequest& Request)
+{
+	CSP_PROFILE_SCOPED();
 
-		TotalRead += Read;
-		float Progress = 100.0f * static_cast<float>(TotalRead) / ContentLength;
-		// RWD_FORMATTED_LOG("Response Progress %f %d %d\n", Progress, TotalRead, ContentLength);
-		Request.SetResponseProgress(Progress);
+	// HEAD responses carry the Content-Length of the body a GET would return, but no body
+	if (Request.GetVerb() != ERequestVerb::HEAD && !ReadResponseBody(ClientSession, PocoResponse, ResponseStream, Request))
+	{
+		return;
 	}
 
 	auto& Response = Request.GetResponse();
@@ -413,18 +498,117 @@ void POCOWebClient::ProcessResponseAsync(Poco::Net::HTTPClientSession& ClientSes
 					   {
 						   return std::tolower(c);
 					   });
-		std::transform(Val.begin(),
-					   Val.end(),
-					   Val.begin(),
-					   [](unsigned char c)
-					   {
-						   return std::tolower(c);
-					   });
+
+		// Cache validators are sent back to the server in conditional requests, so must be kept exactly as they were received
+		if (Key != "etag" && Key != "last-modified")
+		{
+			std::transform(Val.begin(),
+						   Val.end(),
+						   Val.begin(),
+						   [](unsigned char c)
+						   {
+							   return std::tolower(c);
+						   });
+		}
 
 		Payload.AddHeader(Key.c_str(), Val.c_str());
 	}
 }
 
+bool POCOWebClient::ReadResponseBody(Poco::Net::HTTPClientSession& ClientSession,
+									 Poco::Net::HTTPResponse& PocoResponse,
+									 std::istream& ResponseStream,
+									 HttpRequest& Request)
+{
+	const std::streamsize ContentLength = PocoResponse.getContentLength();
+	const bool IsLengthKnown = (ContentLength != Poco::Net::HTTPMessage::UNKNOWN_CONTENT_LENGTH);
+
+	// The body is read straight into the memory the sink hands us, so a sink backed by the body's final destination receives it
+	// without it being copied
+	IHttpResponseSink* CallbackSink = (Request.GetCallback() != nullptr) ? Request.GetCallback()->GetResponseSink() : nullptr;
+	PayloadResponseSink PayloadSink(Request.GetMutableResponse().GetMutablePayload());
+	IHttpResponseSink& Sink = (CallbackSink != nullptr) ? *CallbackSink : PayloadSink;
+
+	if (!Sink.Begin(IsLengthKnown ? static_cast<size_t>(ContentLength) : IHttpResponseSink::UnknownLength))
+	{
+		Sink.End(false);
+		Request.SetResponseCode(EResponseCodes::ResponseRequestEntityTooLarge);
+
+		return true;
+	}
+
+	size_t TotalRead = 0;
+
+	try
+	{
+		while (ResponseStream.good() && (!IsLengthKnown || TotalRead < static_cast<size_t>(ContentLength)))
+		{
+			if (Request.Cancelled())
+			{
+				Sink.End(false);
+				ClientSession.abort();
+
+				Request.SetResponseCode(EResponseCodes::ResponseRequestTimeout);
+				Request.EnableAutoRetry(false);
+
+				return false;
+			}
+
+			size_t ReadLength = IsLengthKnown ? std::min(kPOCOResponseReadSize, static_cast<size_t>(ContentLength) - TotalRead)
+											  : kPOCOResponseReadSize;
+			char* Buffer	  = Sink.GetWriteBuffer(TotalRead, ReadLength);
+
+			if (Buffer == nullptr || ReadLength == 0)
+			{
+				// The rest of the body is left unread, so the connection won't be returned to the pool
+				Sink.End(false);
+				Request.SetResponseCode(EResponseCodes::ResponseRequestEntityTooLarge);
+
+				return true;
+			}
+
+			ResponseStream.read(Buffer, static_cast<std::streamsize>(ReadLength));
+			const size_t Read = static_cast<size_t>(ResponseStream.gcount());
+
+			if (Read > 0)
+			{
+				Sink.OnWritten(TotalRead, Read);
+				TotalRead += Read;
+			}
+
+			if (IsLengthKnown)
+			{
+				Request.SetResponseProgress(100.0f * static_cast<float>(TotalRead) / ContentLength);
+			}
+		}
+	}
+	catch (...)
+	{
+		Sink.End(false);
+
+		throw;
+	}
+
+	if (IsLengthKnown && TotalRead < static_cast<size_t>(ContentLength))
+	{
+		// The connection closed part way through the body. This is treated as a timeout so that the request is retried.
+		Sink.End(false);
+		Request.SetResponseCode(EResponseCodes::ResponseRequestTimeout);
+
+		return true;
+	}
+
+	Sink.End(true);
+
+	// An empty body is still passed through the sink, so that an empty file or buffer is the result, but isn't read in the loop above
+	if (!IsLengthKnown || ContentLength == 0)
+	{
+		Request.SetResponseProgress(100.0f);
+	}
+
+	return true;
+}
+
 void POCOWebClient::ProcessRequestAsync(Poco::Net::HTTPClientSession& ClientSession,
 										Poco::Net::HTTPRequest& PocoRequest,
 										std::ostream& RequestStream,
@@ -462,6 +646,30 @@ void POCOWebClient::ProcessRequestAsync(Poco::Net::HTTPClientSession& ClientSess
 	}
 }
 
+void POCOWebClient::ReleaseSession(POCOSessionPool::SessionPtr ClientSession, Poco::Net::HTTPResponse& PocoResponse, std::istream& ResponseStream)
+{
+	// A connection can only be reused once the previous response has been read in full. Small bodies we didn't consume (e.g. error
+	// responses) are drained, but it's cheaper to reconnect than to read through a large body we're not interested in.
+	if (!PocoResponse.getKeepAlive())
+	{
+		return;
+	}
+
+	char Buffer[kPOCOAsyncBufferSize];
+	std::streamsize TotalDrained = 0;
+
+	while (ResponseStream.good() && TotalDrained < kPOCOMaxDrainSize)
+	{
+		ResponseStream.read(Buffer, sizeof(Buffer));
+		TotalDrained += ResponseStream.gcount();
+	}
+
+	if (ResponseStream.eof())
+	{
+		SessionPool->Release(std::move(ClientSession));
+	}
+}
+
 std::string POCOWebClient::MD5Hash(const void* Data, const size_t Size)
 {
 	Poco::MD5Engine MD5Hasher;
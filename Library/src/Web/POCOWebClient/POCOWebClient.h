@@ -15,12 +15,15 @@
  */
 #pragma once
 
+#include "Web/POCOWebClient/POCOSessionPool.h"
 #include "Web/WebClient.h"
 
 #include <Poco/Net/HTTPCookie.h>
 #include <Poco/Net/HTTPSClientSession.h>
 #include <Poco/Net/PartSource.h>
 #include <Poco/Net/PrivateKeyPassphraseHandler.h>
+#include <Poco/URI.h>
+#include <functional>
 
 
 namespace csp::systems
@@ -80,7 +83,10 @@ public:
 
 protected:
 	// Instances of POCOWebClient should not be created. You should instead rely on the instance that `csp::systems::SystemsManager` holds.
-	POCOWebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh = true);
+	POCOWebClient(const Port InPort,
+				  const ETransferProtocol Tp,
+				  bool AutoRefresh				 = true,
+				  uint32_t MaxConcurrentRequests = CSP_MAX_CONCURRENT_REQUESTS);
 
 	void SetFileUploadContent(HttpPayload* Payload, Poco::Net::PartSource* Source, const char* Version);
 
@@ -93,16 +99,33 @@ protected:
 	void Delete(HttpRequest& Request);
 	void Head(HttpRequest& Request);
 
+	// Writes a request body. Returns false if the request was cancelled while doing so.
+	using RequestBodyWriter = std::function<bool(Poco::Net::HTTPClientSession& ClientSession, std::ostream& RequestStream)>;
+
+	// Sends a request on a pooled session, or a new one, and reads the response headers. Returns nullptr if the request was cancelled.
+	std::istream* SendReceive(POCOSessionPool::SessionPtr& ClientSession,
+							  const Poco::URI& Uri,
+							  Poco::Net::HTTPRequest& PocoRequest,
+							  Poco::Net::HTTPResponse& PocoResponse,
+							  const RequestBodyWriter& WriteBody);
+
 	void ProcessResponseAsync(Poco::Net::HTTPClientSession& ClientSession,
 							  Poco::Net::HTTPResponse& PocoResponse,
 							  std::istream& ResponseStream,
 							  HttpRequest& Request);
+	// Returns false if the request was cancelled while the body was being read
+	bool ReadResponseBody(Poco::Net::HTTPClientSession& ClientSession,
+						  Poco::Net::HTTPResponse& PocoResponse,
+						  std::istream& ResponseStream,
+						  HttpRequest& Request);
 	void ProcessRequestAsync(Poco::Net::HTTPClientSession& ClientSession,
 							 Poco::Net::HTTPRequest& PocoResponse,
 							 std::ostream& RequestStream,
 							 HttpRequest& Request);
+	void ReleaseSession(POCOSessionPool::SessionPtr ClientSession, Poco::Net::HTTPResponse& PocoResponse, std::istream& ResponseStream);
 
 	Poco::Net::Context::Ptr PocoContext;
+	POCOSessionPool* SessionPool;
 
 	std::vector<Poco::Net::HTTPCookie>* Cookies;
 	std::mutex CookiesMutex;
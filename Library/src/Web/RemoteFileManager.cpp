@@ -15,10 +15,824 @@
  */
 #include "Web/RemoteFileManager.h"
 
+#include "Memory/Memory.h"
 #include "Web/HttpAuth.h"
 #include "Web/HttpPayload.h"
+#include "Web/HttpResponseSink.h"
 #include "Web/WebClient.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+
+void SendGetRequest(csp::web::WebClient* WebClient,
+					const csp::common::String& FileUrl,
+					csp::web::IHttpResponseHandler* ResponseHandler,
+					csp::common::CancellationToken& CancellationToken,
+					const csp::FileCache::Validators* Validators)
+{
+	csp::web::Uri GetUri(FileUrl);
+
+	csp::web::HttpPayload Payload;
+	Payload.AddHeader(CSP_TEXT("Content-Type"), CSP_TEXT("text/json"));
+
+	if (Validators != nullptr)
+	{
+		if (!Validators->ETag.empty())
+		{
+			Payload.AddHeader(CSP_TEXT("If-None-Match"), Validators->ETag.c_str());
+		}
+
+		if (!Validators->LastModified.empty())
+		{
+			Payload.AddHeader(CSP_TEXT("If-Modified-Since"), Validators->LastModified.c_str());
+		}
+	}
+
+	WebClient->SendRequest(csp::web::ERequestVerb::GET, GetUri, Payload, ResponseHandler, CancellationToken);
+}
+
+
+/// @brief Sits between a file request and the caller's response handler to serve files from, and store them in, the file cache, and
+/// to give the web client the sink the file should be written to.
+/// A 304 Not Modified response to a conditional request is turned into a 200 OK carrying the cached file, or with the cached file
+/// written to the sink, so the caller's handler doesn't need to know whether the file was cached. Either the cache or the sink may be null.
+class FileResponseHandler : public csp::web::IHttpResponseHandler
+{
+public:
+	FileResponseHandler(csp::web::WebClient* InWebClient,
+						const std::shared_ptr<csp::FileCache>& InCache,
+						const std::shared_ptr<csp::web::IHttpResponseSink>& InSink,
+						const csp::common::String& InFileUrl,
+						csp::services::ResponseHandlerPtr InResponseHandler,
+						csp::common::CancellationToken& InCancellationToken)
+		: WebClient(InWebClient)
+		, Cache(InCache)
+		, Sink(InSink)
+		, FileUrl(InFileUrl)
+		, ResponseHandler(InResponseHandler)
+		, CancellationToken(&InCancellationToken)
+	{
+	}
+
+	~FileResponseHandler() override
+	{
+		if (ResponseHandler != nullptr && ResponseHandler->ShouldDelete())
+		{
+			CSP_DELETE(ResponseHandler);
+		}
+	}
+
+	void OnHttpProgress(csp::web::HttpRequest& Request) override
+	{
+		ResponseHandler->OnHttpProgress(Request);
+	}
+
+	void OnHttpResponse(csp::web::HttpResponse& Response) override
+	{
+		if (Cache == nullptr)
+		{
+			ResponseHandler->OnHttpResponse(Response);
+
+			return;
+		}
+
+		const std::string Key = FileUrl.c_str();
+
+		if (Response.GetResponseCode() == csp::web::EResponseCodes::ResponseNotModified)
+		{
+			auto& Payload	= Response.GetMutablePayload();
+			bool SinkFailed = false;
+
+			const bool Found = Cache->Read(Key,
+										   [this, &Payload, &SinkFailed](const char* Data, size_t Size)
+										   {
+											   if (Sink != nullptr)
+											   {
+												   SinkFailed = !csp::web::WriteToResponseSink(*Sink, Data, Size);
+											   }
+											   else
+											   {
+												   Payload.SetContent(Data, Size);
+											   }
+										   });
+
+			if (!Found)
+			{
+				// The cached file was evicted or lost while we were revalidating it, so download it again in full.
+				// The caller's handler moves to the new request.
+				auto* RetryHandler = CSP_NEW FileResponseHandler(WebClient, Cache, Sink, FileUrl, ResponseHandler, *CancellationToken);
+				ResponseHandler	   = nullptr;
+
+				SendGetRequest(WebClient, FileUrl, RetryHandler, *CancellationToken, nullptr);
+
+				return;
+			}
+
+			Response.SetResponseCode(SinkFailed ? csp::web::EResponseCodes::ResponseRequestEntityTooLarge : csp::web::EResponseCodes::ResponseOK);
+		}
+		else if (Response.GetResponseCode() == csp::web::EResponseCodes::ResponseOK)
+		{
+			if (Sink == nullptr)
+			{
+				StoreResponse(Key, Response);
+			}
+			else
+			{
+				// The file went straight to the sink, so there's nothing to store, and the cached copy (if any) is out of date
+				Cache->Remove(Key);
+			}
+		}
+
+		ResponseHandler->OnHttpResponse(Response);
+	}
+
+	bool ShouldDelete() const override
+	{
+		return true;
+	}
+
+	csp::web::IHttpResponseSink* GetResponseSink() override
+	{
+		return Sink.get();
+	}
+
+private:
+	void StoreResponse(const std::string& Key, const csp::web::HttpResponse& Response)
+	{
+		const auto& Headers = Response.GetPayload().GetHeaders();
+
+		const auto CacheControl = Headers.find("cache-control");
+
+		if (CacheControl != Headers.end() && CacheControl->second.find("no-store") != csp::StlString::npos)
+		{
+			Cache->Remove(Key);
+
+			return;
+		}
+
+		csp::FileCache::Validators Validators;
+
+		if (const auto ETag = Headers.find("etag"); ETag != Headers.end())
+		{
+			Validators.ETag = ETag->second.c_str();
+		}
+
+		if (const auto LastModified = Headers.find("last-modified"); LastModified != Headers.end())
+		{
+			Validators.LastModified = LastModified->second.c_str();
+		}
+
+		// Without a validator we'd have no way of knowing whether the cached file is still current
+		if (Validators.ETag.empty() && Validators.LastModified.empty())
+		{
+			Cache->Remove(Key);
+
+			return;
+		}
+
+		const auto& Content = Response.GetPayload().GetContent();
+
+		Cache->Store(Key, WebClient->MD5Hash(Content.c_str(), Content.Length()), Content.c_str(), Content.Length(), Validators);
+	}
+
+	csp::web::WebClient* WebClient;
+	std::shared_ptr<csp::FileCache> Cache;
+	std::shared_ptr<csp::web::IHttpResponseSink> Sink;
+	csp::common::String FileUrl;
+	csp::services::ResponseHandlerPtr ResponseHandler;
+	csp::common::CancellationToken* CancellationToken;
+};
+
+void GetFileWithCache(csp::web::WebClient* WebClient,
+					  const std::shared_ptr<csp::FileCache>& FileCache,
+					  const csp::common::String& FileUrl,
+					  const std::shared_ptr<csp::web::IHttpResponseSink>& Sink,
+					  csp::services::ResponseHandlerPtr ResponseHandler,
+					  csp::common::CancellationToken& CancellationToken)
+{
+	if (FileCache == nullptr && Sink == nullptr)
+	{
+		SendGetRequest(WebClient, FileUrl, ResponseHandler, CancellationToken, nullptr);
+
+		return;
+	}
+
+	csp::FileCache::Validators Validators;
+	const bool IsCached = (FileCache != nullptr) && FileCache->GetValidators(FileUrl.c_str(), Validators);
+
+	auto* FileHandler = CSP_NEW FileResponseHandler(WebClient, FileCache, Sink, FileUrl, ResponseHandler, CancellationToken);
+
+	SendGetRequest(WebClient, FileUrl, FileHandler, CancellationToken, IsCached ? &Validators : nullptr);
+}
+
+
+/// @brief State shared by the requests making up a ranged download.
+/// Once the file's size is known, the whole file is requested from the sink as one block of memory, and each range is read straight
+/// into its place in that block. At most MaxParallelRanges are in flight at once, and the next range is requested as each one completes.
+/// A range that fails is requested again on its own. The caller's handler is given progress across the whole file, and a single
+/// response once every range has arrived, or once the download has failed and no ranges are still being written.
+/// Ranges are requested with If-Range, so that a file replaced during the download is sent whole instead. Any response that isn't the
+/// range asked for means the ranges already received can't be used, so the download is restarted as a single request.
+class RangedDownload : public std::enable_shared_from_this<RangedDownload>
+{
+public:
+	RangedDownload(csp::web::WebClient* InWebClient,
+				   const std::shared_ptr<csp::FileCache>& InFileCache,
+				   const csp::common::String& InFileUrl,
+				   const std::shared_ptr<csp::web::IHttpResponseSink>& InSink,
+				   const csp::web::RangedDownloadOptions& InOptions,
+				   csp::services::ResponseHandlerPtr InResponseHandler,
+				   csp::common::CancellationToken& InCancellationToken)
+		: WebClient(InWebClient)
+		, FileCache(InFileCache)
+		, FileUrl(InFileUrl)
+		, Sink(InSink)
+		, Options(InOptions)
+		, ResponseHandler(InResponseHandler)
+		, CancellationToken(&InCancellationToken)
+	{
+	}
+
+	~RangedDownload()
+	{
+		if (ResponseHandler != nullptr && ResponseHandler->ShouldDelete())
+		{
+			CSP_DELETE(ResponseHandler);
+		}
+	}
+
+	/// @brief Starts the download once the file's headers have been read.
+	void Start(const csp::web::HttpResponse& HeadResponse);
+
+	void OnRangeProgress(size_t Index, size_t Received, csp::web::HttpRequest& Request);
+	void OnRangeResponse(size_t Index, uint32_t Attempt, const csp::web::HttpResponse& RangeResponse, size_t Received);
+
+	const csp::common::String& GetFileUrl() const
+	{
+		return FileUrl;
+	}
+
+private:
+	struct Range
+	{
+		size_t Index;
+		uint32_t Attempt;
+	};
+
+	// Downloads the file with a single request instead, handing the caller's handler over to it
+	void FallBackToGetFile();
+	void SendRanges(const std::vector<Range>& Ranges);
+
+	// Expects Mutex to be held. Returns true for the one caller that should then call Finish.
+	bool MarkFinished();
+
+	// Expects Mutex not to be held, so that the caller's handler can start other requests from its response
+	void Finish();
+
+	size_t GetRangeStart(size_t Index) const
+	{
+		return Index * Options.RangeSize;
+	}
+
+	size_t GetRangeLength(size_t Index) const
+	{
+		return std::min(Options.RangeSize, FileSize - GetRangeStart(Index));
+	}
+
+	// True if the response is the range at Index of the file whose headers we read, rather than the whole file or another version of it
+	bool IsRequestedRange(const csp::web::HttpResponse& RangeResponse, size_t Index) const;
+
+	csp::web::WebClient* WebClient;
+	std::shared_ptr<csp::FileCache> FileCache;
+	csp::common::String FileUrl;
+	std::shared_ptr<csp::web::IHttpResponseSink> Sink;
+	csp::web::RangedDownloadOptions Options;
+	csp::services::ResponseHandlerPtr ResponseHandler;
+	csp::common::CancellationToken* CancellationToken;
+
+	// Used when the caller didn't give a sink, so that the file is collected in the response payload
+	std::unique_ptr<csp::web::PayloadResponseSink> PayloadSink;
+	csp::web::IHttpResponseSink* Target = nullptr;
+	csp::web::HttpResponse Response;
+
+	char* Destination = nullptr;
+	size_t FileSize	  = 0;
+	// ETag, or failing that Last-Modified, of the file whose headers we read
+	csp::common::String IfRange;
+
+	// Guards everything below, and progress calls to the caller's handler, which isn't expected to be called from several threads at
+	// once. Its final response is given without the lock, once Finished is set and no more progress can be passed on.
+	std::mutex Mutex;
+	size_t NumRanges	 = 0;
+	size_t NextRange	 = 0;
+	size_t NumInFlight	 = 0;
+	size_t TotalReceived = 0;
+	std::vector<size_t> RangeReceived;
+	// Highest progress passed on so far, so that it doesn't go backwards when a range is retried
+	float Progress = 0.0f;
+	// Stays ResponseOK unless the download fails
+	csp::web::EResponseCodes ResultCode = csp::web::EResponseCodes::ResponseOK;
+	// Set when a range comes back as something else, so the file is downloaded again with a single request once no ranges are in flight
+	bool Restart  = false;
+	bool Finished = false;
+};
+
+
+/// @brief Handles one range of a ranged download, reading it straight into its place in the download's block of memory.
+class RangeResponseHandler : public csp::web::IHttpResponseHandler
+{
+public:
+	RangeResponseHandler(const std::shared_ptr<RangedDownload>& InDownload, size_t InIndex, uint32_t InAttempt, char* Destination, size_t Length)
+		: Download(InDownload), Index(InIndex), Attempt(InAttempt), Sink(Destination, Length)
+	{
+	}
+
+	void OnHttpProgress(csp::web::HttpRequest& Request) override
+	{
+		Download->OnRangeProgress(Index, Sink.GetSize(), Request);
+	}
+
+	void OnHttpResponse(csp::web::HttpResponse& Response) override
+	{
+		Download->OnRangeResponse(Index, Attempt, Response, Sink.GetSize());
+	}
+
+	bool ShouldDelete() const override
+	{
+		return true;
+	}
+
+	csp::web::IHttpResponseSink* GetResponseSink() override
+	{
+		return &Sink;
+	}
+
+private:
+	std::shared_ptr<RangedDownload> Download;
+	size_t Index;
+	uint32_t Attempt;
+	csp::web::BufferResponseSink Sink;
+};
+
+
+/// @brief Reads the file's size from a HEAD request and starts the ranged download.
+class RangedDownloadHeadHandler : public csp::web::IHttpResponseHandler
+{
+public:
+	explicit RangedDownloadHeadHandler(const std::shared_ptr<RangedDownload>& InDownload) : Download(InDownload)
+	{
+	}
+
+	void OnHttpResponse(csp::web::HttpResponse& Response) override
+	{
+		Download->Start(Response);
+	}
+
+	bool ShouldDelete() const override
+	{
+		return true;
+	}
+
+private:
+	std::shared_ptr<RangedDownload> Download;
+};
+
+
+void RangedDownload::Start(const csp::web::HttpResponse& HeadResponse)
+{
+	const auto& Headers		 = HeadResponse.GetPayload().GetHeaders();
+	const auto AcceptRanges	 = Headers.find("accept-ranges");
+	const auto ContentLength = Headers.find("content-length");
+
+	const bool CanRequestRanges = HeadResponse.GetResponseCode() == csp::web::EResponseCodes::ResponseOK && AcceptRanges != Headers.end()
+								  && AcceptRanges->second.find("bytes") != csp::StlString::npos && ContentLength != Headers.end();
+
+	FileSize = CanRequestRanges ? static_cast<size_t>(std::strtoull(ContentLength->second.c_str(), nullptr, 10)) : 0;
+
+	if (FileSize == 0 || FileSize < Options.MinRangedSize || Options.RangeSize == 0 || FileSize <= Options.RangeSize)
+	{
+		FallBackToGetFile();
+
+		return;
+	}
+
+	if (Sink == nullptr)
+	{
+		PayloadSink = std::make_unique<csp::web::PayloadResponseSink>(Response.GetMutablePayload());
+	}
+
+	Target = (Sink != nullptr) ? Sink.get() : PayloadSink.get();
+
+	if (!Target->Begin(FileSize))
+	{
+		Target->End(false);
+
+		bool ShouldFinish = false;
+
+		{
+			std::scoped_lock Lock(Mutex);
+			ResultCode	 = csp::web::EResponseCodes::ResponseRequestEntityTooLarge;
+			ShouldFinish = MarkFinished();
+		}
+
+		if (ShouldFinish)
+		{
+			Finish();
+		}
+
+		return;
+	}
+
+	size_t Available = FileSize;
+	Destination		 = Target->GetWriteBuffer(0, Available);
+
+	if (Destination == nullptr || Available < FileSize)
+	{
+		// This sink can only take the file in order, a piece at a time
+		Target->End(false);
+		FallBackToGetFile();
+
+		return;
+	}
+
+	// The ranges aren't stored in the file cache, so a copy cached since the download started may not match the file being downloaded
+	if (FileCache != nullptr)
+	{
+		FileCache->Remove(FileUrl.c_str());
+	}
+
+	// Keep the validators and other headers the caller would have seen from a single request
+	for (const auto& Header : Headers)
+	{
+		Response.GetMutablePayload().AddHeader(Header.first.c_str(), Header.second.c_str());
+	}
+
+	// If-Range only accepts a strong ETag
+	const auto ETag			= Headers.find("etag");
+	const auto LastModified = Headers.find("last-modified");
+
+	if (ETag != Headers.end() && ETag->second.rfind("W/", 0) != 0)
+	{
+		IfRange = ETag->second.c_str();
+	}
+	else if (LastModified != Headers.end())
+	{
+		IfRange = LastModified->second.c_str();
+	}
+
+	std::vector<Range> ToSend;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		NumRanges = (FileSize + Options.RangeSize - 1) / Options.RangeSize;
+		RangeReceived.resize(NumRanges, 0);
+
+		while (NextRange < NumRanges && NumInFlight < std::max<uint32_t>(Options.MaxParallelRanges, 1))
+		{
+			ToSend.push_back({NextRange++, 0});
+			++NumInFlight;
+		}
+	}
+
+	SendRanges(ToSend);
+}
+
+void RangedDownload::OnRangeProgress(size_t Index, size_t Received, csp::web::HttpRequest& Request)
+{
+	std::scoped_lock Lock(Mutex);
+
+	if (Finished || ResponseHandler == nullptr)
+	{
+		return;
+	}
+
+	TotalReceived += Received - RangeReceived[Index];
+	RangeReceived[Index] = Received;
+
+	// The range's own progress is replaced with that of the whole file before it's passed on
+	Progress = std::max(Progress, 100.0f * static_cast<float>(TotalReceived) / FileSize);
+	Request.GetMutableResponse().GetProgress().SetProgressPercentage(Progress);
+	ResponseHandler->OnHttpProgress(Request);
+}
+
+bool RangedDownload::IsRequestedRange(const csp::web::HttpResponse& RangeResponse, size_t Index) const
+{
+	if (RangeResponse.GetResponseCode() != csp::web::EResponseCodes::ResponsePartialContent)
+	{
+		return false;
+	}
+
+	const auto& Headers		= RangeResponse.GetPayload().GetHeaders();
+	const auto ContentRange = Headers.find("content-range");
+
+	const std::string Expected = "bytes " + std::to_string(GetRangeStart(Index)) + "-"
+								 + std::to_string(GetRangeStart(Index) + GetRangeLength(Index) - 1) + "/" + std::to_string(FileSize);
+
+	return ContentRange != Headers.end() && Expected == ContentRange->second.c_str();
+}
+
+void RangedDownload::OnRangeResponse(size_t Index, uint32_t Attempt, const csp::web::HttpResponse& RangeResponse, size_t Received)
+{
+	const csp::web::EResponseCodes ResponseCode = RangeResponse.GetResponseCode();
+
+	std::vector<Range> ToSend;
+	bool ShouldFinish = false;
+
+	{
+		std::scoped_lock Lock(Mutex);
+
+		--NumInFlight;
+
+		const bool IsRange	 = IsRequestedRange(RangeResponse, Index);
+		const bool Succeeded = IsRange && Received == GetRangeLength(Index);
+
+		if (Succeeded)
+		{
+			TotalReceived += Received - RangeReceived[Index];
+			RangeReceived[Index] = Received;
+		}
+		else if (CancellationToken->Cancelled())
+		{
+			ResultCode = ResponseCode;
+		}
+		else if (!IsRange
+				 && (ResponseCode == csp::web::EResponseCodes::ResponseOK || ResponseCode == csp::web::EResponseCodes::ResponsePartialContent
+					 || ResponseCode == csp::web::EResponseCodes::ResponseRequestEntityTooLarge))
+		{
+			// The server answered with the whole file, which is too large for the range's place and so shows up as too large, or with a
+			// different part of it. Either the file has changed since we read its headers or the server ignored the range.
+			Restart = true;
+		}
+		else if (ResultCode == csp::web::EResponseCodes::ResponseOK && !Restart && Attempt < Options.MaxRangeRetries)
+		{
+			TotalReceived -= RangeReceived[Index];
+			RangeReceived[Index] = 0;
+
+			ToSend.push_back({Index, Attempt + 1});
+			++NumInFlight;
+		}
+		else if (ResultCode == csp::web::EResponseCodes::ResponseOK && !Restart)
+		{
+			// The range kept arriving cut short
+			ResultCode = (ResponseCode == csp::web::EResponseCodes::ResponsePartialContent) ? csp::web::EResponseCodes::ResponseRequestTimeout
+																						   : ResponseCode;
+		}
+
+		// Nothing more is requested once the download has failed or is to be restarted, but it can't finish while other ranges are still
+		// being written
+		while (ResultCode == csp::web::EResponseCodes::ResponseOK && !Restart && NextRange < NumRanges
+			   && NumInFlight < std::max<uint32_t>(Options.MaxParallelRanges, 1))
+		{
+			ToSend.push_back({NextRange++, 0});
+			++NumInFlight;
+		}
+
+		ShouldFinish = (NumInFlight == 0) && MarkFinished();
+	}
+
+	if (ShouldFinish)
+	{
+		Finish();
+
+		return;
+	}
+
+	SendRanges(ToSend);
+}
+
+void RangedDownload::FallBackToGetFile()
+{
+	auto* Handler	= ResponseHandler;
+	ResponseHandler = nullptr;
+
+	GetFileWithCache(WebClient, FileCache, FileUrl, Sink, Handler, *CancellationToken);
+}
+
+void RangedDownload::SendRanges(const std::vector<Range>& Ranges)
+{
+	for (const Range& ToSend : Ranges)
+	{
+		const size_t Start = GetRangeStart(ToSend.Index);
+		const size_t End   = Start + GetRangeLength(ToSend.Index) - 1;
+
+		csp::web::HttpPayload Payload;
+		Payload.AddHeader(CSP_TEXT("Range"), csp::common::String(("bytes=" + std::to_string(Start) + "-" + std::to_string(End)).c_str()));
+
+		if (!IfRange.IsEmpty())
+		{
+			Payload.AddHeader(CSP_TEXT("If-Range"), IfRange);
+		}
+
+		auto* Handler
+			= CSP_NEW RangeResponseHandler(shared_from_this(), ToSend.Index, ToSend.Attempt, Destination + Start, GetRangeLength(ToSend.Index));
+
+		WebClient->SendRequest(csp::web::ERequestVerb::GET, csp::web::Uri(FileUrl), Payload, Handler, *CancellationToken);
+	}
+}
+
+bool RangedDownload::MarkFinished()
+{
+	if (Finished)
+	{
+		return false;
+	}
+
+	Finished = true;
+
+	return true;
+}
+
+void RangedDownload::Finish()
+{
+	if (Restart && ResultCode == csp::web::EResponseCodes::ResponseOK)
+	{
+		Target->End(false);
+		FallBackToGetFile();
+
+		return;
+	}
+
+	if (Target != nullptr && ResultCode == csp::web::EResponseCodes::ResponseOK)
+	{
+		Target->OnWritten(0, FileSize);
+		Target->End(true);
+	}
+	else if (Target != nullptr && Destination != nullptr)
+	{
+		Target->End(false);
+	}
+
+	Response.SetResponseCode(ResultCode);
+	Response.GetProgress().SetProgressPercentage(100.0f);
+
+	if (ResponseHandler != nullptr)
+	{
+		ResponseHandler->OnHttpResponse(Response);
+	}
+}
+
+
+/// @brief State shared by the requests making up a batch download.
+/// Requests for the same URL are grouped so that the file is only downloaded once. Groups are requested in priority order, taking the
+/// highest priority of any of their requests, with at most MaxInFlight in flight at once.
+class BatchDownload : public std::enable_shared_from_this<BatchDownload>
+{
+public:
+	BatchDownload(csp::web::WebClient* InWebClient,
+				  const std::shared_ptr<csp::FileCache>& InFileCache,
+				  const std::vector<csp::web::BatchFileRequest>& Requests,
+				  uint32_t InMaxInFlight,
+				  csp::common::CancellationToken& InCancellationToken);
+
+	void SendNext();
+	void OnGroupResponse();
+
+private:
+	struct Group
+	{
+		csp::common::String FileUrl;
+		int32_t Priority;
+		std::vector<csp::services::ResponseHandlerPtr> ResponseHandlers;
+	};
+
+	csp::web::WebClient* WebClient;
+	std::shared_ptr<csp::FileCache> FileCache;
+	uint32_t MaxInFlight;
+	csp::common::CancellationToken* CancellationToken;
+
+	std::mutex Mutex;
+	std::vector<Group> Groups;
+	size_t NextGroup   = 0;
+	size_t NumInFlight = 0;
+	// Set while a call to SendNext is sending requests
+	bool IsSending = false;
+};
+
+
+/// @brief Passes the response for one file of a batch download on to every handler that asked for it.
+class BatchFileResponseHandler : public csp::services::ApiResponseHandlerBase
+{
+public:
+	BatchFileResponseHandler(const std::shared_ptr<BatchDownload>& InDownload, std::vector<csp::services::ResponseHandlerPtr>&& InResponseHandlers)
+		: Download(InDownload), ResponseHandlers(std::move(InResponseHandlers))
+	{
+	}
+
+	~BatchFileResponseHandler() override
+	{
+		for (auto* ResponseHandler : ResponseHandlers)
+		{
+			if (ResponseHandler->ShouldDelete())
+			{
+				CSP_DELETE(ResponseHandler);
+			}
+		}
+	}
+
+	void OnHttpProgress(csp::web::HttpRequest& Request) override
+	{
+		for (auto* ResponseHandler : ResponseHandlers)
+		{
+			ResponseHandler->OnHttpProgress(Request);
+		}
+	}
+
+	void OnHttpResponse(csp::web::HttpResponse& Response) override
+	{
+		for (auto* ResponseHandler : ResponseHandlers)
+		{
+			ResponseHandler->OnHttpResponse(Response);
+		}
+
+		Download->OnGroupResponse();
+	}
+
+private:
+	std::shared_ptr<BatchDownload> Download;
+	std::vector<csp::services::ResponseHandlerPtr> ResponseHandlers;
+};
+
+
+BatchDownload::BatchDownload(csp::web::WebClient* InWebClient,
+							 const std::shared_ptr<csp::FileCache>& InFileCache,
+							 const std::vector<csp::web::BatchFileRequest>& Requests,
+							 uint32_t InMaxInFlight,
+							 csp::common::CancellationToken& InCancellationToken)
+	: WebClient(InWebClient), FileCache(InFileCache), MaxInFlight(std::max<uint32_t>(InMaxInFlight, 1)), CancellationToken(&InCancellationToken)
+{
+	std::unordered_map<std::string, size_t> GroupIndices;
+
+	for (const auto& Request : Requests)
+	{
+		const auto Inserted = GroupIndices.try_emplace(Request.FileUrl.c_str(), Groups.size());
+
+		if (Inserted.second)
+		{
+			Groups.push_back({Request.FileUrl, Request.Priority, {}});
+		}
+
+		Group& FileGroup = Groups[Inserted.first->second];
+		FileGroup.Priority = std::max(FileGroup.Priority, Request.Priority);
+		FileGroup.ResponseHandlers.push_back(Request.ResponseHandler);
+	}
+
+	std::stable_sort(Groups.begin(),
+					 Groups.end(),
+					 [](const Group& A, const Group& B)
+					 {
+						 return A.Priority > B.Priority;
+					 });
+}
+
+void BatchDownload::SendNext()
+{
+	std::unique_lock Lock(Mutex);
+
+	// A cancelled request may be answered before SendRequest returns, calling back in here. Rather than sending the next request from
+	// inside the last one, which would nest once per file, it leaves the free slot to the call that is already sending.
+	if (IsSending)
+	{
+		return;
+	}
+
+	IsSending = true;
+
+	while (NextGroup < Groups.size() && NumInFlight < MaxInFlight)
+	{
+		Group& Next						  = Groups[NextGroup++];
+		const csp::common::String FileUrl = Next.FileUrl;
+		auto* Handler					  = CSP_NEW BatchFileResponseHandler(shared_from_this(), std::move(Next.ResponseHandlers));
+		++NumInFlight;
+
+		// Requests are sent outside the lock, so that responses to other requests can free their slots in the meantime
+		Lock.unlock();
+		GetFileWithCache(WebClient, FileCache, FileUrl, nullptr, Handler, *CancellationToken);
+		Lock.lock();
+	}
+
+	IsSending = false;
+}
+
+void BatchDownload::OnGroupResponse()
+{
+	{
+		std::scoped_lock Lock(Mutex);
+		--NumInFlight;
+	}
+
+	SendNext();
+}
+
+} // namespace
+
 
 namespace csp::web
 {
@@ -35,12 +849,53 @@ void RemoteFileManager::GetFile(const csp::common::String& FileUrl,
 								csp::services::ResponseHandlerPtr ResponseHandler,
 								csp::common::CancellationToken& CancellationToken)
 {
-	csp::web::Uri GetUri(FileUrl);
+	GetFile(FileUrl, nullptr, ResponseHandler, CancellationToken);
+}
+
+void RemoteFileManager::GetFile(const csp::common::String& FileUrl,
+								const std::shared_ptr<IHttpResponseSink>& Sink,
+								csp::services::ResponseHandlerPtr ResponseHandler,
+								csp::common::CancellationToken& CancellationToken)
+{
+	GetFileWithCache(WebClient, GetFileCache(), FileUrl, Sink, ResponseHandler, CancellationToken);
+}
+
+void RemoteFileManager::GetFileInRanges(const csp::common::String& FileUrl,
+										const std::shared_ptr<IHttpResponseSink>& Sink,
+										const RangedDownloadOptions& Options,
+										csp::services::ResponseHandlerPtr ResponseHandler,
+										csp::common::CancellationToken& CancellationToken)
+{
+	const auto FileCache = GetFileCache();
+
+	// The file's size is only read when it might be downloaded in ranges. A cached file is revalidated with a single conditional
+	// request instead, and a sink too small for a ranged download can only take a file that is requested in one go.
+	csp::FileCache::Validators Validators;
+	const bool IsCached	   = (FileCache != nullptr) && FileCache->GetValidators(FileUrl.c_str(), Validators);
+	const bool IsSinkSmall = (Sink != nullptr) && Sink->GetCapacity() < Options.MinRangedSize;
+
+	if (IsCached || IsSinkSmall)
+	{
+		GetFileWithCache(WebClient, FileCache, FileUrl, Sink, ResponseHandler, CancellationToken);
+
+		return;
+	}
+
+	auto Download = std::make_shared<RangedDownload>(WebClient, FileCache, FileUrl, Sink, Options, ResponseHandler, CancellationToken);
 
 	csp::web::HttpPayload Payload;
-	Payload.AddHeader(CSP_TEXT("Content-Type"), CSP_TEXT("text/json"));
+	WebClient->SendRequest(csp::web::ERequestVerb::HEAD, csp::web::Uri(FileUrl), Payload, CSP_NEW RangedDownloadHeadHandler(Download), CancellationToken);
+}
 
-	WebClient->SendRequest(csp::web::ERequestVerb::GET, GetUri, Payload, ResponseHandler, CancellationToken);
+void RemoteFileManager::GetFileBatch(const std::vector<BatchFileRequest>& Requests, uint32_t MaxInFlight, csp::common::CancellationToken& CancellationToken)
+{
+	if (Requests.empty())
+	{
+		return;
+	}
+
+	auto Download = std::make_shared<BatchDownload>(WebClient, GetFileCache(), Requests, MaxInFlight, CancellationToken);
+	Download->SendNext();
 }
 
 void RemoteFileManager::GetResponseHeaders(const csp::common::String& Url, csp::services::ResponseHandlerPtr ResponseHandler)
@@ -51,4 +906,32 @@ void RemoteFileManager::GetResponseHeaders(const csp::common::String& Url, csp::
 	WebClient->SendRequest(csp::web::ERequestVerb::HEAD, GetUri, Payload, ResponseHandler, csp::common::CancellationToken::Dummy());
 }
 
+bool RemoteFileManager::EnableFileCache(const csp::FilePath& Directory, uint64_t MaxSize)
+{
+	auto NewCache = std::make_shared<csp::FileCache>(Directory, MaxSize);
+
+	if (!NewCache->IsValid())
+	{
+		return false;
+	}
+
+	std::scoped_lock Lock(CacheMutex);
+	Cache = std::move(NewCache);
+
+	return true;
+}
+
+void RemoteFileManager::DisableFileCache()
+{
+	std::scoped_lock Lock(CacheMutex);
+	Cache.reset();
+}
+
+std::shared_ptr<csp::FileCache> RemoteFileManager::GetFileCache() const
+{
+	std::scoped_lock Lock(CacheMutex);
+
+	return Cache;
+}
+
 } // namespace csp::web
@@ -18,25 +18,95 @@
 #include "CSP/Common/CancellationToken.h"
 #include "Common/DateTime.h"
 #include "Services/PrototypeService/AssetFileDto.h"
+#include "Storage/FileCache.h"
 #include "Web/WebClient.h"
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 
 namespace csp::web
 {
 
+class IHttpResponseSink;
+
+struct RangedDownloadOptions
+{
+	// Files smaller than this are downloaded with a single request
+	size_t MinRangedSize = 8 * 1024 * 1024;
+	size_t RangeSize	 = 4 * 1024 * 1024;
+	// Further ranges are requested as earlier ones complete
+	uint32_t MaxParallelRanges = 4;
+	// Number of times a failed range is requested again before the download fails
+	uint32_t MaxRangeRetries = 3;
+};
+
+/// @brief One file of a batch download.
+struct BatchFileRequest
+{
+	csp::common::String FileUrl;
+	// Files with a higher priority are requested first, and files with the same priority in the order given
+	int32_t Priority = 0;
+	csp::services::ResponseHandlerPtr ResponseHandler = nullptr;
+};
+
 class RemoteFileManager
 {
 public:
 	RemoteFileManager(csp::web::WebClient* InWebClient);
 	~RemoteFileManager();
 
+	/// @brief Downloads a file. If a file cache is enabled and already holds the file, it is revalidated with a conditional request and,
+	/// if unchanged, the cached copy is returned in the response rather than being downloaded again.
+	void GetFile(const csp::common::String& FileUrl,
+				 csp::services::ResponseHandlerPtr ResponseHandler,
+				 csp::common::CancellationToken& CancellationToken);
+
+	/// @brief Downloads a file, writing it to Sink as it is received rather than to the response payload, which is left empty.
+	/// If the file is served from the file cache, the cached copy is written to the sink. Files written to a sink aren't added to the cache.
 	void GetFile(const csp::common::String& FileUrl,
+				 const std::shared_ptr<IHttpResponseSink>& Sink,
 				 csp::services::ResponseHandlerPtr ResponseHandler,
 				 csp::common::CancellationToken& CancellationToken);
+
+	/// @brief Downloads a file as several byte ranges requested in parallel, each written straight into its place in Sink.
+	/// The file's size is read with a HEAD request first. Small files, files from servers that don't accept range requests, and sinks
+	/// that can't take the whole file as one block of memory are downloaded with GetFile instead. A range that fails is retried on its
+	/// own. The response handler is given progress across the whole file, and a single response once it has all arrived.
+	/// Ranges are requested with If-Range. If the file changes during the download, or the server answers with anything other than the
+	/// range asked for, the download starts again as a single GetFile request.
+	/// Files already in the file cache, and sinks with a capacity below MinRangedSize, go straight to GetFile without the HEAD request.
+	/// Ranged downloads aren't stored in the file cache, and remove any copy of the file that it holds.
+	/// @param Sink Where to write the file. If null, the file is collected in the response payload.
+	void GetFileInRanges(const csp::common::String& FileUrl,
+						 const std::shared_ptr<IHttpResponseSink>& Sink,
+						 const RangedDownloadOptions& Options,
+						 csp::services::ResponseHandlerPtr ResponseHandler,
+						 csp::common::CancellationToken& CancellationToken);
+
+	/// @brief Downloads a batch of files with GetFile, keeping at most MaxInFlight requests in flight and requesting the next file, in
+	/// priority order, as each one completes. Files with the same URL are downloaded once, and the response is given to each of their
+	/// handlers. Each handler is given its own response as soon as its file arrives.
+	void GetFileBatch(const std::vector<BatchFileRequest>& Requests, uint32_t MaxInFlight, csp::common::CancellationToken& CancellationToken);
+
 	void GetResponseHeaders(const csp::common::String& Url, csp::services::ResponseHandlerPtr ResponseHandler);
 
+	/// @brief Starts caching downloaded files in Directory, replacing any cache that was previously enabled.
+	/// @return False if the directory can't be used.
+	bool EnableFileCache(const csp::FilePath& Directory, uint64_t MaxSize);
+	void DisableFileCache();
+
+	/// @brief Returns the current file cache, or null if caching isn't enabled.
+	std::shared_ptr<csp::FileCache> GetFileCache() const;
+
 private:
 	csp::web::WebClient* WebClient;
+
+	// Shared with in-flight requests, so that the cache outlives any responses still being stored when it is disabled
+	std::shared_ptr<csp::FileCache> Cache;
+	mutable std::mutex CacheMutex;
 };
 
 } // namespace csp::web
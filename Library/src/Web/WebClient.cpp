@@ -30,7 +30,27 @@ using namespace std::chrono_literals;
 namespace csp::web
 {
 
-WebClient::WebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh)
+#ifndef CSP_WASM
+namespace
+{
+
+csp::ETaskPriority GetTaskPriority(ERequestPriority Priority)
+{
+	switch (Priority)
+	{
+		case ERequestPriority::High:
+			return csp::ETaskPriority::High;
+		case ERequestPriority::Low:
+			return csp::ETaskPriority::Low;
+		default:
+			return csp::ETaskPriority::Normal;
+	}
+}
+
+} // namespace
+#endif
+
+WebClient::WebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh, uint32_t MaxConcurrentRequests)
 	: RootPort(InPort)
 	, LoginState(nullptr)
 	, UserSystem(nullptr)
@@ -39,7 +59,7 @@ WebClient::WebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRef
 	, AutoRefreshEnabled(AutoRefresh)
 #ifndef CSP_WASM
 	, RequestCount(0)
-	, ThreadPool(CSP_MAX_CONCURRENT_REQUESTS)
+	, Executor(MaxConcurrentRequests)
 #endif
 {
 }
@@ -101,7 +121,7 @@ WebClient::~WebClient()
 
 	PollRequests.Close();
 
-	ThreadPool.Shutdown();
+	Executor.Shutdown();
 #endif
 }
 
@@ -167,9 +187,11 @@ void WebClient::SendRequest(ERequestVerb Verb,
 							HttpPayload& Payload,
 							IHttpResponseHandler* ResponseCallback,
 							csp::common::CancellationToken& CancellationToken,
-							bool AsyncResponse)
+							bool AsyncResponse,
+							ERequestPriority Priority)
 {
 	auto* Request = CSP_NEW csp::web::HttpRequest(this, Verb, InUri, Payload, ResponseCallback, CancellationToken, AsyncResponse);
+	Request->SetPriority(Priority);
 
 #ifdef CSP_WASM
 	RefreshIfExpired();
@@ -221,26 +243,28 @@ void WebClient::AddRequest(HttpRequest* Request, std::chrono::milliseconds SendD
 
 		++RequestCount;
 		Request->IncRefCount();
-		Request->SetSendDelay(SendDelay);
-		ThreadPool.Enqueue(
-			[this, Request](void*)
+
+		auto Work = [this, Request](void*)
+		{
+			while (RefreshStarted)
 			{
-				while (RefreshStarted)
-				{
-					std::this_thread::sleep_for(10ns);
-				}
+				std::this_thread::sleep_for(10ns);
+			}
 
-				if (RefreshNeeded && !RefreshStarted)
-				{
-					RefreshStarted = true;
-				}
+			if (RefreshNeeded && !RefreshStarted)
+			{
+				RefreshStarted = true;
+			}
 
-				Request->RefreshAccessToken();
+			Request->RefreshAccessToken();
+
+			ProcessRequest(Request);
 
-				ProcessRequest(Request);
+			return nullptr;
+		};
 
-				return nullptr;
-			});
+		// Delayed sends (e.g. for Retries) wait on the executor's timer rather than holding up a worker
+		Executor.EnqueueAfter(SendDelay, std::move(Work), GetTaskPriority(Request->GetPriority()));
 #endif
 	}
 }
@@ -278,14 +302,6 @@ void WebClient::ProcessRequest(HttpRequest* Request)
 		auto& Payload = Request->GetMutablePayload();
 		Payload.SetBearerToken();
 
-		const std::chrono::milliseconds SendDelay = Request->GetSendDelay();
-
-		if (SendDelay > std::chrono::milliseconds(0))
-		{
-			// Wait before sending if required (e.g. for Retries)
-			std::this_thread::sleep_for(SendDelay);
-		}
-
 		try
 		{
 			if (!Request->Cancelled())
@@ -23,7 +23,7 @@
 #include "Uri.h"
 
 #ifndef CSP_WASM
-	#include "Common/ThreadPool.h"
+	#include "Common/WorkStealingExecutor.h"
 #endif
 
 #include <atomic>
@@ -56,7 +56,7 @@ namespace csp::web
 		@details    Abstracts web requests and their responses from underlying platform implementation
  */
 
-/// Maximum concurrent requests supported by the Web Request system
+/// Default number of requests the Web Request system will send concurrently
 constexpr int CSP_MAX_CONCURRENT_REQUESTS = 4;
 
 using Port = uint32_t;
@@ -81,7 +81,8 @@ class WebClient
 	friend class csp::systems::SystemsManager;
 
 public:
-	WebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh = true);
+	/// @param MaxConcurrentRequests Number of worker threads sending requests. Requests beyond this are queued by priority.
+	WebClient(const Port InPort, const ETransferProtocol Tp, bool AutoRefresh = true, uint32_t MaxConcurrentRequests = CSP_MAX_CONCURRENT_REQUESTS);
 	virtual ~WebClient();
 
 	/// @brief Main method for sending a Http Request
@@ -90,12 +91,14 @@ public:
 	/// @param Payload Headers and body content
 	/// @param ResponseCallback Pointer to callback for the response
 	/// @param AsyncResponse Flag to indicate if the response should be issued asynchronously as soon as it's received
+	/// @param Priority Queued requests with a higher priority are sent first
 	void SendRequest(ERequestVerb Verb,
 					 const csp::web::Uri& InUri,
 					 HttpPayload& Payload,
 					 IHttpResponseHandler* ResponseCallback,
 					 csp::common::CancellationToken& CancellationToken,
-					 bool AsyncResponse = true);
+					 bool AsyncResponse		  = true,
+					 ERequestPriority Priority = ERequestPriority::Normal);
 
 #ifndef CSP_WASM
 	/// @brief Manually poll for responses that have been flagged as non-async
@@ -145,7 +148,7 @@ private:
 	void DestroyRequest(HttpRequest* Request);
 
 	std::atomic_uint32_t RequestCount;
-	csp::ThreadPool ThreadPool;
+	csp::WorkStealingExecutor Executor;
 	csp::Queue<HttpRequest*> PollRequests;
 	std::unordered_set<HttpRequest*> Requests;
 	std::mutex RequestsMutex;
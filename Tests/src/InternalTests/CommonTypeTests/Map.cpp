@@ -19,9 +19,11 @@
 	#include "CSP/Common/Map.h"
 
 	#include "CSP/Common/Optional.h"
+	#include "CSP/Multiplayer/ReplicatedValue.h"
 	#include "TestHelpers.h"
 
 	#include <gtest/gtest.h>
+	#include <map>
 	#include <Memory/Memory.h>
 
 using namespace csp::common;
@@ -234,4 +236,232 @@ CSP_INTERNAL_TEST(CSPEngine, CommonMapTests, MapClearTest)
 	EXPECT_EQ(MyMap.Size(), 0);
 }
 
+// Test case to check that moving a map takes its elements rather than copying them
+CSP_INTERNAL_TEST(CSPEngine, CommonMapTests, MapMoveTakesElementsTest)
+{
+	Map<int, String> OldMap = {{1, "A string long enough to be stored on the heap"}, {2, "Two"}};
+	const char* OldText		= OldMap[1].c_str();
+
+	Map<int, String> MyMap(std::move(OldMap));
+
+	EXPECT_EQ(OldMap.Size(), 0);
+	EXPECT_EQ(MyMap.Size(), 2);
+	EXPECT_EQ(MyMap[1].c_str(), OldText);
+
+	Map<int, String> OtherMap = {{3, "Three"}};
+	OtherMap				  = std::move(MyMap);
+
+	EXPECT_EQ(MyMap.Size(), 0);
+	EXPECT_EQ(OtherMap.Size(), 2);
+	EXPECT_FALSE(OtherMap.HasKey(3));
+	EXPECT_EQ(OtherMap[1].c_str(), OldText);
+
+	// Maps with other keys are stored differently, but should move in the same way
+	Map<String, String> OldStringMap = {{"One", "A string long enough to be stored on the heap"}};
+	OldText							 = OldStringMap["One"].c_str();
+
+	Map<String, String> StringMap(std::move(OldStringMap));
+
+	EXPECT_EQ(OldStringMap.Size(), 0);
+	EXPECT_EQ(StringMap["One"].c_str(), OldText);
+
+	// A moved from map is still usable
+	OldMap[4] = "Four";
+
+	EXPECT_EQ(OldMap.Size(), 1);
+	EXPECT_EQ(OldMap[4], "Four");
+}
+
+// Test case to check that maps with integer keys keep their elements in key order, and don't move them while other elements change
+CSP_INTERNAL_TEST(CSPEngine, CommonMapTests, MapIntegerKeyStorageTest)
+{
+	Map<uint16_t, String> MyMap;
+	MyMap[30] = "Thirty";
+	MyMap[10] = "Ten";
+	MyMap[20] = "Twenty";
+
+	const String& Twenty = MyMap[20];
+
+	for (uint16_t i = 100; i < 200; ++i)
+	{
+		MyMap[i] = "Hundreds";
+	}
+
+	MyMap.Remove(10);
+	MyMap.Remove(150);
+	MyMap.Remove(999);
+
+	EXPECT_EQ(&MyMap[20], &Twenty);
+	EXPECT_EQ(Twenty, "Twenty");
+	EXPECT_EQ(MyMap.Size(), 101);
+
+	const Map<uint16_t, String>& ConstMap = MyMap;
+
+	EXPECT_EQ(ConstMap[30], "Thirty");
+	EXPECT_THROW(ConstMap[10], std::runtime_error);
+
+	auto* Keys = ConstMap.Keys();
+
+	EXPECT_EQ((*Keys)[0], 20);
+	EXPECT_EQ((*Keys)[1], 30);
+
+	for (size_t i = 1; i < Keys->Size(); ++i)
+	{
+		EXPECT_LT((*Keys)[i - 1], (*Keys)[i]);
+	}
+
+	CSP_DELETE(const_cast<Array<uint16_t>*>(Keys));
+
+	// Copies are deep
+	Map<uint16_t, String> Copy(MyMap);
+	Copy[20] = "Changed";
+
+	EXPECT_EQ(MyMap[20], "Twenty");
+	EXPECT_NE(&Copy[30], &MyMap[30]);
+}
+
+namespace
+{
+
+using csp::multiplayer::ReplicatedValue;
+
+using PropertyMap	 = Map<uint32_t, ReplicatedValue>;
+using StdPropertyMap = std::map<uint32_t, ReplicatedValue>;
+
+constexpr int NumBenchmarkProperties = 20;
+constexpr int NumBenchmarkRepeats	 = 100000;
+
+ReplicatedValue MakeBenchmarkProperty(uint32_t Key)
+{
+	switch (Key % 4)
+	{
+		case 0:
+			return ReplicatedValue(static_cast<int64_t>(Key));
+		case 1:
+			return ReplicatedValue(static_cast<float>(Key));
+		case 2:
+			return ReplicatedValue(Key % 8 == 2);
+		default:
+			return ReplicatedValue(csp::common::Vector3 {1.0f, 2.0f, static_cast<float>(Key)});
+	}
+}
+
+// The ways ComponentBase reads its property maps, for both kinds of map being compared
+bool HasProperty(const PropertyMap& Properties, uint32_t Key)
+{
+	return Properties.HasKey(Key);
+}
+
+bool HasProperty(const StdPropertyMap& Properties, uint32_t Key)
+{
+	return Properties.count(Key) > 0;
+}
+
+const ReplicatedValue& GetProperty(const PropertyMap& Properties, uint32_t Key)
+{
+	return Properties[Key];
+}
+
+const ReplicatedValue& GetProperty(const StdPropertyMap& Properties, uint32_t Key)
+{
+	return Properties.at(Key);
+}
+
+template <typename TFunc> void ForEachProperty(const PropertyMap& Properties, TFunc Func)
+{
+	auto* Keys = Properties.Keys();
+
+	for (size_t i = 0; i < Keys->Size(); ++i)
+	{
+		Func((*Keys)[i], Properties[(*Keys)[i]]);
+	}
+
+	CSP_DELETE(const_cast<Array<uint32_t>*>(Keys));
+}
+
+template <typename TFunc> void ForEachProperty(const StdPropertyMap& Properties, TFunc Func)
+{
+	for (const auto& Pair : Properties)
+	{
+		Func(Pair.first, Pair.second);
+	}
+}
+
+void ClearProperties(PropertyMap& Properties)
+{
+	Properties.Clear();
+}
+
+void ClearProperties(StdPropertyMap& Properties)
+{
+	Properties.clear();
+}
+
+// Gets, sets and iterates the properties of a component in the same way as ComponentBase, adding what it sees to OutChecksum
+template <typename TMap> void AccessComponentProperties(TMap& Properties, int64_t& OutChecksum)
+{
+	TMap DirtyProperties;
+
+	for (int Repeat = 0; Repeat < NumBenchmarkRepeats; ++Repeat)
+	{
+		const uint32_t Key = Repeat % NumBenchmarkProperties;
+
+		// ComponentBase::GetProperty
+		if (HasProperty(Properties, Key))
+		{
+			OutChecksum += static_cast<int64_t>(GetProperty(Properties, Key).GetReplicatedValueType());
+		}
+
+		// ComponentBase::SetProperty, with a new value every other time
+		const ReplicatedValue Value = (Repeat % 2 == 0) ? MakeBenchmarkProperty(Key + Repeat) : GetProperty(Properties, Key);
+
+		if (HasProperty(Properties, Key) && Value.GetReplicatedValueType() != GetProperty(Properties, Key).GetReplicatedValueType())
+		{
+			++OutChecksum;
+		}
+
+		if (Properties[Key] != Value)
+		{
+			Properties[Key]		 = Value;
+			DirtyProperties[Key] = Value;
+		}
+
+		// Serialising the dirty properties once per frame
+		if (Repeat % NumBenchmarkProperties == NumBenchmarkProperties - 1)
+		{
+			ForEachProperty(DirtyProperties,
+							[&OutChecksum](uint32_t PropertyKey, const ReplicatedValue& PropertyValue)
+							{
+								OutChecksum += PropertyKey + static_cast<int64_t>(PropertyValue.GetReplicatedValueType());
+							});
+
+			ClearProperties(DirtyProperties);
+		}
+	}
+}
+
+} // namespace
+
+// The property access patterns used by ComponentBase, compared with the same patterns on a std::map
+CSP_INTERNAL_TEST(CSPEngine, CommonMapTests, MapComponentPropertyAccessTest)
+{
+	PropertyMap Properties;
+	StdPropertyMap StdProperties;
+
+	for (uint32_t Key = 0; Key < NumBenchmarkProperties; ++Key)
+	{
+		Properties[Key]	   = MakeBenchmarkProperty(Key);
+		StdProperties[Key] = MakeBenchmarkProperty(Key);
+	}
+
+	int64_t Checksum	= 0;
+	int64_t StdChecksum = 0;
+
+	AccessComponentProperties(Properties, Checksum);
+	AccessComponentProperties(StdProperties, StdChecksum);
+
+	EXPECT_EQ(Checksum, StdChecksum);
+	EXPECT_EQ(Properties.Size(), NumBenchmarkProperties);
+}
+
 #endif
\ No newline at end of file
@@ -18,10 +18,13 @@
 
 	#include "CSP/Common/String.h"
 	#include "CSP/Common/List.h"
+	#include "Memory/MemoryManager.h"
 
 	#include "TestHelpers.h"
 
 	#include <gtest/gtest.h>
+	#include <string>
+	#include <vector>
 
 
 using namespace csp::common;
@@ -673,4 +676,161 @@ CSP_INTERNAL_TEST(CSPEngine, CommonStringTests, StringJoinListAllEmptyEntriesTes
 	}
 }
 
-#endif
\ No newline at end of file
+CSP_INTERNAL_TEST(CSPEngine, CommonStringTests, StringBufferReuseTest)
+{
+	// Strings are passed across the DLL boundary, so must stay the size of a pointer
+	EXPECT_EQ(sizeof(String), sizeof(void*));
+
+	const char* Short = "abcdefghijklmnopqrstuvw";
+	const char* Long  = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+	String Instance(Short);
+	EXPECT_EQ(Instance.Length(), 23);
+	EXPECT_EQ(Instance, Short);
+
+	// Grows past the buffer
+	Instance.Append("x");
+	EXPECT_EQ(Instance.Length(), 24);
+	EXPECT_EQ(Instance, "abcdefghijklmnopqrstuvwx");
+
+	Instance = Long;
+	EXPECT_EQ(Instance, Long);
+
+	// Shorter strings reuse the buffer
+	Instance = "abc";
+	EXPECT_EQ(Instance, "abc");
+	EXPECT_EQ(Instance.Length(), 3);
+
+	// Appending a string to itself, both within the buffer and growing it
+	Instance.Append(Instance);
+	EXPECT_EQ(Instance, "abcabc");
+
+	Instance = Long;
+	Instance.Append(Instance);
+	EXPECT_EQ(Instance, String(Long) + Long);
+
+	// Moves leave the source empty and usable
+	String Moved(std::move(Instance));
+	EXPECT_EQ(Moved, String(Long) + Long);
+	EXPECT_TRUE(Instance.IsEmpty());
+	EXPECT_EQ(Instance, "");
+
+	Instance = std::move(Moved);
+	EXPECT_EQ(Instance, String(Long) + Long);
+	EXPECT_TRUE(Moved.IsEmpty());
+
+	String Other("xyz");
+	Instance.swap(Other);
+	EXPECT_EQ(Instance, "xyz");
+	EXPECT_EQ(Other, String(Long) + Long);
+
+	// Strings of different lengths with a common prefix
+	EXPECT_NE(String("abc"), String("abcd"));
+	EXPECT_NE(String("abcd"), "abc");
+	EXPECT_NE(String("abc"), "abcd");
+
+	// Strings containing NULs only equal C strings with all the same characters
+	const String WithNul("ab\0cd", 5);
+	EXPECT_NE(WithNul, "ab");
+	EXPECT_NE(WithNul, "abxcd");
+	EXPECT_NE(String("ab\0", 3), "ab");
+	EXPECT_EQ(String("ab", 2), "ab");
+}
+
+CSP_INTERNAL_TEST(CSPEngine, CommonStringTests, StringAllocationCountTest)
+{
+	constexpr int NumStrings = 10000;
+
+	const auto& Allocator = csp::memory::MemoryManager::GetDefaultAllocator();
+
+	// Typical entity and property names, all the same length
+	std::vector<std::string> Names;
+
+	for (int i = 0; i < NumStrings; ++i)
+	{
+		char Name[32];
+		snprintf(Name, sizeof(Name), "Entity_%05d", i);
+		Names.push_back(Name);
+	}
+
+	std::vector<String> Strings;
+	Strings.reserve(NumStrings);
+
+	size_t Start = Allocator.GetNumAllocations();
+
+	for (const auto& Name : Names)
+	{
+		Strings.emplace_back(Name.c_str());
+	}
+
+	const size_t ConstructAllocations = Allocator.GetNumAllocations() - Start;
+
+	std::vector<String> Copies;
+	Copies.reserve(NumStrings);
+	Start = Allocator.GetNumAllocations();
+
+	for (const auto& Instance : Strings)
+	{
+		Copies.push_back(Instance);
+	}
+
+	for (size_t i = 0; i < Copies.size(); ++i)
+	{
+		Copies[i] = Strings[(i + 1) % Strings.size()];
+	}
+
+	const size_t CopyAllocations = Allocator.GetNumAllocations() - Start;
+
+	// Each string allocates once, and reassigning a string of the same length reuses its buffer
+	EXPECT_EQ(ConstructAllocations, NumStrings);
+	EXPECT_EQ(CopyAllocations, NumStrings);
+
+	// Empty strings share a buffer rather than allocating
+	Start = Allocator.GetNumAllocations();
+
+	for (auto& Instance : Copies)
+	{
+		Instance = "";
+	}
+
+	std::vector<String> EmptyStrings(NumStrings);
+
+	EXPECT_EQ(Allocator.GetNumAllocations() - Start, 0);
+	EXPECT_TRUE(EmptyStrings.back().IsEmpty());
+
+	// So do longer strings
+	std::vector<String> LongStrings;
+	LongStrings.reserve(NumStrings);
+	Start = Allocator.GetNumAllocations();
+
+	for (const auto& Name : Names)
+	{
+		LongStrings.emplace_back(("/spaces/entities/components/" + Name).c_str());
+	}
+
+	for (size_t i = 0; i < LongStrings.size(); ++i)
+	{
+		LongStrings[i] = LongStrings[NumStrings - 1 - i];
+	}
+
+	const size_t LongAllocations = Allocator.GetNumAllocations() - Start;
+
+	EXPECT_EQ(LongAllocations, NumStrings);
+
+	// Comparing with a string of the same length compares characters, but a different length is rejected straight away
+	const String SameLengthNeedle("Entity_09999");
+	const String OtherLengthNeedle("Entity_9999");
+	int NumSameLengthMatches  = 0;
+	int NumOtherLengthMatches = 0;
+
+	for (const auto& Instance : Strings)
+	{
+		NumSameLengthMatches += Instance == SameLengthNeedle;
+		NumOtherLengthMatches += Instance == OtherLengthNeedle;
+	}
+
+	EXPECT_EQ(NumSameLengthMatches, 1);
+	EXPECT_EQ(NumOtherLengthMatches, 0);
+}
+
+#endif
@@ -20,6 +20,11 @@
 	#include "TestHelpers.h"
 
 	#include "gtest/gtest.h"
+	#include <atomic>
+	#include <chrono>
+	#include <string>
+	#include <thread>
+	#include <vector>
 
 
 
@@ -146,4 +151,290 @@ CSP_INTERNAL_TEST(CSPEngine, EventTests, EventSystemTest)
 	OlyEvents.UnRegisterListener(kTestEventId, &AllHandler);
 }
 
+
+class SequenceEventHandler : public EventListener
+{
+public:
+	SequenceEventHandler(int NumProducers) : LastSequence(NumProducers, -1), NumReceived(0), NumOutOfOrder(0)
+	{
+	}
+
+	virtual void OnEvent(const Event& InEvent) override
+	{
+		int& Last = LastSequence[InEvent.GetInt("Producer")];
+		int Next  = InEvent.GetInt("Sequence");
+
+		if (Next != Last + 1)
+		{
+			++NumOutOfOrder;
+		}
+
+		Last = Next;
+		++NumReceived;
+	}
+
+	std::vector<int> LastSequence;
+	std::atomic_int NumReceived;
+	int NumOutOfOrder;
+};
+
+
+
+CSP_INTERNAL_TEST(CSPEngine, EventTests, EventPayloadTest)
+{
+	EventSystem Events;
+
+	const std::string LongString(200, 'x');
+
+	Event* TestEvent = Events.AllocateEvent(kTestEventId);
+
+	// More params than are stored inline, and a string too long to be stored inline
+	for (int i = 0; i < 10; ++i)
+	{
+		TestEvent->AddInt(("Int" + std::to_string(i)).c_str(), i * 10);
+	}
+
+	TestEvent->AddString("Short", "ShortValue");
+	TestEvent->AddString("Long", LongString.c_str());
+	TestEvent->AddFloat("Float", 1.5f);
+	TestEvent->AddBool("Bool", true);
+
+	// Adding a key twice keeps the first value
+	TestEvent->AddInt("Int0", 1234);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		EXPECT_EQ(TestEvent->GetInt(("Int" + std::to_string(i)).c_str()), i * 10);
+	}
+
+	EXPECT_STREQ(TestEvent->GetString("Short"), "ShortValue");
+	EXPECT_EQ(TestEvent->GetString("Long"), LongString);
+	EXPECT_EQ(TestEvent->GetFloat("Float"), 1.5f);
+	EXPECT_TRUE(TestEvent->GetBool("Bool"));
+	EXPECT_EQ(TestEvent->GetString("Missing"), nullptr);
+
+	Events.EnqueueEvent(TestEvent);
+	Events.ProcessEvents();
+
+	// Processed events are reused, without any of their old params
+	Event* ReusedEvent = Events.AllocateEvent(USERSERVICE_LOGIN_EVENT_ID);
+
+	EXPECT_EQ(ReusedEvent, TestEvent);
+	EXPECT_TRUE(ReusedEvent->GetId() == USERSERVICE_LOGIN_EVENT_ID);
+	EXPECT_EQ(ReusedEvent->GetInt("Int5"), 0);
+	EXPECT_EQ(ReusedEvent->GetString("Long"), nullptr);
+
+	Events.EnqueueEvent(ReusedEvent);
+	Events.ProcessEvents();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, EventTests, EventQueueOverflowTest)
+{
+	// Enough events that some have to go to the overflow list
+	constexpr int NumEvents = 5000;
+
+	EventSystem Events;
+	SequenceEventHandler Handler(1);
+
+	Events.RegisterListener(kTestEventId, &Handler);
+
+	for (int i = 0; i < NumEvents; ++i)
+	{
+		Event* TestEvent = Events.AllocateEvent(kTestEventId);
+		TestEvent->AddInt("Producer", 0);
+		TestEvent->AddInt("Sequence", i);
+
+		Events.EnqueueEvent(TestEvent);
+	}
+
+	Events.ProcessEvents();
+
+	EXPECT_EQ(Handler.NumReceived, NumEvents);
+	EXPECT_EQ(Handler.NumOutOfOrder, 0);
+
+	Events.UnRegisterListener(kTestEventId, &Handler);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, EventTests, EventSystemThroughputBenchmarkTest)
+{
+	constexpr int NumProducers	    = 4;
+	constexpr int EventsPerProducer = 250000;
+
+	EventSystem Events;
+	SequenceEventHandler Handler(NumProducers);
+
+	Events.RegisterListener(kTestEventId, &Handler);
+
+	std::vector<std::thread> Producers;
+	const auto Start = std::chrono::steady_clock::now();
+
+	for (int Producer = 0; Producer < NumProducers; ++Producer)
+	{
+		Producers.emplace_back(
+			[&Events, Producer]()
+			{
+				for (int i = 0; i < EventsPerProducer; ++i)
+				{
+					Event* TestEvent = Events.AllocateEvent(kTestEventId);
+					TestEvent->AddInt("Producer", Producer);
+					TestEvent->AddInt("Sequence", i);
+
+					Events.EnqueueEvent(TestEvent);
+				}
+			});
+	}
+
+	// Process on this thread while the producers are running, as a game loop would
+	while (Handler.NumReceived < NumProducers * EventsPerProducer)
+	{
+		Events.ProcessEvents();
+		std::this_thread::yield();
+	}
+
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	for (auto& Producer : Producers)
+	{
+		Producer.join();
+	}
+
+	EXPECT_EQ(Handler.NumReceived, NumProducers * EventsPerProducer);
+	EXPECT_EQ(Handler.NumOutOfOrder, 0);
+
+	RecordProperty("EventsPerSecond", std::to_string((NumProducers * EventsPerProducer) / Seconds));
+
+	Events.UnRegisterListener(kTestEventId, &Handler);
+}
+
+
+class CountingEventHandler : public EventListener
+{
+public:
+	CountingEventHandler() : NumReceived(0)
+	{
+	}
+
+	virtual void OnEvent(const Event& InEvent) override
+	{
+		++NumReceived;
+	}
+
+	int NumReceived;
+};
+
+
+
+// Registers and unregisters other listeners from within OnEvent
+class ChangingEventHandler : public EventListener
+{
+public:
+	ChangingEventHandler(EventSystem& InEvents, EventListener* InToRemove, EventListener* InToAdd)
+		: Events(InEvents), ToRemove(InToRemove), ToAdd(InToAdd), NumReceived(0)
+	{
+	}
+
+	virtual void OnEvent(const Event& InEvent) override
+	{
+		if (NumReceived++ == 0)
+		{
+			Events.UnRegisterListener(kTestEventId, ToRemove);
+			Events.RegisterListener(kTestEventId, ToAdd);
+			Events.UnRegisterListener(kTestEventId, this);
+		}
+	}
+
+	EventSystem& Events;
+	EventListener* ToRemove;
+	EventListener* ToAdd;
+	int NumReceived;
+};
+
+
+
+CSP_INTERNAL_TEST(CSPEngine, EventTests, EventListenerChangesDuringDispatchTest)
+{
+	EventSystem Events;
+
+	CountingEventHandler Before;
+	CountingEventHandler Removed;
+	CountingEventHandler Added;
+	ChangingEventHandler Changing(Events, &Removed, &Added);
+
+	Events.RegisterListener(kTestEventId, &Before);
+	Events.RegisterListener(kTestEventId, &Changing);
+	Events.RegisterListener(kTestEventId, &Removed);
+
+	Events.EnqueueEvent(Events.AllocateEvent(kTestEventId));
+	Events.ProcessEvents();
+
+	// The removed listener is skipped straight away, but the added one only receives later events
+	EXPECT_EQ(Before.NumReceived, 1);
+	EXPECT_EQ(Changing.NumReceived, 1);
+	EXPECT_EQ(Removed.NumReceived, 0);
+	EXPECT_EQ(Added.NumReceived, 0);
+
+	Events.EnqueueEvent(Events.AllocateEvent(kTestEventId));
+	Events.ProcessEvents();
+
+	EXPECT_EQ(Before.NumReceived, 2);
+	EXPECT_EQ(Changing.NumReceived, 1);
+	EXPECT_EQ(Removed.NumReceived, 0);
+	EXPECT_EQ(Added.NumReceived, 1);
+
+	Events.UnRegisterAllListeners();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, EventTests, EventDispatchBenchmarkTest)
+{
+	constexpr int NumIds			= 200;
+	constexpr int ListenersPerEvent = 48;
+	constexpr int NumEvents			= 100000;
+
+	EventSystem Events;
+
+	// Plenty of other ids with listeners, so that looking up the dispatcher isn't trivial
+	std::vector<EventId> OtherIds;
+	CountingEventHandler OtherHandler;
+
+	for (int i = 0; i < NumIds; ++i)
+	{
+		OtherIds.emplace_back("BenchmarkEvent", std::to_string(i).c_str());
+		Events.RegisterListener(OtherIds.back(), &OtherHandler);
+	}
+
+	std::vector<CountingEventHandler> Handlers(ListenersPerEvent);
+
+	for (auto& Handler : Handlers)
+	{
+		Events.RegisterListener(kTestEventId, &Handler);
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+
+	// Enqueue in batches, so that the events are reused from the pool as they would be frame to frame
+	for (int Processed = 0; Processed < NumEvents; Processed += 500)
+	{
+		for (int i = 0; i < 500; ++i)
+		{
+			Events.EnqueueEvent(Events.AllocateEvent(kTestEventId));
+		}
+
+		Events.ProcessEvents();
+	}
+
+	const double Nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+
+	for (const auto& Handler : Handlers)
+	{
+		EXPECT_EQ(Handler.NumReceived, NumEvents);
+	}
+
+	EXPECT_EQ(OtherHandler.NumReceived, 0);
+
+	RecordProperty("NsPerEvent", std::to_string(Nanoseconds / NumEvents));
+	RecordProperty("NsPerListenerCall", std::to_string(Nanoseconds / (static_cast<double>(NumEvents) * ListenersPerEvent)));
+
+	Events.UnRegisterAllListeners();
+}
+
 #endif
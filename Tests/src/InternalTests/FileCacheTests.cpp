@@ -0,0 +1,845 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_FILECACHE_TESTS)
+	#include "CSP/CSPFoundation.h"
+	#include "Services/ApiBase/ApiBase.h"
+	#include "Storage/FileCache.h"
+	#include "TestHelpers.h"
+	#include "Web/HttpResponseSink.h"
+	#include "Web/RemoteFileManager.h"
+	#include "Web/WebClient.h"
+
+	#include "gtest/gtest.h"
+	#include <algorithm>
+	#include <atomic>
+	#include <chrono>
+	#include <cstdio>
+	#include <filesystem>
+	#include <functional>
+	#include <map>
+	#include <memory>
+	#include <mutex>
+	#include <string>
+	#include <thread>
+	#include <vector>
+
+
+using namespace csp::web;
+
+
+namespace
+{
+
+std::string GetTestCacheDirectory()
+{
+	const auto Directory = std::filesystem::temp_directory_path() / "csp_file_cache_test";
+	std::filesystem::remove_all(Directory);
+
+	return Directory.string();
+}
+
+std::string ReadCached(csp::FileCache& Cache, const std::string& Key)
+{
+	std::string Content;
+
+	Cache.Read(Key,
+			   [&Content](const char* Data, size_t Size)
+			   {
+				   Content.assign(Data, Size);
+			   });
+
+	return Content;
+}
+
+
+/// Stands in for a HTTP file server without opening any sockets. Serves files by URL, honours If-None-Match, If-Modified-Since and
+/// Range headers, writes to the response sink if the request has one, and counts the number of body bytes it sends.
+/// Each response can be made to take as long as it would over a connection of a given speed, without holding up other requests.
+class LocalFileServer : public WebClient
+{
+public:
+	struct File
+	{
+		std::string Content;
+		std::string ETag;
+		std::string LastModified;
+		bool AcceptRanges = true;
+	};
+
+	LocalFileServer() : WebClient(80, ETransferProtocol::HTTP, false)
+	{
+	}
+
+	void SetFile(const std::string& Url, const File& InFile)
+	{
+		std::scoped_lock Lock(Mutex);
+		Files[Url] = std::make_shared<const File>(InFile);
+	}
+
+	void SetBytesPerSecond(uint64_t InBytesPerSecond)
+	{
+		BytesPerSecond = InBytesPerSecond;
+	}
+
+	// Time taken to answer each GET, on top of sending the body
+	void SetRequestLatency(std::chrono::microseconds InLatency)
+	{
+		RequestLatency = InLatency.count();
+	}
+
+	// The next request for a range starting at Offset is cut short
+	void TruncateNextRangeAt(size_t Offset)
+	{
+		std::scoped_lock Lock(Mutex);
+		TruncatedRanges.push_back(Offset);
+	}
+
+	uint64_t GetBytesSent() const
+	{
+		return BytesSent;
+	}
+
+	uint32_t GetNumNotModified() const
+	{
+		return NumNotModified;
+	}
+
+	uint32_t GetNumRangeRequests() const
+	{
+		return NumRangeRequests;
+	}
+
+	uint32_t GetNumHeadRequests() const
+	{
+		return NumHeadRequests;
+	}
+
+	// URLs of the GET requests received, in the order they arrived
+	std::vector<std::string> GetRequestedUrls() const
+	{
+		std::scoped_lock Lock(Mutex);
+
+		return RequestedUrls;
+	}
+
+	std::string MD5Hash(const void* Data, const size_t Size) override
+	{
+		// Stable for the duration of the test, which is all the cache needs
+		return std::to_string(std::hash<std::string_view>()(std::string_view(static_cast<const char*>(Data), Size)));
+	}
+
+	void SetFileUploadContentFromFile(HttpPayload*, const char*, const char*, const csp::common::String&) override
+	{
+	}
+
+	void SetFileUploadContentFromString(HttpPayload*, const csp::common::String&, const csp::common::String&, const char*, const csp::common::String&) override
+	{
+	}
+
+	void SetFileUploadContentFromBuffer(HttpPayload*, const char*, size_t, const csp::common::String&, const char*, const csp::common::String&) override
+	{
+	}
+
+protected:
+	void Send(HttpRequest& Request) override
+	{
+		Request.SetRequestProgress(100.0f);
+
+		// Shared rather than copied, as several ranges of a large file are served at once
+		std::shared_ptr<const File> Served;
+		size_t Start  = 0;
+		size_t Length = 0;
+		bool IsRange  = false;
+
+		{
+			std::scoped_lock Lock(Mutex);
+
+			const auto FileIt = Files.find(Request.GetUri().GetAsString());
+
+			if (FileIt == Files.end())
+			{
+				Request.SetResponseCode(EResponseCodes::ResponseNotFound);
+
+				return;
+			}
+
+			Served = FileIt->second;
+		}
+
+		auto& Payload = Request.GetMutableResponse().GetMutablePayload();
+
+		if (!Served->ETag.empty())
+		{
+			Payload.AddHeader("etag", Served->ETag.c_str());
+		}
+
+		if (!Served->LastModified.empty())
+		{
+			Payload.AddHeader("last-modified", Served->LastModified.c_str());
+		}
+
+		if (Served->AcceptRanges)
+		{
+			Payload.AddHeader("accept-ranges", "bytes");
+		}
+
+		if (Request.GetVerb() == ERequestVerb::HEAD)
+		{
+			++NumHeadRequests;
+			Payload.AddHeader("content-length", std::to_string(Served->Content.size()).c_str());
+			Request.SetResponseCode(EResponseCodes::ResponseOK);
+
+			return;
+		}
+
+		const auto& Headers		 = Request.GetPayload().GetHeaders();
+		const auto IfNoneMatch	 = Headers.find("If-None-Match");
+		const auto IfModifiedSince = Headers.find("If-Modified-Since");
+		const auto Range		   = Headers.find("Range");
+
+		const bool ETagMatches	   = IfNoneMatch != Headers.end() && !Served->ETag.empty() && IfNoneMatch->second.c_str() == Served->ETag;
+		const bool NotModifiedSince = IfNoneMatch == Headers.end() && IfModifiedSince != Headers.end() && !Served->LastModified.empty()
+									  && IfModifiedSince->second.c_str() == Served->LastModified;
+
+		if (ETagMatches || NotModifiedSince)
+		{
+			++NumNotModified;
+			Request.SetResponseCode(EResponseCodes::ResponseNotModified);
+
+			return;
+		}
+
+		{
+			std::scoped_lock Lock(Mutex);
+			RequestedUrls.push_back(Request.GetUri().GetAsString());
+		}
+
+		Length = Served->Content.size();
+
+		if (Served->AcceptRanges && Range != Headers.end())
+		{
+			size_t End = 0;
+			sscanf(Range->second.c_str(), "bytes=%zu-%zu", &Start, &End);
+
+			Length	= std::min(End + 1, Served->Content.size()) - Start;
+			IsRange = true;
+			++NumRangeRequests;
+
+			Payload.AddHeader("content-range",
+							  ("bytes " + std::to_string(Start) + "-" + std::to_string(Start + Length - 1) + "/" + std::to_string(Served->Content.size()))
+								  .c_str());
+
+			std::scoped_lock Lock(Mutex);
+
+			if (const auto Truncated = std::find(TruncatedRanges.begin(), TruncatedRanges.end(), Start); Truncated != TruncatedRanges.end())
+			{
+				TruncatedRanges.erase(Truncated);
+				Length /= 2;
+			}
+		}
+
+		if (BytesPerSecond > 0 || RequestLatency > 0)
+		{
+			const uint64_t SendTime = (BytesPerSecond > 0) ? Length * 1000000 / BytesPerSecond : 0;
+			std::this_thread::sleep_for(std::chrono::microseconds(RequestLatency + SendTime));
+		}
+
+		const EResponseCodes ResponseCode = IsRange ? EResponseCodes::ResponsePartialContent : EResponseCodes::ResponseOK;
+		auto* Sink						  = Request.GetCallback()->GetResponseSink();
+
+		if (Sink != nullptr)
+		{
+			const bool Written = WriteToResponseSink(*Sink, Served->Content.data() + Start, Length);
+			Request.SetResponseCode(Written ? ResponseCode : EResponseCodes::ResponseRequestEntityTooLarge);
+		}
+		else
+		{
+			Request.SetResponseData(Served->Content.data() + Start, Length);
+			Request.SetResponseCode(ResponseCode);
+		}
+
+		Request.SetResponseProgress(100.0f);
+
+		BytesSent += Length;
+	}
+
+private:
+	mutable std::mutex Mutex;
+	std::map<std::string, std::shared_ptr<const File>> Files;
+	std::vector<size_t> TruncatedRanges;
+	std::vector<std::string> RequestedUrls;
+	std::atomic<uint64_t> BytesPerSecond   = 0;
+	std::atomic<uint64_t> RequestLatency   = 0;
+	std::atomic<uint64_t> BytesSent		   = 0;
+	std::atomic<uint32_t> NumNotModified   = 0;
+	std::atomic<uint32_t> NumRangeRequests = 0;
+	std::atomic<uint32_t> NumHeadRequests  = 0;
+};
+
+
+struct DownloadResult
+{
+	EResponseCodes ResponseCode = EResponseCodes::ResponseInit;
+	std::string Content;
+	float ResponseProgress = 0.0f;
+};
+
+class DownloadResultHandler : public csp::services::ApiResponseHandlerBase
+{
+public:
+	DownloadResultHandler(DownloadResult& InResult, std::atomic_bool& InReceived) : Result(InResult), Received(InReceived)
+	{
+	}
+
+	void OnHttpProgress(HttpRequest& Request) override
+	{
+		EXPECT_GE(Request.GetResponseProgressPercentage(), Result.ResponseProgress);
+		Result.ResponseProgress = Request.GetResponseProgressPercentage();
+	}
+
+	void OnHttpResponse(HttpResponse& Response) override
+	{
+		const auto& Content = Response.GetPayload().GetContent();
+
+		Result.ResponseCode = Response.GetResponseCode();
+		Result.Content.assign(Content.c_str(), Content.Length());
+		Received		 = true;
+	}
+
+private:
+	DownloadResult& Result;
+	std::atomic_bool& Received;
+};
+
+DownloadResult Download(RemoteFileManager& FileManager,
+						const char* Url,
+						const std::shared_ptr<IHttpResponseSink>& Sink = nullptr,
+						const RangedDownloadOptions* RangeOptions	   = nullptr)
+{
+	DownloadResult Result;
+	std::atomic_bool Received = false;
+
+	if (RangeOptions != nullptr)
+	{
+		FileManager.GetFileInRanges(Url, Sink, *RangeOptions, CSP_NEW DownloadResultHandler(Result, Received), csp::common::CancellationToken::Dummy());
+	}
+	else
+	{
+		FileManager.GetFile(Url, Sink, CSP_NEW DownloadResultHandler(Result, Received), csp::common::CancellationToken::Dummy());
+	}
+
+	ResponseWaiter::WaitFor(
+		[&Received]()
+		{
+			return Received.load();
+		},
+		std::chrono::seconds(10),
+		std::chrono::milliseconds(1));
+
+	EXPECT_TRUE(Received);
+
+	return Result;
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, FileCacheTests, FileCacheEvictionTest)
+{
+	const std::string Directory = GetTestCacheDirectory();
+
+	const std::string A(1000, 'a');
+	const std::string B(2000, 'b');
+	const std::string C(1500, 'c');
+
+	{
+		csp::FileCache Cache(Directory, 4000);
+
+		ASSERT_TRUE(Cache.IsValid());
+
+		EXPECT_TRUE(Cache.Store("A", "hasha", A.data(), A.size(), {"\"a\"", ""}));
+		EXPECT_TRUE(Cache.Store("B", "hashb", B.data(), B.size(), {"\"b\"", ""}));
+		// Same content under a different key is only stored once
+		EXPECT_TRUE(Cache.Store("A2", "hasha", A.data(), A.size(), {"\"a\"", ""}));
+
+		EXPECT_EQ(Cache.GetNumEntries(), 3);
+		EXPECT_EQ(Cache.GetSize(), A.size() + B.size());
+
+		// Reading A makes B the least recently used, so B is evicted to make room for C
+		EXPECT_EQ(ReadCached(Cache, "A"), A);
+		EXPECT_TRUE(Cache.Store("C", "hashc", C.data(), C.size(), {"", "Wed, 21 Oct 2015 07:28:00 GMT"}));
+
+		csp::FileCache::Validators Validators;
+		EXPECT_FALSE(Cache.GetValidators("B", Validators));
+		EXPECT_TRUE(Cache.GetValidators("C", Validators));
+		EXPECT_EQ(Validators.LastModified, "Wed, 21 Oct 2015 07:28:00 GMT");
+		EXPECT_EQ(Cache.GetSize(), A.size() + C.size());
+
+		// Larger than the whole budget
+		const std::string Large(5000, 'l');
+		EXPECT_FALSE(Cache.Store("Large", "hashl", Large.data(), Large.size(), {"\"l\"", ""}));
+		EXPECT_EQ(Cache.GetSize(), A.size() + C.size());
+
+		// The index is written shortly after the changes, without waiting for the cache to be destroyed
+		const auto IndexPath = std::filesystem::path(Directory) / "index.json";
+		const auto Deadline	 = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+		while (!std::filesystem::exists(IndexPath) && std::chrono::steady_clock::now() < Deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		EXPECT_TRUE(std::filesystem::exists(IndexPath));
+	}
+
+	// Entries and their recency survive reloading the cache
+	{
+		csp::FileCache Cache(Directory, 4000);
+
+		EXPECT_EQ(Cache.GetNumEntries(), 3);
+		EXPECT_EQ(ReadCached(Cache, "A2"), A);
+		EXPECT_EQ(ReadCached(Cache, "C"), C);
+
+		// A is now the least recently used key, but its content is still referenced by A2
+		Cache.SetMaxSize(C.size() + A.size());
+		EXPECT_EQ(Cache.GetNumEntries(), 3);
+
+		Cache.SetMaxSize(C.size());
+		EXPECT_EQ(Cache.GetNumEntries(), 1);
+		EXPECT_EQ(ReadCached(Cache, "C"), C);
+
+		Cache.Clear();
+		EXPECT_EQ(Cache.GetSize(), 0);
+	}
+
+	std::filesystem::remove_all(Directory);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, FileCacheTests, RemoteFileManagerConditionalGetTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	const std::string Directory = GetTestCacheDirectory();
+
+	constexpr const char* AssetUrl	  = "https://assets.example.com/model.glb";
+	constexpr const char* UncachedUrl = "https://assets.example.com/dynamic.json";
+
+	const std::string AssetV1(256 * 1024, '1');
+	const std::string AssetV2(192 * 1024, '2');
+
+	LocalFileServer Server;
+	Server.SetFile(AssetUrl, {AssetV1, "\"v1\"", ""});
+	// No validators, so this can never be revalidated and mustn't be cached
+	Server.SetFile(UncachedUrl, {"{}", "", ""});
+
+	{
+		RemoteFileManager FileManager(&Server);
+		ASSERT_TRUE(FileManager.EnableFileCache(Directory, 1024 * 1024));
+
+		// First download fills the cache
+		auto Result = Download(FileManager, AssetUrl);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Result.Content, AssetV1);
+		EXPECT_EQ(Server.GetBytesSent(), AssetV1.size());
+
+		// Repeat downloads are revalidated and served from the cache
+		for (int i = 0; i < 5; ++i)
+		{
+			Result = Download(FileManager, AssetUrl);
+			EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+			EXPECT_EQ(Result.Content, AssetV1);
+		}
+
+		EXPECT_EQ(Server.GetBytesSent(), AssetV1.size());
+		EXPECT_EQ(Server.GetNumNotModified(), 5);
+
+		// A changed asset is downloaded again and replaces the cached one
+		Server.SetFile(AssetUrl, {AssetV2, "\"v2\"", ""});
+
+		Result = Download(FileManager, AssetUrl);
+		EXPECT_EQ(Result.Content, AssetV2);
+		EXPECT_EQ(Server.GetBytesSent(), AssetV1.size() + AssetV2.size());
+		EXPECT_EQ(FileManager.GetFileCache()->GetSize(), AssetV2.size());
+
+		Download(FileManager, UncachedUrl);
+		Download(FileManager, UncachedUrl);
+		EXPECT_EQ(FileManager.GetFileCache()->GetNumEntries(), 1);
+	}
+
+	const uint64_t BytesBeforeRestart = Server.GetBytesSent();
+
+	// A new session reuses the cache from the previous one
+	{
+		RemoteFileManager FileManager(&Server);
+		ASSERT_TRUE(FileManager.EnableFileCache(Directory, 1024 * 1024));
+
+		const auto Result = Download(FileManager, AssetUrl);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Result.Content, AssetV2);
+		EXPECT_EQ(Server.GetBytesSent(), BytesBeforeRestart);
+
+		// If the cached file has gone missing by the time the server says it's unchanged, it is downloaded again in full
+		for (const auto& File : std::filesystem::directory_iterator(std::filesystem::path(Directory) / "blobs"))
+		{
+			std::filesystem::remove(File.path());
+		}
+
+		const auto RetriedResult = Download(FileManager, AssetUrl);
+		EXPECT_EQ(RetriedResult.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(RetriedResult.Content, AssetV2);
+		EXPECT_EQ(Server.GetBytesSent(), BytesBeforeRestart + AssetV2.size());
+
+		// With caching disabled, every download is a full download
+		FileManager.DisableFileCache();
+
+		Download(FileManager, AssetUrl);
+		EXPECT_EQ(Server.GetBytesSent(), BytesBeforeRestart + AssetV2.size() * 2);
+	}
+
+	std::filesystem::remove_all(Directory);
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, FileCacheTests, RemoteFileManagerSinkTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	const std::string Directory = GetTestCacheDirectory();
+
+	constexpr const char* AssetUrl = "https://assets.example.com/texture.ktx2";
+
+	const std::string Asset(300 * 1024, 't');
+
+	LocalFileServer Server;
+	Server.SetFile(AssetUrl, {Asset, "\"t1\"", ""});
+
+	{
+		RemoteFileManager FileManager(&Server);
+
+		// Without a cache, the file goes straight to the sink and the payload is left empty
+		std::vector<char> Buffer(Asset.size());
+		auto BufferSink = std::make_shared<BufferResponseSink>(Buffer.data(), Buffer.size());
+
+		auto Result = Download(FileManager, AssetUrl, BufferSink);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_TRUE(Result.Content.empty());
+		EXPECT_EQ(BufferSink->GetSize(), Asset.size());
+		EXPECT_EQ(std::string(Buffer.data(), Buffer.size()), Asset);
+
+		// A buffer that's too small fails the download rather than truncating it
+		std::vector<char> SmallBuffer(Asset.size() - 1);
+		auto SmallSink = std::make_shared<BufferResponseSink>(SmallBuffer.data(), SmallBuffer.size());
+
+		Result = Download(FileManager, AssetUrl, SmallSink);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseRequestEntityTooLarge);
+
+		// Once cached, a revalidated file is written to the sink from the cache
+		ASSERT_TRUE(FileManager.EnableFileCache(Directory, 1024 * 1024));
+		Download(FileManager, AssetUrl);
+
+		const uint64_t BytesBeforeSink = Server.GetBytesSent();
+		std::string Chunked;
+
+		auto ChunkSink = std::make_shared<CallbackResponseSink>(
+			[&Chunked](size_t Offset, const char* Data, size_t Length)
+			{
+				EXPECT_EQ(Offset, Chunked.size());
+				Chunked.append(Data, Length);
+			},
+			64 * 1024);
+
+		Result = Download(FileManager, AssetUrl, ChunkSink);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Chunked, Asset);
+		EXPECT_EQ(Server.GetBytesSent(), BytesBeforeSink);
+		EXPECT_EQ(Server.GetNumNotModified(), 1);
+	}
+
+	std::filesystem::remove_all(Directory);
+
+	csp::CSPFoundation::Shutdown();
+}
+
+
+CSP_INTERNAL_TEST(CSPEngine, FileCacheTests, RemoteFileManagerRangedDownloadTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	constexpr const char* LargeUrl		= "https://assets.example.com/scene.splat";
+	constexpr const char* NoRangesUrl	= "https://assets.example.com/no_ranges.glb";
+	constexpr const char* SmallUrl		= "https://assets.example.com/small.glb";
+	constexpr uint64_t BytesPerSecond	= 400 * 1024 * 1024;
+
+	std::string Large(20 * 1024 * 1024 + 12345, '\0');
+
+	for (size_t i = 0; i < Large.size(); ++i)
+	{
+		Large[i] = static_cast<char>(i * 31 + (i >> 12));
+	}
+
+	LocalFileServer Server;
+	Server.SetFile(LargeUrl, {Large, "\"s1\"", ""});
+	Server.SetFile(NoRangesUrl, {Large, "\"n1\"", "", false});
+	Server.SetFile(SmallUrl, {std::string(1024, 's'), "\"m1\"", ""});
+	Server.SetBytesPerSecond(BytesPerSecond);
+
+	RangedDownloadOptions Options;
+	Options.MinRangedSize	  = 1024 * 1024;
+	Options.RangeSize		  = 2 * 1024 * 1024;
+	Options.MaxParallelRanges = 4;
+
+	const size_t NumRanges = (Large.size() + Options.RangeSize - 1) / Options.RangeSize;
+
+	{
+		RemoteFileManager FileManager(&Server);
+		std::vector<char> Buffer(Large.size());
+
+		// A single request, for comparison
+		const auto SingleStart = std::chrono::steady_clock::now();
+		auto Result			   = Download(FileManager, LargeUrl, std::make_shared<BufferResponseSink>(Buffer.data(), Buffer.size()));
+		const auto SingleTime  = std::chrono::steady_clock::now() - SingleStart;
+
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(std::string(Buffer.data(), Buffer.size()), Large);
+
+		// Ranges are read straight into place, and one that is cut short is requested again on its own
+		std::fill(Buffer.begin(), Buffer.end(), 0);
+		Server.TruncateNextRangeAt(3 * Options.RangeSize);
+
+		const auto RangedStart = std::chrono::steady_clock::now();
+		Result = Download(FileManager, LargeUrl, std::make_shared<BufferResponseSink>(Buffer.data(), Buffer.size()), &Options);
+		const auto RangedTime = std::chrono::steady_clock::now() - RangedStart;
+
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Result.ResponseProgress, 100.0f);
+		EXPECT_EQ(std::string(Buffer.data(), Buffer.size()), Large);
+		EXPECT_EQ(Server.GetNumRangeRequests(), NumRanges + 1);
+
+		// The ranged time includes the range that was cut short and requested again
+		RecordProperty("SingleRequestMs", std::to_string(std::chrono::duration<double, std::milli>(SingleTime).count()));
+		RecordProperty("ParallelRangesMs", std::to_string(std::chrono::duration<double, std::milli>(RangedTime).count()));
+
+		// Without a sink, the ranges are collected in the response payload
+		Result = Download(FileManager, LargeUrl, nullptr, &Options);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Result.Content, Large);
+
+		// Ranged downloads straight to a file
+		const std::string FilePath = (std::filesystem::temp_directory_path() / "csp_ranged_download_test.bin").string();
+
+		Result = Download(FileManager, LargeUrl, std::make_shared<FileResponseSink>(FilePath, 64 * 1024), &Options);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(std::filesystem::file_size(FilePath), Large.size());
+
+		std::filesystem::remove(FilePath);
+
+		// Servers that don't accept ranges, and small files, are downloaded with a single request
+		const uint32_t RangeRequestsBefore = Server.GetNumRangeRequests();
+
+		Result = Download(FileManager, NoRangesUrl, nullptr, &Options);
+		EXPECT_EQ(Result.Content, Large);
+
+		Result = Download(FileManager, SmallUrl, nullptr, &Options);
+		EXPECT_EQ(Result.Content, std::string(1024, 's'));
+
+		EXPECT_EQ(Server.GetNumRangeRequests(), RangeRequestsBefore);
+
+		// A buffer too small for the file fails the download before any ranges are requested
+		std::vector<char> SmallBuffer(Large.size() - 1);
+
+		Result = Download(FileManager, LargeUrl, std::make_shared<BufferResponseSink>(SmallBuffer.data(), SmallBuffer.size()), &Options);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseRequestEntityTooLarge);
+		EXPECT_EQ(Server.GetNumRangeRequests(), RangeRequestsBefore);
+
+		// A buffer too small for a ranged download is downloaded into without reading the file's size first
+		const uint32_t HeadRequestsBefore = Server.GetNumHeadRequests();
+		std::vector<char> SmallFileBuffer(Options.MinRangedSize - 1);
+
+		Result = Download(FileManager, SmallUrl, std::make_shared<BufferResponseSink>(SmallFileBuffer.data(), SmallFileBuffer.size()), &Options);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(std::string(SmallFileBuffer.data(), 1024), std::string(1024, 's'));
+		EXPECT_EQ(Server.GetNumHeadRequests(), HeadRequestsBefore);
+	}
+
+	// A cached file is revalidated with a single request rather than downloaded again in ranges
+	{
+		const std::string Directory = GetTestCacheDirectory();
+
+		RemoteFileManager FileManager(&Server);
+		ASSERT_TRUE(FileManager.EnableFileCache(Directory, 64 * 1024 * 1024));
+
+		Download(FileManager, LargeUrl);
+
+		const uint32_t HeadRequestsBefore  = Server.GetNumHeadRequests();
+		const uint32_t RangeRequestsBefore = Server.GetNumRangeRequests();
+		const uint32_t NotModifiedBefore   = Server.GetNumNotModified();
+
+		auto Result = Download(FileManager, LargeUrl, nullptr, &Options);
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(Result.Content, Large);
+		EXPECT_EQ(Server.GetNumHeadRequests(), HeadRequestsBefore);
+		EXPECT_EQ(Server.GetNumRangeRequests(), RangeRequestsBefore);
+		EXPECT_EQ(Server.GetNumNotModified(), NotModifiedBefore + 1);
+
+		std::filesystem::remove_all(Directory);
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+
+CSP_INTERNAL_TEST(CSPEngine, FileCacheTests, RemoteFileManagerBatchDownloadTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	// A space manifest of 500 assets, some of which share their data, such as the same model placed several times
+	constexpr size_t NumAssets		   = 500;
+	constexpr size_t NumUniqueFiles	   = 350;
+	constexpr uint32_t MaxInFlight	   = 4;
+	constexpr uint64_t BytesPerSecond  = 200 * 1024 * 1024;
+	const auto RequestLatency		   = std::chrono::microseconds(500);
+
+	LocalFileServer Server;
+	Server.SetBytesPerSecond(BytesPerSecond);
+	Server.SetRequestLatency(RequestLatency);
+
+	std::vector<std::string> FileUrls;
+	std::vector<std::string> FileContents;
+
+	for (size_t i = 0; i < NumUniqueFiles; ++i)
+	{
+		FileUrls.push_back("https://assets.example.com/space/asset_" + std::to_string(i) + ".glb");
+		FileContents.push_back(std::string(16 * 1024 + (i * 977) % (48 * 1024), static_cast<char>('a' + i % 26)));
+
+		Server.SetFile(FileUrls.back(), {FileContents.back(), "\"" + std::to_string(i) + "\"", ""});
+	}
+
+	std::vector<size_t> Manifest;
+
+	for (size_t i = 0; i < NumAssets; ++i)
+	{
+		Manifest.push_back(i < NumUniqueFiles ? i : (i * 7) % NumUniqueFiles);
+	}
+
+	const auto WaitForAll = [](std::vector<std::atomic_bool>& Received)
+	{
+		return ResponseWaiter::WaitFor(
+			[&Received]()
+			{
+				return std::all_of(Received.begin(),
+								   Received.end(),
+								   [](const std::atomic_bool& IsReceived)
+								   {
+									   return IsReceived.load();
+								   });
+			},
+			std::chrono::seconds(30),
+			std::chrono::milliseconds(1));
+	};
+
+	RemoteFileManager FileManager(&Server);
+
+	// One request per asset, as when each asset is downloaded separately
+	std::vector<DownloadResult> SeparateResults(NumAssets);
+	std::vector<std::atomic_bool> SeparateReceived(NumAssets);
+
+	const auto SeparateStart = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < NumAssets; ++i)
+	{
+		FileManager.GetFile(FileUrls[Manifest[i]].c_str(),
+							CSP_NEW DownloadResultHandler(SeparateResults[i], SeparateReceived[i]),
+							csp::common::CancellationToken::Dummy());
+	}
+
+	EXPECT_TRUE(WaitForAll(SeparateReceived));
+	const auto SeparateTime = std::chrono::steady_clock::now() - SeparateStart;
+
+	EXPECT_EQ(Server.GetRequestedUrls().size(), NumAssets);
+
+	// The same manifest as a batch, with every 10th asset given a higher priority
+	std::vector<DownloadResult> BatchResults(NumAssets);
+	std::vector<std::atomic_bool> BatchReceived(NumAssets);
+	std::vector<BatchFileRequest> Requests;
+
+	for (size_t i = 0; i < NumAssets; ++i)
+	{
+		Requests.push_back({FileUrls[Manifest[i]].c_str(), (i % 10 == 0) ? 1 : 0, CSP_NEW DownloadResultHandler(BatchResults[i], BatchReceived[i])});
+	}
+
+	const size_t RequestsBefore = Server.GetRequestedUrls().size();
+	const auto BatchStart		= std::chrono::steady_clock::now();
+
+	FileManager.GetFileBatch(Requests, MaxInFlight, csp::common::CancellationToken::Dummy());
+
+	EXPECT_TRUE(WaitForAll(BatchReceived));
+	const auto BatchTime = std::chrono::steady_clock::now() - BatchStart;
+
+	// Every asset gets its own data, but files shared by several assets are only downloaded once
+	for (size_t i = 0; i < NumAssets; ++i)
+	{
+		EXPECT_EQ(BatchResults[i].ResponseCode, EResponseCodes::ResponseOK);
+		EXPECT_EQ(BatchResults[i].Content, FileContents[Manifest[i]]);
+	}
+
+	const auto RequestedUrls = Server.GetRequestedUrls();
+	ASSERT_EQ(RequestedUrls.size() - RequestsBefore, NumUniqueFiles);
+
+	// Higher priority files are requested first. Allow for the requests already in flight being answered out of order.
+	for (size_t i = RequestsBefore; i < RequestsBefore + NumUniqueFiles / 10 - MaxInFlight; ++i)
+	{
+		const std::string Prefix = "https://assets.example.com/space/asset_";
+		const size_t FileIndex	 = std::stoul(RequestedUrls[i].substr(Prefix.size()));
+
+		EXPECT_EQ(FileIndex % 10, 0) << RequestedUrls[i];
+	}
+
+	// Time until every asset in the manifest has its data, recorded in the test report rather than compared, as it depends on the machine
+	RecordProperty("SeparateRequestsAllAssetsMs", std::to_string(std::chrono::duration<double, std::milli>(SeparateTime).count()));
+	RecordProperty("BatchAllAssetsMs", std::to_string(std::chrono::duration<double, std::milli>(BatchTime).count()));
+
+	// A cancelled batch is answered as quickly as requests are sent, and every file still gets its response
+	constexpr size_t NumCancelled = 2000;
+
+	std::vector<DownloadResult> CancelledResults(NumCancelled);
+	std::vector<std::atomic_bool> CancelledReceived(NumCancelled);
+	std::vector<BatchFileRequest> CancelledRequests;
+
+	for (size_t i = 0; i < NumCancelled; ++i)
+	{
+		CancelledRequests.push_back({("https://assets.example.com/space/cancelled_" + std::to_string(i) + ".glb").c_str(),
+									 0,
+									 CSP_NEW DownloadResultHandler(CancelledResults[i], CancelledReceived[i])});
+	}
+
+	csp::common::CancellationToken CancellationToken;
+	CancellationToken.Cancel();
+
+	FileManager.GetFileBatch(CancelledRequests, 1, CancellationToken);
+
+	EXPECT_TRUE(WaitForAll(CancelledReceived));
+
+	for (const auto& Result : CancelledResults)
+	{
+		EXPECT_EQ(Result.ResponseCode, EResponseCodes::ResponseRequestTimeout);
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+#endif
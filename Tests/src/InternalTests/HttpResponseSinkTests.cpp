@@ -0,0 +1,257 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_HTTPRESPONSESINK_TESTS)
+	#include "TestHelpers.h"
+	#include "Web/HttpPayload.h"
+	#include "Web/HttpResponseSink.h"
+
+	#include "gtest/gtest.h"
+	#include <filesystem>
+	#include <fstream>
+	#include <iterator>
+	#include <sstream>
+	#include <string>
+
+
+using namespace csp::web;
+
+
+namespace
+{
+
+std::string GetTestFilePath(const char* Name)
+{
+	return (std::filesystem::temp_directory_path() / Name).string();
+}
+
+std::string ReadFile(const std::string& Path)
+{
+	std::ifstream File(Path, std::ios::binary);
+
+	return std::string(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+}
+
+std::string MakeBody(size_t Size)
+{
+	std::string Body(Size, '\0');
+
+	for (size_t i = 0; i < Size; ++i)
+	{
+		Body[i] = static_cast<char>('a' + (i * 7) % 26);
+	}
+
+	return Body;
+}
+
+// Reads a body from a stream into a sink in the same way as POCOWebClient, asking the sink for memory and reading straight into it.
+// Returns false if the sink rejected the body or ran out of room.
+bool ReadIntoSink(std::istream& Stream, size_t ContentLength, size_t ReadSize, IHttpResponseSink& Sink)
+{
+	const bool IsLengthKnown = (ContentLength != IHttpResponseSink::UnknownLength);
+
+	if (!Sink.Begin(ContentLength))
+	{
+		Sink.End(false);
+
+		return false;
+	}
+
+	size_t TotalRead = 0;
+
+	while (Stream.good() && (!IsLengthKnown || TotalRead < ContentLength))
+	{
+		size_t ReadLength = IsLengthKnown ? std::min(ReadSize, ContentLength - TotalRead) : ReadSize;
+		char* Buffer	  = Sink.GetWriteBuffer(TotalRead, ReadLength);
+
+		if (Buffer == nullptr || ReadLength == 0)
+		{
+			Sink.End(false);
+
+			return false;
+		}
+
+		Stream.read(Buffer, ReadLength);
+		const size_t Read = static_cast<size_t>(Stream.gcount());
+
+		if (Read > 0)
+		{
+			Sink.OnWritten(TotalRead, Read);
+			TotalRead += Read;
+		}
+	}
+
+	Sink.End(true);
+
+	return true;
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, HttpResponseSinkTests, PayloadResponseSinkTest)
+{
+	const std::string Body = MakeBody(100 * 1024 + 17);
+
+	// Known length is read straight into the preallocated payload
+	{
+		HttpPayload Payload;
+		PayloadResponseSink Sink(Payload);
+		std::istringstream Stream(Body);
+
+		EXPECT_TRUE(ReadIntoSink(Stream, Body.size(), 4096, Sink));
+		EXPECT_EQ(Sink.GetSize(), Body.size());
+		EXPECT_EQ(std::string(Payload.GetContent().c_str(), Payload.GetContent().Length()), Body);
+	}
+
+	// Unknown length is collected and only set as the content once complete
+	{
+		HttpPayload Payload;
+		PayloadResponseSink Sink(Payload);
+		std::istringstream Stream(Body);
+
+		EXPECT_TRUE(ReadIntoSink(Stream, IHttpResponseSink::UnknownLength, 4096, Sink));
+		EXPECT_EQ(Sink.GetSize(), Body.size());
+		EXPECT_EQ(std::string(Payload.GetContent().c_str(), Payload.GetContent().Length()), Body);
+	}
+}
+
+CSP_INTERNAL_TEST(CSPEngine, HttpResponseSinkTests, BufferResponseSinkTest)
+{
+	const std::string Body = MakeBody(10000);
+	std::string Buffer(Body.size(), '\0');
+
+	BufferResponseSink Sink(Buffer.data(), Buffer.size());
+
+	EXPECT_TRUE(WriteToResponseSink(Sink, Body.data(), Body.size()));
+	EXPECT_EQ(Sink.GetSize(), Body.size());
+	EXPECT_EQ(Buffer, Body);
+
+	// Rejected up front when the length is known to be too long
+	BufferResponseSink SmallSink(Buffer.data(), Buffer.size() - 1);
+
+	EXPECT_FALSE(SmallSink.Begin(Body.size()));
+
+	// And runs out of room part way through when it isn't
+	std::istringstream Stream(Body);
+
+	EXPECT_FALSE(ReadIntoSink(Stream, IHttpResponseSink::UnknownLength, 4096, SmallSink));
+	EXPECT_EQ(SmallSink.GetSize(), Body.size() - 1);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, HttpResponseSinkTests, FileResponseSinkTest)
+{
+	const std::string Path = GetTestFilePath("csp_response_sink_test.bin");
+	const std::string Body = MakeBody(1024 * 1024 + 3);
+
+	// Known length is written into a mapping of the file
+	{
+		FileResponseSink Sink(Path, 64 * 1024);
+		std::istringstream Stream(Body);
+
+		EXPECT_TRUE(ReadIntoSink(Stream, Body.size(), 256 * 1024, Sink));
+		EXPECT_EQ(ReadFile(Path), Body);
+	}
+
+	// Unknown length replaces the previous file, written through the sink's buffer
+	{
+		const std::string Shorter = Body.substr(0, Body.size() / 2);
+
+		FileResponseSink Sink(Path, 64 * 1024);
+		std::istringstream Stream(Shorter);
+
+		EXPECT_TRUE(ReadIntoSink(Stream, IHttpResponseSink::UnknownLength, 256 * 1024, Sink));
+		EXPECT_EQ(Sink.GetSize(), Shorter.size());
+		EXPECT_EQ(ReadFile(Path), Shorter);
+	}
+
+	// An empty body replaces the previous file with an empty one
+	{
+		FileResponseSink Sink(Path, 64 * 1024);
+		std::istringstream Stream("");
+
+		EXPECT_TRUE(ReadIntoSink(Stream, 0, 256 * 1024, Sink));
+		EXPECT_EQ(Sink.GetSize(), 0);
+		ASSERT_TRUE(std::filesystem::exists(Path));
+		EXPECT_EQ(std::filesystem::file_size(Path), 0);
+	}
+
+	// A failed download doesn't leave a partial file behind
+	{
+		FileResponseSink Sink(Path, 64 * 1024);
+
+		ASSERT_TRUE(Sink.Begin(Body.size()));
+
+		size_t Length = 1000;
+		char* Buffer  = Sink.GetWriteBuffer(0, Length);
+		ASSERT_NE(Buffer, nullptr);
+
+		memcpy(Buffer, Body.data(), Length);
+		Sink.OnWritten(0, Length);
+		Sink.End(false);
+
+		EXPECT_FALSE(std::filesystem::exists(Path));
+	}
+}
+
+CSP_INTERNAL_TEST(CSPEngine, HttpResponseSinkTests, CallbackResponseSinkTest)
+{
+	const std::string Body = MakeBody(300 * 1024);
+	std::string Received;
+	size_t NumChunks = 0;
+
+	CallbackResponseSink Sink(
+		[&Received, &NumChunks](size_t Offset, const char* Data, size_t Length)
+		{
+			EXPECT_EQ(Offset, Received.size());
+			EXPECT_LE(Length, 64 * 1024);
+
+			Received.append(Data, Length);
+			++NumChunks;
+		},
+		64 * 1024);
+
+	std::istringstream Stream(Body);
+
+	EXPECT_TRUE(ReadIntoSink(Stream, Body.size(), 256 * 1024, Sink));
+	EXPECT_EQ(Received, Body);
+	EXPECT_EQ(NumChunks, 5);
+
+	// A retried request starts again from the beginning
+	Received.clear();
+	EXPECT_TRUE(WriteToResponseSink(Sink, Body.data(), Body.size()));
+	EXPECT_EQ(Received, Body);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, HttpResponseSinkTests, FileResponseSinkLargeBodyTest)
+{
+	// A download larger than any buffer along the way is read straight into a mapping of the file
+	const std::string Path = GetTestFilePath("csp_response_sink_large.bin");
+	const std::string Body = MakeBody(64 * 1024 * 1024);
+
+	{
+		std::istringstream Stream(Body);
+		FileResponseSink Sink(Path, 256 * 1024);
+
+		EXPECT_TRUE(ReadIntoSink(Stream, Body.size(), 256 * 1024, Sink));
+		EXPECT_EQ(Sink.GetSize(), Body.size());
+	}
+
+	EXPECT_EQ(ReadFile(Path), Body);
+	std::filesystem::remove(Path);
+}
+
+#endif
\ No newline at end of file
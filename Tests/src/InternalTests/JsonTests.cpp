@@ -19,6 +19,11 @@
 	#include "gtest/gtest.h"
 
 	#include "Json/JsonSerializer.h"
+	#include "Memory/MemoryManager.h"
+	#include "Services/ApiBase/ApiBase.h"
+
+	#include <chrono>
+	#include <string>
 
 using namespace csp::json;
 
@@ -291,4 +296,186 @@ CSP_INTERNAL_TEST(CSPEngine, JsonTests, JsonObjectContainerObjectTest)
 	}
 }
 
+// A Dto shaped like the asset details returned by GetAssetsByCriteria, which can only read itself from a string
+class TestAssetStringDto : public csp::services::DtoBase
+{
+public:
+	void FromJson(const csp::common::String& Json) override
+	{
+		++NumParses;
+
+		rapidjson::Document JsonDoc;
+		JsonDoc.Parse(Json.c_str());
+
+		ReadMembers(JsonDoc);
+	}
+
+	csp::common::String Id;
+	csp::common::String Name;
+	csp::common::String Uri;
+	int32_t Version = 0;
+	std::vector<csp::common::String> Tags;
+
+	static int NumParses;
+
+protected:
+	void ReadMembers(const rapidjson::Value& Json)
+	{
+		for (const auto& Member : Json.GetObject())
+		{
+			const std::string_view MemberName(Member.name.GetString(), Member.name.GetStringLength());
+
+			if (MemberName == "id")
+			{
+				csp::web::JsonValueToType(Member.value, Id);
+			}
+			else if (MemberName == "name")
+			{
+				csp::web::JsonValueToType(Member.value, Name);
+			}
+			else if (MemberName == "uri")
+			{
+				csp::web::JsonValueToType(Member.value, Uri);
+			}
+			else if (MemberName == "version")
+			{
+				csp::web::JsonValueToType(Member.value, Version);
+			}
+			else if (MemberName == "tags")
+			{
+				csp::web::JsonValueToType(Member.value, Tags);
+			}
+		}
+	}
+};
+
+int TestAssetStringDto::NumParses = 0;
+
+// The same Dto, which can also read itself from a value in an already parsed response
+class TestAssetDto : public TestAssetStringDto
+{
+public:
+	void FromJsonValue(const rapidjson::Value& Json) override
+	{
+		ReadMembers(Json);
+	}
+};
+
+std::string MakeTestAssetsJson(int NumAssets)
+{
+	std::string Json = "{\"skip\":0,\"limit\":" + std::to_string(NumAssets) + ",\"items\":[";
+	char Item[512];
+
+	for (int i = 0; i < NumAssets; ++i)
+	{
+		snprintf(Item,
+				 sizeof(Item),
+				 "%s{\"id\":\"64f1c2a9e4b0%012d\",\"name\":\"Asset_%05d\",\"uri\":\"https://assets.example.com/spaces/64f1c2a9e4b0a1b2c3d4e5f6/"
+				 "asset_%05d.glb\",\"version\":%d,\"tags\":[\"model\",\"lod0\"]}",
+				 i == 0 ? "" : ",",
+				 i,
+				 i,
+				 i,
+				 i % 7);
+		Json += Item;
+	}
+
+	Json += "]}";
+
+	return Json;
+}
+
+CSP_INTERNAL_TEST(CSPEngine, JsonTests, DtoArrayFromJsonValueTest)
+{
+	const std::string Json = MakeTestAssetsJson(3);
+
+	csp::services::DtoArray<TestAssetDto> Assets;
+	TestAssetStringDto::NumParses = 0;
+	Assets.FromJson(Json.c_str());
+
+	// Elements are read from the parsed response
+	ASSERT_EQ(Assets.GetArray().size(), 3);
+	EXPECT_EQ(TestAssetStringDto::NumParses, 0);
+	EXPECT_EQ(Assets.GetArray()[1].Id, "64f1c2a9e4b0000000000001");
+	EXPECT_EQ(Assets.GetArray()[1].Name, "Asset_00001");
+	EXPECT_EQ(Assets.GetArray()[2].Version, 2);
+	ASSERT_EQ(Assets.GetArray()[2].Tags.size(), 2);
+	EXPECT_EQ(Assets.GetArray()[2].Tags[1], "lod0");
+
+	// Dtos which can only read a string are still supported, by writing each element back out to a string
+	csp::services::DtoArray<TestAssetStringDto> StringAssets;
+	StringAssets.FromJson(Json.c_str());
+
+	ASSERT_EQ(StringAssets.GetArray().size(), 3);
+	EXPECT_EQ(TestAssetStringDto::NumParses, 3);
+	EXPECT_EQ(StringAssets.GetArray()[1].Uri, Assets.GetArray()[1].Uri);
+
+	// Plain arrays are read in the same way as objects with an items array
+	csp::services::DtoArray<TestAssetDto> PlainAssets;
+	PlainAssets.FromJson("[{\"name\":\"First\"},{\"name\":\"Second\"}]");
+
+	ASSERT_EQ(PlainAssets.GetArray().size(), 2);
+	EXPECT_EQ(PlainAssets.GetArray()[1].Name, "Second");
+
+	// Anything else is ignored
+	csp::services::DtoArray<TestAssetDto> NoAssets;
+	NoAssets.FromJson("{\"items\":3}");
+	NoAssets.FromJson("\"items\"");
+
+	EXPECT_TRUE(NoAssets.GetArray().empty());
+}
+
+CSP_INTERNAL_TEST(CSPEngine, JsonTests, DtoArrayParseBenchmarkTest)
+{
+	constexpr int NumAssets = 10000;
+
+	const csp::common::String Json(MakeTestAssetsJson(NumAssets).c_str());
+	const auto& Allocator = csp::memory::MemoryManager::GetDefaultAllocator();
+
+	// Reading each element from a string, as every Dto did before they could read from a parsed value
+	csp::services::DtoArray<TestAssetStringDto> StringAssets;
+	TestAssetStringDto::NumParses = 0;
+	size_t StartAllocations		  = Allocator.GetNumAllocations();
+	auto Start					  = std::chrono::steady_clock::now();
+
+	StringAssets.FromJson(Json);
+
+	const double StringSeconds	   = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	const size_t StringAllocations = Allocator.GetNumAllocations() - StartAllocations;
+	const int StringParses		   = TestAssetStringDto::NumParses;
+
+	// Reading each element straight from the parsed response
+	csp::services::DtoArray<TestAssetDto> Assets;
+	TestAssetStringDto::NumParses = 0;
+	StartAllocations			  = Allocator.GetNumAllocations();
+	Start						  = std::chrono::steady_clock::now();
+
+	Assets.FromJson(Json);
+
+	const double ValueSeconds	  = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	const size_t ValueAllocations = Allocator.GetNumAllocations() - StartAllocations;
+
+	ASSERT_EQ(Assets.GetArray().size(), NumAssets);
+	ASSERT_EQ(StringAssets.GetArray().size(), NumAssets);
+	EXPECT_EQ(StringParses, NumAssets);
+	EXPECT_EQ(TestAssetStringDto::NumParses, 0);
+	EXPECT_LT(ValueAllocations, StringAllocations);
+
+	for (int i = 0; i < NumAssets; i += 997)
+	{
+		EXPECT_EQ(Assets.GetArray()[i].Id, StringAssets.GetArray()[i].Id);
+		EXPECT_EQ(Assets.GetArray()[i].Uri, StringAssets.GetArray()[i].Uri);
+		EXPECT_EQ(Assets.GetArray()[i].Version, StringAssets.GetArray()[i].Version);
+		EXPECT_EQ(Assets.GetArray()[i].Tags.size(), StringAssets.GetArray()[i].Tags.size());
+	}
+
+	const double Megabytes = Json.Length() / (1024.0 * 1024.0);
+
+	RecordProperty("ResponseMegabytes", std::to_string(Megabytes));
+	RecordProperty("StringMegabytesPerSecond", std::to_string(Megabytes / StringSeconds));
+	RecordProperty("StringAllocations", std::to_string(StringAllocations));
+	RecordProperty("ValueMegabytesPerSecond", std::to_string(Megabytes / ValueSeconds));
+	RecordProperty("ValueAllocations", std::to_string(ValueAllocations));
+}
+
 #endif
\ No newline at end of file
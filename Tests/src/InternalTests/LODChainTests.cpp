@@ -0,0 +1,418 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_LOD_CHAIN_TESTS)
+	#include "CSP/Common/CancellationToken.h"
+	#include "Common/Scheduler.h"
+	#include "Systems/Assets/LODChainCache.h"
+	#include "Systems/Assets/LODHelpers.h"
+	#include "Systems/Assets/LODPrefetch.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <condition_variable>
+	#include <deque>
+	#include <functional>
+	#include <map>
+	#include <mutex>
+	#include <string>
+	#include <vector>
+
+
+using namespace csp::systems;
+using namespace std::chrono_literals;
+
+
+namespace
+{
+
+Asset MakeLODAsset(const std::string& Id, const std::string& CollectionId, const std::string& Style)
+{
+	Asset NewAsset;
+	NewAsset.Id				   = Id.c_str();
+	NewAsset.AssetCollectionId = CollectionId.c_str();
+	NewAsset.Styles			   = csp::common::Array<csp::common::String> {"Default", Style.c_str()};
+
+	return NewAsset;
+}
+
+// Stands in for the asset service, keeping the assets of each collection in memory and counting round trips. Responses can be held
+// back and released later, so that requests can overlap as they would over the network.
+class LocalLODStore : public LODChainCache::IStore
+{
+public:
+	void GetModelAssets(const std::string& AssetCollectionId, LODChainCache::AssetsCallback Callback) override
+	{
+		++NumGets;
+
+		Respond(
+			[this, AssetCollectionId, Callback]()
+			{
+				const auto& CollectionAssets = Assets[AssetCollectionId];
+				csp::common::Array<Asset> Result(CollectionAssets.size());
+
+				for (size_t i = 0; i < CollectionAssets.size(); ++i)
+				{
+					Result[i] = CollectionAssets[i];
+				}
+
+				Callback(!ShouldFail, ShouldFail ? 500 : 200, Result);
+			});
+	}
+
+	// Sends held back responses, including any to requests made while doing so
+	void ReleaseAll()
+	{
+		while (!Held.empty())
+		{
+			auto Response = std::move(Held.front());
+			Held.pop_front();
+			Response();
+		}
+	}
+
+	std::map<std::string, std::vector<Asset>> Assets;
+	int NumGets		= 0;
+	bool IsDeferred = false;
+	bool ShouldFail = false;
+
+private:
+	void Respond(std::function<void()> Response)
+	{
+		if (IsDeferred)
+		{
+			Held.push_back(std::move(Response));
+		}
+		else
+		{
+			Response();
+		}
+	}
+
+	std::deque<std::function<void()>> Held;
+};
+
+LODChain MakeChain(const std::vector<int>& Levels)
+{
+	LODChain Chain;
+	Chain.AssetCollectionId = "Collection";
+	Chain.LODAssets			= csp::common::Array<LODAsset>(Levels.size());
+
+	for (size_t i = 0; i < Levels.size(); ++i)
+	{
+		Chain.LODAssets[i].Asset.Id = ("Asset" + std::to_string(Levels[i])).c_str();
+		Chain.LODAssets[i].Level	= Levels[i];
+	}
+
+	return Chain;
+}
+
+// Records the levels a prefetch downloads and when, and waits for it to finish
+struct PrefetchRecorder
+{
+	void Downloaded(int Level)
+	{
+		std::scoped_lock Lock(Mutex);
+		Levels.push_back(Level);
+		Times.push_back(LODPrefetch::Clock::now());
+	}
+
+	void Complete(bool InSucceeded, uint16_t InHttpResultCode)
+	{
+		std::scoped_lock Lock(Mutex);
+		Succeeded	   = InSucceeded;
+		HttpResultCode = InHttpResultCode;
+		IsComplete	   = true;
+		Done.notify_all();
+	}
+
+	bool WaitUntilComplete()
+	{
+		std::unique_lock Lock(Mutex);
+
+		return Done.wait_for(Lock,
+							 10s,
+							 [this]()
+							 {
+								 return IsComplete;
+							 });
+	}
+
+	std::mutex Mutex;
+	std::condition_variable Done;
+	std::vector<int> Levels;
+	std::vector<LODPrefetch::Clock::time_point> Times;
+	bool IsComplete			= false;
+	bool Succeeded			= false;
+	uint16_t HttpResultCode = 0;
+};
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, LODChainTests, MultiDigitLevelTest)
+{
+	using Styles = csp::common::Array<csp::common::String>;
+
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"Default", "lod:3"}), 3);
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"lod:12"}), 12);
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {CreateLODStyleVar(105)}), 105);
+
+	// Styles that only look like LOD styles are ignored
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"Default"}), -1);
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"lod:"}), -1);
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"lod:-1"}), -1);
+	EXPECT_EQ(GetLODLevelFromStylesArray(Styles {"lod:2x", "lod:7"}), 7);
+
+	const csp::common::Array<Asset> Assets {MakeLODAsset("Asset10", "Collection", "lod:10"),
+											MakeLODAsset("Asset2", "Collection", "lod:2"),
+											MakeLODAsset("Other", "Collection", "Default"),
+											MakeLODAsset("Asset0", "Collection", "lod:0")};
+
+	const LODChain Chain = CreateLODChainFromAssets(Assets, "Collection");
+
+	ASSERT_EQ(Chain.LODAssets.Size(), 3);
+	EXPECT_EQ(Chain.LODAssets[0].Level, 0);
+	EXPECT_EQ(Chain.LODAssets[1].Level, 2);
+	EXPECT_EQ(Chain.LODAssets[2].Level, 10);
+	EXPECT_EQ(Chain.LODAssets[2].Asset.Id, "Asset10");
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LODChainTests, CachedChainTest)
+{
+	constexpr int NUM_REQUESTS = 50;
+
+	LocalLODStore Store;
+	Store.Assets["Collection"] = {MakeLODAsset("Asset0", "Collection", "lod:0"), MakeLODAsset("Asset1", "Collection", "lod:1")};
+	Store.IsDeferred		   = true;
+
+	LODChainCache Cache(&Store, 10, 15min);
+
+	int NumSucceeded = 0;
+
+	const auto CountChain = [&NumSucceeded](bool Succeeded, uint16_t /*HttpResultCode*/, const LODChain& Chain)
+	{
+		NumSucceeded += (Succeeded && Chain.LODAssets.Size() == 2) ? 1 : 0;
+	};
+
+	// Requests made while the chain is being fetched wait for the same response
+	for (int i = 0; i < NUM_REQUESTS / 2; ++i)
+	{
+		Cache.GetChain("Collection", CountChain);
+	}
+
+	Store.ReleaseAll();
+
+	for (int i = 0; i < NUM_REQUESTS / 2; ++i)
+	{
+		Cache.GetChain("Collection", CountChain);
+	}
+
+	EXPECT_EQ(NumSucceeded, NUM_REQUESTS);
+	EXPECT_EQ(Store.NumGets, 1);
+
+	// Changes to any asset in the collection, whether or not the collection is known, discard the chain
+	Store.IsDeferred = false;
+
+	Cache.OnAssetChanged("", "Collection");
+	Cache.GetChain("Collection", CountChain);
+	EXPECT_EQ(Store.NumGets, 2);
+
+	Cache.OnAssetChanged("Asset1", "");
+	Cache.GetChain("Collection", CountChain);
+	EXPECT_EQ(Store.NumGets, 3);
+
+	Cache.OnAssetChanged("Unrelated", "");
+	Cache.GetChain("Collection", CountChain);
+	EXPECT_EQ(Store.NumGets, 3);
+
+	// A chain invalidated while it is being fetched isn't cached
+	Store.IsDeferred = true;
+	Cache.Invalidate("Collection");
+	Cache.GetChain("Collection", CountChain);
+	Cache.Invalidate("Collection");
+	Store.ReleaseAll();
+
+	EXPECT_EQ(Cache.GetNumChains(), 0);
+
+	// Clearing the cache fails anything waiting
+	bool Failed = false;
+	Cache.GetChain("Collection",
+				   [&Failed](bool Succeeded, uint16_t /*HttpResultCode*/, const LODChain& /*Chain*/)
+				   {
+					   Failed = !Succeeded;
+				   });
+	Cache.Clear();
+	Store.ReleaseAll();
+
+	EXPECT_TRUE(Failed);
+	EXPECT_EQ(Cache.GetNumChains(), 0);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LODChainTests, PrefetchOrderTest)
+{
+	// Levels are downloaded from the coarsest to the finest, whatever order the chain is in
+	{
+		PrefetchRecorder Recorder;
+
+		auto Prefetch = std::make_shared<LODPrefetch>(
+			MakeChain({0, 12, 1, 3}),
+			0,
+			csp::common::CancellationToken::Dummy(),
+			[&Recorder](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+			{
+				Recorder.Downloaded(Level.Level);
+				Downloaded(true, 200, 1024);
+			},
+			[&Recorder](bool Succeeded, uint16_t HttpResultCode)
+			{
+				Recorder.Complete(Succeeded, HttpResultCode);
+			});
+		Prefetch->Start();
+
+		ASSERT_TRUE(Recorder.WaitUntilComplete());
+		EXPECT_TRUE(Recorder.Succeeded);
+		EXPECT_EQ(Recorder.Levels, (std::vector<int> {12, 3, 1, 0}));
+	}
+
+	// A level that fails doesn't stop the others, but fails the prefetch
+	{
+		PrefetchRecorder Recorder;
+
+		auto Prefetch = std::make_shared<LODPrefetch>(
+			MakeChain({0, 1, 2}),
+			0,
+			csp::common::CancellationToken::Dummy(),
+			[&Recorder](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+			{
+				Recorder.Downloaded(Level.Level);
+				Downloaded(Level.Level != 2, Level.Level != 2 ? 200 : 404, 1024);
+			},
+			[&Recorder](bool Succeeded, uint16_t HttpResultCode)
+			{
+				Recorder.Complete(Succeeded, HttpResultCode);
+			});
+		Prefetch->Start();
+
+		ASSERT_TRUE(Recorder.WaitUntilComplete());
+		EXPECT_FALSE(Recorder.Succeeded);
+		EXPECT_EQ(Recorder.HttpResultCode, 404);
+		EXPECT_EQ(Recorder.Levels, (std::vector<int> {2, 1, 0}));
+	}
+
+	// Cancelling stops the prefetch before the next level
+	{
+		PrefetchRecorder Recorder;
+		csp::common::CancellationToken Token;
+
+		auto Prefetch = std::make_shared<LODPrefetch>(
+			MakeChain({0, 1, 2}),
+			0,
+			Token,
+			[&Recorder, &Token](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+			{
+				Recorder.Downloaded(Level.Level);
+				Token.Cancel();
+				Downloaded(true, 200, 1024);
+			},
+			[&Recorder](bool Succeeded, uint16_t HttpResultCode)
+			{
+				Recorder.Complete(Succeeded, HttpResultCode);
+			});
+		Prefetch->Start();
+
+		ASSERT_TRUE(Recorder.WaitUntilComplete());
+		EXPECT_FALSE(Recorder.Succeeded);
+		EXPECT_EQ(Recorder.Levels, (std::vector<int> {2}));
+	}
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LODChainTests, PrefetchBudgetTest)
+{
+	constexpr uint64_t LEVEL_SIZE		= 100 * 1024;
+	constexpr uint64_t BYTES_PER_SECOND = 1024 * 1024;
+
+	EXPECT_EQ(LODPrefetch::GetBudgetDelay(LEVEL_SIZE, 0), LODPrefetch::Clock::duration::zero());
+	EXPECT_EQ(LODPrefetch::GetBudgetDelay(BYTES_PER_SECOND / 2, BYTES_PER_SECOND), 500ms);
+
+	PrefetchRecorder Recorder;
+
+	const auto Start = LODPrefetch::Clock::now();
+
+	auto Prefetch = std::make_shared<LODPrefetch>(
+		MakeChain({0, 1, 2}),
+		BYTES_PER_SECOND,
+		csp::common::CancellationToken::Dummy(),
+		[&Recorder](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+		{
+			Recorder.Downloaded(Level.Level);
+			Downloaded(true, 200, LEVEL_SIZE);
+		},
+		[&Recorder](bool Succeeded, uint16_t HttpResultCode)
+		{
+			Recorder.Complete(Succeeded, HttpResultCode);
+		});
+	Prefetch->Start();
+
+	ASSERT_TRUE(Recorder.WaitUntilComplete());
+	EXPECT_TRUE(Recorder.Succeeded);
+	ASSERT_EQ(Recorder.Levels.size(), 3);
+
+	// The coarsest level is downloaded first, and each finer level once the bytes before it fit within the budget. Only the order and the
+	// lower bounds are checked, as how late a download starts depends on the load on the machine.
+	EXPECT_GE(Recorder.Times[0], Start);
+	EXPECT_LE(Recorder.Times[0], Recorder.Times[1]);
+	EXPECT_LE(Recorder.Times[1], Recorder.Times[2]);
+	EXPECT_GE(Recorder.Times[1] - Start, LODPrefetch::GetBudgetDelay(LEVEL_SIZE, BYTES_PER_SECOND));
+	EXPECT_GE(Recorder.Times[2] - Start, LODPrefetch::GetBudgetDelay(2 * LEVEL_SIZE, BYTES_PER_SECOND));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LODChainTests, PrefetchSchedulerShutdownTest)
+{
+	constexpr uint64_t LEVEL_SIZE		= 100 * 1024;
+	constexpr uint64_t BYTES_PER_SECOND = 1024 * 1024;
+
+	// Finer levels have to wait on the scheduler, which won't take any more timers
+	csp::GetScheduler()->Shutdown();
+
+	PrefetchRecorder Recorder;
+
+	auto Prefetch = std::make_shared<LODPrefetch>(
+		MakeChain({0, 1, 2}),
+		BYTES_PER_SECOND,
+		csp::common::CancellationToken::Dummy(),
+		[&Recorder](const LODAsset& Level, LODPrefetch::DownloadedCallback Downloaded)
+		{
+			Recorder.Downloaded(Level.Level);
+			Downloaded(true, 200, LEVEL_SIZE);
+		},
+		[&Recorder](bool Succeeded, uint16_t HttpResultCode)
+		{
+			Recorder.Complete(Succeeded, HttpResultCode);
+		});
+	Prefetch->Start();
+
+	EXPECT_TRUE(Recorder.WaitUntilComplete());
+	EXPECT_FALSE(Recorder.Succeeded);
+	EXPECT_EQ(Recorder.HttpResultCode, 0);
+	EXPECT_EQ(Recorder.Levels, std::vector<int>({2}));
+
+	// The next caller gets a new scheduler
+	csp::DestroyScheduler();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,548 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_LEADER_FAILOVER_TESTS)
+	#include "CSP/CSPFoundation.h"
+	#include "CSP/Systems/SystemsManager.h"
+	#include "Multiplayer/Election/ClientElectionManager.h"
+	#include "Multiplayer/Election/LeaderFailover.h"
+	#include "PlatformTestUtils.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <map>
+	#include <memory>
+	#include <set>
+	#include <vector>
+
+
+using namespace csp::multiplayer;
+using namespace std::chrono_literals;
+
+
+namespace
+{
+
+using Clock = LeaderFailover::Clock;
+
+constexpr Clock::duration HEARTBEAT_INTERVAL = 250ms;
+constexpr Clock::duration TIMEOUT			 = 1000ms;
+constexpr Clock::duration LATENCY			 = 20ms;
+constexpr Clock::duration TICK				 = 5ms;
+
+// Stands in for the multiplayer connection, passing heartbeats between clients in the same process with a fixed latency, on a simulated
+// clock so that every run is the same. Clients can be stopped, as if they had crashed, or cut off from the others, and can be made to
+// never send heartbeats, as a client running an older version wouldn't.
+class LocalElectionTransport
+{
+public:
+	struct Client
+	{
+		std::unique_ptr<LeaderFailover> Failover;
+		bool IsRunning		 = true;
+		bool IsCutOff		 = false;
+		bool SendsHeartbeats = true;
+	};
+
+	explicit LocalElectionTransport(const std::vector<int64_t>& Ids) : Now(Clock::time_point() + 1h)
+	{
+		for (int64_t Id : Ids)
+		{
+			Client& NewClient = Clients[Id];
+
+			NewClient.Failover = std::make_unique<LeaderFailover>(
+				HEARTBEAT_INTERVAL,
+				TIMEOUT,
+				[this, Id](uint64_t Epoch)
+				{
+					Broadcast(Id, Epoch);
+				},
+				nullptr);
+		}
+
+		for (auto& Entry : Clients)
+		{
+			Entry.second.Failover->SetLocalClient(Entry.first, Now);
+
+			for (int64_t Id : Ids)
+			{
+				Entry.second.Failover->AddClient(Id);
+			}
+		}
+	}
+
+	// Tells every running client the result of an election
+	void Elect(int64_t LeaderId)
+	{
+		for (auto& Entry : Clients)
+		{
+			if (Entry.second.IsRunning)
+			{
+				Entry.second.Failover->SetLeader(LeaderId, Now);
+			}
+		}
+	}
+
+	// Tells every running client that another has left the space
+	void Remove(int64_t Id)
+	{
+		Clients[Id].IsRunning = false;
+
+		for (auto& Entry : Clients)
+		{
+			if (Entry.second.IsRunning)
+			{
+				Entry.second.Failover->RemoveClient(Id, Now);
+			}
+		}
+	}
+
+	void Run(Clock::duration Time)
+	{
+		RunUntil(
+			[]()
+			{
+				return false;
+			},
+			Time);
+	}
+
+	// Ticks every running client until Condition holds, returning how long that took, or Limit if it never did
+	template <typename ConditionType> Clock::duration RunUntil(ConditionType Condition, Clock::duration Limit)
+	{
+		const Clock::time_point Start = Now;
+
+		while (Now - Start < Limit)
+		{
+			if (Condition())
+			{
+				return Now - Start;
+			}
+
+			Now += TICK;
+			Deliver();
+
+			for (auto& Entry : Clients)
+			{
+				if (Entry.second.IsRunning)
+				{
+					Entry.second.Failover->Update(Now);
+				}
+			}
+		}
+
+		return Limit;
+	}
+
+	// Whether every running client that isn't cut off agrees on the leader and its epoch
+	bool Agree(int64_t LeaderId, uint64_t Epoch) const
+	{
+		for (const auto& Entry : Clients)
+		{
+			const LeaderFailover& Failover = *Entry.second.Failover;
+
+			if (Entry.second.IsRunning && !Entry.second.IsCutOff && (Failover.GetLeader() != LeaderId || Failover.GetEpoch() != Epoch))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	LeaderFailover& Get(int64_t Id)
+	{
+		return *Clients[Id].Failover;
+	}
+
+	std::map<int64_t, Client> Clients;
+	Clock::time_point Now;
+
+private:
+	struct Message
+	{
+		Clock::time_point DeliveryTime;
+		int64_t From;
+		int64_t To;
+		uint64_t Epoch;
+	};
+
+	void Broadcast(int64_t From, uint64_t Epoch)
+	{
+		if (!Clients[From].SendsHeartbeats)
+		{
+			return;
+		}
+
+		for (const auto& Entry : Clients)
+		{
+			if (Entry.first != From)
+			{
+				InFlight.push_back({Now + LATENCY, From, Entry.first, Epoch});
+			}
+		}
+	}
+
+	void Deliver()
+	{
+		std::vector<Message> Due;
+
+		for (auto It = InFlight.begin(); It != InFlight.end();)
+		{
+			if (It->DeliveryTime <= Now)
+			{
+				Due.push_back(*It);
+				It = InFlight.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+
+		for (const Message& Delivered : Due)
+		{
+			const Client& From = Clients[Delivered.From];
+			Client& To		   = Clients[Delivered.To];
+
+			if (To.IsRunning && From.IsCutOff == To.IsCutOff)
+			{
+				To.Failover->OnHeartbeat(Delivered.From, Delivered.Epoch, Now);
+			}
+		}
+	}
+
+	std::vector<Message> InFlight;
+};
+
+double ToMilliseconds(Clock::duration Time)
+{
+	return std::chrono::duration<double, std::milli>(Time).count();
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, SilentLeaderDropTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(2s);
+
+	ASSERT_TRUE(Transport.Agree(5, 1));
+	EXPECT_EQ(Transport.Get(1).GetSuccessor(), 4);
+
+	// The leader stops without leaving the space, so only its missing heartbeats show that it has gone
+	Transport.Clients[5].IsRunning = false;
+
+	const auto FirstTick = Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Get(4).IsLocalClientLeader();
+		},
+		10s);
+
+	const auto Agreed = FirstTick
+						+ Transport.RunUntil(
+							[&Transport]()
+							{
+								return Transport.Agree(4, 2);
+							},
+							10s);
+
+	// The successor takes over without an election once it has missed heartbeats for the timeout. The timeout runs from the last
+	// heartbeat to arrive, which may have been on its way when the leader stopped.
+	EXPECT_LE(ToMilliseconds(FirstTick), ToMilliseconds(TIMEOUT + LATENCY + TICK));
+	EXPECT_LE(ToMilliseconds(Agreed), ToMilliseconds(TIMEOUT + 2 * LATENCY + 2 * TICK));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, LeaderRemovedTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(1s);
+
+	// When the leader is seen to leave, the successor takes over straight away
+	Transport.Remove(5);
+
+	EXPECT_TRUE(Transport.Get(4).IsLocalClientLeader());
+	EXPECT_EQ(Transport.Get(4).GetEpoch(), 2);
+
+	for (int64_t Id : {1, 2, 3})
+	{
+		EXPECT_EQ(Transport.Get(Id).GetLeader(), 4);
+	}
+
+	const auto Agreed = Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	EXPECT_LE(ToMilliseconds(Agreed), ToMilliseconds(LATENCY + TICK));
+
+	// Nobody fails over again while the new leader is sending heartbeats
+	Transport.Run(5s);
+
+	EXPECT_TRUE(Transport.Agree(4, 2));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, StaleLeaderFencingTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(1s);
+
+	// Cut the leader off. It keeps believing it is the leader, while the others fail over.
+	Transport.Clients[5].IsCutOff = true;
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	ASSERT_TRUE(Transport.Agree(4, 2));
+	EXPECT_TRUE(Transport.Get(5).IsLocalClientLeader());
+	EXPECT_EQ(Transport.Get(5).GetEpoch(), 1);
+
+	// The new leader applies writes from either epoch, but the old one won't apply a write sent under the new epoch, and steps down
+	EXPECT_TRUE(Transport.Get(4).CanApplyScriptWrite(1, Transport.Now));
+	EXPECT_TRUE(Transport.Get(4).CanApplyScriptWrite(2, Transport.Now));
+	EXPECT_FALSE(Transport.Get(5).CanApplyScriptWrite(2, Transport.Now));
+	EXPECT_FALSE(Transport.Get(5).IsLocalClientLeader());
+
+	// Once the partition heals, the old leader hears from the new one, and its heartbeats from the old epoch are ignored
+	Transport.Clients[5].IsCutOff = false;
+
+	const auto Healed = Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	EXPECT_LE(ToMilliseconds(Healed), ToMilliseconds(HEARTBEAT_INTERVAL + LATENCY + TICK));
+
+	Transport.Run(5s);
+
+	EXPECT_TRUE(Transport.Agree(4, 2));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, StaleLeaderHeartbeatTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(1s);
+
+	// Cut the leader off until the others have failed over, then let it rejoin without anyone sending it a script
+	Transport.Clients[5].IsCutOff = true;
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	Transport.Clients[5].IsCutOff = false;
+
+	// The old leader's heartbeat reaches the others first, but is rejected as being from an old epoch
+	EXPECT_FALSE(Transport.Get(1).OnHeartbeat(5, 1, Transport.Now));
+	EXPECT_EQ(Transport.Get(1).GetLeader(), 4);
+
+	const auto Healed = Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	EXPECT_LE(ToMilliseconds(Healed), ToMilliseconds(HEARTBEAT_INTERVAL + LATENCY + TICK));
+	EXPECT_FALSE(Transport.Get(5).IsLocalClientLeader());
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, SuspectedLeaderTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(1s);
+
+	for (int64_t Id : {1, 2, 3, 4, 5})
+	{
+		EXPECT_FALSE(Transport.Get(Id).IsSuspected(5));
+	}
+
+	// Cut the leader off, so that the others time it out
+	Transport.Clients[5].IsCutOff = true;
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	for (int64_t Id : {1, 2, 3, 4})
+	{
+		EXPECT_TRUE(Transport.Get(Id).IsSuspected(5)) << "Client " << Id;
+		EXPECT_FALSE(Transport.Get(Id).IsSuspected(4)) << "Client " << Id;
+	}
+
+	// Once the partition heals, the old leader finds out it was replaced, and suspects itself as the others do
+	Transport.Clients[5].IsCutOff = false;
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 2);
+		},
+		10s);
+
+	EXPECT_TRUE(Transport.Agree(4, 2));
+	EXPECT_TRUE(Transport.Get(5).IsSuspected(5));
+	EXPECT_EQ(Transport.Get(5).GetSuccessor(), Transport.Get(1).GetSuccessor());
+
+	// A suspected client that leaves is forgotten
+	Transport.Remove(5);
+
+	for (int64_t Id : {1, 2, 3, 4})
+	{
+		EXPECT_FALSE(Transport.Get(Id).IsSuspected(5));
+	}
+
+	// A follower that hears from the successor under a newer epoch before timing the leader out suspects the leader all the same
+	LeaderFailover Follower(HEARTBEAT_INTERVAL, TIMEOUT, nullptr, nullptr);
+	Follower.SetLocalClient(1, Transport.Now);
+	Follower.AddClient(4);
+	Follower.AddClient(5);
+	Follower.SetLeader(5, Transport.Now);
+
+	EXPECT_TRUE(Follower.OnHeartbeat(5, 1, Transport.Now));
+	EXPECT_TRUE(Follower.OnHeartbeat(4, 2, Transport.Now + LATENCY));
+	EXPECT_TRUE(Follower.IsSuspected(5));
+	EXPECT_EQ(Follower.GetSuccessor(), 1);
+
+	// It is no longer suspected once it is heard from as leader again
+	EXPECT_TRUE(Follower.OnHeartbeat(5, 3, Transport.Now + 2 * LATENCY));
+	EXPECT_FALSE(Follower.IsSuspected(5));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, SuccessorAlsoDroppedTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	Transport.Elect(5);
+	Transport.Run(1s);
+
+	// The leader and its successor stop together, so the followers give up on the successor after a further timeout
+	Transport.Clients[5].IsRunning = false;
+	Transport.Clients[4].IsRunning = false;
+
+	const auto FirstTick = Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Get(3).IsLocalClientLeader();
+		},
+		10s);
+
+	EXPECT_LE(ToMilliseconds(FirstTick), ToMilliseconds(2 * TIMEOUT + LATENCY + 2 * TICK));
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(3, 2);
+		},
+		10s);
+
+	EXPECT_TRUE(Transport.Agree(3, 2));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, SilentElectedLeaderTest)
+{
+	LocalElectionTransport Transport({1, 2, 3, 4, 5});
+
+	// The elected leader is running an older version, so it never sends a heartbeat, but it is still running scripts
+	Transport.Clients[5].SendsHeartbeats = false;
+
+	Transport.Elect(5);
+	Transport.Run(5 * TIMEOUT);
+
+	// Nobody fails over from a leader they have never heard from, which would leave two clients running scripts
+	for (int64_t Id : {1, 2, 3, 4})
+	{
+		EXPECT_EQ(Transport.Get(Id).GetLeader(), 5);
+		EXPECT_FALSE(Transport.Get(Id).IsLocalClientLeader());
+	}
+
+	// Failing over when it is seen to leave still works
+	Transport.Remove(5);
+
+	EXPECT_TRUE(Transport.Get(4).IsLocalClientLeader());
+
+	Transport.RunUntil(
+		[&Transport]()
+		{
+			return Transport.Agree(4, 1);
+		},
+		10s);
+
+	EXPECT_TRUE(Transport.Agree(4, 1));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, LeaderFailoverTests, HeartbeatBeforeAvatarTest)
+{
+	InitialiseFoundation();
+
+	{
+		// Not connected, so the messages it sends go nowhere
+		ClientElectionManager Manager(csp::systems::SystemsManager::Get().GetSpaceEntitySystem());
+
+		Manager.LocalClient = Manager.AddClientUsingId(1);
+		Manager.Failover.SetLocalClient(1, LeaderFailover::Clock::now());
+
+		// The leader's heartbeat arrives before its avatar, so there is no client to make leader yet
+		Manager.OnLeaderHeartbeat(5, 1, false);
+
+		EXPECT_EQ(Manager.Failover.GetLeader(), 5);
+		EXPECT_EQ(Manager.GetLeader(), nullptr);
+
+		// Its avatar arriving makes it the leader, without waiting for another heartbeat or election
+		ClientProxy* Leader = Manager.AddClientUsingId(5);
+
+		ASSERT_NE(Leader, nullptr);
+		EXPECT_EQ(Manager.GetLeader(), Leader);
+		EXPECT_FALSE(Manager.IsLocalClientLeader());
+		EXPECT_EQ(Manager.GetLeaderEpoch(), 1);
+
+		// Other clients arriving don't change it
+		Manager.AddClientUsingId(3);
+
+		EXPECT_EQ(Manager.GetLeader(), Leader);
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+#endif
\ No newline at end of file
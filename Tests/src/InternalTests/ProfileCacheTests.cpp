@@ -0,0 +1,403 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_PROFILE_CACHE_TESTS)
+	#include "Systems/Users/ProfileCache.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <condition_variable>
+	#include <deque>
+	#include <functional>
+		#include <map>
+	#include <mutex>
+	#include <string>
+	#include <thread>
+	#include <vector>
+
+
+using namespace csp::systems;
+using namespace std::chrono_literals;
+
+
+namespace
+{
+
+constexpr size_t CAPACITY		= 1000;
+constexpr auto MAX_AGE			= 5min;
+constexpr auto BATCH_WINDOW		= 20ms;
+constexpr size_t MAX_BATCH_SIZE	= 100;
+
+// Stands in for the user service, counting requests and how many times each user was asked for. Responses can be held back and
+// released later, so that requests can overlap as they would over the network.
+class LocalProfileStore : public ProfileCache::IStore
+{
+public:
+	void GetBasicProfiles(const std::vector<std::string>& UserIds, ProfileCache::ProfilesCallback Callback) override
+	{
+		std::function<void()> Response;
+
+		{
+			std::scoped_lock Lock(Mutex);
+
+			++NumRequests;
+
+			for (const auto& UserId : UserIds)
+			{
+				++TimesRequested[UserId];
+			}
+
+			Response = [this, UserIds, Callback]()
+			{
+				std::vector<BasicProfile> Profiles;
+
+				for (const auto& UserId : UserIds)
+				{
+					// Users that don't exist are left out of the response
+					if (UserId.rfind("Missing", 0) == 0)
+					{
+						continue;
+					}
+
+					BasicProfile Profile;
+					Profile.UserId		= UserId.c_str();
+					Profile.DisplayName = (DisplayNamePrefix + UserId).c_str();
+					Profiles.push_back(Profile);
+				}
+
+				Callback(!ShouldFail, ShouldFail ? 500 : 200, Profiles);
+			};
+
+			if (IsDeferred)
+			{
+				Held.push_back(std::move(Response));
+
+				return;
+			}
+		}
+
+		Response();
+	}
+
+	// Sends held back responses, including any to requests made while doing so
+	void ReleaseAll()
+	{
+		for (;;)
+		{
+			std::function<void()> Response;
+
+			{
+				std::scoped_lock Lock(Mutex);
+
+				if (Held.empty())
+				{
+					return;
+				}
+
+				Response = std::move(Held.front());
+				Held.pop_front();
+			}
+
+			Response();
+		}
+	}
+
+	int GetNumRequests()
+	{
+		std::scoped_lock Lock(Mutex);
+
+		return NumRequests;
+	}
+
+	int GetTimesRequested(const std::string& UserId)
+	{
+		std::scoped_lock Lock(Mutex);
+
+		return TimesRequested[UserId];
+	}
+
+	bool IsDeferred				  = false;
+	bool ShouldFail				  = false;
+	std::string DisplayNamePrefix = "Name of ";
+
+private:
+	std::mutex Mutex;
+	int NumRequests = 0;
+	std::map<std::string, int> TimesRequested;
+	std::deque<std::function<void()>> Held;
+};
+
+// Counts callbacks, so that tests can wait for ones that are called from the scheduler's threads
+class CallbackCounter
+{
+public:
+	ProfileCache::ProfilesCallback Expect(std::vector<std::string> ExpectedUserIds)
+	{
+		{
+			std::scoped_lock Lock(Mutex);
+			++NumExpected;
+		}
+
+		return [this, ExpectedUserIds](bool Succeeded, uint16_t /*HttpResultCode*/, const std::vector<BasicProfile>& Profiles)
+		{
+			std::vector<std::string> UserIds;
+
+			for (const auto& Profile : Profiles)
+			{
+				UserIds.push_back(Profile.UserId.c_str());
+			}
+
+			std::scoped_lock Lock(Mutex);
+
+			NumSucceeded += Succeeded ? 1 : 0;
+			NumMatched += (UserIds == ExpectedUserIds) ? 1 : 0;
+			++NumCalled;
+			Called.notify_all();
+		};
+	}
+
+	bool WaitForAll()
+	{
+		std::unique_lock Lock(Mutex);
+
+		return Called.wait_for(Lock,
+							   5s,
+							   [this]()
+							   {
+								   return NumCalled == NumExpected;
+							   });
+	}
+
+	int NumExpected	 = 0;
+	int NumCalled	 = 0;
+	int NumSucceeded = 0;
+	int NumMatched	 = 0;
+
+private:
+	std::mutex Mutex;
+	std::condition_variable Called;
+};
+
+std::string GetAvatarId(int Index)
+{
+	return "User" + std::to_string(Index);
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, ProfileCacheTests, AvatarJoinStormTest)
+{
+	constexpr int NUM_AVATARS		  = 200;
+	constexpr int ROSTER_REFRESH_RATE = 10;
+	// Long enough that only full batches are sent while avatars are joining, however slowly the test runs
+	constexpr auto STORM_BATCH_WINDOW = 1min;
+
+	LocalProfileStore Store;
+	Store.IsDeferred = true;
+
+	ProfileCache Cache(&Store, CAPACITY, MAX_AGE, STORM_BATCH_WINDOW, MAX_BATCH_SIZE);
+	CallbackCounter Counter;
+
+	// Every avatar that joins asks for its own profile, and every few joins the roster asks for everyone who has joined so far
+	int NumUncachedRequests = 0;
+	std::vector<std::string> Joined;
+
+	for (int i = 0; i < NUM_AVATARS; ++i)
+	{
+		Joined.push_back(GetAvatarId(i));
+		Cache.GetProfiles({Joined.back()}, Counter.Expect({Joined.back()}));
+		++NumUncachedRequests;
+
+		if ((i + 1) % ROSTER_REFRESH_RATE == 0)
+		{
+			Cache.GetProfiles(Joined, Counter.Expect(Joined));
+			++NumUncachedRequests;
+		}
+	}
+
+	// The responses only arrive once everything has been asked for, so every request overlaps the ones before it
+	Cache.Flush();
+	Store.ReleaseAll();
+
+	ASSERT_TRUE(Counter.WaitForAll());
+	EXPECT_EQ(Counter.NumSucceeded, Counter.NumExpected);
+	EXPECT_EQ(Counter.NumMatched, Counter.NumExpected);
+
+	// Full batches are sent straight away, and each user is only asked for once
+	EXPECT_EQ(Store.GetNumRequests(), NUM_AVATARS / MAX_BATCH_SIZE);
+
+	for (int i = 0; i < NUM_AVATARS; ++i)
+	{
+		EXPECT_EQ(Store.GetTimesRequested(GetAvatarId(i)), 1);
+	}
+
+	// Once everyone's profile is cached, asking again doesn't need the user service
+	Cache.GetProfiles(Joined, Counter.Expect(Joined));
+
+	ASSERT_TRUE(Counter.WaitForAll());
+	EXPECT_EQ(Store.GetNumRequests(), NUM_AVATARS / MAX_BATCH_SIZE);
+	EXPECT_LT(Store.GetNumRequests(), NumUncachedRequests);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ProfileCacheTests, BatchWindowTest)
+{
+	LocalProfileStore Store;
+	ProfileCache Cache(&Store, CAPACITY, MAX_AGE, BATCH_WINDOW, MAX_BATCH_SIZE);
+	CallbackCounter Counter;
+
+	// Single users asked for at around the same time are asked for together once the window ends
+	Cache.GetProfiles({"User1"}, Counter.Expect({"User1"}));
+	Cache.GetProfiles({"User2"}, Counter.Expect({"User2"}));
+	Cache.GetProfiles({"User1", "User3", "User1"}, Counter.Expect({"User1", "User3"}));
+	Cache.GetProfiles({"Missing1", "User2"}, Counter.Expect({"User2"}));
+
+	EXPECT_EQ(Store.GetNumRequests(), 0);
+
+	ASSERT_TRUE(Counter.WaitForAll());
+	EXPECT_EQ(Counter.NumMatched, Counter.NumExpected);
+	EXPECT_EQ(Store.GetNumRequests(), 1);
+	EXPECT_EQ(Cache.GetNumProfiles(), 3);
+
+	// Users without a profile aren't cached, so are asked for again
+	Cache.GetProfiles({"Missing1", "User3"}, Counter.Expect({"User3"}));
+
+	ASSERT_TRUE(Counter.WaitForAll());
+	EXPECT_EQ(Store.GetNumRequests(), 2);
+	EXPECT_EQ(Store.GetTimesRequested("User3"), 1);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ProfileCacheTests, EvictionTest)
+{
+	LocalProfileStore Store;
+
+	// The least recently used profile is discarded to make room
+	{
+		ProfileCache Cache(&Store, 3, MAX_AGE, BATCH_WINDOW, MAX_BATCH_SIZE);
+
+		Cache.GetProfiles({"User1", "User2", "User3"}, nullptr);
+		Cache.Flush();
+		Cache.GetProfiles({"User1"}, nullptr);
+		Cache.GetProfiles({"User4"}, nullptr);
+		Cache.Flush();
+
+		EXPECT_EQ(Cache.GetNumProfiles(), 3);
+		EXPECT_EQ(Store.GetNumRequests(), 2);
+
+		Cache.GetProfiles({"User1", "User3", "User4"}, nullptr);
+		EXPECT_EQ(Store.GetNumRequests(), 2);
+
+		Cache.GetProfiles({"User2"}, nullptr);
+		Cache.Flush();
+		EXPECT_EQ(Store.GetNumRequests(), 3);
+	}
+
+	// Profiles older than the maximum age are read again
+	{
+		ProfileCache Cache(&Store, CAPACITY, 0s, BATCH_WINDOW, MAX_BATCH_SIZE);
+
+		Cache.GetProfiles({"User1"}, nullptr);
+		Cache.Flush();
+		Cache.GetProfiles({"User1"}, nullptr);
+		Cache.Flush();
+
+		EXPECT_EQ(Store.GetNumRequests(), 5);
+	}
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ProfileCacheTests, InvalidateTest)
+{
+	LocalProfileStore Store;
+	Store.IsDeferred = true;
+
+	ProfileCache Cache(&Store, CAPACITY, MAX_AGE, BATCH_WINDOW, MAX_BATCH_SIZE);
+
+	std::string DisplayName;
+	const auto StoreDisplayName = [&DisplayName](bool /*Succeeded*/, uint16_t /*HttpResultCode*/, const std::vector<BasicProfile>& Profiles)
+	{
+		DisplayName = Profiles.empty() ? "" : Profiles[0].DisplayName.c_str();
+	};
+
+	// A profile invalidated while it is being read is returned, but not cached
+	Cache.GetProfiles({"User1"}, StoreDisplayName);
+	Cache.Flush();
+	Cache.Invalidate("User1");
+	Store.ReleaseAll();
+
+	EXPECT_EQ(DisplayName, "Name of User1");
+	EXPECT_EQ(Cache.GetNumProfiles(), 0);
+
+	Store.DisplayNamePrefix = "New name of ";
+	Cache.GetProfiles({"User1"}, StoreDisplayName);
+	Cache.Flush();
+	Store.ReleaseAll();
+
+	EXPECT_EQ(DisplayName, "New name of User1");
+	EXPECT_EQ(Store.GetNumRequests(), 2);
+
+	// Failures are passed on to everyone waiting, and nothing is cached
+	bool Failed = false;
+	Store.ShouldFail = true;
+	Cache.Invalidate("User1");
+	Cache.GetProfiles({"User1"},
+					  [&Failed](bool Succeeded, uint16_t HttpResultCode, const std::vector<BasicProfile>& /*Profiles*/)
+					  {
+						  Failed = !Succeeded && HttpResultCode == 500;
+					  });
+	Cache.Flush();
+	Store.ReleaseAll();
+
+	EXPECT_TRUE(Failed);
+	EXPECT_EQ(Cache.GetNumProfiles(), 0);
+
+	// Clearing the cache fails anything waiting
+	Failed			 = false;
+	Store.ShouldFail = false;
+	Cache.GetProfiles({"User2"},
+					  [&Failed](bool Succeeded, uint16_t /*HttpResultCode*/, const std::vector<BasicProfile>& /*Profiles*/)
+					  {
+						  Failed = !Succeeded;
+					  });
+	Cache.Flush();
+	Cache.Clear();
+	Store.ReleaseAll();
+
+	EXPECT_TRUE(Failed);
+	EXPECT_EQ(Cache.GetNumProfiles(), 0);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ProfileCacheTests, DestroyedWithFlushScheduledTest)
+{
+	LocalProfileStore Store;
+
+	// Destroying the cache while a flush is scheduled, or running, must not call into the destroyed cache
+	for (int i = 0; i < 20; ++i)
+	{
+		auto Cache = std::make_unique<ProfileCache>(&Store, CAPACITY, MAX_AGE, BATCH_WINDOW, MAX_BATCH_SIZE);
+		Cache->GetProfiles({"User" + std::to_string(i)}, nullptr);
+
+		// Lands close to the end of the window on some runs, so that the scheduled flush may have already started
+		std::this_thread::sleep_for(BATCH_WINDOW * i / 20);
+		Cache.reset();
+	}
+
+	std::this_thread::sleep_for(BATCH_WINDOW * 2);
+
+	EXPECT_LE(Store.GetNumRequests(), 20);
+}
+
+#endif
\ No newline at end of file
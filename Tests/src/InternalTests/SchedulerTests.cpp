@@ -15,11 +15,20 @@
  */
 
 #if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_SCHEDULER_TESTS)
+	#include "CSP/CSPFoundation.h"
 	#include "Common/DateTime.h"
 	#include "Common/Scheduler.h"
+	#include "PlatformTestUtils.h"
 	#include "TestHelpers.h"
 
 	#include "gtest/gtest.h"
+	#include <algorithm>
+	#include <atomic>
+	#include <chrono>
+	#include <random>
+	#include <string>
+	#include <thread>
+	#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -47,4 +56,250 @@ CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SchedulerTest)
 
 	EXPECT_TRUE(ScheduleCallback);
 }
+
+CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SharedSchedulerLifetimeTest)
+{
+	csp::DestroyScheduler();
+
+	// Racing first calls must all get the same scheduler
+	constexpr int NumThreads = 8;
+
+	std::vector<std::thread> Threads;
+	std::vector<csp::Scheduler*> Instances(NumThreads, nullptr);
+
+	for (int i = 0; i < NumThreads; ++i)
+	{
+		Threads.emplace_back(
+			[&Instances, i]()
+			{
+				Instances[i] = csp::GetScheduler();
+			});
+	}
+
+	for (auto& Thread : Threads)
+	{
+		Thread.join();
+	}
+
+	for (csp::Scheduler* Instance : Instances)
+	{
+		EXPECT_EQ(Instance, Instances[0]);
+	}
+
+	// Foundation creates the scheduler on Initialise and destroys it on Shutdown
+	csp::DestroyScheduler();
+
+	InitialiseFoundation();
+
+	std::atomic_bool Ran = false;
+
+	csp::GetScheduler()->ScheduleAfter(1ms,
+									   [&Ran]()
+									   {
+										   Ran = true;
+									   });
+
+	EXPECT_TRUE(ResponseWaiter::WaitFor(
+		[&Ran]()
+		{
+			return Ran.load();
+		},
+		std::chrono::seconds(5),
+		1ms));
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SchedulerCancelTest)
+{
+	csp::Scheduler Scheduler;
+	Scheduler.Initialise();
+
+	std::atomic_int NumOneOffCalls	 = 0;
+	std::atomic_int NumRepeatedCalls = 0;
+
+	const auto Cancelled = Scheduler.ScheduleAfter(50ms,
+												   [&NumOneOffCalls]()
+												   {
+													   ++NumOneOffCalls;
+												   });
+
+	Scheduler.ScheduleAfter(20ms,
+							[&NumOneOffCalls]()
+							{
+								++NumOneOffCalls;
+							});
+
+	const auto Repeating = Scheduler.ScheduleEvery(5ms,
+												   [&NumRepeatedCalls]()
+												   {
+													   ++NumRepeatedCalls;
+												   });
+
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), 3);
+	EXPECT_TRUE(Scheduler.CancelTask(Cancelled));
+	EXPECT_FALSE(Scheduler.CancelTask(Cancelled));
+
+	std::this_thread::sleep_for(100ms);
+
+	EXPECT_EQ(NumOneOffCalls, 1);
+	EXPECT_GE(NumRepeatedCalls, 5);
+
+	EXPECT_TRUE(Scheduler.CancelTask(Repeating));
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), 0);
+
+	// A call may already have been handed to a worker when the task was cancelled
+	std::this_thread::sleep_for(10ms);
+	const int CallsAfterCancel = NumRepeatedCalls;
+	std::this_thread::sleep_for(50ms);
+
+	EXPECT_EQ(NumRepeatedCalls, CallsAfterCancel);
+
+	Scheduler.Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SchedulerRejectsTimersAfterShutdownTest)
+{
+	csp::Scheduler Scheduler;
+	Scheduler.Initialise();
+	Scheduler.Shutdown();
+
+	std::atomic_bool Ran = false;
+
+	// Nothing would ever run these, so they must not be accepted
+	EXPECT_EQ(Scheduler.ScheduleAfter(1ms,
+									  [&Ran]()
+									  {
+										  Ran = true;
+									  }),
+			  csp::InvalidScheduledTaskId);
+	EXPECT_EQ(Scheduler.ScheduleEvery(1ms,
+									  [&Ran]()
+									  {
+										  Ran = true;
+									  }),
+			  csp::InvalidScheduledTaskId);
+
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), 0);
+	EXPECT_FALSE(Ran);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SchedulerManyTimersBenchmarkTest)
+{
+	constexpr int NumTimers = 100000;
+
+	csp::Scheduler Scheduler;
+	Scheduler.Initialise();
+
+	std::mt19937 Random(1234);
+	std::uniform_int_distribution<int> DelayMs(1000, 1500);
+	std::vector<std::chrono::milliseconds> Delays(NumTimers);
+
+	for (auto& Delay : Delays)
+	{
+		Delay = std::chrono::milliseconds(DelayMs(Random));
+	}
+
+	std::atomic_int NumFired			 = 0;
+	std::atomic_int NumCancelledFired	 = 0;
+	std::vector<csp::ScheduledTaskId> Ids(NumTimers);
+
+	auto Start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < NumTimers; ++i)
+	{
+		Ids[i] = Scheduler.ScheduleAfter(Delays[i],
+										 [i, &NumFired, &NumCancelledFired]()
+										 {
+											 ++NumFired;
+											 NumCancelledFired += i % 2;
+										 });
+	}
+
+	const double ScheduleTimeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), NumTimers);
+
+	// Cancel every other timer, from all over the heap
+	Start = std::chrono::steady_clock::now();
+
+	for (int i = 1; i < NumTimers; i += 2)
+	{
+		EXPECT_TRUE(Scheduler.CancelTask(Ids[i]));
+	}
+
+	const double CancelTimeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), NumTimers / 2);
+
+	const auto Deadline = std::chrono::steady_clock::now() + 5s;
+
+	while (NumFired < NumTimers / 2 && std::chrono::steady_clock::now() < Deadline)
+	{
+		std::this_thread::sleep_for(10ms);
+	}
+
+	EXPECT_EQ(NumFired, NumTimers / 2);
+	EXPECT_EQ(NumCancelledFired, 0);
+	EXPECT_EQ(Scheduler.GetNumPendingTasks(), 0);
+
+	RecordProperty("NsPerSchedule", std::to_string(ScheduleTimeNs / NumTimers));
+	RecordProperty("NsPerCancel", std::to_string(CancelTimeNs / (NumTimers / 2)));
+
+	Scheduler.Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SchedulerTests, SchedulerJitterBenchmarkTest)
+{
+	constexpr int NumTimers = 200;
+
+	csp::Scheduler Scheduler;
+	Scheduler.Initialise();
+
+	std::vector<std::chrono::steady_clock::time_point> Expected(NumTimers);
+	std::vector<std::chrono::steady_clock::time_point> Fired(NumTimers);
+	std::atomic_int NumFired = 0;
+
+	// Spread the timers 2.5ms apart, so each is waited for separately
+	for (int i = 0; i < NumTimers; ++i)
+	{
+		const auto Delay = std::chrono::microseconds(10000 + i * 2500);
+		Expected[i]		 = std::chrono::steady_clock::now() + Delay;
+
+		Scheduler.ScheduleAfter(Delay,
+								[i, &Fired, &NumFired]()
+								{
+									Fired[i] = std::chrono::steady_clock::now();
+									++NumFired;
+								});
+	}
+
+	const auto Deadline = std::chrono::steady_clock::now() + 5s;
+
+	while (NumFired < NumTimers && std::chrono::steady_clock::now() < Deadline)
+	{
+		std::this_thread::sleep_for(10ms);
+	}
+
+	ASSERT_EQ(NumFired, NumTimers);
+
+	std::vector<double> JitterUs(NumTimers);
+
+	for (int i = 0; i < NumTimers; ++i)
+	{
+		JitterUs[i] = std::chrono::duration<double, std::micro>(Fired[i] - Expected[i]).count();
+
+		// Never early
+		EXPECT_GE(Fired[i], Expected[i]);
+	}
+
+	std::sort(JitterUs.begin(), JitterUs.end());
+
+	// Recorded rather than asserted on, as how late a timer fires depends on the platform's timer resolution and the load on the machine
+	RecordProperty("JitterMedianUs", std::to_string(JitterUs[NumTimers / 2]));
+	RecordProperty("JitterP99Us", std::to_string(JitterUs[NumTimers * 99 / 100]));
+	RecordProperty("JitterMaxUs", std::to_string(JitterUs.back()));
+
+	Scheduler.Shutdown();
+}
 #endif
\ No newline at end of file
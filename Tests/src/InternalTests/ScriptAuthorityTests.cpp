@@ -0,0 +1,189 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_SCRIPT_AUTHORITY_TESTS)
+	#include "Multiplayer/Election/ScriptAuthorityRing.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <map>
+	#include <vector>
+
+
+using namespace csp::multiplayer;
+
+
+namespace
+{
+
+constexpr size_t NUM_ENTITIES	 = 20000;
+constexpr size_t MAX_CLIENTS	 = 16;
+constexpr uint64_t FIRST_ENTITY = 1000;
+
+// Each simulated client keeps its own view of the clients in the space, in the order it heard about them
+struct SimulatedClient
+{
+	int64_t Id;
+	ScriptAuthorityRing Ring;
+};
+
+std::vector<int64_t> GetAuthorities(const ScriptAuthorityRing& Ring)
+{
+	std::vector<int64_t> Authorities(NUM_ENTITIES);
+
+	for (size_t i = 0; i < NUM_ENTITIES; ++i)
+	{
+		Authorities[i] = Ring.GetAuthority(FIRST_ENTITY + i);
+	}
+
+	return Authorities;
+}
+
+std::map<int64_t, size_t> GetLoads(const std::vector<int64_t>& Authorities)
+{
+	std::map<int64_t, size_t> Loads;
+
+	for (const int64_t Authority : Authorities)
+	{
+		++Loads[Authority];
+	}
+
+	return Loads;
+}
+
+// Checks that every client agrees on the authority for every entity, and that each client's share is close to even
+std::vector<int64_t> CheckClients(const std::vector<SimulatedClient>& Clients)
+{
+	const auto Authorities = GetAuthorities(Clients.front().Ring);
+
+	for (const auto& Client : Clients)
+	{
+		EXPECT_EQ(GetAuthorities(Client.Ring), Authorities) << "Client " << Client.Id << " disagrees";
+	}
+
+	const auto Loads = GetLoads(Authorities);
+	EXPECT_EQ(Loads.size(), Clients.size());
+
+	const double MeanLoad = static_cast<double>(NUM_ENTITIES) / Clients.size();
+
+	for (const auto& Load : Loads)
+	{
+		EXPECT_LE(Load.second, MeanLoad * 1.3) << "Client " << Load.first << " with " << Clients.size() << " clients";
+		EXPECT_GE(Load.second, MeanLoad * 0.7) << "Client " << Load.first << " with " << Clients.size() << " clients";
+	}
+
+	return Authorities;
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, ScriptAuthorityTests, ConsistentHashingRebalanceTest)
+{
+	std::vector<SimulatedClient> Clients;
+	std::vector<int64_t> Authorities;
+
+	// Clients join one at a time. Each new client learns about the existing ones in its own order.
+	for (size_t i = 0; i < MAX_CLIENTS; ++i)
+	{
+		const int64_t NewId = 4000 + static_cast<int64_t>(i) * 37;
+
+		SimulatedClient NewClient {NewId, ScriptAuthorityRing()};
+
+		for (auto It = Clients.rbegin(); It != Clients.rend(); ++It)
+		{
+			NewClient.Ring.AddClient(It->Id);
+		}
+
+		NewClient.Ring.AddClient(NewId);
+
+		for (auto& Client : Clients)
+		{
+			Client.Ring.AddClient(NewId);
+		}
+
+		Clients.push_back(std::move(NewClient));
+
+		const auto NewAuthorities = CheckClients(Clients);
+
+		// Only entities taken by the new client have moved, and it took close to its fair share
+		if (!Authorities.empty())
+		{
+			size_t NumMoved = 0;
+
+			for (size_t e = 0; e < NUM_ENTITIES; ++e)
+			{
+				if (NewAuthorities[e] != Authorities[e])
+				{
+					EXPECT_EQ(NewAuthorities[e], NewId);
+					++NumMoved;
+				}
+			}
+
+			EXPECT_LE(NumMoved, NUM_ENTITIES / Clients.size() * 1.3);
+		}
+
+		Authorities = NewAuthorities;
+	}
+
+	// Clients leave from the middle of the join order, then the first client to join
+	const size_t LeaveOrder[] = {5, 9, 0, 3};
+
+	for (const size_t Index : LeaveOrder)
+	{
+		const int64_t LeavingId = Clients[Index].Id;
+		Clients.erase(Clients.begin() + Index);
+
+		for (auto& Client : Clients)
+		{
+			Client.Ring.RemoveClient(LeavingId);
+		}
+
+		const auto NewAuthorities = CheckClients(Clients);
+
+		// Only the leaving client's entities have moved
+		for (size_t e = 0; e < NUM_ENTITIES; ++e)
+		{
+			if (Authorities[e] != LeavingId)
+			{
+				EXPECT_EQ(NewAuthorities[e], Authorities[e]);
+			}
+			else
+			{
+				EXPECT_NE(NewAuthorities[e], LeavingId);
+			}
+		}
+
+		Authorities = NewAuthorities;
+	}
+
+	// A client that rejoins gets back exactly the entities it had
+	ScriptAuthorityRing Ring;
+	Ring.AddClient(1);
+
+	const auto OneClient = GetAuthorities(Ring);
+	Ring.AddClient(2);
+	Ring.RemoveClient(2);
+
+	EXPECT_EQ(GetAuthorities(Ring), OneClient);
+	EXPECT_EQ(Ring.GetNumClients(), 1u);
+	EXPECT_FALSE(Ring.HasClient(2));
+
+	Ring.Clear();
+	EXPECT_EQ(Ring.GetAuthority(FIRST_ENTITY), ScriptAuthorityRing::NoClient);
+}
+
+#endif
\ No newline at end of file
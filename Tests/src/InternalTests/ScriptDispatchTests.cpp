@@ -0,0 +1,222 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_SCRIPT_DISPATCH_TESTS)
+	#include "CSP/CSPFoundation.h"
+	#include "CSP/Common/StringFormat.h"
+	#include "CSP/Multiplayer/Script/EntityScript.h"
+	#include "CSP/Multiplayer/Script/EntityScriptMessages.h"
+	#include "CSP/Multiplayer/SpaceEntity.h"
+	#include "CSP/Systems/Script/ScriptSystem.h"
+	#include "CSP/Systems/SystemsManager.h"
+	#include "Debug/Logging.h"
+	#include "Memory/Memory.h"
+	#include "TestHelpers.h"
+	#include "quickjspp.hpp"
+
+	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <string>
+
+
+namespace
+{
+
+// Scripted entities are spread across contexts in groups, so the benchmark measures dispatch cost rather than the memory cost of one
+// QuickJS context per entity
+constexpr int64_t FIRST_CONTEXT_ID		= 1000000;
+constexpr size_t ENTITIES_PER_CONTEXT	= 100;
+constexpr const char* DELTA_TIME_PARAMS = "{\"deltaTimeMS\": 16.000000}";
+
+int GetTickCount(csp::systems::ScriptSystem* ScriptSystem, int64_t ContextId)
+{
+	auto* Context = static_cast<qjs::Context*>(ScriptSystem->GetContext(ContextId));
+
+	return Context->eval("globalThis.tickCount").as<int>();
+}
+
+std::string GetReceived(csp::systems::ScriptSystem* ScriptSystem, int64_t ContextId)
+{
+	auto* Context = static_cast<qjs::Context*>(ScriptSystem->GetContext(ContextId));
+
+	return Context->eval("globalThis.received").as<std::string>();
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, ScriptDispatchTests, EntityTickDispatchBenchmarkTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* ScriptSystem = csp::systems::SystemsManager::Get().GetScriptSystem();
+
+	const size_t EntityCounts[] = {1000, 10000};
+
+	for (const size_t EntityCount : EntityCounts)
+	{
+		const size_t ContextCount = EntityCount / ENTITIES_PER_CONTEXT;
+
+		for (size_t i = 0; i < ContextCount; ++i)
+		{
+			const int64_t ContextId = FIRST_CONTEXT_ID + i;
+			ASSERT_TRUE(ScriptSystem->CreateContext(ContextId));
+
+			std::string Source = "globalThis.tickCount = 0;\n";
+
+			for (size_t j = 0; j < ENTITIES_PER_CONTEXT; ++j)
+			{
+				Source += "globalThis.onTick" + std::to_string(j) + " = (_evtName, params) => { globalThis.tickCount++; };\n";
+			}
+
+			ASSERT_TRUE(ScriptSystem->RunScript(ContextId, Source.c_str()));
+		}
+
+		std::vector<csp::common::String> Callbacks;
+
+		for (size_t j = 0; j < ENTITIES_PER_CONTEXT; ++j)
+		{
+			Callbacks.push_back(("onTick" + std::to_string(j)).c_str());
+		}
+
+		// Source path: format and evaluate a call script for every entity, as PostMessageToScript did previously
+		auto Start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < EntityCount; ++i)
+		{
+			const int64_t ContextId				= FIRST_CONTEXT_ID + i / ENTITIES_PER_CONTEXT;
+			const csp::common::String& Callback = Callbacks[i % ENTITIES_PER_CONTEXT];
+			const csp::common::String ScriptText
+				= csp::common::StringFormat("%s('%s','%s')", Callback.c_str(), csp::multiplayer::SCRIPT_MSG_ENTITY_TICK, DELTA_TIME_PARAMS);
+
+			ScriptSystem->RunScript(ContextId, ScriptText);
+		}
+
+		const double SourceTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+		// Resolve the function handles up front, as SubscribeToMessage does
+		for (size_t i = 0; i < EntityCount; ++i)
+		{
+			ASSERT_TRUE(ScriptSystem->ResolveFunction(FIRST_CONTEXT_ID + i / ENTITIES_PER_CONTEXT, Callbacks[i % ENTITIES_PER_CONTEXT]));
+		}
+
+		// Handle path: call the cached function directly
+		Start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < EntityCount; ++i)
+		{
+			ScriptSystem->CallFunction(FIRST_CONTEXT_ID + i / ENTITIES_PER_CONTEXT,
+									   Callbacks[i % ENTITIES_PER_CONTEXT],
+									   csp::multiplayer::SCRIPT_MSG_ENTITY_TICK,
+									   DELTA_TIME_PARAMS);
+		}
+
+		const double HandleTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+		// Both paths must have run every callback exactly once
+		for (size_t i = 0; i < ContextCount; ++i)
+		{
+			EXPECT_EQ(GetTickCount(ScriptSystem, FIRST_CONTEXT_ID + i), static_cast<int>(ENTITIES_PER_CONTEXT * 2));
+		}
+
+		// Timings are recorded rather than compared, as they depend on the machine and its load
+		const std::string Entities = std::to_string(EntityCount);
+
+		RecordProperty("SourceTickMs_" + Entities, std::to_string(SourceTickMs));
+		RecordProperty("HandleTickMs_" + Entities, std::to_string(HandleTickMs));
+
+		for (size_t i = 0; i < ContextCount; ++i)
+		{
+			ScriptSystem->DestroyContext(FIRST_CONTEXT_ID + i);
+		}
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ScriptDispatchTests, UnresolvedFunctionTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* ScriptSystem = csp::systems::SystemsManager::Get().GetScriptSystem();
+
+	ASSERT_TRUE(ScriptSystem->CreateContext(FIRST_CONTEXT_ID));
+
+	// Callbacks that don't exist yet can't be resolved, so callers fall back to evaluating source
+	EXPECT_FALSE(ScriptSystem->ResolveFunction(FIRST_CONTEXT_ID, "onTick"));
+	EXPECT_FALSE(ScriptSystem->CallFunction(FIRST_CONTEXT_ID, "onTick", csp::multiplayer::SCRIPT_MSG_ENTITY_TICK, DELTA_TIME_PARAMS));
+
+	ASSERT_TRUE(ScriptSystem->RunScript(FIRST_CONTEXT_ID,
+										"globalThis.tickCount = 0; globalThis.onTick = (_evtName, params) => { globalThis.tickCount += "
+										"JSON.parse(params).deltaTimeMS; };"));
+
+	// Once defined, the function is resolved on first call and receives the params unchanged
+	EXPECT_TRUE(ScriptSystem->CallFunction(FIRST_CONTEXT_ID, "onTick", csp::multiplayer::SCRIPT_MSG_ENTITY_TICK, DELTA_TIME_PARAMS));
+	EXPECT_EQ(GetTickCount(ScriptSystem, FIRST_CONTEXT_ID), 16);
+
+	// Replacing the function is picked up without resolving it again
+	ASSERT_TRUE(ScriptSystem->RunScript(FIRST_CONTEXT_ID, "globalThis.onTick = (_evtName, params) => { globalThis.tickCount = -1; };"));
+	EXPECT_TRUE(ScriptSystem->CallFunction(FIRST_CONTEXT_ID, "onTick", csp::multiplayer::SCRIPT_MSG_ENTITY_TICK, DELTA_TIME_PARAMS));
+	EXPECT_EQ(GetTickCount(ScriptSystem, FIRST_CONTEXT_ID), -1);
+
+	// Resetting the context drops cached handles along with the functions they refer to
+	ASSERT_TRUE(ScriptSystem->ResetContext(FIRST_CONTEXT_ID));
+	EXPECT_FALSE(ScriptSystem->CallFunction(FIRST_CONTEXT_ID, "onTick", csp::multiplayer::SCRIPT_MSG_ENTITY_TICK, DELTA_TIME_PARAMS));
+
+	ScriptSystem->DestroyContext(FIRST_CONTEXT_ID);
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, ScriptDispatchTests, PostMessageToScriptTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* ScriptSystem = csp::systems::SystemsManager::Get().GetScriptSystem();
+
+	// Not part of a space, so its scripts are always run locally. Adding the script component creates its context.
+	auto* Entity = CSP_NEW csp::multiplayer::SpaceEntity();
+	Entity->AddComponent(csp::multiplayer::ComponentType::ScriptData);
+
+	csp::multiplayer::EntityScript* Script = Entity->GetScript();
+	const int64_t ContextId				   = Entity->GetId();
+
+	ASSERT_TRUE(ScriptSystem->RunScript(ContextId,
+										"globalThis.received = ''; globalThis.onTestMessage = (message, params) => { globalThis.received = "
+										"'first ' + message + ' ' + params; };"));
+
+	Script->SubscribeToMessage("testMessage", "onTestMessage");
+	Script->PostMessageToScript("testMessage", "{\"value\": 1}");
+
+	EXPECT_EQ(GetReceived(ScriptSystem, ContextId), "first testMessage {\"value\": 1}");
+
+	// A script that replaces its callback without subscribing again gets the new one
+	ASSERT_TRUE(ScriptSystem->RunScript(ContextId, "globalThis.onTestMessage = (message, params) => { globalThis.received = 'second ' + params; };"));
+	Script->PostMessageToScript("testMessage", "{\"value\": 2}");
+
+	EXPECT_EQ(GetReceived(ScriptSystem, ContextId), "second {\"value\": 2}");
+
+	// Messages that nothing has subscribed to aren't passed on
+	Script->PostMessageToScript("otherMessage", "{\"value\": 3}");
+
+	EXPECT_EQ(GetReceived(ScriptSystem, ContextId), "second {\"value\": 2}");
+
+	CSP_DELETE(Entity);
+
+	csp::CSPFoundation::Shutdown();
+}
+
+#endif
@@ -16,15 +16,20 @@
 
 #ifndef SKIP_INTERNAL_TESTS
 
+	#include "Multiplayer/MsgPackEntitySerialiser.h"
 	#include "Multiplayer/SignalRMsgPackEntitySerialiser.h"
 	#include "CSP/CSPFoundation.h"
 	#include "CSP/Multiplayer/SpaceEntity.h"
 	#include "CSP/Multiplayer/Components/AvatarSpaceComponent.h"
 	#include "CSP/Multiplayer/Components/StaticModelSpaceComponent.h"
+	#include "Memory/MemoryManager.h"
 	#include "Multiplayer/SpaceEntityKeys.h"
 	#include "TestHelpers.h"
 
 	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <cstring>
+	#include <string>
 
 
 using namespace csp::common;
@@ -392,4 +397,284 @@ CSP_INTERNAL_TEST(CSPEngine, SerialisationTests, SpaceEntityObjectSignalRDeseria
 	CSP_DELETE(Object);
 }
 
+namespace
+{
+
+// Checks that a msgpack object read from the output of MsgPackEntitySerialiser has the same structure and values as the
+// signalr::value tree produced by SignalRMsgPackEntitySerialiser for the same entity
+bool MatchesSignalRValue(const msgpack::object& Object, const signalr::value& Value)
+{
+	switch (Value.type())
+	{
+		case signalr::value_type::uint_map:
+		{
+			auto& Map = Value.as_uint_map();
+
+			if (Object.type != msgpack::type::MAP || Object.via.map.size != Map.size())
+			{
+				return false;
+			}
+
+			for (uint32_t i = 0; i < Object.via.map.size; ++i)
+			{
+				auto& Entry = Object.via.map.ptr[i];
+				auto It		= Map.find(Entry.key.via.u64);
+
+				if (It == Map.end() || !MatchesSignalRValue(Entry.val, It->second))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+		case signalr::value_type::array:
+		{
+			auto& Array = Value.as_array();
+
+			if (Object.type != msgpack::type::ARRAY || Object.via.array.size != Array.size())
+			{
+				return false;
+			}
+
+			for (uint32_t i = 0; i < Object.via.array.size; ++i)
+			{
+				if (!MatchesSignalRValue(Object.via.array.ptr[i], Array[i]))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+		case signalr::value_type::raw:
+		{
+			size_t Size;
+			auto* Data = Value.as_raw(Size);
+
+			return Object.type == msgpack::type::BIN && Object.via.bin.size == Size && std::memcmp(Object.via.bin.ptr, Data, Size) == 0;
+		}
+		case signalr::value_type::string:
+			return Object.type == msgpack::type::STR && std::string(Object.via.str.ptr, Object.via.str.size) == Value.as_string();
+		case signalr::value_type::integer:
+			return (Object.type == msgpack::type::POSITIVE_INTEGER && static_cast<int64_t>(Object.via.u64) == Value.as_integer())
+				   || (Object.type == msgpack::type::NEGATIVE_INTEGER && Object.via.i64 == Value.as_integer());
+		case signalr::value_type::uinteger:
+			return Object.type == msgpack::type::POSITIVE_INTEGER && Object.via.u64 == Value.as_uinteger();
+		case signalr::value_type::float64:
+			return (Object.type == msgpack::type::FLOAT32 || Object.type == msgpack::type::FLOAT64) && Object.via.f64 == Value.as_double();
+		case signalr::value_type::boolean:
+			return Object.type == msgpack::type::BOOLEAN && Object.via.boolean == Value.as_bool();
+		case signalr::value_type::null:
+			return Object.type == msgpack::type::NIL;
+		default:
+			return false;
+	}
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, SerialisationTests, SpaceEntityObjectMsgPackSerialisationTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto Object			   = CSP_NEW SpaceEntity();
+	Object->Type		   = SpaceEntityType::Object;
+	Object->Id			   = 1337;
+	Object->IsTransferable = true;
+	Object->IsPersistant   = true;
+	Object->Name		   = "MyObject";
+	Object->Transform	   = {Vector3 {1.2f, 2.34f, 3.45f}, Vector4 {4.1f, 5.1f, 6.1f, 7.1f}, Vector3 {1, 1, 1}};
+	Object->OwnerId		   = 42;
+	Object->ParentId	   = 9999;
+
+	auto* NewComponent = (StaticModelSpaceComponent*) Object->AddComponent(ComponentType::StaticModel);
+	NewComponent->SetExternalResourceAssetCollectionId("blah");
+	NewComponent->SetIsVisible(true);
+
+	SignalRMsgPackEntitySerialiser SignalRSerialiser;
+	Object->Serialise(SignalRSerialiser);
+	auto SignalRObject = SignalRSerialiser.Finalise();
+
+	MsgPackEntitySerialiser Serialiser;
+	Object->Serialise(Serialiser);
+
+	// Both serialisers must produce the same message, so that the server can't tell them apart
+	auto Handle = msgpack::unpack(Serialiser.GetData(), Serialiser.GetSize());
+	EXPECT_TRUE(MatchesSignalRValue(Handle.get(), SignalRObject));
+
+	auto SerialisedObject = Serialiser.Finalise();
+	EXPECT_TRUE(SerialisedObject.is_packed());
+
+	// The deserialiser reads strings in place, so takes ownership of the message to keep them alive
+	MsgPackEntityDeserialiser Deserialiser(std::move(SerialisedObject));
+	auto DeserialisedObject = CSP_NEW SpaceEntity();
+	DeserialisedObject->Deserialise(Deserialiser);
+
+	EXPECT_EQ(DeserialisedObject->Id, Object->Id);
+	EXPECT_EQ(DeserialisedObject->IsPersistant, Object->IsPersistant);
+	EXPECT_EQ(DeserialisedObject->Name, Object->Name);
+	EXPECT_EQ(DeserialisedObject->Transform.Position, Object->Transform.Position);
+	EXPECT_EQ(DeserialisedObject->Transform.Rotation, Object->Transform.Rotation);
+	EXPECT_EQ(DeserialisedObject->Transform.Scale, Object->Transform.Scale);
+	EXPECT_EQ(DeserialisedObject->OwnerId, Object->OwnerId);
+	EXPECT_EQ(*DeserialisedObject->ParentId, *Object->ParentId);
+
+	EXPECT_EQ(DeserialisedObject->Components.Size(), 1);
+
+	auto* DeserialisedComponent = (StaticModelSpaceComponent*) DeserialisedObject->GetComponent(COMPONENT_KEY_START_COMPONENTS);
+
+	EXPECT_EQ(DeserialisedComponent->GetComponentType(), ComponentType::StaticModel);
+	EXPECT_EQ(DeserialisedComponent->GetExternalResourceAssetCollectionId(), "blah");
+	EXPECT_EQ(DeserialisedComponent->GetIsVisible(), true);
+
+	CSP_DELETE(DeserialisedObject);
+	CSP_DELETE(Object);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SerialisationTests, SpaceEntityPatchMsgPackSerialisationTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto Object		= CSP_NEW SpaceEntity();
+	Object->Type	= SpaceEntityType::Object;
+	Object->Id		= 1337;
+	Object->OwnerId = 42;
+
+	Object->SetPosition({1.2f, 2.34f, 3.45f});
+	Object->SetRotation({4.1f, 5.1f, 6.1f, 7.1f});
+
+	auto* NewComponent = (StaticModelSpaceComponent*) Object->AddComponent(ComponentType::StaticModel);
+	NewComponent->SetExternalResourceAssetCollectionId("blah");
+
+	SignalRMsgPackEntitySerialiser SignalRSerialiser;
+	Object->SerialisePatch(SignalRSerialiser);
+	auto SignalRPatch = SignalRSerialiser.Finalise();
+
+	MsgPackEntitySerialiser Serialiser;
+	Object->SerialisePatch(Serialiser);
+
+	auto Handle = msgpack::unpack(Serialiser.GetData(), Serialiser.GetSize());
+	EXPECT_TRUE(MatchesSignalRValue(Handle.get(), SignalRPatch));
+
+	// Read the patch back in the same way as SpaceEntitySystem::ApplyIncomingPatch
+	auto SerialisedPatch = Serialiser.Finalise();
+	MsgPackEntityDeserialiser Deserialiser(SerialisedPatch);
+	auto PatchedObject = CSP_NEW SpaceEntity();
+
+	Deserialiser.EnterEntity();
+	{
+		EXPECT_EQ(Deserialiser.ReadUInt64(), Object->Id);
+		EXPECT_EQ(Deserialiser.ReadUInt64(), Object->OwnerId);
+		EXPECT_FALSE(Deserialiser.ReadBool()); // Destroy
+
+		uint32_t Size = 0;
+		Deserialiser.EnterArray(Size);
+		{
+			EXPECT_FALSE(Deserialiser.ReadBool());
+			EXPECT_TRUE(Deserialiser.NextValueIsNull());
+			Deserialiser.Skip();
+		}
+		Deserialiser.LeaveArray();
+
+		PatchedObject->DeserialiseFromPatch(Deserialiser);
+	}
+	Deserialiser.LeaveEntity();
+
+	EXPECT_EQ(PatchedObject->Transform.Position, Vector3(1.2f, 2.34f, 3.45f));
+	EXPECT_EQ(PatchedObject->Transform.Rotation, Vector4(4.1f, 5.1f, 6.1f, 7.1f));
+
+	auto* PatchedComponent = (StaticModelSpaceComponent*) PatchedObject->GetComponent(NewComponent->GetId());
+
+	EXPECT_TRUE(PatchedComponent != nullptr);
+	EXPECT_EQ(PatchedComponent->GetComponentType(), ComponentType::StaticModel);
+	EXPECT_EQ(PatchedComponent->GetExternalResourceAssetCollectionId(), "blah");
+
+	CSP_DELETE(PatchedObject);
+	CSP_DELETE(Object);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SerialisationTests, PatchSerialisationAllocationTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	constexpr int NumPatches = 10000;
+
+	// A typical avatar patch carries movement and the avatar state, and a typical object patch a transform and one component
+	auto Avatar		= CSP_NEW SpaceEntity();
+	Avatar->Type	= SpaceEntityType::Avatar;
+	Avatar->Id		= 42;
+	Avatar->OwnerId = 1337;
+	Avatar->SetPosition({1.2f, 2.34f, 3.45f});
+	Avatar->SetRotation({4.1f, 5.1f, 6.1f, 7.1f});
+
+	auto* AvatarComponent = (AvatarSpaceComponent*) Avatar->AddComponent(ComponentType::AvatarData);
+	AvatarComponent->SetAvatarId("MyCoolAvatar");
+	AvatarComponent->SetState(AvatarState::Flying);
+	AvatarComponent->SetUserId("0123456789ABCDEF");
+
+	auto Object		= CSP_NEW SpaceEntity();
+	Object->Type	= SpaceEntityType::Object;
+	Object->Id		= 1337;
+	Object->OwnerId = 42;
+	Object->SetPosition({1.2f, 2.34f, 3.45f});
+	Object->SetRotation({4.1f, 5.1f, 6.1f, 7.1f});
+	Object->SetScale({2.0f, 2.0f, 2.0f});
+
+	auto* StaticModelComponent = (StaticModelSpaceComponent*) Object->AddComponent(ComponentType::StaticModel);
+	StaticModelComponent->SetExternalResourceAssetCollectionId("blah");
+	StaticModelComponent->SetIsVisible(true);
+
+	const auto& Allocator = csp::memory::MemoryManager::GetDefaultAllocator();
+
+	// Allocations are counted through the CSP allocator, which other threads also use, and times depend on the machine, so both are
+	// recorded in the test report rather than asserted on
+	for (SpaceEntity* Entity : {Avatar, Object})
+	{
+		const std::string Prefix = (Entity == Avatar) ? "Avatar" : "Object";
+
+		// Serialise once up front, so that the buffer has already grown to fit the patch
+		MsgPackEntitySerialiser Serialiser;
+		Entity->SerialisePatch(Serialiser);
+
+		// SignalRMsgPackEntitySerialiser builds a signalr::value tree, which the hub protocol then encodes when the patch is sent
+		SignalRMsgPackEntitySerialiser SignalRSerialiser;
+
+		size_t StartAllocations = Allocator.GetNumAllocations();
+		auto Start				= std::chrono::steady_clock::now();
+
+		for (int i = 0; i < NumPatches; ++i)
+		{
+			Entity->SerialisePatch(SignalRSerialiser);
+			auto Patch = SignalRSerialiser.Finalise();
+		}
+
+		const double SignalRNs			= std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+		const size_t SignalRAllocations = Allocator.GetNumAllocations() - StartAllocations;
+
+		// MsgPackEntitySerialiser writes the encoded patch straight into its buffer, which is what the hub protocol sends
+		StartAllocations = Allocator.GetNumAllocations();
+		Start			 = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < NumPatches; ++i)
+		{
+			Entity->SerialisePatch(Serialiser);
+		}
+
+		const double MsgPackNs			= std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+		const size_t MsgPackAllocations = Allocator.GetNumAllocations() - StartAllocations;
+
+		EXPECT_GT(Serialiser.GetSize(), 0);
+
+		RecordProperty(Prefix + "SignalRNsPerPatch", std::to_string(SignalRNs / NumPatches));
+		RecordProperty(Prefix + "MsgPackNsPerPatch", std::to_string(MsgPackNs / NumPatches));
+		RecordProperty(Prefix + "SignalRAllocationsPerPatch", std::to_string(static_cast<double>(SignalRAllocations) / NumPatches));
+		RecordProperty(Prefix + "MsgPackAllocationsPerPatch", std::to_string(static_cast<double>(MsgPackAllocations) / NumPatches));
+	}
+
+	CSP_DELETE(Object);
+	CSP_DELETE(Avatar);
+}
+
 #endif
\ No newline at end of file
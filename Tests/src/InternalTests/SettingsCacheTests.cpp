@@ -0,0 +1,364 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_SETTINGS_CACHE_TESTS)
+	#include "Systems/Settings/SettingsCache.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <chrono>
+	#include <deque>
+	#include <filesystem>
+	#include <functional>
+	#include <map>
+	#include <sstream>
+	#include <string>
+	#include <thread>
+	#include <vector>
+
+
+using namespace csp::systems;
+using namespace std::chrono_literals;
+
+
+namespace
+{
+
+constexpr const char* CONTEXT = "UserSettings";
+
+// Stands in for the settings service, keeping settings in memory and counting round trips. Responses can be held back and released
+// later, so that requests can overlap as they would over the network.
+class LocalSettingsStore : public SettingsCache::IStore
+{
+public:
+	void Get(const std::string& Context, const std::string& Key, SettingsCache::ValueCallback Callback) override
+	{
+		++NumGets;
+
+		Respond(
+			[this, Context, Key, Callback]()
+			{
+				const auto It = Settings.find({Context, Key});
+				Callback(!ShouldFail, ShouldFail ? 500 : 200, It != Settings.end() ? It->second : "");
+			});
+	}
+
+	void Put(const std::string& Context, const std::map<std::string, std::string>& Values, SettingsCache::WriteCallback Callback) override
+	{
+		++NumPuts;
+
+		Respond(
+			[this, Context, Values, Callback]()
+			{
+				if (!ShouldFail)
+				{
+					for (const auto& [Key, Value] : Values)
+					{
+						Settings[{Context, Key}] = Value;
+					}
+				}
+
+				Callback(!ShouldFail, ShouldFail ? 500 : 200);
+			});
+	}
+
+	// Sends held back responses, including any to requests made while doing so
+	void ReleaseAll()
+	{
+		while (!Held.empty())
+		{
+			auto Response = std::move(Held.front());
+			Held.pop_front();
+			Response();
+		}
+	}
+
+	std::map<std::pair<std::string, std::string>, std::string> Settings;
+	int NumGets		= 0;
+	int NumPuts		= 0;
+	bool IsDeferred = false;
+	bool ShouldFail = false;
+
+private:
+	void Respond(std::function<void()> Response)
+	{
+		if (IsDeferred)
+		{
+			Held.push_back(std::move(Response));
+		}
+		else
+		{
+			Response();
+		}
+	}
+
+	std::deque<std::function<void()>> Held;
+};
+
+std::string GetTestFilePath(const char* Name)
+{
+	return (std::filesystem::temp_directory_path() / Name).string();
+}
+
+// Adds to a comma separated list in the same way as SettingsSystem::AddBlockedSpace
+SettingsCache::Mutation AddToList(const std::string& Item)
+{
+	return [Item](std::string& Value)
+	{
+		if (("," + Value + ",").find("," + Item + ",") != std::string::npos)
+		{
+			return false;
+		}
+
+		Value = Value.empty() ? Item : Item + "," + Value;
+
+		return true;
+	};
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, SettingsCacheTests, ConcurrentListChangesTest)
+{
+	constexpr int NUM_CHANGES = 20;
+
+	LocalSettingsStore Store;
+	Store.IsDeferred = true;
+
+	SettingsCache Cache(&Store, 15min);
+	Cache.SetUser("User");
+
+	int NumSucceeded = 0;
+
+	for (int i = 0; i < NUM_CHANGES; ++i)
+	{
+		Cache.Modify(CONTEXT,
+					 "BlockedSpaces",
+					 AddToList("Space" + std::to_string(i)),
+					 [&NumSucceeded](bool Succeeded, uint16_t /*HttpResultCode*/)
+					 {
+						 NumSucceeded += Succeeded ? 1 : 0;
+					 });
+	}
+
+	Store.ReleaseAll();
+
+	// The list is read once, and the changes are written in the first write plus one more for everything made while it was in flight
+	EXPECT_EQ(NumSucceeded, NUM_CHANGES);
+	EXPECT_EQ(Store.NumGets, 1);
+	EXPECT_EQ(Store.NumPuts, 2);
+
+	// No change was lost
+	const std::string Written = Store.Settings[{CONTEXT, "BlockedSpaces"}];
+
+	for (int i = 0; i < NUM_CHANGES; ++i)
+	{
+		EXPECT_NE(("," + Written + ",").find(",Space" + std::to_string(i) + ","), std::string::npos);
+	}
+
+	// Changes that don't change anything aren't written
+	bool Called = false;
+	Cache.Modify(CONTEXT,
+				 "BlockedSpaces",
+				 AddToList("Space0"),
+				 [&Called](bool Succeeded, uint16_t /*HttpResultCode*/)
+				 {
+					 Called = Succeeded;
+				 });
+
+	EXPECT_TRUE(Called);
+	EXPECT_EQ(Store.NumPuts, 2);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SettingsCacheTests, CachedReadTest)
+{
+	LocalSettingsStore Store;
+	Store.Settings[{CONTEXT, "NDAStatus"}] = "true";
+
+	SettingsCache Cache(&Store, 15min);
+	Cache.SetUser("User");
+
+	std::string Value;
+	const auto StoreValue = [&Value](bool Succeeded, uint16_t /*HttpResultCode*/, const std::string& InValue)
+	{
+		EXPECT_TRUE(Succeeded);
+		Value = InValue;
+	};
+
+	Cache.Get(CONTEXT, "NDAStatus", StoreValue);
+	Cache.Get(CONTEXT, "NDAStatus", StoreValue);
+
+	EXPECT_EQ(Value, "true");
+	EXPECT_EQ(Store.NumGets, 1);
+
+	// Values that have been written don't need to be read
+	Cache.Set(CONTEXT, "Newsletter", "false", nullptr);
+	Cache.Get(CONTEXT, "Newsletter", StoreValue);
+
+	EXPECT_EQ(Value, "false");
+	EXPECT_EQ(Store.NumGets, 1);
+	EXPECT_EQ(Store.NumPuts, 1);
+
+	// Invalidated values are read again
+	Cache.Invalidate();
+	Cache.Get(CONTEXT, "NDAStatus", StoreValue);
+
+	EXPECT_EQ(Store.NumGets, 2);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SettingsCacheTests, VersionStampTest)
+{
+	LocalSettingsStore Store;
+	Store.Settings[{CONTEXT, "AvatarInfo"}] = "Old";
+	Store.IsDeferred						= true;
+
+	SettingsCache Cache(&Store, 15min);
+	Cache.SetUser("User");
+
+	std::string Value;
+
+	// A value set while it is being read isn't replaced by the value that was read
+	Cache.Get(CONTEXT,
+			  "AvatarInfo",
+			  [&Value](bool /*Succeeded*/, uint16_t /*HttpResultCode*/, const std::string& InValue)
+			  {
+				  Value = InValue;
+			  });
+	Cache.Set(CONTEXT, "AvatarInfo", "New", nullptr);
+
+	Store.ReleaseAll();
+
+	EXPECT_EQ(Value, "New");
+	EXPECT_EQ((Store.Settings[{CONTEXT, "AvatarInfo"}]), "New");
+
+	// A failed write means we no longer know the value, so it is read again
+	Store.ShouldFail = true;
+	Cache.Set(CONTEXT, "AvatarInfo", "Failed", nullptr);
+	Store.ReleaseAll();
+	Store.ShouldFail = false;
+
+	Cache.Get(CONTEXT,
+			  "AvatarInfo",
+			  [&Value](bool /*Succeeded*/, uint16_t /*HttpResultCode*/, const std::string& InValue)
+			  {
+				  Value = InValue;
+			  });
+	Store.ReleaseAll();
+
+	EXPECT_EQ(Value, "New");
+	EXPECT_EQ(Store.NumGets, 2);
+
+	// Clearing the cache fails anything waiting on a read
+	bool Failed = false;
+	Cache.Modify(CONTEXT,
+				 "RecentSpaces",
+				 AddToList("Space"),
+				 [&Failed](bool Succeeded, uint16_t /*HttpResultCode*/)
+				 {
+					 Failed = !Succeeded;
+				 });
+	Cache.Clear();
+	Store.ReleaseAll();
+
+	EXPECT_TRUE(Failed);
+	EXPECT_EQ((Store.Settings.count({CONTEXT, "RecentSpaces"})), 0);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SettingsCacheTests, PersistenceTest)
+{
+	const std::string Path = GetTestFilePath("csp_settings_cache_test.json");
+	std::filesystem::remove(Path);
+
+	LocalSettingsStore Store;
+	Store.Settings[{CONTEXT, "RecentSpaces"}] = "Space1,Space2";
+
+	{
+		SettingsCache Cache(&Store, 15min);
+		Cache.SetUser("User");
+		EXPECT_TRUE(Cache.EnablePersistence(Path));
+
+		Cache.Get(CONTEXT, "RecentSpaces", [](bool, uint16_t, const std::string&) {});
+		Cache.Set(CONTEXT, "NDAStatus", "true", nullptr);
+
+		// The file is written shortly after the responses, without waiting for the cache to be destroyed
+		const auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+		while (!std::filesystem::exists(Path) && std::chrono::steady_clock::now() < Deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		EXPECT_TRUE(std::filesystem::exists(Path));
+	}
+
+	EXPECT_EQ(Store.NumGets, 1);
+
+	// Values cached in one session are read from the file in the next
+	{
+		SettingsCache Cache(&Store, 15min);
+		Cache.SetUser("User");
+		EXPECT_TRUE(Cache.EnablePersistence(Path));
+		EXPECT_EQ(Cache.GetNumEntries(), 2);
+
+		std::string Value;
+		Cache.Get(CONTEXT,
+				  "RecentSpaces",
+				  [&Value](bool /*Succeeded*/, uint16_t /*HttpResultCode*/, const std::string& InValue)
+				  {
+					  Value = InValue;
+				  });
+
+		EXPECT_EQ(Value, "Space1,Space2");
+		EXPECT_EQ(Store.NumGets, 1);
+
+		// But not for another user
+		Cache.SetUser("OtherUser");
+		EXPECT_EQ(Cache.GetNumEntries(), 0);
+	}
+
+	std::filesystem::remove(Path);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SettingsCacheTests, PortraitUriTest)
+{
+	LocalSettingsStore Store;
+	SettingsCache Cache(&Store, 15min);
+
+	Cache.SetPortraitUri("User1", "https://portraits/1.png", "Asset1", "Collection1");
+	Cache.SetPortraitUri("User2", "https://portraits/2.png", "Asset2", "Collection2");
+
+	std::string Uri;
+	EXPECT_TRUE(Cache.GetPortraitUri("User1", Uri));
+	EXPECT_EQ(Uri, "https://portraits/1.png");
+
+	// Changes to the portrait asset, or to its collection, discard the URI
+	Cache.OnAssetChanged("Asset1", "");
+	EXPECT_FALSE(Cache.GetPortraitUri("User1", Uri));
+	EXPECT_TRUE(Cache.GetPortraitUri("User2", Uri));
+
+	Cache.OnAssetChanged("", "Collection2");
+	EXPECT_FALSE(Cache.GetPortraitUri("User2", Uri));
+
+	Cache.SetPortraitUri("User1", "https://portraits/1.png", "Asset1", "Collection1");
+	Cache.RemovePortraitUri("User1");
+	EXPECT_FALSE(Cache.GetPortraitUri("User1", Uri));
+
+	// None of this needs the settings service
+	EXPECT_EQ(Store.NumGets + Store.NumPuts, 0);
+}
+
+#endif
\ No newline at end of file
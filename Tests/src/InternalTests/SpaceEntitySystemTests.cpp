@@ -0,0 +1,707 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_SPACEENTITYSYSTEM_TESTS)
+	#include "CSP/CSPFoundation.h"
+	#include "CSP/Multiplayer/Components/StaticModelSpaceComponent.h"
+	#include "CSP/Multiplayer/SpaceEntity.h"
+	#include "CSP/Multiplayer/SpaceEntitySystem.h"
+	#include "CSP/Systems/SystemsManager.h"
+	#include "Common/RecursiveSharedMutex.h"
+	#include "Memory/Memory.h"
+	#include "Multiplayer/IncomingPatchQueue.h"
+	#include "Multiplayer/MsgPackEntitySerialiser.h"
+	#include "Multiplayer/PatchBatcher.h"
+	#include "Multiplayer/SpaceEntityKeys.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <atomic>
+	#include <chrono>
+	#include <iterator>
+	#include <msgpack/unpack.hpp>
+	#include <mutex>
+	#include <shared_mutex>
+	#include <string>
+	#include <system_error>
+	#include <thread>
+	#include <vector>
+
+
+using namespace csp::multiplayer;
+
+
+namespace
+{
+
+constexpr size_t LOOKUPS_PER_RUN = 100000;
+
+double AverageLookupTimeNs(const std::chrono::steady_clock::time_point& Start, const std::chrono::steady_clock::time_point& End)
+{
+	return std::chrono::duration<double, std::nano>(End - Start).count() / static_cast<double>(LOOKUPS_PER_RUN);
+}
+
+// Encodes a msgpack string that takes up exactly Size bytes, to stand in for an entity patch
+std::vector<char> MakePatch(size_t Size)
+{
+	// 2 byte str8 header
+	std::vector<char> Patch(Size, 'x');
+	Patch[0] = static_cast<char>(0xd9);
+	Patch[1] = static_cast<char>(Size - 2);
+
+	return Patch;
+}
+
+} // namespace
+
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, EntityLookupScalingTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* EntitySystem = csp::systems::SystemsManager::Get().GetSpaceEntitySystem();
+
+	const size_t EntityCounts[] = {100, 1000, 10000, 100000};
+	double IdLookupTimesNs[std::size(EntityCounts)];
+	double NameLookupTimesNs[std::size(EntityCounts)];
+
+	for (size_t Run = 0; Run < std::size(EntityCounts); ++Run)
+	{
+		const size_t EntityCount = EntityCounts[Run];
+
+		for (size_t i = 0; i < EntityCount; ++i)
+		{
+			auto* Entity = CSP_NEW SpaceEntity(EntitySystem);
+			Entity->Type = SpaceEntityType::Object;
+			Entity->Id	 = i + 1;
+			Entity->Name = ("Entity" + std::to_string(i)).c_str();
+
+			EntitySystem->AddEntity(Entity);
+		}
+
+		EntitySystem->ProcessPendingEntityOperations();
+
+		ASSERT_EQ(EntitySystem->GetNumEntities(), EntityCount);
+
+		// Look up entities spread across the whole list, so a linear scan would visit on average half of it
+		const size_t Stride = EntityCount / 7 + 1;
+		size_t Found		= 0;
+
+		auto Start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < LOOKUPS_PER_RUN; ++i)
+		{
+			Found += EntitySystem->FindSpaceEntityById((i * Stride) % EntityCount + 1) != nullptr;
+		}
+
+		IdLookupTimesNs[Run] = AverageLookupTimeNs(Start, std::chrono::steady_clock::now());
+
+		EXPECT_EQ(Found, LOOKUPS_PER_RUN);
+
+		// Prebuild names so that only the lookup itself is timed
+		csp::common::String Names[7];
+
+		for (size_t i = 0; i < std::size(Names); ++i)
+		{
+			Names[i] = ("Entity" + std::to_string((i * Stride) % EntityCount)).c_str();
+		}
+
+		Found = 0;
+		Start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < LOOKUPS_PER_RUN; ++i)
+		{
+			Found += EntitySystem->FindSpaceObject(Names[i % std::size(Names)]) != nullptr;
+		}
+
+		NameLookupTimesNs[Run] = AverageLookupTimeNs(Start, std::chrono::steady_clock::now());
+
+		EXPECT_EQ(Found, LOOKUPS_PER_RUN);
+
+		// Recorded in the test report rather than asserted on, since wall-clock bounds flake on loaded machines
+		RecordProperty("IdLookupNs_" + std::to_string(EntityCount), std::to_string(IdLookupTimesNs[Run]));
+		RecordProperty("NameLookupNs_" + std::to_string(EntityCount), std::to_string(NameLookupTimesNs[Run]));
+
+		// Renamed entities must be found under their new name only
+		auto* Renamed = EntitySystem->FindSpaceEntityById(1);
+		Renamed->SetNameInternal("RenamedEntity");
+
+		EXPECT_EQ(EntitySystem->FindSpaceEntity("RenamedEntity"), Renamed);
+		EXPECT_EQ(EntitySystem->FindSpaceEntity("Entity0"), nullptr);
+		EXPECT_EQ(EntitySystem->FindSpaceAvatar("RenamedEntity"), nullptr);
+
+		EntitySystem->LocalDestroyAllEntities();
+
+		EXPECT_EQ(EntitySystem->FindSpaceEntityById(1), nullptr);
+		EXPECT_EQ(EntitySystem->FindSpaceEntity("RenamedEntity"), nullptr);
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, PatchBatcherTest)
+{
+	std::vector<uint32_t> MessageSizes;
+	size_t LargestMessage = 0;
+
+	PatchBatcher Batcher(1000,
+						 300,
+						 [&MessageSizes, &LargestMessage](const signalr::value& Patches, uint32_t NumPatches)
+						 {
+							 size_t Size;
+							 auto* Data = reinterpret_cast<const char*>(Patches.as_packed(Size));
+
+							 // Every message must be a well formed array holding the patches added to it
+							 auto Handle = msgpack::unpack(Data, Size);
+							 EXPECT_EQ(Handle.get().type, msgpack::type::ARRAY);
+							 EXPECT_EQ(Handle.get().via.array.size, NumPatches);
+
+							 MessageSizes.push_back(NumPatches);
+							 LargestMessage = std::max(LargestMessage, Size);
+						 });
+
+	const auto Patch = MakePatch(100);
+	int NumAdded	 = 0;
+
+	// Simulate a burst of far more edits than fit in one frame
+	for (int i = 0; i < 10000 && Batcher.HasBudget(); ++i)
+	{
+		Batcher.Add(Patch.data(), Patch.size());
+		++NumAdded;
+	}
+
+	Batcher.Flush();
+
+	// The frame stops once the budget is used, and no message goes over the size limit (plus its array header)
+	EXPECT_EQ(NumAdded, 10);
+	EXPECT_EQ(Batcher.GetBytesAdded(), 1000);
+	EXPECT_EQ(MessageSizes, std::vector<uint32_t>({3, 3, 3, 1}));
+	EXPECT_EQ(Batcher.GetNumMessagesSent(), 4);
+	EXPECT_LE(LargestMessage, 300 + 5);
+
+	// A patch larger than the limit by itself is still sent, on its own
+	MessageSizes.clear();
+
+	PatchBatcher UnlimitedBudget(0,
+								 300,
+								 [&MessageSizes](const signalr::value& /*Patches*/, uint32_t NumPatches)
+								 {
+									 MessageSizes.push_back(NumPatches);
+								 });
+
+	const auto LargePatch = MakePatch(250);
+
+	UnlimitedBudget.Add(Patch.data(), Patch.size());
+	UnlimitedBudget.Add(LargePatch.data(), LargePatch.size());
+	UnlimitedBudget.Add(Patch.data(), Patch.size());
+	UnlimitedBudget.Flush();
+	UnlimitedBudget.Flush();
+
+	EXPECT_TRUE(UnlimitedBudget.HasBudget());
+	EXPECT_EQ(MessageSizes, std::vector<uint32_t>({1, 1, 1}));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, OutgoingPatchPriorityTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* EntitySystem = csp::systems::SystemsManager::Get().GetSpaceEntitySystem();
+	EntitySystem->SetEntityPatchRateLimitEnabled(false);
+
+	const csp::common::Vector3 Position = {1.0f, 2.0f, 3.0f};
+
+	// Every entity only moves, so all of the patches are the same size, and the budget allows for three of them per frame
+	{
+		SpaceEntity Entity;
+		Entity.Id	   = 1;
+		Entity.OwnerId = csp::systems::SystemsManager::Get().GetMultiplayerConnection()->GetClientId();
+		Entity.SetPosition(Position);
+
+		MsgPackEntitySerialiser Serialiser;
+		Entity.SerialisePatch(Serialiser);
+
+		EntitySystem->SetEntityPatchFrameBudget(static_cast<uint32_t>(3 * Serialiser.GetSize()));
+	}
+
+	// Objects 1-4 and avatars 5-8, each with the number of seconds since its last patch
+	const std::pair<uint64_t, int> EntityAges[] = {{1, 10}, {2, 40}, {3, 20}, {4, 30}, {5, 5}, {6, 1}, {7, 3}, {8, 2}};
+
+	std::vector<uint64_t> SentIds;
+	std::vector<SpaceEntity*> Entities;
+
+	for (const auto& [Id, Age] : EntityAges)
+	{
+		auto* Entity = CSP_NEW SpaceEntity(EntitySystem);
+		Entity->Type = Id <= 4 ? SpaceEntityType::Object : SpaceEntityType::Avatar;
+		Entity->Id	 = Id;
+		Entity->SetPatchSentCallback(
+			[&SentIds, Id = Id](bool /*Success*/)
+			{
+				SentIds.push_back(Id);
+			});
+
+		EntitySystem->AddEntity(Entity);
+		Entities.push_back(Entity);
+	}
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	const auto Now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+
+	for (size_t i = 0; i < Entities.size(); ++i)
+	{
+		Entities[i]->TimeOfLastPatch = Now - std::chrono::seconds(EntityAges[i].second);
+		Entities[i]->SetPosition(Position);
+		Entities[i]->QueueUpdate();
+	}
+
+	// Avatars go first, oldest first, and whatever doesn't fit in the budget waits for the next frame
+	EntitySystem->ProcessPendingEntityOperations();
+	EXPECT_EQ(SentIds, std::vector<uint64_t>({5, 7, 8}));
+
+	// Avatar 5 has just been sent, but still goes ahead of objects that have waited longer
+	Entities[4]->SetPosition({4.0f, 5.0f, 6.0f});
+	Entities[4]->QueueUpdate();
+
+	SentIds.clear();
+	EntitySystem->ProcessPendingEntityOperations();
+	EXPECT_EQ(SentIds, std::vector<uint64_t>({6, 5, 2}));
+
+	SentIds.clear();
+	EntitySystem->ProcessPendingEntityOperations();
+	EXPECT_EQ(SentIds, std::vector<uint64_t>({4, 3, 1}));
+
+	// Everything has been sent
+	SentIds.clear();
+	EntitySystem->ProcessPendingEntityOperations();
+	EXPECT_TRUE(SentIds.empty());
+
+	EntitySystem->LocalDestroyAllEntities();
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, EntityLockContentionTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* EntitySystem = csp::systems::SystemsManager::Get().GetSpaceEntitySystem();
+
+	constexpr size_t EntityCount = 1000;
+	constexpr int NumStorms		 = 20;
+
+	for (size_t i = 0; i < EntityCount; ++i)
+	{
+		auto* Entity = CSP_NEW SpaceEntity(EntitySystem);
+		Entity->Type = SpaceEntityType::Object;
+		Entity->Id	 = i + 1;
+		Entity->Name = ("Entity" + std::to_string(i)).c_str();
+
+		EntitySystem->AddEntity(Entity);
+	}
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	// A patch moving every entity, as they would arrive from the server
+	std::vector<signalr::value> Patches;
+	MsgPackEntitySerialiser Serialiser;
+
+	for (size_t i = 0; i < EntityCount; ++i)
+	{
+		SpaceEntity Entity;
+		Entity.Id = i + 1;
+		Entity.SetPosition({static_cast<float>(i), 1.0f, 2.0f});
+		Entity.SerialisePatch(Serialiser);
+
+		Patches.push_back(Serialiser.Finalise());
+	}
+
+	for (int NumReaders : {1, 2, 4, 8})
+	{
+		std::atomic_bool Stop		 = false;
+		std::atomic<uint64_t> NumReads = 0;
+		std::vector<std::thread> Readers;
+
+		for (int i = 0; i < NumReaders; ++i)
+		{
+			// Read the way a renderer would each frame: walk every entity, plus some lookups by id
+			Readers.emplace_back(
+				[EntitySystem, &Stop, &NumReads]()
+				{
+					uint64_t Reads = 0;
+
+					while (!Stop)
+					{
+						const size_t NumEntities = EntitySystem->GetNumEntities();
+
+						for (size_t j = 0; j < NumEntities; ++j)
+						{
+							Reads += EntitySystem->GetEntityByIndex(j) != nullptr;
+						}
+
+						for (uint64_t Id = 1; Id <= EntityCount; Id += 97)
+						{
+							Reads += EntitySystem->FindSpaceEntityById(Id) != nullptr;
+						}
+					}
+
+					NumReads += Reads;
+				});
+		}
+
+		for (int Storm = 0; Storm < NumStorms; ++Storm)
+		{
+			for (const auto& Patch : Patches)
+			{
+				EntitySystem->PendingIncomingUpdates->Push(Patch);
+			}
+
+			EntitySystem->ProcessPendingEntityOperations();
+		}
+
+		Stop = true;
+
+		for (auto& Reader : Readers)
+		{
+			Reader.join();
+		}
+
+		// Readers must make progress while patches are being applied, and must not starve the thread applying them
+		EXPECT_GT(NumReads.load(), 0);
+		EXPECT_EQ(EntitySystem->FindSpaceEntityById(EntityCount)->GetPosition().X, static_cast<float>(EntityCount - 1));
+	}
+
+	EntitySystem->LocalDestroyAllEntities();
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, RecursiveSharedMutexUpgradeTest)
+{
+	csp::RecursiveSharedMutex Mutex;
+
+	{
+		std::shared_lock SharedLock(Mutex);
+		std::shared_lock NestedSharedLock(Mutex);
+
+		// Upgrading would deadlock, so must fail in release builds as well as debug ones
+		EXPECT_THROW(Mutex.lock(), std::system_error);
+	}
+
+	// The failed attempt must leave the mutex usable
+	{
+		std::scoped_lock ExclusiveLock(Mutex);
+		std::shared_lock NestedSharedLock(Mutex);
+	}
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, GlobalTransformCacheTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	auto* EntitySystem = csp::systems::SystemsManager::Get().GetSpaceEntitySystem();
+
+	// A single chain, as in a deeply nested prefab. Every link is offset by 1 along its parent's X axis.
+	constexpr size_t Depth = 256;
+
+	for (size_t i = 0; i < Depth; ++i)
+	{
+		auto* Entity = CSP_NEW SpaceEntity(EntitySystem);
+		Entity->Type	  = SpaceEntityType::Object;
+		Entity->Id		  = i + 1;
+		Entity->Name	  = ("Entity" + std::to_string(i)).c_str();
+		Entity->Transform = {{i == 0 ? 0.0f : 1.0f, 0, 0}, {0, 0, 0, 1}, {1, 1, 1}};
+
+		if (i > 0)
+		{
+			Entity->ParentId = i;
+		}
+
+		EntitySystem->AddEntity(Entity);
+	}
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	for (size_t i = 0; i < Depth; ++i)
+	{
+		EntitySystem->ResolveEntityHierarchy(EntitySystem->FindSpaceEntityById(i + 1));
+	}
+
+	auto* Root = EntitySystem->FindSpaceEntityById(1);
+	auto* Leaf = EntitySystem->FindSpaceEntityById(Depth);
+
+	ASSERT_EQ(Leaf->GetParentEntity()->GetId(), Depth - 1);
+
+	const SpaceTransform LeafTransform = Leaf->GetGlobalTransform();
+
+	EXPECT_FLOAT_EQ(LeafTransform.Position.X, static_cast<float>(Depth - 1));
+	EXPECT_EQ(LeafTransform.Rotation, csp::common::Vector4(0, 0, 0, 1));
+	EXPECT_EQ(LeafTransform.Scale, csp::common::Vector3(1, 1, 1));
+
+	constexpr size_t NumQueries = 10000;
+	double Sum					= 0.0;
+
+	for (size_t i = 0; i < NumQueries; ++i)
+	{
+		Sum += Leaf->GetGlobalPosition().X;
+	}
+
+	EXPECT_DOUBLE_EQ(Sum, static_cast<double>(Depth - 1) * NumQueries);
+
+	// Rotating the root by 90 degrees about Z and doubling its scale must be reflected all the way down the chain
+	MsgPackEntitySerialiser Serialiser;
+
+	{
+		SpaceEntity Patch;
+		Patch.Id = Root->GetId();
+		Patch.SetRotation({0, 0, 0.70710678f, 0.70710678f});
+		Patch.SetScale({2, 2, 2});
+		Patch.SerialisePatch(Serialiser);
+	}
+
+	EntitySystem->PendingIncomingUpdates->Push(Serialiser.Finalise());
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	EXPECT_TRUE(Leaf->GlobalTransformDirty);
+
+	EntitySystem->UpdateWorldTransforms();
+
+	EXPECT_FALSE(Leaf->GlobalTransformDirty);
+
+	const SpaceTransform RotatedTransform = Leaf->GetGlobalTransform();
+
+	EXPECT_NEAR(RotatedTransform.Position.X, 0.0f, 1e-3f);
+	EXPECT_NEAR(RotatedTransform.Position.Y, 2.0f * (Depth - 1), 1e-2f);
+	EXPECT_NEAR(RotatedTransform.Rotation.Z, 0.70710678f, 1e-5f);
+	EXPECT_EQ(RotatedTransform.Scale, csp::common::Vector3(2, 2, 2));
+
+	// Moving an entity only invalidates it and its descendants
+	auto* Middle = EntitySystem->FindSpaceEntityById(Depth / 2);
+	Middle->Transform.Position = {2, 0, 0};
+	Middle->MarkGlobalTransformDirty();
+
+	EXPECT_FALSE(Middle->GetParentEntity()->GlobalTransformDirty);
+	EXPECT_TRUE(Leaf->GlobalTransformDirty);
+	EXPECT_NEAR(Leaf->GetGlobalPosition().Y, 2.0f * Depth, 1e-2f);
+
+	// Detaching an entity makes its global transform its local one
+	Leaf->RemoveParentEntity();
+	EntitySystem->ResolveEntityHierarchy(Leaf);
+
+	EXPECT_EQ(Leaf->GetGlobalTransform().Position, csp::common::Vector3(1, 0, 0));
+
+	EntitySystem->LocalDestroyAllEntities();
+
+	csp::CSPFoundation::Shutdown();
+}
+
+CSP_INTERNAL_TEST(CSPEngine, SpaceEntitySystemTests, IncomingPatchCoalescingTest)
+{
+	InitialiseFoundationWithUserAgentInfo(EndpointBaseURI);
+
+	// Merging, on patches built by hand
+	{
+		IncomingEntityPatch First;
+		First.EntityId		= 1;
+		First.HasComponents = true;
+		First.ViewComponents.emplace_back(COMPONENT_KEY_VIEW_POSITION, csp::common::Vector3(1, 0, 0));
+		First.Components.push_back({COMPONENT_KEY_START_COMPONENTS,
+									static_cast<uint64_t>(ComponentType::StaticModel),
+									{{1, ReplicatedValue(true)}, {2, ReplicatedValue(int64_t(1))}}});
+
+		IncomingEntityPatch Moved	   = First;
+		Moved.ViewComponents[0].second = csp::common::Vector3(2, 0, 0);
+		Moved.Components[0].Properties = {{2, ReplicatedValue(int64_t(2))}};
+
+		IncomingEntityPatch Other = Moved;
+		Other.EntityId			  = 2;
+
+		IncomingEntityPatch Removed = First;
+		Removed.Components[0].Type	= static_cast<uint64_t>(ComponentType::Invalid);
+		Removed.Components[0].Properties.clear();
+
+		IncomingEntityPatch Destroyed;
+		Destroyed.EntityId = 2;
+		Destroyed.Destroy  = true;
+
+		std::vector<IncomingEntityPatch> Patches = {First, Other, Moved, Removed, First, Destroyed, Moved};
+		IncomingPatchQueue::Coalesce(Patches);
+
+		// Moved is merged into First, but removing the component and adding it back each need their own patch, and nothing is merged
+		// across the destruction of an entity
+		ASSERT_EQ(Patches.size(), 6);
+		EXPECT_EQ(Patches[0].EntityId, 1);
+		EXPECT_EQ(Patches[0].ViewComponents[0].second.GetVector3(), csp::common::Vector3(2, 0, 0));
+		ASSERT_EQ(Patches[0].Components[0].Properties.size(), 2);
+		EXPECT_TRUE(Patches[0].Components[0].Properties[0].second.GetBool());
+		EXPECT_EQ(Patches[0].Components[0].Properties[1].second.GetInt(), 2);
+		EXPECT_EQ(Patches[1].EntityId, 2);
+		EXPECT_EQ(Patches[2].Components[0].Type, static_cast<uint64_t>(ComponentType::Invalid));
+		EXPECT_EQ(Patches[3].Components[0].Type, static_cast<uint64_t>(ComponentType::StaticModel));
+		EXPECT_TRUE(Patches[4].Destroy);
+		EXPECT_EQ(Patches[5].EntityId, 1);
+		EXPECT_EQ(Patches[5].Components[0].Properties.size(), 1);
+	}
+
+	// 200 avatars, each sending 4 patches per frame
+	auto* EntitySystem = csp::systems::SystemsManager::Get().GetSpaceEntitySystem();
+
+	constexpr size_t NumAvatars		 = 200;
+	constexpr size_t PatchesPerFrame = 4;
+	constexpr size_t NumFrames		 = 25;
+	constexpr size_t NumPatches		 = NumAvatars * PatchesPerFrame * NumFrames;
+
+	size_t NumUpdates = 0;
+
+	for (size_t i = 0; i < NumAvatars; ++i)
+	{
+		auto* Entity = CSP_NEW SpaceEntity(EntitySystem);
+		Entity->Type = SpaceEntityType::Avatar;
+		Entity->Id	 = i + 1;
+		Entity->Name = ("Avatar" + std::to_string(i)).c_str();
+		Entity->SetUpdateCallback(
+			[&NumUpdates](SpaceEntity*, SpaceEntityUpdateFlags, csp::common::Array<ComponentUpdateInfo>&)
+			{
+				++NumUpdates;
+			});
+
+		EntitySystem->AddEntity(Entity);
+	}
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	// Record the patches the avatars would send. Every avatar moves several times a frame, and its last patch each frame also updates its model.
+	std::vector<std::vector<signalr::value>> Frames(NumFrames);
+	MsgPackEntitySerialiser Serialiser;
+
+	for (size_t Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		for (size_t Step = 0; Step < PatchesPerFrame; ++Step)
+		{
+			for (size_t i = 0; i < NumAvatars; ++i)
+			{
+				SpaceEntity Source;
+				Source.Id	   = i + 1;
+				Source.OwnerId = i + 1;
+				Source.SetPosition({static_cast<float>(i), static_cast<float>(Frame), static_cast<float>(Step)});
+				Source.SetRotation({0, 0, 0, 1});
+
+				if (Step == PatchesPerFrame - 1)
+				{
+					auto* Model = static_cast<StaticModelSpaceComponent*>(Source.AddComponent(ComponentType::StaticModel));
+					Model->SetExternalResourceAssetCollectionId(std::to_string(Frame).c_str());
+				}
+
+				Source.SerialisePatch(Serialiser);
+				Frames[Frame].push_back(Serialiser.Finalise());
+			}
+		}
+	}
+
+	const auto ExpectFinalState = [EntitySystem]()
+	{
+		for (size_t i = 0; i < NumAvatars; ++i)
+		{
+			auto* Avatar = EntitySystem->FindSpaceEntityById(i + 1);
+			auto* Model	 = static_cast<StaticModelSpaceComponent*>(Avatar->GetComponent(COMPONENT_KEY_START_COMPONENTS));
+
+			EXPECT_EQ(Avatar->GetPosition(), csp::common::Vector3(i, NumFrames - 1, PatchesPerFrame - 1));
+			ASSERT_NE(Model, nullptr);
+			EXPECT_EQ(Model->GetExternalResourceAssetCollectionId(), std::to_string(NumFrames - 1).c_str());
+		}
+	};
+
+	// Every patch applied in turn, straight from msgpack
+	for (const auto& Frame : Frames)
+	{
+		for (const auto& Message : Frame)
+		{
+			std::scoped_lock EntitiesLocker(*EntitySystem->EntitiesLock);
+
+			MsgPackEntityDeserialiser Deserialiser(Message);
+
+			Deserialiser.EnterEntity();
+			{
+				SpaceEntity* Entity = EntitySystem->FindSpaceEntityById(Deserialiser.ReadUInt64());
+				Entity->OwnerId		= Deserialiser.ReadUInt64();
+				Deserialiser.ReadBool();
+
+				uint32_t Size = 0;
+				Deserialiser.EnterArray(Size);
+				{
+					Deserialiser.ReadBool();
+					Deserialiser.Skip();
+				}
+				Deserialiser.LeaveArray();
+
+				Entity->DeserialiseFromPatch(Deserialiser);
+			}
+			Deserialiser.LeaveEntity();
+		}
+	}
+
+	EXPECT_EQ(NumUpdates, NumPatches);
+	ExpectFinalState();
+
+	// Merged per entity, decoded on this thread and then with the decode workers
+	const size_t NumWorkers = std::max<size_t>(IncomingPatchQueue::GetDefaultNumDecodeWorkers(), 1);
+
+	for (const size_t NumDecodeWorkers : {size_t(0), NumWorkers})
+	{
+		IncomingPatchQueue Queue(NumDecodeWorkers);
+		NumUpdates = 0;
+
+		for (const auto& Frame : Frames)
+		{
+			for (const auto& Message : Frame)
+			{
+				Queue.Push(Message);
+			}
+
+			const auto Patches = Queue.Flush();
+
+			EXPECT_EQ(Patches.size(), NumAvatars);
+
+			for (const auto& Patch : Patches)
+			{
+				std::scoped_lock EntitiesLocker(*EntitySystem->EntitiesLock);
+				EntitySystem->ApplyIncomingPatch(Patch);
+			}
+		}
+
+		EXPECT_EQ(NumUpdates, NumAvatars * NumFrames);
+		ExpectFinalState();
+	}
+
+	// The same through the entity system itself
+	NumUpdates = 0;
+
+	for (const auto& Message : Frames.front())
+	{
+		EntitySystem->PendingIncomingUpdates->Push(Message);
+	}
+
+	EntitySystem->ProcessPendingEntityOperations();
+
+	EXPECT_EQ(NumUpdates, NumAvatars);
+	EXPECT_EQ(EntitySystem->FindSpaceEntityById(NumAvatars)->GetPosition(), csp::common::Vector3(NumAvatars - 1, 0, PatchesPerFrame - 1));
+
+	EntitySystem->LocalDestroyAllEntities();
+
+	csp::CSPFoundation::Shutdown();
+}
+#endif
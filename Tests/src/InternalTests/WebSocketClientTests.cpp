@@ -23,7 +23,24 @@
 	#include "PlatformTestUtils.h"
 	#include "TestHelpers.h"
 
+	#ifndef CSP_WASM
+		#include "Multiplayer/SignalR/POCOSignalRClient/POCOSignalRClient.h"
+
+		#include <Poco/Net/HTTPRequestHandler.h>
+		#include <Poco/Net/HTTPRequestHandlerFactory.h>
+		#include <Poco/Net/HTTPServer.h>
+		#include <Poco/Net/HTTPServerParams.h>
+		#include <Poco/Net/HTTPServerRequest.h>
+		#include <Poco/Net/HTTPServerResponse.h>
+		#include <Poco/Net/ServerSocket.h>
+		#include <Poco/Net/WebSocket.h>
+	#endif
+
 	#include "gtest/gtest.h"
+	#include <algorithm>
+	#include <condition_variable>
+	#include <mutex>
+	#include <vector>
 
 using namespace csp::multiplayer;
 
@@ -98,4 +115,159 @@ CSP_INTERNAL_TEST(CSPEngine, WebSocketClientTests, SignalRClientSendReceiveTest)
 	// Logout
 	LogOut(UserSystem);
 }
+
+	#ifndef CSP_WASM
+
+namespace
+{
+
+class EchoWebSocketRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+	void handleRequest(Poco::Net::HTTPServerRequest& Request, Poco::Net::HTTPServerResponse& Response) override
+	{
+		Poco::Net::WebSocket Socket(Request, Response);
+
+		char Buffer[4096];
+		int Flags = 0;
+
+		try
+		{
+			for (;;)
+			{
+				const int Received = Socket.receiveFrame(Buffer, sizeof(Buffer), Flags);
+
+				if (Received <= 0 || (Flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) == Poco::Net::WebSocket::FRAME_OP_CLOSE)
+				{
+					break;
+				}
+
+				Socket.sendFrame(Buffer, Received, Flags);
+			}
+		}
+		catch (const Poco::Exception&)
+		{
+			// Client went away
+		}
+	}
+};
+
+class EchoWebSocketRequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+	Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest& Request) override
+	{
+		return new EchoWebSocketRequestHandler();
+	}
+};
+
+} // namespace
+
+CSP_INTERNAL_TEST(CSPEngine, WebSocketClientTests, WebSocketReceiveLatencyTest)
+{
+	InitialiseFoundation();
+
+	{
+		Poco::Net::ServerSocket ServerSocket(Poco::Net::SocketAddress("127.0.0.1", 0));
+		Poco::Net::HTTPServer Server(new EchoWebSocketRequestHandlerFactory(), ServerSocket, new Poco::Net::HTTPServerParams());
+		Server.start();
+
+		CSPWebSocketClientPOCO Client;
+
+		bool Connected = false;
+		Client.Connect(Poco::URI("ws://127.0.0.1:" + std::to_string(ServerSocket.address().port()) + "/echo"),
+					   [&Connected](bool Result)
+					   {
+						   Connected = Result;
+					   });
+
+		ASSERT_TRUE(Connected);
+
+		std::mutex ReceivedMutex;
+		std::condition_variable ReceivedCondition;
+		std::vector<std::chrono::steady_clock::time_point> ReceiveTimes;
+
+		// Like the SignalR client, re-arm the receive from inside the callback
+		IWebSocketClient::ReceiveHandler OnReceive;
+		OnReceive = [&](const std::string& Message, bool Result)
+		{
+			EXPECT_TRUE(Result);
+
+			{
+				std::scoped_lock Lock(ReceivedMutex);
+				ReceiveTimes.push_back(std::chrono::steady_clock::now());
+			}
+
+			ReceivedCondition.notify_one();
+
+			if (Result)
+			{
+				Client.Receive(OnReceive);
+			}
+		};
+
+		Client.Receive(OnReceive);
+
+		auto SendAndWait = [&](const std::string& Message)
+		{
+			const auto SendTime = std::chrono::steady_clock::now();
+
+			std::unique_lock<std::mutex> Lock(ReceivedMutex);
+			const size_t PreviousCount = ReceiveTimes.size();
+			Lock.unlock();
+
+			Client.Send(Message,
+						[](bool Result)
+						{
+							EXPECT_TRUE(Result);
+						});
+
+			Lock.lock();
+
+			const bool Received = ReceivedCondition.wait_for(Lock,
+															 std::chrono::seconds(5),
+															 [&]()
+															 {
+																 return ReceiveTimes.size() > PreviousCount;
+															 });
+
+			EXPECT_TRUE(Received);
+
+			return Received ? std::chrono::duration<double, std::micro>(ReceiveTimes.back() - SendTime).count() : 0.0;
+		};
+
+		// The first message is expected to be the JSON handshake response
+		SendAndWait("{}\x1e");
+
+		// Subsequent messages are length-prefixed, with a single byte prefix for messages shorter than 128 bytes
+		const std::string Message = std::string(1, static_cast<char>(32)) + std::string(32, 'x');
+		constexpr int NumMessages = 500;
+
+		std::vector<double> Latencies;
+		Latencies.reserve(NumMessages);
+
+		for (int i = 0; i < NumMessages; ++i)
+		{
+			Latencies.push_back(SendAndWait(Message));
+		}
+
+		std::sort(Latencies.begin(), Latencies.end());
+
+		// Recorded in the test report rather than asserted on, as the round trip depends on the load on the machine
+		RecordProperty("RoundTripP50Us", std::to_string(Latencies[NumMessages * 50 / 100]));
+		RecordProperty("RoundTripP99Us", std::to_string(Latencies[NumMessages * 99 / 100]));
+
+		// Stop must interrupt the blocking poll promptly
+		const auto StopStart = std::chrono::steady_clock::now();
+		Client.Stop(nullptr);
+
+		EXPECT_LT(std::chrono::steady_clock::now() - StopStart, std::chrono::milliseconds(500));
+
+		Server.stopAll(true);
+	}
+
+	csp::CSPFoundation::Shutdown();
+}
+
+	#endif
 #endif
\ No newline at end of file
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2023 Magnopus LLC
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(SKIP_INTERNAL_TESTS) || defined(RUN_WORKSTEALINGEXECUTOR_TESTS)
+	#include "Common/WorkStealingExecutor.h"
+	#include "TestHelpers.h"
+
+	#include "gtest/gtest.h"
+	#include <atomic>
+	#include <chrono>
+	#include <mutex>
+	#include <set>
+	#include <string>
+	#include <thread>
+	#include <vector>
+
+using namespace std::chrono_literals;
+
+
+CSP_INTERNAL_TEST(CSPEngine, WorkStealingExecutorTests, TimerWheelTest)
+{
+	csp::TimerWheel<int> Wheel(8);
+
+	// Delays shorter than, equal to and longer than a single revolution of the wheel
+	Wheel.Add(3, 3);
+	Wheel.Add(8, 8);
+	Wheel.Add(20, 20);
+	Wheel.Add(0, 1);
+
+	EXPECT_EQ(Wheel.Size(), 4);
+
+	std::vector<int> Expired;
+
+	for (int Tick = 1; Tick <= 20; ++Tick)
+	{
+		Wheel.Advance(Expired);
+
+		for (int Item : Expired)
+		{
+			EXPECT_EQ(Item, Tick);
+		}
+
+		Expired.clear();
+	}
+
+	EXPECT_TRUE(Wheel.IsEmpty());
+}
+
+CSP_INTERNAL_TEST(CSPEngine, WorkStealingExecutorTests, PriorityTest)
+{
+	csp::WorkStealingExecutor Executor(1);
+
+	std::mutex OrderMutex;
+	std::vector<int> Order;
+	std::atomic_bool Release = false;
+
+	// Hold the only worker so that everything else queues up behind it
+	Executor.Enqueue(
+		[&Release](void*)
+		{
+			while (!Release)
+			{
+				std::this_thread::sleep_for(1ms);
+			}
+
+			return nullptr;
+		});
+
+	auto Record = [&OrderMutex, &Order](int Value)
+	{
+		return [&OrderMutex, &Order, Value](void*)
+		{
+			std::scoped_lock Lock(OrderMutex);
+			Order.push_back(Value);
+
+			return nullptr;
+		};
+	};
+
+	Executor.Enqueue(Record(3), csp::ETaskPriority::Low);
+	Executor.Enqueue(Record(2), csp::ETaskPriority::Normal);
+	Executor.Enqueue(Record(1), csp::ETaskPriority::High);
+	Executor.Enqueue(Record(4), csp::ETaskPriority::Low);
+
+	Release = true;
+	Executor.Shutdown();
+
+	EXPECT_EQ(Order, std::vector<int>({1, 2, 3, 4}));
+}
+
+CSP_INTERNAL_TEST(CSPEngine, WorkStealingExecutorTests, DelayedTaskTest)
+{
+	csp::WorkStealingExecutor Executor(1);
+
+	const auto Start = std::chrono::steady_clock::now();
+
+	std::atomic<std::chrono::steady_clock::duration> DelayedTime = std::chrono::steady_clock::duration::zero();
+	std::atomic<std::chrono::steady_clock::duration> ImmediateTime = std::chrono::steady_clock::duration::zero();
+
+	Executor.EnqueueAfter(200ms,
+						  [&DelayedTime, Start](void*)
+						  {
+							  DelayedTime = std::chrono::steady_clock::now() - Start;
+
+							  return nullptr;
+						  });
+
+	// A pending delayed task must not occupy the only worker
+	Executor.Enqueue(
+		[&ImmediateTime, Start](void*)
+		{
+			ImmediateTime = std::chrono::steady_clock::now() - Start;
+
+			return nullptr;
+		});
+
+	ASSERT_TRUE(ResponseWaiter::WaitFor(
+		[&DelayedTime]()
+		{
+			return DelayedTime.load() != std::chrono::steady_clock::duration::zero();
+		},
+		std::chrono::seconds(10),
+		10ms));
+
+	// Only the order and the lower bound are checked, as how late a task runs depends on the load on the machine
+	EXPECT_NE(ImmediateTime.load(), std::chrono::steady_clock::duration::zero());
+	EXPECT_LT(ImmediateTime.load(), DelayedTime.load());
+	EXPECT_GE(DelayedTime.load(), std::chrono::steady_clock::duration(200ms));
+
+	// Delayed tasks still pending at shutdown are run rather than dropped
+	std::atomic_bool ShutdownTaskRan = false;
+
+	Executor.EnqueueAfter(10s,
+						  [&ShutdownTaskRan](void*)
+						  {
+							  ShutdownTaskRan = true;
+
+							  return nullptr;
+						  });
+
+	Executor.Shutdown();
+
+	EXPECT_TRUE(ShutdownTaskRan);
+}
+
+CSP_INTERNAL_TEST(CSPEngine, WorkStealingExecutorTests, WorkStealingTest)
+{
+	constexpr int NumWorkers = 4;
+	constexpr int NumTasks	 = 16;
+
+	csp::WorkStealingExecutor Executor(NumWorkers);
+
+	std::atomic_int Completed = 0;
+
+	std::mutex WorkerIdsMutex;
+	std::set<std::thread::id> WorkerIds;
+
+	// Everything is enqueued from a single worker, so all of it lands on that worker's queue and has to be stolen by the others
+	Executor.Enqueue(
+		[&Executor, &Completed, &WorkerIdsMutex, &WorkerIds](void*)
+		{
+			for (int i = 0; i < NumTasks; ++i)
+			{
+				Executor.Enqueue(
+					[&Completed, &WorkerIdsMutex, &WorkerIds](void*)
+					{
+						{
+							std::scoped_lock Lock(WorkerIdsMutex);
+							WorkerIds.insert(std::this_thread::get_id());
+						}
+
+						std::this_thread::sleep_for(20ms);
+						++Completed;
+
+						return nullptr;
+					});
+			}
+
+			return nullptr;
+		});
+
+	Executor.Shutdown();
+
+	EXPECT_EQ(Completed, NumTasks);
+
+	// The idle workers have 320ms of queued work to take from the busy one
+	EXPECT_GT(WorkerIds.size(), static_cast<size_t>(1));
+}
+
+// Every task enqueued before Shutdown is run, like ThreadPool. Timings are recorded in the test report rather than asserted on,
+// as they depend on the machine and its load.
+CSP_INTERNAL_TEST(CSPEngine, WorkStealingExecutorTests, ThroughputBenchmarkTest)
+{
+	constexpr int NumTasks = 100000;
+
+	for (size_t NumWorkers : {4, 16, 64})
+	{
+		csp::ThreadPool Pool(NumWorkers);
+		csp::WorkStealingExecutor Executor(NumWorkers);
+
+		std::atomic_int PoolCompleted	  = 0;
+		std::atomic_int ExecutorCompleted = 0;
+
+		const auto PoolStart = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < NumTasks; ++i)
+		{
+			Pool.Enqueue(
+				[&PoolCompleted](void*)
+				{
+					++PoolCompleted;
+
+					return nullptr;
+				});
+		}
+
+		Pool.Shutdown();
+
+		const auto PoolTime = std::chrono::steady_clock::now() - PoolStart;
+
+		const auto ExecutorStart = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < NumTasks; ++i)
+		{
+			Executor.Enqueue(
+				[&ExecutorCompleted](void*)
+				{
+					++ExecutorCompleted;
+
+					return nullptr;
+				});
+		}
+
+		Executor.Shutdown();
+
+		const auto ExecutorTime = std::chrono::steady_clock::now() - ExecutorStart;
+
+		EXPECT_EQ(PoolCompleted, NumTasks);
+		EXPECT_EQ(ExecutorCompleted, NumTasks);
+
+		const std::string Workers = std::to_string(NumWorkers);
+
+		RecordProperty("ThreadPoolMs_" + Workers, std::to_string(std::chrono::duration<double, std::milli>(PoolTime).count()));
+		RecordProperty("WorkStealingExecutorMs_" + Workers, std::to_string(std::chrono::duration<double, std::milli>(ExecutorTime).count()));
+	}
+}
+
+#endif
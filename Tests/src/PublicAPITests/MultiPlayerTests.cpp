@@ -26,6 +26,7 @@
 #include "CSP/Systems/Spaces/UserRoles.h"
 #include "CSP/Systems/SystemsManager.h"
 #include "CSP/Systems/Users/UserSystem.h"
+#include "Common/RecursiveSharedMutex.h"
 #include "Debug/Logging.h"
 #include "Memory/Memory.h"
 #include "Multiplayer/SpaceEntityKeys.h"
@@ -1776,7 +1777,7 @@ struct InternalSpaceEntitySystem : public csp::multiplayer::SpaceEntitySystem
 {
 	void ClearEntities()
 	{
-		std::scoped_lock<std::recursive_mutex> EntitiesLocker(*EntitiesLock);
+		std::scoped_lock EntitiesLocker(*EntitiesLock);
 
 		Entities.Clear();
 		Objects.Clear();
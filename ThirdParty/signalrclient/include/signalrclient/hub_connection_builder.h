@@ -7,6 +7,7 @@
 #include "_exports.h"
 #include "hub_connection.h"
 #include <memory>
+#include <set>
 #include "websocket_client.h"
 #include "http_client.h"
 
@@ -37,6 +38,12 @@ namespace signalr
 
 #ifdef USE_MSGPACK
         SIGNALRCLIENT_API hub_connection_builder& with_messagepack_hub_protocol();
+
+        /**
+         * As above, but the arguments of the given hub methods are passed to their handlers as messagepack encoded
+         * value_type::packed values, one per argument, so that they can be decoded without building a signalr::value tree.
+         */
+        SIGNALRCLIENT_API hub_connection_builder& with_messagepack_hub_protocol(const std::set<std::string>& packed_argument_targets);
 #endif
 
         SIGNALRCLIENT_API hub_connection build();
@@ -50,5 +57,6 @@ namespace signalr
         std::function<std::shared_ptr<http_client>(const signalr_client_config&)> m_http_client_factory;
         bool m_skip_negotiation = false;
         bool m_use_messagepack = false;
+        std::set<std::string> m_packed_argument_targets;
     };
 }
@@ -27,7 +27,8 @@ namespace signalr
         uinteger,
         float64,
         null,
-        boolean
+        boolean,
+        packed
     };
 
     /**
@@ -106,6 +107,13 @@ namespace signalr
          */
         SIGNALRCLIENT_API value(const uint8_t* val, size_t len);
 
+        /**
+         * Create an object representing a value_type::packed from a buffer that already holds a complete messagepack encoded value.
+         * The buffer is written to the message as-is, so the messagepack protocol can send data that was serialised elsewhere
+         * without converting it to a tree of signalr::value's first.
+         */
+        SIGNALRCLIENT_API static value from_packed(const uint8_t* val, size_t len);
+
         /**
          * Create an object representing a value_type::map with the given map of string-value's.
          */
@@ -196,6 +204,11 @@ namespace signalr
          */
         SIGNALRCLIENT_API bool is_raw() const;
 
+        /**
+         * True if the object stored is a pre-encoded messagepack buffer.
+         */
+        SIGNALRCLIENT_API bool is_packed() const;
+
         /**
          * True if the object stored is a bool.
          */
@@ -236,6 +249,11 @@ namespace signalr
          */
         SIGNALRCLIENT_API const uint8_t* as_raw(size_t& len) const;
 
+        /**
+         * Returns the stored object as a messagepack encoded buffer, storing the length of the buffer in the provided out parameter. This will throw if the underlying object is not a signalr::type::packed.
+         */
+        SIGNALRCLIENT_API const uint8_t* as_packed(size_t& len) const;
+
         /**
          * Returns the stored object as a map of property name to signalr::value. This will throw if the underlying object is not a signalr::type::string_map.
          */
@@ -86,6 +86,13 @@ namespace signalr
         m_use_messagepack = true;
         return *this;
     }
+
+    hub_connection_builder& hub_connection_builder::with_messagepack_hub_protocol(const std::set<std::string>& packed_argument_targets)
+    {
+        m_use_messagepack = true;
+        m_packed_argument_targets = packed_argument_targets;
+        return *this;
+    }
 #endif
 
     hub_connection hub_connection_builder::build()
@@ -107,7 +114,7 @@ namespace signalr
 #ifdef USE_MSGPACK
         if (m_use_messagepack)
         {
-            hub_protocol = std::unique_ptr<messagepack_hub_protocol>(new messagepack_hub_protocol());
+            hub_protocol = std::unique_ptr<messagepack_hub_protocol>(new messagepack_hub_protocol(m_packed_argument_targets));
         }
         else
 #endif
@@ -4,6 +4,7 @@
 
 #include "stdafx.h"
 #include "json_helpers.h"
+#include "signalrclient/signalr_exception.h"
 #include <cmath>
 #include <stdint.h>
 
@@ -120,6 +121,8 @@ namespace signalr
             }
             return object;
         }
+        case signalr::value_type::packed:
+            throw signalr_exception("packed values can only be sent using the messagepack hub protocol");
         case signalr::value_type::null:
         default:
             return Json::Value(Json::ValueType::nullValue);
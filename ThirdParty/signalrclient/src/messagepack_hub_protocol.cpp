@@ -183,6 +183,14 @@ void pack_messagepack(const signalr::value& v, msgpack::packer<string_wrapper>&
 			}
 			return;
 		}
+		case signalr::value_type::packed:
+		{
+			// Already messagepack encoded, so append the bytes without a header
+			size_t len;
+			auto ptr = v.as_packed(len);
+			packer.pack_bin_body((const char*) ptr, static_cast<uint32_t>(len));
+			return;
+		}
 		case signalr::value_type::null:
 		default:
 		{
@@ -192,6 +200,31 @@ void pack_messagepack(const signalr::value& v, msgpack::packer<string_wrapper>&
 	}
 }
 
+// Creates an array of packed values, one for each of the invocation arguments, so that they can be read directly by the handler
+signalr::value createPackedArguments(const msgpack::object& arguments)
+{
+	std::vector<signalr::value> vec;
+	vec.reserve(arguments.via.array.size);
+
+	string_wrapper str;
+
+	for (size_t i = 0; i < arguments.via.array.size; ++i)
+	{
+		str.str.clear();
+		msgpack::packer<string_wrapper> packer(str);
+		packer.pack(*(arguments.via.array.ptr + i));
+
+		vec.push_back(signalr::value::from_packed(reinterpret_cast<const uint8_t*>(str.str.data()), str.str.size()));
+	}
+
+	return signalr::value(std::move(vec));
+}
+
+messagepack_hub_protocol::messagepack_hub_protocol(std::set<std::string> packed_argument_targets)
+	: m_packed_argument_targets(std::move(packed_argument_targets))
+{
+}
+
 std::string signalr::messagepack_hub_protocol::write_message(const hub_message* hub_message) const
 {
 	string_wrapper str;
@@ -374,8 +407,19 @@ std::vector<std::unique_ptr<hub_message>> messagepack_hub_protocol::parse_messag
 					throw signalr_exception("reading 'arguments' as array failed");
 				}
 
-				vec.emplace_back(std::unique_ptr<hub_message>(
-					new invocation_message(std::move(invocation_id), std::move(target), createValue(*msgpack_obj_index))));
+				signalr::value arguments;
+
+				if (m_packed_argument_targets.find(target) != m_packed_argument_targets.end())
+				{
+					arguments = createPackedArguments(*msgpack_obj_index);
+				}
+				else
+				{
+					arguments = createValue(*msgpack_obj_index);
+				}
+
+				vec.emplace_back(
+					std::unique_ptr<hub_message>(new invocation_message(std::move(invocation_id), std::move(target), std::move(arguments))));
 
 				if (num_elements_of_message > 5)
 				{
@@ -8,12 +8,19 @@
 
 #include "signalrclient/signalr_value.h"
 #include "hub_protocol.h"
+#include <set>
 
 namespace signalr
 {
     class messagepack_hub_protocol : public hub_protocol
     {
     public:
+        /**
+         * Arguments of invocations of any of the packed_argument_targets are passed to the handler as value_type::packed
+         * values rather than being converted to signalr::value's.
+         */
+        messagepack_hub_protocol(std::set<std::string> packed_argument_targets = {});
+
         std::string write_message(const hub_message*) const;
         std::vector<std::unique_ptr<hub_message>> parse_messages(const std::string&) const;
 
@@ -35,6 +42,7 @@ namespace signalr
         ~messagepack_hub_protocol() {}
     private:
         std::string m_protocol_name = "messagepack";
+        std::set<std::string> m_packed_argument_targets;
     };
 }
 
@@ -31,6 +31,8 @@ namespace signalr
             return "null";
         case signalr::value_type::boolean:
             return "boolean";
+        case signalr::value_type::packed:
+            return "packed";
         default:
             return std::to_string((int)v);
         }
@@ -68,6 +70,11 @@ namespace signalr
         case value_type::uint_map:
             new (&mStorage.uint_map) std::map<uint64_t, value>();
             break;
+        case value_type::raw:
+        case value_type::packed:
+            mStorage.buffer.ptr = nullptr;
+            mStorage.buffer.len = 0;
+            break;
         case value_type::null:
         default:
             break;
@@ -131,6 +138,17 @@ namespace signalr
         memcpy(mStorage.buffer.ptr, val, len);
     }
 
+    value value::from_packed(const uint8_t* val, size_t len)
+    {
+        value packed;
+        packed.mType = value_type::packed;
+        packed.mStorage.buffer.len = len;
+        packed.mStorage.buffer.ptr = (uint8_t*)malloc(len);
+        memcpy(packed.mStorage.buffer.ptr, val, len);
+
+        return packed;
+    }
+
     value::value(const std::map<std::string, value>& map) : mType(value_type::string_map)
     {
         new (&mStorage.string_map) std::map<std::string, value>(map);
@@ -160,6 +178,7 @@ namespace signalr
             new (&mStorage.array) std::vector<value>(rhs.mStorage.array);
             break;
         case value_type::raw:
+        case value_type::packed:
             mStorage.buffer.len = rhs.mStorage.buffer.len;
             mStorage.buffer.ptr = (uint8_t*)malloc(rhs.mStorage.buffer.len);
             memcpy(mStorage.buffer.ptr, rhs.mStorage.buffer.ptr, rhs.mStorage.buffer.len);
@@ -204,6 +223,12 @@ namespace signalr
             mStorage.buffer.ptr = (uint8_t*)malloc(rhs.mStorage.buffer.len);
             memmove(mStorage.buffer.ptr, rhs.mStorage.buffer.ptr, rhs.mStorage.buffer.len);
             break;
+        case value_type::packed:
+            // Packed buffers can be large, so take ownership rather than copying
+            mStorage.buffer = rhs.mStorage.buffer;
+            rhs.mStorage.buffer.ptr = nullptr;
+            rhs.mStorage.buffer.len = 0;
+            break;
         case value_type::string:
             new (&mStorage.string) std::string(std::move(rhs.mStorage.string));
             break;
@@ -244,7 +269,9 @@ namespace signalr
             mStorage.array.~vector();
             break;
         case value_type::raw:
-            if (mStorage.buffer.ptr && mStorage.buffer.len)
+        case value_type::packed:
+            // malloc may hand back a block even for an empty buffer, so free whatever we hold regardless of its length
+            if (mStorage.buffer.ptr)
             {
                 free(mStorage.buffer.ptr);
             }
@@ -279,6 +306,7 @@ namespace signalr
             new (&mStorage.array) std::vector<value>(rhs.mStorage.array);
             break;
         case value_type::raw:
+        case value_type::packed:
             mStorage.buffer.len = rhs.mStorage.buffer.len;
             mStorage.buffer.ptr = (uint8_t*)malloc(rhs.mStorage.buffer.len);
             memcpy(mStorage.buffer.ptr, rhs.mStorage.buffer.ptr, rhs.mStorage.buffer.len);
@@ -327,6 +355,12 @@ namespace signalr
             mStorage.buffer.ptr = (uint8_t*)malloc(rhs.mStorage.buffer.len);
             memmove(mStorage.buffer.ptr, rhs.mStorage.buffer.ptr, rhs.mStorage.buffer.len);
             break;
+        case value_type::packed:
+            // Packed buffers can be large, so take ownership rather than copying
+            mStorage.buffer = rhs.mStorage.buffer;
+            rhs.mStorage.buffer.ptr = nullptr;
+            rhs.mStorage.buffer.len = 0;
+            break;
         case value_type::string:
             new (&mStorage.string) std::string(std::move(rhs.mStorage.string));
             break;
@@ -401,6 +435,11 @@ namespace signalr
         return mType == signalr::value_type::raw;
     }
 
+    bool value::is_packed() const
+    {
+        return mType == signalr::value_type::packed;
+    }
+
     bool value::is_bool() const
     {
         return mType == signalr::value_type::boolean;
@@ -478,6 +517,18 @@ namespace signalr
         return mStorage.buffer.ptr;
     }
 
+    const uint8_t* value::as_packed(size_t& len) const
+    {
+        if (!is_packed())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(mType) + "' expected it to be a 'packed'");
+        }
+
+        len = mStorage.buffer.len;
+
+        return mStorage.buffer.ptr;
+    }
+
     const std::map<std::string, value>& value::as_string_map() const
     {
         if (!is_string_map())